@@ -22,6 +22,10 @@
 #define IBC_ENDIAN_H_
 
 // Includes --------------------------------------------------------------------
+#include <cstring>
+#ifdef _MSC_VER
+#include <stdlib.h>
+#endif
 #include "ibc/base/types.h"
 
 // Macros ----------------------------------------------------------------------
@@ -46,6 +50,15 @@
  #define CONV_TO_LITTLE_ENDIAN(x)     ibc::Endian::swap(x)
  #define CONV_TO_BIG_ENDIAN(x)        x
 #endif
+//
+#if defined(__AVX2__)
+ #define IBC_ENDIAN_USE_AVX2
+ #define IBC_ENDIAN_USE_SSSE3
+ #include <immintrin.h>
+#elif defined(__SSSE3__)
+ #define IBC_ENDIAN_USE_SSSE3
+ #include <tmmintrin.h>
+#endif
 
 // Namespace -------------------------------------------------------------------
 namespace ibc
@@ -57,33 +70,47 @@ namespace ibc
     // -------------------------------------------------------------------------
     // swap
     // -------------------------------------------------------------------------
-    // [TODO] should use _byteswap_ushort() with VC++ compiler
-    //
     static uint16_t  swap(uint16_t inValue)
     {
+    #if defined(__GNUC__) || defined(__clang__)
+      return __builtin_bswap16(inValue);
+    #elif defined(_MSC_VER)
+      return _byteswap_ushort(inValue);
+    #else
       uint16_t  result;
       result  = inValue << 8;
       result |= inValue >> 8;
       return result;
+    #endif
     }
     // -------------------------------------------------------------------------
     // swap
     // -------------------------------------------------------------------------
     static uint32_t  swap(uint32_t inValue)
     {
+    #if defined(__GNUC__) || defined(__clang__)
+      return __builtin_bswap32(inValue);
+    #elif defined(_MSC_VER)
+      return _byteswap_ulong(inValue);
+    #else
       uint32_t  result;
       result  = inValue << 24;
       result |= (inValue&0x0000FF00) << 8;
       result |= (inValue&0x00FF0000) >> 8;
       result |= inValue >> 24;
       return result;
+    #endif
     }
     // -------------------------------------------------------------------------
     // swap
     // -------------------------------------------------------------------------
-    // TODO : might need to use swap32 twice instead
     static uint64_t  swap(uint64_t inValue)
     {
+    #if defined(__GNUC__) || defined(__clang__)
+      return __builtin_bswap64(inValue);
+    #elif defined(_MSC_VER)
+      return _byteswap_uint64(inValue);
+    #else
       uint64_t  result;
       result  = inValue << 56;
       result |= (inValue&0x000000000000FF00) << 40;
@@ -94,6 +121,7 @@ namespace ibc
       result |= (inValue&0x00FF000000000000) >> 40;
       result |= inValue >> 56;
       return result;
+    #endif
     }
     // -------------------------------------------------------------------------
     // swap
@@ -142,6 +170,195 @@ namespace ibc
         dataPtr[inSize - i - 1] = t;
       }
     }
+    // -------------------------------------------------------------------------
+    // swapBuffer16
+    // -------------------------------------------------------------------------
+    // Swaps inNum 16bit values from inSrc to outDst.
+    // inSrc and outDst can be the same buffer, but must not partially overlap.
+    // No alignment is required.
+    static void swapBuffer16(const void *inSrc, void *outDst, size_t inNum)
+    {
+      static const unsigned char  shuffle[16] =
+        {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14};
+      size_t  i = swapBufferSIMD(inSrc, outDst, inNum * 2, shuffle) / 2;
+      const unsigned char *srcPtr = (const unsigned char *)inSrc;
+      unsigned char *dstPtr = (unsigned char *)outDst;
+      for (; i < inNum; i++)
+      {
+        uint16_t  v;
+        ::memcpy(&v, srcPtr + i * 2, 2);
+        v = swap(v);
+        ::memcpy(dstPtr + i * 2, &v, 2);
+      }
+    }
+    // -------------------------------------------------------------------------
+    // swapBuffer32
+    // -------------------------------------------------------------------------
+    static void swapBuffer32(const void *inSrc, void *outDst, size_t inNum)
+    {
+      static const unsigned char  shuffle[16] =
+        {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12};
+      size_t  i = swapBufferSIMD(inSrc, outDst, inNum * 4, shuffle) / 4;
+      const unsigned char *srcPtr = (const unsigned char *)inSrc;
+      unsigned char *dstPtr = (unsigned char *)outDst;
+      for (; i < inNum; i++)
+      {
+        uint32_t  v;
+        ::memcpy(&v, srcPtr + i * 4, 4);
+        v = swap(v);
+        ::memcpy(dstPtr + i * 4, &v, 4);
+      }
+    }
+    // -------------------------------------------------------------------------
+    // swapBuffer64
+    // -------------------------------------------------------------------------
+    static void swapBuffer64(const void *inSrc, void *outDst, size_t inNum)
+    {
+      static const unsigned char  shuffle[16] =
+        {7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8};
+      size_t  i = swapBufferSIMD(inSrc, outDst, inNum * 8, shuffle) / 8;
+      const unsigned char *srcPtr = (const unsigned char *)inSrc;
+      unsigned char *dstPtr = (unsigned char *)outDst;
+      for (; i < inNum; i++)
+      {
+        uint64_t  v;
+        ::memcpy(&v, srcPtr + i * 8, 8);
+        v = swap(v);
+        ::memcpy(dstPtr + i * 8, &v, 8);
+      }
+    }
+    // -------------------------------------------------------------------------
+    // swapBuffer16 (in-place)
+    // -------------------------------------------------------------------------
+    static void swapBuffer16(void *ioBuffer, size_t inNum)
+    {
+      swapBuffer16(ioBuffer, ioBuffer, inNum);
+    }
+    // -------------------------------------------------------------------------
+    // swapBuffer32 (in-place)
+    // -------------------------------------------------------------------------
+    static void swapBuffer32(void *ioBuffer, size_t inNum)
+    {
+      swapBuffer32(ioBuffer, ioBuffer, inNum);
+    }
+    // -------------------------------------------------------------------------
+    // swapBuffer64 (in-place)
+    // -------------------------------------------------------------------------
+    static void swapBuffer64(void *ioBuffer, size_t inNum)
+    {
+      swapBuffer64(ioBuffer, ioBuffer, inNum);
+    }
+    // -------------------------------------------------------------------------
+    // swapBuffer16Strided
+    // -------------------------------------------------------------------------
+    // Swaps inNum values placed every inSrcStride bytes (e.g. one field of
+    // an array of structs) to every inDstStride bytes.
+    // (inSrc == outDst with the same stride swaps the field in-place)
+    static void swapBuffer16Strided(const void *inSrc, size_t inSrcStride,
+                                    void *outDst, size_t inDstStride, size_t inNum)
+    {
+      if (inSrcStride == 2 && inDstStride == 2)
+      {
+        swapBuffer16(inSrc, outDst, inNum);
+        return;
+      }
+      const unsigned char *srcPtr = (const unsigned char *)inSrc;
+      unsigned char *dstPtr = (unsigned char *)outDst;
+      for (size_t i = 0; i < inNum; i++)
+      {
+        uint16_t  v;
+        ::memcpy(&v, srcPtr, 2);
+        v = swap(v);
+        ::memcpy(dstPtr, &v, 2);
+        srcPtr += inSrcStride;
+        dstPtr += inDstStride;
+      }
+    }
+    // -------------------------------------------------------------------------
+    // swapBuffer32Strided
+    // -------------------------------------------------------------------------
+    static void swapBuffer32Strided(const void *inSrc, size_t inSrcStride,
+                                    void *outDst, size_t inDstStride, size_t inNum)
+    {
+      if (inSrcStride == 4 && inDstStride == 4)
+      {
+        swapBuffer32(inSrc, outDst, inNum);
+        return;
+      }
+      const unsigned char *srcPtr = (const unsigned char *)inSrc;
+      unsigned char *dstPtr = (unsigned char *)outDst;
+      for (size_t i = 0; i < inNum; i++)
+      {
+        uint32_t  v;
+        ::memcpy(&v, srcPtr, 4);
+        v = swap(v);
+        ::memcpy(dstPtr, &v, 4);
+        srcPtr += inSrcStride;
+        dstPtr += inDstStride;
+      }
+    }
+    // -------------------------------------------------------------------------
+    // swapBuffer64Strided
+    // -------------------------------------------------------------------------
+    static void swapBuffer64Strided(const void *inSrc, size_t inSrcStride,
+                                    void *outDst, size_t inDstStride, size_t inNum)
+    {
+      if (inSrcStride == 8 && inDstStride == 8)
+      {
+        swapBuffer64(inSrc, outDst, inNum);
+        return;
+      }
+      const unsigned char *srcPtr = (const unsigned char *)inSrc;
+      unsigned char *dstPtr = (unsigned char *)outDst;
+      for (size_t i = 0; i < inNum; i++)
+      {
+        uint64_t  v;
+        ::memcpy(&v, srcPtr, 8);
+        v = swap(v);
+        ::memcpy(dstPtr, &v, 8);
+        srcPtr += inSrcStride;
+        dstPtr += inDstStride;
+      }
+    }
+
+  protected:
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // swapBufferSIMD
+    // -------------------------------------------------------------------------
+    // Shuffles the bytes with pshufb and returns the number of bytes processed.
+    // The rest (less than one register) is left for the scalar code.
+    static size_t swapBufferSIMD(const void *inSrc, void *outDst, size_t inSize,
+                                 const unsigned char inShuffle[16])
+    {
+      size_t  i = 0;
+    #ifdef IBC_ENDIAN_USE_SSSE3
+      const unsigned char *srcPtr = (const unsigned char *)inSrc;
+      unsigned char *dstPtr = (unsigned char *)outDst;
+      __m128i mask = _mm_loadu_si128((const __m128i *)inShuffle);
+     #ifdef IBC_ENDIAN_USE_AVX2
+      __m256i mask2 = _mm256_broadcastsi128_si256(mask);
+      for (; i + 64 <= inSize; i += 64)
+      {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(srcPtr + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(srcPtr + i + 32));
+        _mm256_storeu_si256((__m256i *)(dstPtr + i), _mm256_shuffle_epi8(v0, mask2));
+        _mm256_storeu_si256((__m256i *)(dstPtr + i + 32), _mm256_shuffle_epi8(v1, mask2));
+      }
+     #endif
+      for (; i + 16 <= inSize; i += 16)
+      {
+        __m128i v = _mm_loadu_si128((const __m128i *)(srcPtr + i));
+        _mm_storeu_si128((__m128i *)(dstPtr + i), _mm_shuffle_epi8(v, mask));
+      }
+    #else
+      UNUSED(inSrc);
+      UNUSED(outDst);
+      UNUSED(inSize);
+      UNUSED(inShuffle);
+    #endif
+      return i;
+    }
   };
 };
 
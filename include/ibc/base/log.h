@@ -24,6 +24,7 @@
 // Includes --------------------------------------------------------------------
 #include <stdio.h>
 #include <string.h>
+#include <stdarg.h>
 #include <iostream>
 #include <ostream>
 #include "ibc/base/types.h"
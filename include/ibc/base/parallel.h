@@ -0,0 +1,166 @@
+// =============================================================================
+//  parallel.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/base/parallel.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the simple data parallel helpers
+*/
+
+#ifndef IBC_PARALLEL_H_
+#define IBC_PARALLEL_H_
+
+// Includes --------------------------------------------------------------------
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "ibc/base/types.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+  // ---------------------------------------------------------------------------
+  // Parallel class
+  // ---------------------------------------------------------------------------
+  // Splits [0, inNum) into contiguous tasks and runs them on std::thread.
+  // The first task runs on the calling thread. This is meant for the large
+  // batch jobs (point clouds, images), not for the fine grained ones.
+  class  Parallel
+  {
+  public:
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getThreadNum
+    // -------------------------------------------------------------------------
+    static unsigned int getThreadNum()
+    {
+      unsigned int  num = std::thread::hardware_concurrency();
+      if (num == 0)
+        num = 1;
+      return num;
+    }
+    // -------------------------------------------------------------------------
+    // getTaskNum
+    // -------------------------------------------------------------------------
+    // Returns the number of tasks for inNum items, so that each task has at
+    // least inMinTaskSize items (inMaxTaskNum == 0 : the number of cores)
+    static unsigned int getTaskNum(size_t inNum, size_t inMinTaskSize,
+                                   unsigned int inMaxTaskNum = 0)
+    {
+      if (inMaxTaskNum == 0)
+        inMaxTaskNum = getThreadNum();
+      if (inMinTaskSize == 0)
+        inMinTaskSize = 1;
+      size_t  num = inNum / inMinTaskSize;
+      if (num > inMaxTaskNum)
+        num = inMaxTaskNum;
+      if (num == 0)
+        num = 1;
+      return (unsigned int )num;
+    }
+    // -------------------------------------------------------------------------
+    // getTaskRange
+    // -------------------------------------------------------------------------
+    static void getTaskRange(size_t inNum, unsigned int inTaskNum, unsigned int inTaskIndex,
+                             size_t *outBegin, size_t *outEnd)
+    {
+      *outBegin = (inNum * inTaskIndex) / inTaskNum;
+      *outEnd   = (inNum * (inTaskIndex + 1)) / inTaskNum;
+    }
+    // -------------------------------------------------------------------------
+    // forEachTask
+    // -------------------------------------------------------------------------
+    // Calls inFunc(taskIndex, begin, end) for each task and waits for all.
+    template <typename FuncType>
+    static void forEachTask(size_t inNum, unsigned int inTaskNum, FuncType inFunc)
+    {
+      if (inTaskNum <= 1)
+      {
+        inFunc(0u, (size_t )0, inNum);
+        return;
+      }
+      std::vector<std::thread>  threads;
+      threads.reserve(inTaskNum - 1);
+      for (unsigned int i = 1; i < inTaskNum; i++)
+      {
+        size_t  begin, end;
+        getTaskRange(inNum, inTaskNum, i, &begin, &end);
+        threads.emplace_back(inFunc, i, begin, end);
+      }
+      size_t  begin, end;
+      getTaskRange(inNum, inTaskNum, 0, &begin, &end);
+      inFunc(0u, begin, end);
+      for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+    }
+    // -------------------------------------------------------------------------
+    // forEach
+    // -------------------------------------------------------------------------
+    // Calls inFunc(begin, end) in parallel (the task number is automatic)
+    template <typename FuncType>
+    static void forEach(size_t inNum, size_t inMinTaskSize, FuncType inFunc)
+    {
+      unsigned int  taskNum = getTaskNum(inNum, inMinTaskSize);
+      forEachTask(inNum, taskNum,
+        [&inFunc](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          inFunc(inBegin, inEnd);
+        });
+    }
+    // -------------------------------------------------------------------------
+    // sort
+    // -------------------------------------------------------------------------
+    // Sorts the tasks in parallel, then merges the neighboring sorted runs in
+    // parallel (log2(task number) rounds). Not stable.
+    template <typename IteratorType, typename CompareType>
+    static void sort(IteratorType inBegin, IteratorType inEnd, CompareType inComp,
+                     size_t inMinTaskSize = 64 * 1024, unsigned int inTaskNum = 0)
+    {
+      size_t  num = (size_t )(inEnd - inBegin);
+      if (inTaskNum == 0)
+        inTaskNum = getTaskNum(num, inMinTaskSize);
+      forEachTask(num, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inTaskBegin, size_t inTaskEnd)
+        {
+          UNUSED(inTaskIndex);
+          std::sort(inBegin + inTaskBegin, inBegin + inTaskEnd, inComp);
+        });
+      for (unsigned int width = 1; width < inTaskNum; width *= 2)
+      {
+        unsigned int  mergeNum = (inTaskNum + width * 2 - 1) / (width * 2);
+        forEachTask(mergeNum, mergeNum,
+          [&](unsigned int inTaskIndex, size_t inMergeBegin, size_t inMergeEnd)
+          {
+            UNUSED(inTaskIndex);
+            for (size_t i = inMergeBegin; i < inMergeEnd; i++)
+            {
+              unsigned int  task0 = (unsigned int )(i * width * 2);
+              unsigned int  task1 = task0 + width;
+              if (task1 >= inTaskNum)
+                continue;
+              unsigned int  task2 = std::min(task1 + width, inTaskNum);
+              size_t  begin, middle, end, dummy;
+              getTaskRange(num, inTaskNum, task0, &begin, &dummy);
+              getTaskRange(num, inTaskNum, task1, &middle, &dummy);
+              getTaskRange(num, inTaskNum, task2 - 1, &dummy, &end);
+              std::inplace_merge(inBegin + begin, inBegin + middle, inBegin + end, inComp);
+            }
+          });
+      }
+    }
+  };
+};
+
+#endif  // #ifdef IBC_PARALLEL_H_
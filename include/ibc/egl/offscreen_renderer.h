@@ -0,0 +1,651 @@
+// =============================================================================
+//  offscreen_renderer.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/egl/offscreen_renderer.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the headless (EGL) offscreen renderer
+*/
+// -----------------------------------------------------------------------------
+// Appendix
+//
+// Renders the models without a window (e.g. on the servers without a GPU).
+// The context is created on the Mesa surfaceless platform when it is
+// available (works with llvmpipe), otherwise on the default EGL display.
+// Link with -lEGL -lOpenGL (or -lGL)
+//
+// https://www.khronos.org/registry/EGL/extensions/MESA/EGL_MESA_platform_surfaceless.txt
+// https://developer.nvidia.com/blog/egl-eye-opengl-visualization-without-x-server/
+// -----------------------------------------------------------------------------
+
+#ifndef IBC_EGL_OFFSCREEN_RENDERER_H_
+#define IBC_EGL_OFFSCREEN_RENDERER_H_
+
+// Includes --------------------------------------------------------------------
+#include <stdio.h>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include "ibc/gl/matrix.h"
+#include "ibc/gl/model_interface.h"
+#include "ibc/gl/shader_interface.h"
+#include "ibc/gl/program_cache.h"
+#include "ibc/gl/frame_uniforms.h"
+#include "ibc/gl/state_tracker.h"
+#include "ibc/gl/async_pixel_reader.h"
+#include "ibc/image/image_buffer.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace egl
+ {
+  // ---------------------------------------------------------------------------
+  // OffscreenRenderer class
+  // ---------------------------------------------------------------------------
+  // The same model / shader lists as the GLView classes, drawn into a frame
+  // buffer object of an EGL context without a surface.
+  //
+  //  renderer.init(256, 256);
+  //  renderer.addShader(&shader);  renderer.addModel(&model);
+  //  renderer.initModels();
+  //  for (each scan)
+  //  {
+  //    model.setDataPtr(...);
+  //    renderer.render();
+  //    renderer.requestPixels(index);         // asynchronous
+  //    while (renderer.retrievePixels(&image, &index, false))
+  //      save(image, index);
+  //  }
+  //  while (renderer.retrievePixels(&image, &index)) save(image, index);
+  class OffscreenRenderer
+  {
+  public:
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // OffscreenRenderer
+    // -------------------------------------------------------------------------
+    OffscreenRenderer()
+    {
+      mDisplay = EGL_NO_DISPLAY;
+      mContext = EGL_NO_CONTEXT;
+      mSurface = EGL_NO_SURFACE;
+      mIsInitialized = false;
+      mIsModelsInitialized = false;
+      mWidth = 0;
+      mHeight = 0;
+      mSamples = 0;
+      mFrameBuffer = 0;
+      mColorBuffer = 0;
+      mDepthBuffer = 0;
+      mResolveFrameBuffer = 0;
+      mResolveColorBuffer = 0;
+      mRendererStr = NULL;
+      mVersionStr = NULL;
+      mClearColor[0] = 0.3f;
+      mClearColor[1] = 0.3f;
+      mClearColor[2] = 0.3f;
+      mClearColor[3] = 0.0f;
+
+      // Initialize mModelView and mProjection (Set identity matrix)
+      ibc::gl::MatrixBase<GLfloat> matrix;
+      matrix.setIdentity();
+      matrix.getTransposedMatrix(mGLModelView);
+      matrix.getTransposedMatrix(mGLProjection);
+    }
+    // -------------------------------------------------------------------------
+    // ~OffscreenRenderer
+    // -------------------------------------------------------------------------
+    virtual ~OffscreenRenderer()
+    {
+      dispose();
+    }
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // init
+    // -------------------------------------------------------------------------
+    // Creates the context (OpenGL 3.3 core) and the frame buffer, and makes
+    // the context current. inSamples > 0 : multisampled (resolved before
+    // reading the pixels)
+    bool init(int inWidth, int inHeight, int inSamples = 0, int inRingSize = 3)
+    {
+      if (mIsInitialized)
+        dispose();
+      if (initContext() == false)
+      {
+        disposeContext();
+        return false;
+      }
+      mIsInitialized = true;
+
+      mRendererStr = glGetString(GL_RENDERER);
+      mVersionStr = glGetString(GL_VERSION);
+
+      glEnable(GL_CULL_FACE);
+      glCullFace(GL_BACK);
+
+      glClearDepth(1.0);
+      glDepthFunc(GL_LESS);
+      glEnable(GL_DEPTH_TEST);
+
+      mFrameUniforms.init();
+      if (resize(inWidth, inHeight, inSamples, inRingSize) == false)
+      {
+        dispose();
+        return false;
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // dispose
+    // -------------------------------------------------------------------------
+    // Disposes the added models and shaders too (should be called before they
+    // are destroyed, if they are destroyed before this renderer)
+    void dispose()
+    {
+      if (mIsInitialized == false)
+        return;
+      makeCurrent();
+      disposeModels();
+      mPixelReader.dispose();
+      mFrameUniforms.dispose();
+      disposeFrameBuffer();
+      disposeContext();
+      mIsInitialized = false;
+    }
+    // -------------------------------------------------------------------------
+    // resize
+    // -------------------------------------------------------------------------
+    // The pending pixel requests are discarded
+    bool resize(int inWidth, int inHeight, int inSamples = 0, int inRingSize = 3)
+    {
+      if (mIsInitialized == false || inWidth <= 0 || inHeight <= 0)
+        return false;
+      makeCurrent();
+      disposeFrameBuffer();
+      mWidth = inWidth;
+      mHeight = inHeight;
+      mSamples = inSamples;
+      if (initFrameBuffer() == false)
+        return false;
+      return mPixelReader.init(mWidth, mHeight, inRingSize);
+    }
+    // -------------------------------------------------------------------------
+    // makeCurrent
+    // -------------------------------------------------------------------------
+    bool makeCurrent()
+    {
+      if (mContext == EGL_NO_CONTEXT)
+        return false;
+      if (eglGetCurrentContext() == mContext)
+        return true;
+      return (eglMakeCurrent(mDisplay, mSurface, mSurface, mContext) == EGL_TRUE);
+    }
+    // -------------------------------------------------------------------------
+    // addModel
+    // -------------------------------------------------------------------------
+    void  addModel(ibc::gl::ModelInterface *inModel)
+    {
+      mModelList.push_back(inModel);
+    }
+    // -------------------------------------------------------------------------
+    // removeModel
+    // -------------------------------------------------------------------------
+    void  removeModel(ibc::gl::ModelInterface *inModel)
+    {
+      auto it = std::find(mModelList.begin(), mModelList.end(), inModel);
+      if (it == mModelList.end())
+        return;
+      mModelList.erase(it);
+    }
+    // -------------------------------------------------------------------------
+    // addShader
+    // -------------------------------------------------------------------------
+    void  addShader(ibc::gl::ShaderInterface *inShader)
+    {
+      mShaderList.push_back(inShader);
+    }
+    // -------------------------------------------------------------------------
+    // removeShader
+    // -------------------------------------------------------------------------
+    void  removeShader(ibc::gl::ShaderInterface *inShader)
+    {
+      auto it = std::find(mShaderList.begin(), mShaderList.end(), inShader);
+      if (it == mShaderList.end())
+        return;
+      mShaderList.erase(it);
+    }
+    // -------------------------------------------------------------------------
+    // initModels
+    // -------------------------------------------------------------------------
+    // Initializes the added shaders and models (after init())
+    bool initModels()
+    {
+      if (makeCurrent() == false)
+        return false;
+      disposeModels();
+      ibc::gl::StateTracker::getInstance()->invalidate();
+      ibc::gl::ProgramRegistry::setCurrentShareGroup(mContext);
+      bool  result = true;
+      for (auto it = mShaderList.begin(); it != mShaderList.end(); it++)
+        if ((*it)->initShader() == false)
+          result = false;
+
+      for (auto it = mModelList.begin(); it != mModelList.end(); it++)
+        if ((*it)->initModel() == false)
+          result = false;
+      mIsModelsInitialized = true;
+      return result;
+    }
+    // -------------------------------------------------------------------------
+    // disposeModels
+    // -------------------------------------------------------------------------
+    void disposeModels()
+    {
+      if (mIsModelsInitialized == false)
+        return;
+      ibc::gl::StateTracker::getInstance()->invalidate();
+      for (auto it = mModelList.begin(); it != mModelList.end(); it++)
+        (*it)->disposeModel();
+
+      for (auto it = mShaderList.begin(); it != mShaderList.end(); it++)
+        (*it)->disposeShader();
+      mIsModelsInitialized = false;
+    }
+    // -------------------------------------------------------------------------
+    // setModelView
+    // -------------------------------------------------------------------------
+    void setModelView(const GLfloat inModelView[16])
+    {
+      memcpy(mGLModelView, inModelView, sizeof(mGLModelView));
+    }
+    // -------------------------------------------------------------------------
+    // setProjection
+    // -------------------------------------------------------------------------
+    void setProjection(const GLfloat inProjection[16])
+    {
+      memcpy(mGLProjection, inProjection, sizeof(mGLProjection));
+    }
+    // -------------------------------------------------------------------------
+    // setClearColor
+    // -------------------------------------------------------------------------
+    void setClearColor(GLfloat inR, GLfloat inG, GLfloat inB, GLfloat inA)
+    {
+      mClearColor[0] = inR;
+      mClearColor[1] = inG;
+      mClearColor[2] = inB;
+      mClearColor[3] = inA;
+    }
+    // -------------------------------------------------------------------------
+    // render
+    // -------------------------------------------------------------------------
+    // Draws the enabled models into the frame buffer
+    bool render()
+    {
+      if (mIsInitialized == false || makeCurrent() == false)
+        return false;
+      glBindFramebuffer(GL_FRAMEBUFFER, mFrameBuffer);
+      glViewport(0, 0, mWidth, mHeight);
+      ibc::gl::StateTracker::getInstance()->invalidate();
+      mFrameUniforms.update(mGLModelView, mGLProjection);
+
+      glClearColor(mClearColor[0], mClearColor[1], mClearColor[2], mClearColor[3]);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      for (auto it = mModelList.begin(); it != mModelList.end(); it++)
+        if ((*it)->isEnabled())
+          (*it)->drawModel(mGLModelView, mGLProjection);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // requestPixels
+    // -------------------------------------------------------------------------
+    // Starts reading the last rendered frame (see AsyncPixelReader::request).
+    // When the ring is full, the oldest frame should be retrieved first
+    bool requestPixels(int inTag = 0)
+    {
+      if (mIsInitialized == false || makeCurrent() == false)
+        return false;
+      bindReadFrameBuffer();
+      bool  result = mPixelReader.request(inTag);
+      glBindFramebuffer(GL_FRAMEBUFFER, mFrameBuffer);
+      return result;
+    }
+    // -------------------------------------------------------------------------
+    // retrievePixels
+    // -------------------------------------------------------------------------
+    // Copies the oldest requested frame into outImage (RGBA 8bit, top-down)
+    bool retrievePixels(ibc::image::ImageBuffer *outImage, int *outTag = NULL,
+                        bool inWait = true)
+    {
+      if (mIsInitialized == false || makeCurrent() == false)
+        return false;
+      return mPixelReader.retrieve(outImage, outTag, inWait);
+    }
+    // -------------------------------------------------------------------------
+    // readPixels
+    // -------------------------------------------------------------------------
+    // Synchronous version (doesn't touch the pending requests)
+    bool readPixels(ibc::image::ImageBuffer *outImage)
+    {
+      if (mIsInitialized == false || makeCurrent() == false)
+        return false;
+      ibc::image::ImageType  type(ibc::image::ImageType::PIXEL_TYPE_RGBA,
+                                  ibc::image::ImageType::BUFFER_TYPE_PIXEL_ALIGNED,
+                                  ibc::image::ImageType::DATA_TYPE_8BIT);
+      outImage->allocateImageBuffer(ibc::image::ImageFormat(type, mWidth, mHeight));
+      bindReadFrameBuffer();
+      glPixelStorei(GL_PACK_ALIGNMENT, 4);
+      for (int y = 0; y < mHeight; y++)   // top-down
+        glReadPixels(0, mHeight - 1 - y, mWidth, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                     outImage->getImageBufferLinePtr(y));
+      glBindFramebuffer(GL_FRAMEBUFFER, mFrameBuffer);
+      outImage->markAsImageModified();
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // getPendingPixelsNum
+    // -------------------------------------------------------------------------
+    size_t getPendingPixelsNum() const
+    {
+      return mPixelReader.getPendingNum();
+    }
+    // -------------------------------------------------------------------------
+    // getWidth
+    // -------------------------------------------------------------------------
+    int getWidth() const
+    {
+      return mWidth;
+    }
+    // -------------------------------------------------------------------------
+    // getHeight
+    // -------------------------------------------------------------------------
+    int getHeight() const
+    {
+      return mHeight;
+    }
+    // -------------------------------------------------------------------------
+    // getRendererStr
+    // -------------------------------------------------------------------------
+    const GLubyte *getRendererStr() const
+    {
+      return mRendererStr;
+    }
+    // -------------------------------------------------------------------------
+    // getVersionStr
+    // -------------------------------------------------------------------------
+    const GLubyte *getVersionStr() const
+    {
+      return mVersionStr;
+    }
+
+    // Member variables --------------------------------------------------------
+    GLfloat mGLModelView[16], mGLProjection[16];
+    ibc::gl::FrameUniforms  mFrameUniforms; // the matrices and the light for the shaders
+
+  protected:
+    // Member variables --------------------------------------------------------
+    EGLDisplay  mDisplay;
+    EGLContext  mContext;
+    EGLSurface  mSurface;   // EGL_NO_SURFACE, or a 1x1 pbuffer (no surfaceless)
+    bool  mIsInitialized;
+    bool  mIsModelsInitialized;
+
+    int     mWidth;
+    int     mHeight;
+    int     mSamples;
+    GLuint  mFrameBuffer;
+    GLuint  mColorBuffer;
+    GLuint  mDepthBuffer;
+    GLuint  mResolveFrameBuffer;  // for the multisampled frame buffer
+    GLuint  mResolveColorBuffer;
+    GLfloat mClearColor[4];
+
+    const GLubyte *mRendererStr;
+    const GLubyte *mVersionStr;
+
+    std::vector<ibc::gl::ShaderInterface *>   mShaderList;
+    std::vector<ibc::gl::ModelInterface *>    mModelList;
+    ibc::gl::AsyncPixelReader mPixelReader;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // initContext
+    // -------------------------------------------------------------------------
+    bool initContext()
+    {
+      const char *clientExts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+      PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC )eglGetProcAddress("eglGetPlatformDisplayEXT");
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+      if (getPlatformDisplay != NULL && hasExtension(clientExts, "EGL_MESA_platform_surfaceless"))
+        mDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#else
+      UNUSED(clientExts);
+      UNUSED(getPlatformDisplay);
+#endif
+      if (mDisplay == EGL_NO_DISPLAY)
+        mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+      if (mDisplay == EGL_NO_DISPLAY)
+      {
+        printf("Error: no EGL display\n");
+        return false;
+      }
+      EGLint  major, minor;
+      if (eglInitialize(mDisplay, &major, &minor) == EGL_FALSE)
+      {
+        printf("Error: eglInitialize() failed (0x%x)\n", eglGetError());
+        mDisplay = EGL_NO_DISPLAY;
+        return false;
+      }
+      if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE)
+      {
+        printf("Error: EGL doesn't support OpenGL\n");
+        return false;
+      }
+
+      // The pbuffer is only used when the surfaceless context isn't supported
+      const char *displayExts = eglQueryString(mDisplay, EGL_EXTENSIONS);
+      bool  isSurfaceless = hasExtension(displayExts, "EGL_KHR_surfaceless_context");
+      static const EGLint configAttribs[] =
+      {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+      };
+      EGLConfig config = NULL;
+      EGLint  configNum = 0;
+      if (eglChooseConfig(mDisplay, configAttribs, &config, 1, &configNum) == EGL_FALSE ||
+          configNum == 0)
+      {
+        config = NULL;
+        if (isSurfaceless == false ||
+            hasExtension(displayExts, "EGL_KHR_no_config_context") == false)
+        {
+          printf("Error: no EGL config for OpenGL\n");
+          return false;
+        }
+      }
+      // The core profile (the shaders and the models skip the legacy enables
+      // in it, see StateTracker::isCoreProfile())
+      static const EGLint contextAttribs[] =
+      {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+      };
+      mContext = eglCreateContext(mDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+      if (mContext == EGL_NO_CONTEXT)
+      {
+        printf("Error: eglCreateContext() failed (0x%x)\n", eglGetError());
+        return false;
+      }
+      if (isSurfaceless == false)
+      {
+        static const EGLint pbufferAttribs[] =
+        {
+          EGL_WIDTH, 1,
+          EGL_HEIGHT, 1,
+          EGL_NONE
+        };
+        mSurface = eglCreatePbufferSurface(mDisplay, config, pbufferAttribs);
+        if (mSurface == EGL_NO_SURFACE)
+        {
+          printf("Error: eglCreatePbufferSurface() failed (0x%x)\n", eglGetError());
+          return false;
+        }
+      }
+      if (eglMakeCurrent(mDisplay, mSurface, mSurface, mContext) == EGL_FALSE)
+      {
+        printf("Error: eglMakeCurrent() failed (0x%x)\n", eglGetError());
+        return false;
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // disposeContext
+    // -------------------------------------------------------------------------
+    void disposeContext()
+    {
+      if (mDisplay == EGL_NO_DISPLAY)
+        return;
+      eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      if (mSurface != EGL_NO_SURFACE)
+        eglDestroySurface(mDisplay, mSurface);
+      if (mContext != EGL_NO_CONTEXT)
+        eglDestroyContext(mDisplay, mContext);
+      // eglTerminate() is not called, the display is shared by the other
+      // renderers of the process
+      mSurface = EGL_NO_SURFACE;
+      mContext = EGL_NO_CONTEXT;
+      mDisplay = EGL_NO_DISPLAY;
+    }
+    // -------------------------------------------------------------------------
+    // initFrameBuffer
+    // -------------------------------------------------------------------------
+    bool initFrameBuffer()
+    {
+      glGenRenderbuffers(1, &mColorBuffer);
+      glBindRenderbuffer(GL_RENDERBUFFER, mColorBuffer);
+      if (mSamples > 0)
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, mSamples, GL_RGBA8, mWidth, mHeight);
+      else
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, mWidth, mHeight);
+      glGenRenderbuffers(1, &mDepthBuffer);
+      glBindRenderbuffer(GL_RENDERBUFFER, mDepthBuffer);
+      if (mSamples > 0)
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, mSamples, GL_DEPTH_COMPONENT24, mWidth, mHeight);
+      else
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mWidth, mHeight);
+      glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+      glGenFramebuffers(1, &mFrameBuffer);
+      glBindFramebuffer(GL_FRAMEBUFFER, mFrameBuffer);
+      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColorBuffer);
+      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthBuffer);
+      if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+      {
+        printf("Error: the frame buffer is not complete\n");
+        return false;
+      }
+      if (mSamples > 0)
+      {
+        glGenRenderbuffers(1, &mResolveColorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, mResolveColorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, mWidth, mHeight);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glGenFramebuffers(1, &mResolveFrameBuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, mResolveFrameBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mResolveColorBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+          printf("Error: the resolve frame buffer is not complete\n");
+          return false;
+        }
+      }
+      glBindFramebuffer(GL_FRAMEBUFFER, mFrameBuffer);
+      glViewport(0, 0, mWidth, mHeight);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // disposeFrameBuffer
+    // -------------------------------------------------------------------------
+    void disposeFrameBuffer()
+    {
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      if (mFrameBuffer != 0)
+        glDeleteFramebuffers(1, &mFrameBuffer);
+      if (mColorBuffer != 0)
+        glDeleteRenderbuffers(1, &mColorBuffer);
+      if (mDepthBuffer != 0)
+        glDeleteRenderbuffers(1, &mDepthBuffer);
+      if (mResolveFrameBuffer != 0)
+        glDeleteFramebuffers(1, &mResolveFrameBuffer);
+      if (mResolveColorBuffer != 0)
+        glDeleteRenderbuffers(1, &mResolveColorBuffer);
+      mFrameBuffer = 0;
+      mColorBuffer = 0;
+      mDepthBuffer = 0;
+      mResolveFrameBuffer = 0;
+      mResolveColorBuffer = 0;
+    }
+    // -------------------------------------------------------------------------
+    // bindReadFrameBuffer
+    // -------------------------------------------------------------------------
+    // Binds the single sampled frame buffer to GL_READ_FRAMEBUFFER
+    // (resolves the multisampled one)
+    void bindReadFrameBuffer()
+    {
+      if (mSamples <= 0)
+      {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, mFrameBuffer);
+        return;
+      }
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, mFrameBuffer);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mResolveFrameBuffer);
+      glBlitFramebuffer(0, 0, mWidth, mHeight, 0, 0, mWidth, mHeight,
+                        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, mResolveFrameBuffer);
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // hasExtension
+    // -------------------------------------------------------------------------
+    static bool hasExtension(const char *inExtensions, const char *inName)
+    {
+      if (inExtensions == NULL)
+        return false;
+      size_t  len = strlen(inName);
+      const char *p = inExtensions;
+      while ((p = strstr(p, inName)) != NULL)
+      {
+        if ((p == inExtensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == 0))
+          return true;
+        p += len;
+      }
+      return false;
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_EGL_OFFSCREEN_RENDERER_H_
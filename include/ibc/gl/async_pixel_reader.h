@@ -0,0 +1,282 @@
+// =============================================================================
+//  async_pixel_reader.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/async_pixel_reader.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the asynchronous glReadPixels (PBO ring)
+*/
+
+#ifndef IBC_GL_ASYNC_PIXEL_READER_H_
+#define IBC_GL_ASYNC_PIXEL_READER_H_
+
+// Includes --------------------------------------------------------------------
+#include <cstring>
+#include <vector>
+#include "ibc/base/types.h"
+#include "ibc/image/image_buffer.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // AsyncPixelReader class
+  // ---------------------------------------------------------------------------
+  // Reads the frame buffer into a ring of pixel buffer objects. request()
+  // returns immediately (the copy runs on the GPU side) and retrieve() maps
+  // the oldest buffer after its fence is signaled, so the CPU can render the
+  // next frames while the previous ones are transferred.
+  // The pixels are RGBA 8bit. The rows are flipped to top-down when they are
+  // copied into the ImageBuffer.
+#ifndef QT_VERSION
+  class AsyncPixelReader
+#else
+  class AsyncPixelReader : protected IBC_QOPENGL_CLASS_NAME
+#endif
+  {
+  public:
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // AsyncPixelReader
+    // -------------------------------------------------------------------------
+    AsyncPixelReader()
+    {
+      mIsInitialized = false;
+      mWidth = 0;
+      mHeight = 0;
+      mHead = 0;
+      mPendingNum = 0;
+#ifdef QT_VERSION
+      mOpenGLFunctionsInitialized = false;
+#endif
+    }
+    // -------------------------------------------------------------------------
+    // ~AsyncPixelReader
+    // -------------------------------------------------------------------------
+    virtual ~AsyncPixelReader()
+    {
+    }
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // init
+    // -------------------------------------------------------------------------
+    // Should be called with the GL context current
+    // inRingSize : the number of the frames in flight
+    bool init(int inWidth, int inHeight, int inRingSize = 3)
+    {
+#ifdef QT_VERSION
+      if (mOpenGLFunctionsInitialized == false)
+      {
+        initializeOpenGLFunctions();
+        mOpenGLFunctionsInitialized = true;
+      }
+#endif
+      if (mIsInitialized)
+        dispose();
+      if (inWidth <= 0 || inHeight <= 0 || inRingSize <= 0)
+        return false;
+      mWidth = inWidth;
+      mHeight = inHeight;
+      mSlots.resize(inRingSize);
+      for (size_t i = 0; i < mSlots.size(); i++)
+      {
+        glGenBuffers(1, &(mSlots[i].buffer));
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, mSlots[i].buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, getFrameSize(), NULL, GL_STREAM_READ);
+        mSlots[i].fence = NULL;
+        mSlots[i].tag = 0;
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      mHead = 0;
+      mPendingNum = 0;
+      mIsInitialized = true;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // dispose
+    // -------------------------------------------------------------------------
+    // The pending frames are discarded
+    void dispose()
+    {
+      if (mIsInitialized == false)
+        return;
+      for (size_t i = 0; i < mSlots.size(); i++)
+      {
+        if (mSlots[i].fence != NULL)
+          glDeleteSync(mSlots[i].fence);
+        glDeleteBuffers(1, &(mSlots[i].buffer));
+      }
+      mSlots.clear();
+      mWidth = 0;
+      mHeight = 0;
+      mPendingNum = 0;
+      mIsInitialized = false;
+    }
+    // -------------------------------------------------------------------------
+    // request
+    // -------------------------------------------------------------------------
+    // Starts reading the current read frame buffer (init() size from 0, 0).
+    // inTag is returned by retrieve() with the frame (e.g. the scan index).
+    // Returns false if the ring is full (retrieve() the oldest one first)
+    bool request(int inTag = 0)
+    {
+      if (mIsInitialized == false || isFull())
+        return false;
+      Slot  &slot = mSlots[mHead];
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+      glPixelStorei(GL_PACK_ALIGNMENT, 4);
+      glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      slot.tag = inTag;
+      mHead = (mHead + 1) % mSlots.size();
+      mPendingNum++;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // isReady
+    // -------------------------------------------------------------------------
+    // true if the oldest frame can be retrieved without waiting
+    bool isReady()
+    {
+      if (mPendingNum == 0)
+        return false;
+      Slot  &slot = mSlots[getTail()];
+      GLenum  result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+      return (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED);
+    }
+    // -------------------------------------------------------------------------
+    // retrieve
+    // -------------------------------------------------------------------------
+    // Copies the oldest frame into outImage (allocated as RGBA 8bit).
+    // Returns false if there is no pending frame, or inWait is false and the
+    // frame is not ready yet, or the wait failed (the frame is dropped)
+    bool retrieve(ibc::image::ImageBuffer *outImage, int *outTag = NULL, bool inWait = true)
+    {
+      if (mPendingNum == 0)
+        return false;
+      if (inWait == false && isReady() == false)
+        return false;
+      Slot  &slot = mSlots[getTail()];
+      GLenum  waitResult;
+      do
+      {
+        waitResult = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      WAIT_TIMEOUT_NS);
+      }
+      while (waitResult == GL_TIMEOUT_EXPIRED);
+      glDeleteSync(slot.fence);
+      slot.fence = NULL;
+      mPendingNum--;
+      if (outTag != NULL)
+        *outTag = slot.tag;
+      if (waitResult == GL_WAIT_FAILED)
+        return false;   // the frame is dropped (the PBO may not be written)
+
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+      const unsigned char *src = (const unsigned char *)
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, getFrameSize(), GL_MAP_READ_BIT);
+      bool  result = false;
+      if (src != NULL)
+      {
+        ibc::image::ImageType  type(ibc::image::ImageType::PIXEL_TYPE_RGBA,
+                                    ibc::image::ImageType::BUFFER_TYPE_PIXEL_ALIGNED,
+                                    ibc::image::ImageType::DATA_TYPE_8BIT);
+        ibc::image::ImageFormat  format(type, mWidth, mHeight);
+        outImage->allocateImageBuffer(format);
+        size_t  lineSize = (size_t )mWidth * 4;
+        for (int y = 0; y < mHeight; y++)
+          memcpy(outImage->getImageBufferLinePtr(y),
+                 src + lineSize * (mHeight - 1 - y), lineSize);
+        outImage->markAsImageModified();
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        result = true;
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      return result;
+    }
+    // -------------------------------------------------------------------------
+    // getPendingNum
+    // -------------------------------------------------------------------------
+    size_t getPendingNum() const
+    {
+      return mPendingNum;
+    }
+    // -------------------------------------------------------------------------
+    // isFull
+    // -------------------------------------------------------------------------
+    bool isFull() const
+    {
+      return mPendingNum >= mSlots.size();
+    }
+    // -------------------------------------------------------------------------
+    // getWidth
+    // -------------------------------------------------------------------------
+    int getWidth() const
+    {
+      return mWidth;
+    }
+    // -------------------------------------------------------------------------
+    // getHeight
+    // -------------------------------------------------------------------------
+    int getHeight() const
+    {
+      return mHeight;
+    }
+
+  protected:
+    // Constants ---------------------------------------------------------------
+    static const GLuint64 WAIT_TIMEOUT_NS = 100000000;   // 100ms per wait
+
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      GLuint  buffer;
+      GLsync  fence;
+      int     tag;
+    } Slot;
+
+    // Member variables --------------------------------------------------------
+    bool    mIsInitialized;
+    int     mWidth;
+    int     mHeight;
+    std::vector<Slot> mSlots;
+    size_t  mHead;        // the next slot to request
+    size_t  mPendingNum;
+#ifdef QT_VERSION
+    bool  mOpenGLFunctionsInitialized;
+#endif
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getTail
+    // -------------------------------------------------------------------------
+    size_t getTail() const
+    {
+      return (mHead + mSlots.size() - mPendingNum) % mSlots.size();
+    }
+    // -------------------------------------------------------------------------
+    // getFrameSize
+    // -------------------------------------------------------------------------
+    GLsizeiptr getFrameSize() const
+    {
+      return (GLsizeiptr )mWidth * mHeight * 4;
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_ASYNC_PIXEL_READER_H_
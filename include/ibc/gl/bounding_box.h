@@ -0,0 +1,283 @@
+// =============================================================================
+//  bounding_box.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/bounding_box.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the bounding box (AABB) calculation
+*/
+
+#ifndef IBC_GL_BOUNDING_BOX_H_
+#define IBC_GL_BOUNDING_BOX_H_
+
+// Includes --------------------------------------------------------------------
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include "ibc/base/types.h"
+#include "ibc/base/parallel.h"
+
+// Macros ----------------------------------------------------------------------
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define IBC_GL_BOUNDING_BOX_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // BoundingBox class
+  // ---------------------------------------------------------------------------
+  // All the functions take the strided xyz array, so that any of the vertex
+  // structs in ibc/gl/data.h (x, y, z at the top) can be passed as is.
+  // The min max array is {x_min, x_max, y_min, y_max, z_min, z_max}.
+  class BoundingBox
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static const size_t  MIN_TASK_SIZE  = 256 * 1024;  // points per thread
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // calcMinMax
+    // -------------------------------------------------------------------------
+    // NaN points are ignored. Returns false if there is no valid point.
+    // (inTaskNum == 0 : the task number is decided from the data size)
+    static bool calcMinMax(const void *inDataPtr, size_t inDataNum, size_t inStride,
+                           GLfloat outMinMax[6], unsigned int inTaskNum = 0)
+    {
+      initMinMax(outMinMax);
+      if (inDataPtr == NULL || inDataNum == 0)
+        return false;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inDataNum, MIN_TASK_SIZE);
+      //
+      std::vector<GLfloat>  partial(inTaskNum * 6);
+      Parallel::forEachTask(inDataNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          calcMinMaxKernel((const unsigned char *)inDataPtr, inBegin, inEnd,
+                           inDataNum, inStride, &(partial[inTaskIndex * 6]));
+        });
+      for (unsigned int i = 0; i < inTaskNum; i++)
+        mergeMinMax(&(partial[i * 6]), outMinMax);
+      //
+      return isValidMinMax(outMinMax);
+    }
+    // -------------------------------------------------------------------------
+    // calcMinMax
+    // -------------------------------------------------------------------------
+    template <typename DataType>
+    static bool calcMinMax(const DataType *inDataPtr, size_t inDataNum,
+                           GLfloat outMinMax[6], unsigned int inTaskNum = 0)
+    {
+      return calcMinMax((const void *)inDataPtr, inDataNum, sizeof(DataType),
+                        outMinMax, inTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // calcRobustMinMax
+    // -------------------------------------------------------------------------
+    // Percentile clipped bounds for the noisy scans
+    // (e.g. inLowerPercent = 1.0, inUpperPercent = 99.0)
+    // If inDataNum > inMaxSampleNum, the points are sampled at a fixed interval.
+    static bool calcRobustMinMax(const void *inDataPtr, size_t inDataNum, size_t inStride,
+                                 double inLowerPercent, double inUpperPercent,
+                                 GLfloat outMinMax[6], size_t inMaxSampleNum = 1024 * 1024)
+    {
+      initMinMax(outMinMax);
+      if (inDataPtr == NULL || inDataNum == 0 || inMaxSampleNum == 0)
+        return false;
+      if (inLowerPercent < 0.0)
+        inLowerPercent = 0.0;
+      if (inUpperPercent > 100.0)
+        inUpperPercent = 100.0;
+      if (inLowerPercent > inUpperPercent)
+        return false;
+      //
+      size_t  step = (inDataNum + inMaxSampleNum - 1) / inMaxSampleNum;
+      std::vector<GLfloat>  values;
+      values.reserve(inDataNum / step + 1);
+      for (int axis = 0; axis < 3; axis++)
+      {
+        values.clear();
+        const unsigned char *ptr = ((const unsigned char *)inDataPtr) + sizeof(GLfloat) * axis;
+        for (size_t i = 0; i < inDataNum; i += step)
+        {
+          GLfloat v;
+          ::memcpy(&v, ptr + inStride * i, sizeof(GLfloat));
+          if (std::isnan(v) == false)
+            values.push_back(v);
+        }
+        if (values.size() == 0)
+          return false;
+        size_t  last = values.size() - 1;
+        size_t  lower = (size_t )(last * inLowerPercent / 100.0 + 0.5);
+        size_t  upper = (size_t )(last * inUpperPercent / 100.0 + 0.5);
+        std::nth_element(values.begin(), values.begin() + lower, values.end());
+        outMinMax[axis * 2]     = values[lower];
+        std::nth_element(values.begin() + lower, values.begin() + upper, values.end());
+        outMinMax[axis * 2 + 1] = values[upper];
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // calcFitParam
+    // -------------------------------------------------------------------------
+    // The fit parameter used by the point cloud shaders
+    // (translate to the center, then scale the longest side to 2.0)
+    static void calcFitParam(const GLfloat inMinMax[6], GLfloat outParam[4])
+    {
+      GLfloat size_x = inMinMax[1] - inMinMax[0];
+      GLfloat size_y = inMinMax[3] - inMinMax[2];
+      GLfloat size_z = inMinMax[5] - inMinMax[4];
+      GLfloat size_max = size_x;
+      if (size_y > size_max)
+        size_max = size_y;
+      if (size_z > size_max)
+        size_max = size_z;
+      //
+      outParam[0] = -1.0 * (inMinMax[0] + size_x / 2.0);
+      outParam[1] = -1.0 * (inMinMax[2] + size_y / 2.0);
+      outParam[2] = -1.0 * (inMinMax[4] + size_z / 2.0);
+      if (size_max != 0)
+        outParam[3] = 2.0 / size_max;
+      else
+        outParam[3] = 1.0;
+    }
+    // -------------------------------------------------------------------------
+    // initMinMax
+    // -------------------------------------------------------------------------
+    static void initMinMax(GLfloat outMinMax[6])
+    {
+      for (int i = 0; i < 3; i++)
+      {
+        outMinMax[i * 2]     =  std::numeric_limits<GLfloat>::infinity();
+        outMinMax[i * 2 + 1] = -std::numeric_limits<GLfloat>::infinity();
+      }
+    }
+    // -------------------------------------------------------------------------
+    // updateMinMax
+    // -------------------------------------------------------------------------
+    static void updateMinMax(GLfloat inX, GLfloat inY, GLfloat inZ, GLfloat ioMinMax[6])
+    {
+      // Written as (v < min) so that NaN doesn't update anything
+      if (inX < ioMinMax[0])
+        ioMinMax[0] = inX;
+      if (inX > ioMinMax[1])
+        ioMinMax[1] = inX;
+      if (inY < ioMinMax[2])
+        ioMinMax[2] = inY;
+      if (inY > ioMinMax[3])
+        ioMinMax[3] = inY;
+      if (inZ < ioMinMax[4])
+        ioMinMax[4] = inZ;
+      if (inZ > ioMinMax[5])
+        ioMinMax[5] = inZ;
+    }
+    // -------------------------------------------------------------------------
+    // mergeMinMax
+    // -------------------------------------------------------------------------
+    static void mergeMinMax(const GLfloat inMinMax[6], GLfloat ioMinMax[6])
+    {
+      for (int i = 0; i < 3; i++)
+      {
+        if (inMinMax[i * 2] < ioMinMax[i * 2])
+          ioMinMax[i * 2] = inMinMax[i * 2];
+        if (inMinMax[i * 2 + 1] > ioMinMax[i * 2 + 1])
+          ioMinMax[i * 2 + 1] = inMinMax[i * 2 + 1];
+      }
+    }
+    // -------------------------------------------------------------------------
+    // isValidMinMax
+    // -------------------------------------------------------------------------
+    static bool isValidMinMax(const GLfloat inMinMax[6])
+    {
+      for (int i = 0; i < 3; i++)
+        if (!(inMinMax[i * 2] <= inMinMax[i * 2 + 1]))
+          return false;
+      return true;
+    }
+
+  protected:
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // calcMinMaxKernel
+    // -------------------------------------------------------------------------
+    // Processes [inBegin, inEnd) of the array which has inDataNum points
+    static void calcMinMaxKernel(const unsigned char *inDataPtr,
+                                 size_t inBegin, size_t inEnd,
+                                 size_t inDataNum, size_t inStride,
+                                 GLfloat outMinMax[6])
+    {
+      initMinMax(outMinMax);
+#ifdef IBC_GL_BOUNDING_BOX_USE_SSE
+      // One point (x, y, z, <don't care>) per SSE register.
+      // 16 bytes are loaded for each point, so the last point is handled
+      // by the scalar code if the stride is shorter than 16 bytes.
+      size_t  vectorEnd = inEnd;
+      if (inStride < 16 && vectorEnd == inDataNum)
+        vectorEnd--;
+      __m128  min0 = _mm_set1_ps(std::numeric_limits<GLfloat>::infinity());
+      __m128  max0 = _mm_set1_ps(-std::numeric_limits<GLfloat>::infinity());
+      __m128  min1 = min0;
+      __m128  max1 = max0;
+      const unsigned char *ptr = inDataPtr + inStride * inBegin;
+      size_t  i = inBegin;
+      // _mm_min_ps(a, b) returns b if a is NaN, so NaN points are skipped
+      for (; i + 2 <= vectorEnd; i += 2)
+      {
+        __m128  v0 = _mm_loadu_ps((const float *)ptr);
+        __m128  v1 = _mm_loadu_ps((const float *)(ptr + inStride));
+        min0 = _mm_min_ps(v0, min0);
+        max0 = _mm_max_ps(v0, max0);
+        min1 = _mm_min_ps(v1, min1);
+        max1 = _mm_max_ps(v1, max1);
+        ptr += inStride * 2;
+      }
+      for (; i < vectorEnd; i++)
+      {
+        __m128  v0 = _mm_loadu_ps((const float *)ptr);
+        min0 = _mm_min_ps(v0, min0);
+        max0 = _mm_max_ps(v0, max0);
+        ptr += inStride;
+      }
+      min0 = _mm_min_ps(min0, min1);
+      max0 = _mm_max_ps(max0, max1);
+      float minValues[4], maxValues[4];
+      _mm_storeu_ps(minValues, min0);
+      _mm_storeu_ps(maxValues, max0);
+      for (int j = 0; j < 3; j++)
+      {
+        outMinMax[j * 2]     = minValues[j];
+        outMinMax[j * 2 + 1] = maxValues[j];
+      }
+      inBegin = i;
+#endif
+      for (size_t i = inBegin; i < inEnd; i++)
+      {
+        GLfloat xyz[3];
+        ::memcpy(xyz, inDataPtr + inStride * i, sizeof(xyz));
+        updateMinMax(xyz[0], xyz[1], xyz[2], outMinMax);
+      }
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_BOUNDING_BOX_H_
@@ -130,6 +130,34 @@ namespace ibc
     //
     GLubyte i;
   } glXYZ_NORMf_Iub;
+  //
+  // Quantized point (12 bytes)
+  // x, y, z : 16bit snorm relative to the chunk (see glQuantizedChunk)
+  // nx, ny  : octahedral encoded normal
+  typedef struct
+  {
+    GLshort x;
+    GLshort y;
+    GLshort z;
+    //
+    GLubyte nx;
+    GLubyte ny;
+    //
+    GLubyte r;
+    GLubyte g;
+    GLubyte b;
+    GLubyte a;
+  } glXYZs_NORMoct_RGBAub;
+  //
+  // The points [first, first + count) are decoded as
+  // position = origin + (x, y, z) / 32767 * scale
+  typedef struct
+  {
+    GLuint  first;
+    GLuint  count;
+    GLfloat origin[3];
+    GLfloat scale;
+  } glQuantizedChunk;
   // ---------------------------------------------------------------------------
   // Typedefs (classes)
   // ---------------------------------------------------------------------------
@@ -142,6 +170,41 @@ namespace ibc
   typedef std::vector<glXYZ_NORMf_RGBAub> glDataXYZ_NORMf_RGBub;
   typedef std::vector<glXYZ_NORM_If>      glDataXYZ_NORM_If;
   typedef std::vector<glXYZ_NORMf_Iub>    glDataXYZ_NORMf_Iub;
+  typedef std::vector<glXYZs_NORMoct_RGBAub> glDataXYZs_NORMoct_RGBAub;
+  //
+  // Polygon indices in the CSR (compressed sparse row) form
+  // The indices of the i-th face are indices[offsets[i]] ... indices[offsets[i+1] - 1]
+  // (offsets.size() == face number + 1)
+  typedef struct
+  {
+    std::vector<GLuint> offsets;
+    std::vector<GLuint> indices;
+  } glFacesCSR;
+  // ---------------------------------------------------------------------------
+  // Vertex traits
+  // ---------------------------------------------------------------------------
+  // The layout of the float vertex structs for the generic point algorithms:
+  // FLOAT_NUM GLfloat (x, y, z at the top), then UBYTE_NUM GLubyte.
+  // NORMAL_OFFSET is the GLfloat index of nx (-1 : no normal)
+  template <typename DataType> struct VertexTraits;
+  template <> struct VertexTraits<glXYZf>
+    { enum { FLOAT_NUM = 3, UBYTE_NUM = 0, NORMAL_OFFSET = -1 }; };
+  template <> struct VertexTraits<glXYZ_RGBf>
+    { enum { FLOAT_NUM = 6, UBYTE_NUM = 0, NORMAL_OFFSET = -1 }; };
+  template <> struct VertexTraits<glXYZ_If>
+    { enum { FLOAT_NUM = 4, UBYTE_NUM = 0, NORMAL_OFFSET = -1 }; };
+  template <> struct VertexTraits<glXYZ_NORM_RGBf>
+    { enum { FLOAT_NUM = 9, UBYTE_NUM = 0, NORMAL_OFFSET = 3 }; };
+  template <> struct VertexTraits<glXYZ_NORM_If>
+    { enum { FLOAT_NUM = 7, UBYTE_NUM = 0, NORMAL_OFFSET = 3 }; };
+  template <> struct VertexTraits<glXYZf_RGBAub>
+    { enum { FLOAT_NUM = 3, UBYTE_NUM = 4, NORMAL_OFFSET = -1 }; };
+  template <> struct VertexTraits<glXYZ_NORMf_RGBAub>
+    { enum { FLOAT_NUM = 6, UBYTE_NUM = 4, NORMAL_OFFSET = 3 }; };
+  template <> struct VertexTraits<glXYZf_Iub>
+    { enum { FLOAT_NUM = 3, UBYTE_NUM = 1, NORMAL_OFFSET = -1 }; };
+  template <> struct VertexTraits<glXYZ_NORMf_Iub>
+    { enum { FLOAT_NUM = 6, UBYTE_NUM = 1, NORMAL_OFFSET = 3 }; };
  };
 };
 
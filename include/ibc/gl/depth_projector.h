@@ -0,0 +1,507 @@
+// =============================================================================
+//  depth_projector.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/depth_projector.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the back projection of the depth images
+*/
+
+#ifndef IBC_GL_DEPTH_PROJECTOR_H_
+#define IBC_GL_DEPTH_PROJECTOR_H_
+
+// Includes --------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "ibc/base/types.h"
+#include "ibc/base/parallel.h"
+#include "ibc/image/image_buffer.h"
+#include "ibc/gl/data.h"
+
+// Macros ----------------------------------------------------------------------
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IBC_GL_DEPTH_PROJECTOR_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // DepthProjector class
+  // ---------------------------------------------------------------------------
+  // Back projects the depth images (16bit or float) to glXYZf_RGBAub with the
+  // pinhole model. The rays (x / z, y / z) of the pixels are precomputed by
+  // setIntrinsics() (or given by setRayTable() for the undistorted rays).
+  // The points are in the camera coordinates (x right, y down, z forward),
+  // or (x, -y, -z) with setGLCoordinates(true).
+  // The output can be the mapped VBO of PointsRGBA8:
+  //  void *ptr = points.lockStreamBuffer(&maxNum);
+  //  points.unlockStreamBuffer(projector.project(depth, (glXYZf_RGBAub *)ptr, maxNum));
+  // The points are written once and in order (nothing is read back).
+  class DepthProjector
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static const size_t  MIN_TASK_SIZE = 64 * 1024;  // pixels per thread
+
+    // Typedefs ----------------------------------------------------------------
+    // 8bit color image. offset : the byte offsets of r, g, b, a in the pixel
+    // (-1 : 255 for a)
+    typedef struct
+    {
+      const GLubyte *dataPtr;
+      unsigned int  width;
+      unsigned int  height;
+      size_t        pixelStep;
+      size_t        lineStep;
+      int           offset[4];
+    } ColorImage;
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // DepthProjector
+    // -------------------------------------------------------------------------
+    DepthProjector()
+    {
+      mWidth = 0;
+      mHeight = 0;
+      mDepthScale = 1.0f;
+      mMinDepth = 0;
+      mMaxDepth = std::numeric_limits<GLfloat>::infinity();
+      mIsGLCoordinates = false;
+      mDefaultColor[0] = mDefaultColor[1] = mDefaultColor[2] = mDefaultColor[3] = 255;
+      mIsColorRegistered = false;
+      mColorFx = mColorFy = 1;
+      mColorCx = mColorCy = 0;
+      for (int i = 0; i < 9; i++)
+        mColorRotation[i] = (i % 4 == 0) ? 1.0f : 0.0f;
+      mColorTranslation[0] = mColorTranslation[1] = mColorTranslation[2] = 0;
+    }
+    // -------------------------------------------------------------------------
+    // ~DepthProjector
+    // -------------------------------------------------------------------------
+    virtual ~DepthProjector()
+    {
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setIntrinsics
+    // -------------------------------------------------------------------------
+    void setIntrinsics(unsigned int inWidth, unsigned int inHeight,
+                       GLfloat inFx, GLfloat inFy, GLfloat inCx, GLfloat inCy)
+    {
+      mWidth = inWidth;
+      mHeight = inHeight;
+      mRays.resize((size_t )inWidth * inHeight * 2);
+      GLfloat *ray = mRays.data();
+      for (unsigned int y = 0; y < inHeight; y++)
+        for (unsigned int x = 0; x < inWidth; x++)
+        {
+          *ray++ = ((GLfloat )x - inCx) / inFx;
+          *ray++ = ((GLfloat )y - inCy) / inFy;
+        }
+    }
+    // -------------------------------------------------------------------------
+    // setRayTable
+    // -------------------------------------------------------------------------
+    // inRays : (x / z, y / z) of inWidth x inHeight pixels
+    void setRayTable(unsigned int inWidth, unsigned int inHeight, const GLfloat *inRays)
+    {
+      mWidth = inWidth;
+      mHeight = inHeight;
+      mRays.assign(inRays, inRays + (size_t )inWidth * inHeight * 2);
+    }
+    // -------------------------------------------------------------------------
+    // getWidth
+    // -------------------------------------------------------------------------
+    unsigned int getWidth() const
+    {
+      return mWidth;
+    }
+    // -------------------------------------------------------------------------
+    // getHeight
+    // -------------------------------------------------------------------------
+    unsigned int getHeight() const
+    {
+      return mHeight;
+    }
+    // -------------------------------------------------------------------------
+    // setDepthScale
+    // -------------------------------------------------------------------------
+    // z = value * inScale (e.g. 0.001 for the 16bit depth in mm)
+    void setDepthScale(GLfloat inScale)
+    {
+      mDepthScale = inScale;
+    }
+    // -------------------------------------------------------------------------
+    // setDepthRange
+    // -------------------------------------------------------------------------
+    // The depth out of (inMin, inMax] (and NaN or inf) is invalid
+    void setDepthRange(GLfloat inMin, GLfloat inMax)
+    {
+      mMinDepth = inMin;
+      mMaxDepth = inMax;
+    }
+    // -------------------------------------------------------------------------
+    // setGLCoordinates
+    // -------------------------------------------------------------------------
+    void setGLCoordinates(bool inEnable)
+    {
+      mIsGLCoordinates = inEnable;
+    }
+    // -------------------------------------------------------------------------
+    // setDefaultColor
+    // -------------------------------------------------------------------------
+    // The color without the color image (or out of the color image)
+    void setDefaultColor(GLubyte inR, GLubyte inG, GLubyte inB, GLubyte inA = 255)
+    {
+      mDefaultColor[0] = inR;
+      mDefaultColor[1] = inG;
+      mDefaultColor[2] = inB;
+      mDefaultColor[3] = inA;
+    }
+    // -------------------------------------------------------------------------
+    // setColorCamera
+    // -------------------------------------------------------------------------
+    // Registers the color image with the intrinsics of the color camera and
+    // the pose (p_color = R * p_depth + t, R in the row major order, t in the
+    // scaled depth unit). Otherwise the color image is aligned to the depth
+    // image (scaled with the nearest pixel if the sizes differ)
+    void setColorCamera(GLfloat inFx, GLfloat inFy, GLfloat inCx, GLfloat inCy,
+                        const GLfloat inRotation[9], const GLfloat inTranslation[3])
+    {
+      mIsColorRegistered = true;
+      mColorFx = inFx;
+      mColorFy = inFy;
+      mColorCx = inCx;
+      mColorCy = inCy;
+      for (int i = 0; i < 9; i++)
+        mColorRotation[i] = inRotation[i];
+      for (int i = 0; i < 3; i++)
+        mColorTranslation[i] = inTranslation[i];
+    }
+    // -------------------------------------------------------------------------
+    // clearColorCamera
+    // -------------------------------------------------------------------------
+    void clearColorCamera()
+    {
+      mIsColorRegistered = false;
+    }
+    // -------------------------------------------------------------------------
+    // project
+    // -------------------------------------------------------------------------
+    // The depth image (mono, 16bit or float) of the intrinsics size.
+    // Returns the number of the points written (0 on error)
+    size_t project(const ibc::image::ImageBuffer &inDepth,
+                   glXYZf_RGBAub *outPtr, size_t inMaxNum,
+                   const ibc::image::ImageBuffer *inColor = NULL,
+                   bool inCompact = true, unsigned int inTaskNum = 0) const
+    {
+      if (inDepth.checkImageBufferPtr() == false)
+        return 0;
+      ibc::image::ImageFormat format = inDepth.getImageFormat();
+      if (format.mWidth != mWidth || format.mHeight != mHeight)
+        return 0;
+      ColorImage  color, *colorPtr = NULL;
+      if (inColor != NULL)
+      {
+        if (toColorImage(*inColor, &color) == false)
+          return 0;
+        colorPtr = &color;
+      }
+      const void  *depthPtr = inDepth.getImageBufferLinePtr(0);
+      switch (format.mType.mDataType)
+      {
+        case ibc::image::ImageType::DATA_TYPE_16BIT:
+          return project((const uint16_t *)depthPtr, format.mLineStep,
+                         outPtr, inMaxNum, colorPtr, inCompact, inTaskNum);
+        case ibc::image::ImageType::DATA_TYPE_FLOAT:
+          return project((const float *)depthPtr, format.mLineStep,
+                         outPtr, inMaxNum, colorPtr, inCompact, inTaskNum);
+        default:
+          break;
+      }
+      return 0;
+    }
+    // -------------------------------------------------------------------------
+    // project
+    // -------------------------------------------------------------------------
+    // inCompact == true  : only the valid points are written (in the row order)
+    // inCompact == false : width x height points, NaN for the invalid ones
+    //                      (organized, e.g. for NormalEstimator::estimateOrganized)
+    template <typename ValueType>
+    size_t project(const ValueType *inDepthPtr, size_t inLineStep,
+                   glXYZf_RGBAub *outPtr, size_t inMaxNum,
+                   const ColorImage *inColor = NULL,
+                   bool inCompact = true, unsigned int inTaskNum = 0) const
+    {
+      size_t  num = (size_t )mWidth * mHeight;
+      if (inDepthPtr == NULL || outPtr == NULL || num == 0)
+        return 0;
+      if (inColor != NULL && (inColor->dataPtr == NULL || inColor->width == 0 ||
+                              inColor->height == 0))
+        return 0;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(num, MIN_TASK_SIZE);
+      const unsigned char *depthPtr = (const unsigned char *)inDepthPtr;
+      if (inCompact == false)
+      {
+        if (inMaxNum < num)
+          return 0;
+        Parallel::forEachTask(mHeight, inTaskNum,
+          [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+          {
+            UNUSED(inTaskIndex);
+            projectRows<ValueType>(depthPtr, inLineStep, inColor, inBegin, inEnd,
+                                   outPtr + inBegin * mWidth, false, num);
+          });
+        return num;
+      }
+      if (inTaskNum <= 1)
+        return projectRows<ValueType>(depthPtr, inLineStep, inColor, 0, mHeight,
+                                      outPtr, true, inMaxNum);
+      // Counts the valid points of the tasks, then writes them to their offsets
+      std::vector<size_t> offsets(inTaskNum + 1, 0);
+      Parallel::forEachTask(mHeight, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          offsets[inTaskIndex + 1] = countRows<ValueType>(depthPtr, inLineStep, inBegin, inEnd);
+        });
+      for (unsigned int i = 0; i < inTaskNum; i++)
+        offsets[i + 1] += offsets[i];
+      Parallel::forEachTask(mHeight, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          size_t  first = offsets[inTaskIndex];
+          if (first >= inMaxNum)
+            return;
+          size_t  maxNum = std::min(offsets[inTaskIndex + 1], inMaxNum) - first;
+          projectRows<ValueType>(depthPtr, inLineStep, inColor, inBegin, inEnd,
+                                 outPtr + first, true, maxNum);
+        });
+      return std::min(offsets[inTaskNum], inMaxNum);
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // toColorImage
+    // -------------------------------------------------------------------------
+    // 8bit mono, RGB, BGR, RGBA, BGRA, ARGB or ABGR (pixel aligned)
+    static bool toColorImage(const ibc::image::ImageBuffer &inImage, ColorImage *outColor)
+    {
+      using ibc::image::ImageType;
+      if (inImage.checkImageBufferPtr() == false)
+        return false;
+      ibc::image::ImageFormat format = inImage.getImageFormat();
+      if (format.mType.mDataType != ImageType::DATA_TYPE_8BIT ||
+          format.mType.isPlanar() || format.mPixelStep == 0)
+        return false;
+      static const int  offsets[][4] =
+      {
+        {0, 0, 0, -1},  // mono
+        {0, 1, 2, -1},  // RGB
+        {2, 1, 0, -1},  // BGR
+        {0, 1, 2, 3},   // RGBA
+        {2, 1, 0, 3},   // BGRA
+        {1, 2, 3, 0},   // ARGB
+        {3, 2, 1, 0}    // ABGR
+      };
+      int index;
+      switch (format.mType.mPixelType)
+      {
+        case ImageType::PIXEL_TYPE_MONO:  index = 0;  break;
+        case ImageType::PIXEL_TYPE_RGB:   index = 1;  break;
+        case ImageType::PIXEL_TYPE_BGR:   index = 2;  break;
+        case ImageType::PIXEL_TYPE_RGBA:  index = 3;  break;
+        case ImageType::PIXEL_TYPE_BGRA:  index = 4;  break;
+        case ImageType::PIXEL_TYPE_ARGB:  index = 5;  break;
+        case ImageType::PIXEL_TYPE_ABGR:  index = 6;  break;
+        default:
+          return false;
+      }
+      outColor->dataPtr = (const GLubyte *)inImage.getImageBufferLinePtr(0);
+      outColor->width = format.mWidth;
+      outColor->height = format.mHeight;
+      outColor->pixelStep = format.mPixelStep;
+      outColor->lineStep = format.mLineStep;
+      for (int i = 0; i < 4; i++)
+        outColor->offset[i] = offsets[index][i];
+      return true;
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    unsigned int  mWidth;
+    unsigned int  mHeight;
+    std::vector<GLfloat>  mRays;
+    GLfloat mDepthScale;
+    GLfloat mMinDepth;
+    GLfloat mMaxDepth;
+    bool    mIsGLCoordinates;
+    GLubyte mDefaultColor[4];
+    bool    mIsColorRegistered;
+    GLfloat mColorFx, mColorFy, mColorCx, mColorCy;
+    GLfloat mColorRotation[9];
+    GLfloat mColorTranslation[3];
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // isValidDepth
+    // -------------------------------------------------------------------------
+    bool isValidDepth(GLfloat inDepth) const
+    {
+      return (std::isfinite(inDepth) && inDepth > mMinDepth && inDepth <= mMaxDepth);
+    }
+    // -------------------------------------------------------------------------
+    // countRows
+    // -------------------------------------------------------------------------
+    template <typename ValueType>
+    size_t countRows(const unsigned char *inDepthPtr, size_t inLineStep,
+                     size_t inBegin, size_t inEnd) const
+    {
+      size_t  num = 0;
+      for (size_t y = inBegin; y < inEnd; y++)
+      {
+        const ValueType *depth = (const ValueType *)(inDepthPtr + inLineStep * y);
+        for (unsigned int x = 0; x < mWidth; x++)
+          num += isValidDepth((GLfloat )depth[x] * mDepthScale) ? 1 : 0;
+      }
+      return num;
+    }
+    // -------------------------------------------------------------------------
+    // projectRows
+    // -------------------------------------------------------------------------
+    // Returns the number of the points written (up to inMaxNum)
+    template <typename ValueType>
+    size_t projectRows(const unsigned char *inDepthPtr, size_t inLineStep,
+                       const ColorImage *inColor, size_t inBegin, size_t inEnd,
+                       glXYZf_RGBAub *outPtr, bool inCompact, size_t inMaxNum) const
+    {
+      uint32_t  defaultColor;
+      std::memcpy(&defaultColor, mDefaultColor, sizeof(defaultColor));
+#ifdef IBC_GL_DEPTH_PROJECTOR_USE_SSE2
+      const __m128  rayBase = _mm_set_ps(0, 1, 0, 0);   // (-, -, 1, 0)
+      const __m128  xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+      const __m128  signMask = mIsGLCoordinates ?
+                                _mm_set_ps(0, -0.0f, -0.0f, 0) : _mm_setzero_ps();
+      const __m128  invalid = _mm_set_ps(0, std::numeric_limits<GLfloat>::quiet_NaN(),
+                                            std::numeric_limits<GLfloat>::quiet_NaN(),
+                                            std::numeric_limits<GLfloat>::quiet_NaN());
+#else
+      const GLfloat sign = mIsGLCoordinates ? -1.0f : 1.0f;
+#endif
+      bool  isColorAligned = (inColor != NULL && mIsColorRegistered == false);
+      bool  isColorScaled = (inColor != NULL &&
+                             (inColor->width != mWidth || inColor->height != mHeight));
+      size_t  num = 0;
+      for (size_t y = inBegin; y < inEnd; y++)
+      {
+        const ValueType *depth = (const ValueType *)(inDepthPtr + inLineStep * y);
+        const GLfloat   *ray = mRays.data() + y * mWidth * 2;
+        const GLubyte   *colorLine = NULL;
+        if (isColorAligned)
+          colorLine = inColor->dataPtr + inColor->lineStep *
+                      (isColorScaled ? y * inColor->height / mHeight : y);
+        for (unsigned int x = 0; x < mWidth; x++, ray += 2)
+        {
+          GLfloat d = (GLfloat )depth[x] * mDepthScale;
+          bool    isValid = isValidDepth(d);
+          if (isValid == false && inCompact)
+            continue;
+          if (num >= inMaxNum)
+            return num;
+          uint32_t  color = defaultColor;
+          if (isValid && isColorAligned)
+            color = packColor(colorLine + inColor->pixelStep *
+                              (isColorScaled ? (size_t )x * inColor->width / mWidth : x),
+                              inColor->offset);
+          else if (isValid && inColor != NULL)
+            color = sampleColor(inColor, ray, d, defaultColor);
+          glXYZf_RGBAub *out = outPtr + num++;
+#ifdef IBC_GL_DEPTH_PROJECTOR_USE_SSE2
+          // (rx, ry, 1, 0) * d with the color bits in the 4th lane (one 16 byte store).
+          // The 4th lane is cleared before OR-ing the color (0 * d is -0 for d < 0)
+          __m128  v;
+          if (isValid)
+          {
+            v = _mm_loadl_pi(rayBase, (const __m64 *)ray);
+            v = _mm_xor_ps(_mm_mul_ps(v, _mm_set1_ps(d)), signMask);
+            v = _mm_and_ps(v, xyzMask);
+          }
+          else
+            v = invalid;
+          v = _mm_or_ps(v, _mm_castsi128_ps(_mm_set_epi32((int )color, 0, 0, 0)));
+          _mm_storeu_ps((float *)out, v);
+#else
+          if (isValid)
+          {
+            out->x = ray[0] * d;
+            out->y = ray[1] * d * sign;
+            out->z = d * sign;
+          }
+          else
+            out->x = out->y = out->z = std::numeric_limits<GLfloat>::quiet_NaN();
+          std::memcpy(&(out->r), &color, sizeof(color));
+#endif
+        }
+      }
+      return num;
+    }
+    // -------------------------------------------------------------------------
+    // sampleColor
+    // -------------------------------------------------------------------------
+    // The nearest pixel of the registered color image
+    uint32_t sampleColor(const ColorImage *inColor, const GLfloat inRay[2],
+                         GLfloat inDepth, uint32_t inDefault) const
+    {
+      GLfloat p[3] = {inRay[0] * inDepth, inRay[1] * inDepth, inDepth};
+      GLfloat c[3];
+      for (int i = 0; i < 3; i++)
+        c[i] = mColorRotation[i * 3 + 0] * p[0] + mColorRotation[i * 3 + 1] * p[1] +
+               mColorRotation[i * 3 + 2] * p[2] + mColorTranslation[i];
+      if (!(c[2] > 0))
+        return inDefault;
+      GLfloat u = std::floor(mColorFx * c[0] / c[2] + mColorCx + 0.5f);
+      GLfloat v = std::floor(mColorFy * c[1] / c[2] + mColorCy + 0.5f);
+      if (!(u >= 0 && u < (GLfloat )inColor->width && v >= 0 && v < (GLfloat )inColor->height))
+        return inDefault;
+      return packColor(inColor->dataPtr + inColor->lineStep * (size_t )v +
+                       inColor->pixelStep * (size_t )u, inColor->offset);
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // packColor
+    // -------------------------------------------------------------------------
+    // RGBA8 in the memory order
+    static uint32_t packColor(const GLubyte *inPixel, const int inOffset[4])
+    {
+      GLubyte rgba[4] = {inPixel[inOffset[0]], inPixel[inOffset[1]], inPixel[inOffset[2]],
+                         (GLubyte )((inOffset[3] >= 0) ? inPixel[inOffset[3]] : 255)};
+      uint32_t  color;
+      std::memcpy(&color, rgba, sizeof(color));
+      return color;
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_DEPTH_PROJECTOR_H_
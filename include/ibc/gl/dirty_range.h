@@ -0,0 +1,177 @@
+// =============================================================================
+//  dirty_range.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/dirty_range.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for tracking the modified ranges of a buffer
+*/
+
+#ifndef IBC_GL_DIRTY_RANGE_H_
+#define IBC_GL_DIRTY_RANGE_H_
+
+// Includes --------------------------------------------------------------------
+#include <cstddef>
+#include <vector>
+#include "ibc/base/types.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // DirtyRange class
+  // ---------------------------------------------------------------------------
+  // Keeps the modified [first, first + count) element ranges sorted and merged,
+  // so that only those spans are uploaded with glBufferSubData().
+  // Overlapping and adjacent ranges are merged. When the number of ranges
+  // exceeds inMaxRangeNum, the two ranges with the smallest gap are merged
+  // (uploading a small gap is cheaper than issuing many small calls).
+  class DirtyRange
+  {
+  public:
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      size_t  first;
+      size_t  count;
+    } Range;
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // DirtyRange
+    // -------------------------------------------------------------------------
+    DirtyRange(size_t inMaxRangeNum = 16)
+    {
+      mMaxRangeNum = inMaxRangeNum;
+      if (mMaxRangeNum == 0)
+        mMaxRangeNum = 1;
+    }
+    // -------------------------------------------------------------------------
+    // ~DirtyRange
+    // -------------------------------------------------------------------------
+    virtual ~DirtyRange()
+    {
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // add
+    // -------------------------------------------------------------------------
+    void add(size_t inFirst, size_t inCount)
+    {
+      if (inCount == 0)
+        return;
+      size_t  last = inFirst + inCount;
+      // The first range which ends at or after inFirst (touching counts)
+      size_t  i = 0;
+      while (i < mRanges.size() && mRanges[i].first + mRanges[i].count < inFirst)
+        i++;
+      // Absorb all the ranges which start at or before the new end
+      size_t  j = i;
+      while (j < mRanges.size() && mRanges[j].first <= last)
+      {
+        if (mRanges[j].first < inFirst)
+          inFirst = mRanges[j].first;
+        if (mRanges[j].first + mRanges[j].count > last)
+          last = mRanges[j].first + mRanges[j].count;
+        j++;
+      }
+      Range range = {inFirst, last - inFirst};
+      if (i == j)
+        mRanges.insert(mRanges.begin() + i, range);
+      else
+      {
+        mRanges[i] = range;
+        mRanges.erase(mRanges.begin() + i + 1, mRanges.begin() + j);
+      }
+      while (mRanges.size() > mMaxRangeNum)
+        mergeClosest();
+    }
+    // -------------------------------------------------------------------------
+    // clear
+    // -------------------------------------------------------------------------
+    void clear()
+    {
+      mRanges.clear();
+    }
+    // -------------------------------------------------------------------------
+    // isEmpty
+    // -------------------------------------------------------------------------
+    bool isEmpty() const
+    {
+      return mRanges.empty();
+    }
+    // -------------------------------------------------------------------------
+    // getRanges
+    // -------------------------------------------------------------------------
+    const std::vector<Range> &getRanges() const
+    {
+      return mRanges;
+    }
+    // -------------------------------------------------------------------------
+    // getTotalCount
+    // -------------------------------------------------------------------------
+    size_t getTotalCount() const
+    {
+      size_t  total = 0;
+      for (size_t i = 0; i < mRanges.size(); i++)
+        total += mRanges[i].count;
+      return total;
+    }
+    // -------------------------------------------------------------------------
+    // clip
+    // -------------------------------------------------------------------------
+    // Drops the part beyond inNum (e.g. after the data number is reduced)
+    void clip(size_t inNum)
+    {
+      while (mRanges.empty() == false && mRanges.back().first >= inNum)
+        mRanges.pop_back();
+      if (mRanges.empty() == false &&
+          mRanges.back().first + mRanges.back().count > inNum)
+        mRanges.back().count = inNum - mRanges.back().first;
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    std::vector<Range>  mRanges;
+    size_t  mMaxRangeNum;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // mergeClosest
+    // -------------------------------------------------------------------------
+    void mergeClosest()
+    {
+      size_t  index = 0;
+      size_t  minGap = (size_t )-1;
+      for (size_t i = 0; i + 1 < mRanges.size(); i++)
+      {
+        size_t  gap = mRanges[i + 1].first - (mRanges[i].first + mRanges[i].count);
+        if (gap < minGap)
+        {
+          minGap = gap;
+          index = i;
+        }
+      }
+      mRanges[index].count = mRanges[index + 1].first + mRanges[index + 1].count
+                              - mRanges[index].first;
+      mRanges.erase(mRanges.begin() + index + 1);
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_DIRTY_RANGE_H_
@@ -113,6 +113,61 @@ namespace ibc { namespace gl { namespace file
       return charTokenizer(inStr, inLen, outWords, separators, 2);
     }
     // -------------------------------------------------------------------------
+    // getNextLine
+    // -------------------------------------------------------------------------
+    // Finds the next non-empty line from *ioPos and moves *ioPos to the end
+    // of the line. Returns false if there is no more line.
+    static bool getNextLine(const char *inStr, size_t inLen, size_t *ioPos, Range *outLine)
+    {
+      size_t  pos = *ioPos;
+      while (pos < inLen &&
+             (inStr[pos] == CHAR_LF_CODE || inStr[pos] == CHAR_CR_CODE))
+        pos++;
+      if (pos >= inLen || inStr[pos] == 0)
+      {
+        *ioPos = pos;
+        return false;
+      }
+      outLine->from = pos;
+      while (pos < inLen && inStr[pos] != 0 &&
+             inStr[pos] != CHAR_LF_CODE && inStr[pos] != CHAR_CR_CODE)
+        pos++;
+      outLine->len = pos - outLine->from;
+      *ioPos = pos;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // findWords
+    // -------------------------------------------------------------------------
+    // Fixed size array version of findWords() (no memory allocation).
+    // Only the first inMaxWordNum words are stored into outWords, but the
+    // returned value is the number of all the words in the string.
+    static size_t findWords(const char *inStr, size_t inLen,
+                            Range *outWords, size_t inMaxWordNum)
+    {
+      size_t  num = 0;
+      size_t  pos = 0;
+      while (pos < inLen)
+      {
+        while (pos < inLen &&
+               (inStr[pos] == CHAR_SPACE_CODE || inStr[pos] == CHAR_TAB_CODE))
+          pos++;
+        if (pos >= inLen)
+          break;
+        size_t  from = pos;
+        while (pos < inLen &&
+               inStr[pos] != CHAR_SPACE_CODE && inStr[pos] != CHAR_TAB_CODE)
+          pos++;
+        if (num < inMaxWordNum)
+        {
+          outWords[num].from = from;
+          outWords[num].len  = pos - from;
+        }
+        num++;
+      }
+      return num;
+    }
+    // -------------------------------------------------------------------------
     // charTokenizer
     // -------------------------------------------------------------------------
     static size_t charTokenizer(const char *inStr, size_t inLen, std::vector<Range> *outRanges,
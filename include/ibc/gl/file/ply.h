@@ -26,19 +26,26 @@
 #include <vector>
 #include <string>
 #include <string_view>
+#include <charconv>
 #include <stdlib.h>
 #include <stdio.h>
+#include <errno.h>
 #ifdef _WIN32
 #include <io.h>
+#else
+#include <unistd.h>
 #endif
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <QFileInfo>
+#if __has_include(<QFileInfo>)
+#include <QFileInfo>  // Q_OS_WIN
+#endif
 #include "ibc/base/types.h"
 #include "ibc/base/endian.h"
 #include "ibc/base/log.h"
 #include "ibc/gl/data.h"
+#include "ibc/gl/bounding_box.h"
 #include "ibc/gl/file/common.h"
 
 // Macros ----------------------------------------------------------------------
@@ -49,6 +56,25 @@
 #define IBC_GL_FILE_PLY_TRACE()
 #define IBC_GL_FILE_PLY_TRACE_ONCE()
 #endif
+//
+// Helpers for the PLYFile::OutputInfo tables
+// (struct, member, property type, source data type, output data type)
+#define IBC_GL_FILE_PLY_OUTPUT_INFO(s, m, p, st, ot)  \
+  { PLYHeader::p, PLYHeader::ot, PLYHeader::st, offsetof(ibc::gl::s, m), false, 1.0, 0.0 }
+// GLfloat color [0.0 - 1.0] -> uchar color [0 - 255]
+#define IBC_GL_FILE_PLY_OUTPUT_INFO_COLOR(s, m, p)  \
+  { PLYHeader::p, PLYHeader::DATA_TYPE_UCHAR, PLYHeader::DATA_TYPE_FLOAT,  \
+    offsetof(ibc::gl::s, m), true, 255.0, 0.5 }
+//
+// Helpers for the PLYFile::DestinationInfo tables
+// (struct, member, property type, destination data type, mandatory, default value)
+#define IBC_GL_FILE_PLY_INPUT_INFO(s, m, p, dt, mn, dv)  \
+  { PLYHeader::p, PLYHeader::dt, offsetof(ibc::gl::s, m), mn, dv,  \
+    false, 1.0, 0.0, false, 0, 0 }
+// uchar color [0 - 255] -> GLfloat color [0.0 - 1.0]
+#define IBC_GL_FILE_PLY_INPUT_INFO_COLOR(s, m, p)  \
+  { PLYHeader::p, PLYHeader::DATA_TYPE_FLOAT32, offsetof(ibc::gl::s, m), false, 1.0,  \
+    true, 1.0 / 255.0, 0.0, true, 0.0, 1.0 }
 
 // Namespace -------------------------------------------------------------------
 //namespace ibc::gl::file // <- nested namespace (C++17)
@@ -193,6 +219,7 @@ namespace ibc { namespace gl { namespace file
       mObjInfoStr.clear();
       mElements.clear();
       mProperties.clear();
+      mElementLayouts.clear();
     }
     // -------------------------------------------------------------------------
     // setFormat
@@ -281,6 +308,12 @@ namespace ibc { namespace gl { namespace file
       if (mElements[index].type == ELEMENT_TYPE_USER)
         mElements[index].name = std::string_view(inNameStr, inNameStrLen);
       mElements[index].num  = inElementNum;
+      //
+      mElementLayouts.resize(index + 1);
+      mElementLayouts[index].singleDataSize = 0;
+      mElementLayouts[index].containsList   = false;
+      for (int i = 0; i < PROPERTY_SLOT_NUM; i++)
+        mElementLayouts[index].slots[i] = -1;
       return index;
     }
     // -------------------------------------------------------------------------
@@ -323,6 +356,7 @@ namespace ibc { namespace gl { namespace file
       mProperties[index].dataType     = inDataType;
       mProperties[index].isList       = false;
       mProperties[index].listNumType  = DATA_TYPE_NOT_SPECIFIED;
+      addPropertyLayout(index);
       return index;
     }
     // -------------------------------------------------------------------------
@@ -341,6 +375,7 @@ namespace ibc { namespace gl { namespace file
       mProperties[index].dataType     = inDataType;
       mProperties[index].isList       = true;
       mProperties[index].listNumType  = inListNumType;
+      addPropertyLayout(index);
       return index;
     }
     // -------------------------------------------------------------------------
@@ -357,24 +392,34 @@ namespace ibc { namespace gl { namespace file
     size_t getElementProperties(size_t inElementIndex, std::vector<Property> *outProperties) const
     {
       IBC_GL_FILE_PLY_TRACE();
-      for (size_t i = 0; i < mProperties.size(); i++)
-        if (mProperties[i].elementIndex == inElementIndex)
-          outProperties->push_back(mProperties[i]);
+      const std::vector<size_t> &indices = getElementPropertyIndices(inElementIndex);
+      for (size_t i = 0; i < indices.size(); i++)
+        outProperties->push_back(mProperties[indices[i]]);
       return outProperties->size();
     }
     // -------------------------------------------------------------------------
+    // getElementPropertyIndices
+    // -------------------------------------------------------------------------
+    // Returns the indices of getProperties() which belong to the element
+    const std::vector<size_t> &getElementPropertyIndices(size_t inElementIndex) const
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      static const std::vector<size_t>  emptyIndices;
+      if (inElementIndex >= mElementLayouts.size())
+        return emptyIndices;
+      return mElementLayouts[inElementIndex].propertyIndices;
+    }
+    // -------------------------------------------------------------------------
     // findPropertyIndex
     // -------------------------------------------------------------------------
     bool findPropertyIndex(size_t inElementIndex, PropertyType inType, size_t *outIndex) const
     {
       IBC_GL_FILE_PLY_TRACE();
-      for (size_t i = 0; i < mProperties.size(); i++)
-        if (mProperties[i].elementIndex == inElementIndex && mProperties[i].type == inType)
-        {
-          *outIndex = i;
-          return true;
-        }
-      return false;
+      const PropertyLayout  *layout = findPropertyLayout(inElementIndex, inType);
+      if (layout == NULL)
+        return false;
+      *outIndex = layout->propertyIndex;
+      return true;
     }
     // -------------------------------------------------------------------------
     // getElementSingleDataSize
@@ -382,17 +427,11 @@ namespace ibc { namespace gl { namespace file
     size_t getElementSingleDataSize(size_t inElementIndex, bool *outContainsList) const
     {
       IBC_GL_FILE_PLY_TRACE();
-      size_t  elementSize = 0;
       *outContainsList = false;
-      for (size_t i = 0; i < mProperties.size(); i++)
-        if (mProperties[i].elementIndex == inElementIndex)
-        {
-          if (mProperties[i].isList == false)
-            elementSize += sizeofDataType(mProperties[i].dataType);
-          else
-            *outContainsList = true;
-        }
-      return elementSize;
+      if (inElementIndex >= mElementLayouts.size())
+        return 0;
+      *outContainsList = mElementLayouts[inElementIndex].containsList;
+      return mElementLayouts[inElementIndex].singleDataSize;
     }
     // -------------------------------------------------------------------------
     // getElementTotalSize
@@ -405,24 +444,34 @@ namespace ibc { namespace gl { namespace file
       if (containsList == false)
         return elementSize * mElements[inElementIndex].num;
       //
+      const std::vector<size_t> &indices = getElementPropertyIndices(inElementIndex);
+      std::vector<const Property *> properties(indices.size());
+      for (size_t j = 0; j < indices.size(); j++)
+        properties[j] = &(mProperties[indices[j]]);
+      //
+      const unsigned char *dataPtr = (const unsigned char *)inDataPtr;
       size_t offset = 0;
       bool  flipEndian = doesNeedToFlipEndian(mDataFormat);
       for (size_t i = 0; i < mElements[inElementIndex].num; i++)
-        for (size_t j = 0; j < mProperties.size(); j++)
-          if (mProperties[j].elementIndex == inElementIndex)
+        for (size_t j = 0; j < properties.size(); j++)
+        {
+          if (properties[j]->isList == false)
+            offset += sizeofDataType(properties[j]->dataType);
+          else
           {
-            if (mProperties[j].isList == false)
-              offset += sizeofDataType(mProperties[j].dataType);
-            else
-            {
-              double num = getValue((const unsigned char *)inDataPtr, offset,
-                                    mProperties[j].listNumType, flipEndian);
-              offset += sizeofDataType(mProperties[j].listNumType);
-              offset += sizeofDataType(mProperties[j].dataType) * num;
-            }
-            if (offset > inDataSize)
+            size_t numSize = sizeofDataType(properties[j]->listNumType);
+            if (offset + numSize > inDataSize)
+              return 0;
+            int64_t num = getIntegerValue(dataPtr, offset,
+                                          properties[j]->listNumType, flipEndian);
+            if (num < 0)
               return 0;
+            offset += numSize;
+            offset += sizeofDataType(properties[j]->dataType) * (size_t )num;
           }
+          if (offset > inDataSize)
+            return 0;
+        }
       return offset;
     }
     // -------------------------------------------------------------------------
@@ -454,7 +503,7 @@ namespace ibc { namespace gl { namespace file
       {
         size_t offset;
         if (Common::skipLines(elementStrPtr, inDataSize,
-                              mElements[inElementIndex].num, &offset) == false)
+                              mElements[i].num, &offset) == false)
           return false;
         elementStrPtr += offset;
         (*outOffset) += offset;
@@ -472,22 +521,18 @@ namespace ibc { namespace gl { namespace file
       if (inType == PROPERTY_TYPE_NOT_SPECIFIED)
         return false;
       *outOffset = 0;
-      for (size_t i = 0; i < mProperties.size(); i++)
-        if (mProperties[i].elementIndex == inElementIndex)
-        {
-          if (mProperties[i].isList)  // We can't calculate the offset here in this case
-            return false;
-          if (mProperties[i].type == inType)
-          {
-            *outDataType = mProperties[i].dataType;
-            return true;
-          }
-          if (mDataFormat != DATA_FORMAT_ASCII)
-            (*outOffset) += sizeofDataType(mProperties[i].dataType);
-          else
-            (*outOffset) += 1;
-        }
-      return false;
+      const PropertyLayout  *layout = findPropertyLayout(inElementIndex, inType);
+      if (layout == NULL)
+        return false;
+      // We can't calculate the offset here in this case
+      if (layout->isAfterList || mProperties[layout->propertyIndex].isList)
+        return false;
+      if (mDataFormat != DATA_FORMAT_ASCII)
+        *outOffset = layout->binaryOffset;
+      else
+        *outOffset = layout->asciiOffset;
+      *outDataType = mProperties[layout->propertyIndex].dataType;
+      return true;
     }
 
     // -------------------------------------------------------------------------
@@ -522,6 +567,59 @@ namespace ibc { namespace gl { namespace file
         str.append("C");
       return str;
     }
+    // -------------------------------------------------------------------------
+    // getHeaderStr
+    // -------------------------------------------------------------------------
+    // Returns the header text (from "ply" to "end_header" + EOL) for writing
+    std::string getHeaderStr() const
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      std::string str;
+      str.append(getReservedWord(LINE_TYPE_START));
+      str.append(1, Common::CHAR_EOL_CODE);
+      str.append(getReservedWord(LINE_TYPE_FORMAT));
+      str.append(" ");
+      str.append(getFormatStr());
+      str.append(1, Common::CHAR_EOL_CODE);
+      appendHeaderLines(&str, getReservedWord(LINE_TYPE_COMMENT), mCommentStr);
+      appendHeaderLines(&str, getReservedWord(LINE_TYPE_OBJ_INFO), mObjInfoStr);
+      for (size_t i = 0; i < mElements.size(); i++)
+      {
+        str.append(getReservedWord(LINE_TYPE_ELEMENT));
+        str.append(" ");
+        if (mElements[i].type != ELEMENT_TYPE_USER)
+          str.append(getElementTypeWord(mElements[i].type));
+        else
+          str.append(mElements[i].name);
+        str.append(" ");
+        str.append(std::to_string(mElements[i].num));
+        str.append(1, Common::CHAR_EOL_CODE);
+        for (size_t j = 0; j < mProperties.size(); j++)
+        {
+          if (mProperties[j].elementIndex != i)
+            continue;
+          str.append(getReservedWord(LINE_TYPE_PROPERTY));
+          str.append(" ");
+          if (mProperties[j].isList)
+          {
+            str.append(getReservedWord(LINE_TYPE_PROPERTY_LIST));
+            str.append(" ");
+            str.append(getDataTypeWord(mProperties[j].listNumType));
+            str.append(" ");
+          }
+          str.append(getDataTypeWord(mProperties[j].dataType));
+          str.append(" ");
+          if (mProperties[j].type != PROPERTY_TYPE_USER)
+            str.append(getPropertyTypeWord(mProperties[j].type));
+          else
+            str.append(mProperties[j].name);
+          str.append(1, Common::CHAR_EOL_CODE);
+        }
+      }
+      str.append(getReservedWord(LINE_TYPE_END));
+      str.append(1, Common::CHAR_EOL_CODE);
+      return str;
+    }
 
     // Debug Functions ---------------------------------------------------------
     void  debugDumpHeader(std::ostream *outStream) const
@@ -608,25 +706,20 @@ namespace ibc { namespace gl { namespace file
       size_t  elementIndex = 0;
       size_t  elementNum = 0;
       size_t  len;
-      std::vector<Common::Range> lines;
-      std::vector<Common::Range> words;
+      size_t  pos = 0;
+      Common::Range line;
+      Common::Range words[MAX_HEADER_WORD_NUM];
+      size_t  wordNum;
       DataFormat  format;
 
       outHeader->clear();
 
-      Common::findLines(inHeaderStr, inLen, &lines);
-      if (lines.size() < 2)
-      {
-        IBC_LOG_ERROR("Invaild header string");
-        return false;
-      }
-      //
-      for (size_t i = 0; i < lines.size(); i++)
+      // Single pass lexer : lines and words are not stored anywhere
+      while (Common::getNextLine(inHeaderStr, inLen, &pos, &line))
       {
-        words.clear();
-        const char  *linePtr = &(inHeaderStr[lines[i].from]);
-        Common::findWords(linePtr, lines[i].len, &words);
-        if (words.size() == 0)
+        const char  *linePtr = &(inHeaderStr[line.from]);
+        wordNum = Common::findWords(linePtr, line.len, words, MAX_HEADER_WORD_NUM);
+        if (wordNum == 0)
         {
           IBC_LOG_ERROR("A blank line in the PLY header");
           return false;
@@ -679,7 +772,7 @@ namespace ibc { namespace gl { namespace file
               IBC_LOG_ERROR("Found a \"format\" more than twice");
               return false;
             }
-            if (words.size() != 3)
+            if (wordNum != 3)
             {
               IBC_LOG_ERROR("Invalid format line");
               return false;
@@ -695,28 +788,32 @@ namespace ibc { namespace gl { namespace file
             foundFormat = true;
             break;
           case LINE_TYPE_COMMENT:
-            if (words.size() > 1) // Skip a blank comment line
+            if (wordNum > 1) // Skip a blank comment line
             {
-              len = lines[i].len - words[1].from;
+              len = line.len - words[1].from;
               outHeader->addComment(&(linePtr[words[1].from]), len);
             }
             break;
           case LINE_TYPE_OBJ_INFO:
-            if (words.size() > 1) // Skip a blank obj_info line
+            if (wordNum > 1) // Skip a blank obj_info line
             {
-              len = lines[i].len - words[1].from;
+              len = line.len - words[1].from;
               outHeader->addObjInfo(&(linePtr[words[1].from]), len);
             }
             break;
           case LINE_TYPE_ELEMENT:
-            if (words.size() < 3)
+            if (wordNum < 3)
             {
               IBC_LOG_ERROR("Invalid element line");
               return false;
             }
-            // TODO : Clean up here
-            //num = std::stoul(std::string_view(&(linePtr[words[2].from]), words[2].len));
-            elementNum = std::stoul(std::string(&(linePtr[words[2].from]), words[2].len));
+            if (std::from_chars(&(linePtr[words[2].from]),
+                                &(linePtr[words[2].from + words[2].len]),
+                                elementNum).ec != std::errc())
+            {
+              IBC_LOG_ERROR("Invalid element number");
+              return false;
+            }
             if (elementNum != 0)
             {
               elementIndex = outHeader->addElement(&(linePtr[words[1].from]), words[1].len, elementNum);
@@ -735,7 +832,7 @@ namespace ibc { namespace gl { namespace file
               propertyCount++;
               break;
             }
-            if (words.size() < 3)
+            if (wordNum < 3)
             {
               IBC_LOG_ERROR("Invalid element line");
               return false;
@@ -747,7 +844,7 @@ namespace ibc { namespace gl { namespace file
             }
             else
             {
-              if (words.size() != 5)
+              if (wordNum != 5)
               {
                 IBC_LOG_ERROR("Invalid element line");
                 return false;
@@ -912,6 +1009,64 @@ namespace ibc { namespace gl { namespace file
       return 0;
     }
     // -------------------------------------------------------------------------
+    // getIntegerValue
+    // -------------------------------------------------------------------------
+    // Same as getValue(), but without the double conversion.
+    // (used for the list counts and the vertex indices)
+    // The NaN, inf or out of the int64 range float values are returned as -1,
+    // which the callers reject as an invalid count or index
+    static int64_t getIntegerValue(const unsigned char *inDataPtr, size_t inOffset,
+                            PLYHeader::DataType inType, bool inFlipEndian)
+    {
+      IBC_GL_FILE_PLY_TRACE_ONCE();
+      unsigned char data[8];
+      ::memcpy(data, &(inDataPtr[inOffset]), PLYHeader::sizeofDataType(inType));
+      //
+      if (inFlipEndian)
+        flipEndian(data, inType);
+      //
+      switch (inType)
+      {
+        case DATA_TYPE_INT8:
+        case DATA_TYPE_CHAR:
+          return (int64_t )(*((int8_t *)data));
+        case DATA_TYPE_UINT8:
+        case DATA_TYPE_UCHAR:
+          return (int64_t )(*((uint8_t *)data));
+        case DATA_TYPE_INT16:
+        case DATA_TYPE_SHORT:
+          return (int64_t )(*((int16_t *)data));
+        case DATA_TYPE_UINT16:
+        case DATA_TYPE_USHORT:
+          return (int64_t )(*((uint16_t *)data));
+        case DATA_TYPE_INT32:
+        case DATA_TYPE_INT:
+          return (int64_t )(*((int32_t  *)data));
+        case DATA_TYPE_UINT32:
+        case DATA_TYPE_UINT:
+          return (int64_t )(*((uint32_t  *)data));
+        case DATA_TYPE_FLOAT32:
+        case DATA_TYPE_FLOAT:
+          return floatToInteger(*((float  *)data));
+        case DATA_TYPE_FLOAT64:
+        case DATA_TYPE_DOUBLE:
+          return floatToInteger(*((double  *)data));
+        default:
+          break;
+      }
+      return 0;
+    }
+    // -------------------------------------------------------------------------
+    // floatToInteger
+    // -------------------------------------------------------------------------
+    // -1 for NaN, inf or out of [-2^63, 2^63) (the cast is undefined for them)
+    static int64_t floatToInteger(double inValue)
+    {
+      if (!(inValue >= -9223372036854775808.0 && inValue < 9223372036854775808.0))
+        return -1;
+      return (int64_t )inValue;
+    }
+    // -------------------------------------------------------------------------
     // setValue
     // -------------------------------------------------------------------------
     static void setValue(double inValue, unsigned char *outDataPtr, size_t inOffset,
@@ -968,14 +1123,25 @@ namespace ibc { namespace gl { namespace file
     // -------------------------------------------------------------------------
     static void flipEndian(unsigned char *ioDataPtr, DataType inType)
     {
-      IBC_GL_FILE_PLY_TRACE();
+      IBC_GL_FILE_PLY_TRACE_ONCE();
+      flipEndian(ioDataPtr, 0, 1, inType);
+    }
+    // -------------------------------------------------------------------------
+    // flipEndian
+    // -------------------------------------------------------------------------
+    // Flips inNum values placed every inStride bytes in-place
+    // (e.g. one property of all the elements)
+    static void flipEndian(unsigned char *ioDataPtr, size_t inStride, size_t inNum,
+                           DataType inType)
+    {
+      IBC_GL_FILE_PLY_TRACE_ONCE();
       switch (inType)
       {
         case DATA_TYPE_INT16:
         case DATA_TYPE_UINT16:
         case DATA_TYPE_SHORT:
         case DATA_TYPE_USHORT:
-          ibc::Endian::swapBytes(ioDataPtr, 2);
+          ibc::Endian::swapBuffer16Strided(ioDataPtr, inStride, ioDataPtr, inStride, inNum);
           break;
         case DATA_TYPE_INT32:
         case DATA_TYPE_UINT32:
@@ -983,11 +1149,11 @@ namespace ibc { namespace gl { namespace file
         case DATA_TYPE_INT:
         case DATA_TYPE_UINT:
         case DATA_TYPE_FLOAT:
-          ibc::Endian::swapBytes(ioDataPtr, 4);
+          ibc::Endian::swapBuffer32Strided(ioDataPtr, inStride, ioDataPtr, inStride, inNum);
           break;
         case DATA_TYPE_FLOAT64:
         case DATA_TYPE_DOUBLE:
-          ibc::Endian::swapBytes(ioDataPtr, 8);
+          ibc::Endian::swapBuffer64Strided(ioDataPtr, inStride, ioDataPtr, inStride, inNum);
           break;
         default:
           break;
@@ -1044,10 +1210,44 @@ namespace ibc { namespace gl { namespace file
       clipToDataTypeRange(inType, &v);
       return v;
     }
+    // -------------------------------------------------------------------------
+    // getIntegerFromStr
+    // -------------------------------------------------------------------------
+    static bool getIntegerFromStr(const char *inDataStrPtr, size_t inDataSize,
+                            int64_t *outValue)
+    {
+      IBC_GL_FILE_PLY_TRACE_ONCE();
+      std::from_chars_result result =
+        std::from_chars(inDataStrPtr, inDataStrPtr + inDataSize, *outValue);
+      if (result.ec != std::errc())
+        return false;
+      return true;
+    }
 
   protected:
     // Constants ---------------------------------------------------------------
     static const size_t  MIN_HEADER_LEN  = (3+1+10);   // "ply" + "\r" + "end_header"
+    static const size_t  MAX_HEADER_WORD_NUM  = 8;      // "property list <type> <type> <name>" + margin
+    static const int     PROPERTY_SLOT_NUM    = 16;     // See getPropertySlot()
+
+    // Typedefs ----------------------------------------------------------------
+    // Per-element property table, which is built when the properties are added.
+    // This makes the property lookups O(1) instead of walking all the properties.
+    typedef struct
+    {
+      size_t  propertyIndex;  // Index of mProperties
+      size_t  binaryOffset;   // Offset in a binary record (valid if isAfterList == false)
+      size_t  asciiOffset;    // Word index in an ascii record (valid if isAfterList == false)
+      bool    isAfterList;    // A property list precedes this property
+    } PropertyLayout;
+    typedef struct
+    {
+      size_t  singleDataSize; // Sum of the non-list property sizes
+      bool    containsList;
+      std::vector<size_t>         propertyIndices;  // Indices of mProperties (in order)
+      std::vector<PropertyLayout> layouts;          // Same order as propertyIndices
+      int     slots[PROPERTY_SLOT_NUM];             // Slot -> index of layouts (or -1)
+    } ElementLayout;
 
     // Member variables --------------------------------------------------------
     DataFormat    mDataFormat;
@@ -1056,9 +1256,107 @@ namespace ibc { namespace gl { namespace file
     std::string   mObjInfoStr;
     std::vector<Element>  mElements;
     std::vector<Property> mProperties;
+    std::vector<ElementLayout>  mElementLayouts;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // addPropertyLayout
+    // -------------------------------------------------------------------------
+    void  addPropertyLayout(size_t inPropertyIndex)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      const Property  &property = mProperties[inPropertyIndex];
+      if (property.elementIndex >= mElementLayouts.size())
+        return;
+      ElementLayout &elementLayout = mElementLayouts[property.elementIndex];
+      PropertyLayout  layout;
+      layout.propertyIndex  = inPropertyIndex;
+      layout.binaryOffset   = elementLayout.singleDataSize;
+      layout.asciiOffset    = elementLayout.propertyIndices.size();
+      layout.isAfterList    = elementLayout.containsList;
+      int slot = getPropertySlot(property.type);
+      if (slot >= 0 && elementLayout.slots[slot] < 0)
+        elementLayout.slots[slot] = (int )elementLayout.layouts.size();
+      elementLayout.propertyIndices.push_back(inPropertyIndex);
+      elementLayout.layouts.push_back(layout);
+      if (property.isList)
+        elementLayout.containsList = true;
+      else
+        elementLayout.singleDataSize += sizeofDataType(property.dataType);
+    }
+    // -------------------------------------------------------------------------
+    // findPropertyLayout
+    // -------------------------------------------------------------------------
+    const PropertyLayout  *findPropertyLayout(size_t inElementIndex, PropertyType inType) const
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      if (inElementIndex >= mElementLayouts.size())
+        return NULL;
+      const ElementLayout &elementLayout = mElementLayouts[inElementIndex];
+      int slot = getPropertySlot(inType);
+      if (slot >= 0)
+      {
+        if (elementLayout.slots[slot] < 0)
+          return NULL;
+        return &(elementLayout.layouts[elementLayout.slots[slot]]);
+      }
+      // User defined properties (rare case)
+      for (size_t i = 0; i < elementLayout.layouts.size(); i++)
+        if (mProperties[elementLayout.layouts[i].propertyIndex].type == inType)
+          return &(elementLayout.layouts[i]);
+      return NULL;
+    }
 
     // Static Functions --------------------------------------------------------
     // -------------------------------------------------------------------------
+    // getPropertySlot
+    // -------------------------------------------------------------------------
+    // Perfect hash of the known property types (-1 for the others)
+    static int getPropertySlot(PropertyType inType)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      if (inType >= PROPERTY_X && inType <= PROPERTY_CONFIDENCE)
+        return inType - PROPERTY_X;   // 0 - 11
+      switch (inType)
+      {
+        case PROPERTY_VERTEX_METERIAL_INDEX:
+          return 12;
+        case PROPERTY_FACE_VERTEX_INDEX:
+          return 13;
+        case PROPERTY_EDGE_VERTEX1:
+          return 14;
+        case PROPERTY_EDGE_VERTEX2:
+          return 15;
+        default:
+          break;
+      }
+      return -1;
+    }
+    // -------------------------------------------------------------------------
+    // appendHeaderLines
+    // -------------------------------------------------------------------------
+    // Appends "<inKeyword> <line>" for each EOL separated line in inLinesStr
+    static void appendHeaderLines(std::string *outStr, const char *inKeyword,
+                                  const std::string &inLinesStr)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      size_t  from = 0;
+      while (from < inLinesStr.size())
+      {
+        size_t  to = inLinesStr.find(Common::CHAR_EOL_CODE, from);
+        if (to == std::string::npos)
+          to = inLinesStr.size();
+        outStr->append(inKeyword);
+        if (to != from)
+        {
+          outStr->append(" ");
+          outStr->append(inLinesStr, from, to - from);
+        }
+        outStr->append(1, Common::CHAR_EOL_CODE);
+        from = to + 1;
+      }
+    }
+    // -------------------------------------------------------------------------
     // getReservedWord
     // -------------------------------------------------------------------------
     static const char *getReservedWord(LineType inLine)
@@ -1093,16 +1391,41 @@ namespace ibc { namespace gl { namespace file
     static LineType findReservedWord(const char *inStr, size_t inLen)
     {
       IBC_GL_FILE_PLY_TRACE();
-      const LineType  wordIndex[] = {
-        LINE_TYPE_START, LINE_TYPE_END, LINE_TYPE_FORMAT,
-        LINE_TYPE_COMMENT, LINE_TYPE_OBJ_INFO, LINE_TYPE_ELEMENT,
-        LINE_TYPE_PROPERTY, LINE_TYPE_PROPERTY_LIST};
-      //
+      // The reserved words can be distinguished by the length and the first
+      // character, so we need at most one string comparison here
       std::string_view  strView(inStr, inLen);
-      size_t num = sizeof(wordIndex) / sizeof(PropertyType);
-      for (size_t i = 0; i < num; i++)
-        if (strView == getReservedWord(wordIndex[i]))
-          return wordIndex[i];
+      LineType  type = LINE_TYPE_NOT_SPECIFIED;
+      switch (inLen)
+      {
+        case 3:
+          type = LINE_TYPE_START;
+          break;
+        case 4:
+          type = LINE_TYPE_PROPERTY_LIST;
+          break;
+        case 6:
+          type = LINE_TYPE_FORMAT;
+          break;
+        case 7:
+          if (inStr[0] == 'c')
+            type = LINE_TYPE_COMMENT;
+          else
+            type = LINE_TYPE_ELEMENT;
+          break;
+        case 8:
+          if (inStr[0] == 'o')
+            type = LINE_TYPE_OBJ_INFO;
+          else
+            type = LINE_TYPE_PROPERTY;
+          break;
+        case 10:
+          type = LINE_TYPE_END;
+          break;
+        default:
+          return LINE_TYPE_NOT_SPECIFIED;
+      }
+      if (strView == getReservedWord(type))
+        return type;
       //
       return LINE_TYPE_NOT_SPECIFIED;
     }
@@ -1142,16 +1465,24 @@ namespace ibc { namespace gl { namespace file
     static DataFormat findDataFormatWord(const char *inStr, size_t inLen)
     {
       IBC_GL_FILE_PLY_TRACE();
-      const DataFormat  wordIndex[] = {
-        DATA_FORMAT_ASCII,
-        DATA_FORMAT_BINARY_LITTLE_ENDIAN,
-        DATA_FORMAT_BINARY_BIG_ENDIAN};
-      //
       std::string_view  strView(inStr, inLen);
-      size_t num = sizeof(wordIndex) / sizeof(PropertyType);
-      for (size_t i = 0; i < num; i++)
-        if (strView == getDataFormatWord(wordIndex[i]))
-          return wordIndex[i];
+      DataFormat  format = DATA_FORMAT_NOT_SPECIFIED;
+      switch (inLen)
+      {
+        case 5:
+          format = DATA_FORMAT_ASCII;
+          break;
+        case 17:
+          format = DATA_FORMAT_BINARY_BIG_ENDIAN;
+          break;
+        case 20:
+          format = DATA_FORMAT_BINARY_LITTLE_ENDIAN;
+          break;
+        default:
+          return DATA_FORMAT_NOT_SPECIFIED;
+      }
+      if (strView == getDataFormatWord(format))
+        return format;
       //
       return DATA_FORMAT_NOT_SPECIFIED;
     }
@@ -1207,30 +1538,69 @@ namespace ibc { namespace gl { namespace file
     static DataType findDataTypeWord(const char *inStr, size_t inLen)
     {
       IBC_GL_FILE_PLY_TRACE();
-      const DataType  wordIndex[] = {
-        DATA_TYPE_INT8,     DATA_TYPE_UINT8,
-        DATA_TYPE_INT16,    DATA_TYPE_UINT16,
-        DATA_TYPE_INT32,    DATA_TYPE_UINT32,
-        DATA_TYPE_FLOAT32,  DATA_TYPE_FLOAT64,
-        //
-        DATA_TYPE_CHAR,     DATA_TYPE_UCHAR,
-        DATA_TYPE_SHORT,    DATA_TYPE_USHORT,
-        DATA_TYPE_INT,      DATA_TYPE_UINT,
-        DATA_TYPE_FLOAT,    DATA_TYPE_DOUBLE};
-      //
+      // Since we will not use the obsolete style internally,
+      // the obsolete words are mapped to the new style types here
       std::string_view  strView(inStr, inLen);
-      size_t num = sizeof(wordIndex) / sizeof(PropertyType);
-      for (size_t i = 0; i < num; i++)
-        if (strView == getDataTypeWord(wordIndex[i]))
-        {
-          if (wordIndex[i] <  DATA_TYPE_CHAR)
-            return wordIndex[i];
-          else
-            // Since we will not use the obsolete style internally
-            return (DataType )(wordIndex[i] - DATA_TYPE_CHAR + DATA_TYPE_INT8);
-        }
-      //
-      return DATA_TYPE_NOT_SPECIFIED;
+      DataType  type = DATA_TYPE_NOT_SPECIFIED;
+      DataType  wordType = DATA_TYPE_NOT_SPECIFIED;
+      if (inLen == 0)
+        return DATA_TYPE_NOT_SPECIFIED;
+      switch (inStr[0])
+      {
+        case 'i':   // int8, int16, int32, int
+          switch (inLen)
+          {
+            case 3:
+              wordType = DATA_TYPE_INT;
+              break;
+            case 4:
+              wordType = DATA_TYPE_INT8;
+              break;
+            case 5:
+              wordType = (inStr[3] == '1') ? DATA_TYPE_INT16 : DATA_TYPE_INT32;
+              break;
+          }
+          break;
+        case 'u':   // uint8, uint16, uint32, uchar, ushort, uint
+          switch (inLen)
+          {
+            case 4:
+              wordType = DATA_TYPE_UINT;
+              break;
+            case 5:
+              wordType = (inStr[1] == 'c') ? DATA_TYPE_UCHAR : DATA_TYPE_UINT8;
+              break;
+            case 6:
+              if (inStr[1] == 's')
+                wordType = DATA_TYPE_USHORT;
+              else
+                wordType = (inStr[4] == '1') ? DATA_TYPE_UINT16 : DATA_TYPE_UINT32;
+              break;
+          }
+          break;
+        case 'f':   // float32, float64, float
+          if (inLen == 5)
+            wordType = DATA_TYPE_FLOAT;
+          else if (inLen == 7)
+            wordType = (inStr[5] == '3') ? DATA_TYPE_FLOAT32 : DATA_TYPE_FLOAT64;
+          break;
+        case 'c':
+          wordType = DATA_TYPE_CHAR;
+          break;
+        case 's':
+          wordType = DATA_TYPE_SHORT;
+          break;
+        case 'd':
+          wordType = DATA_TYPE_DOUBLE;
+          break;
+      }
+      if (wordType == DATA_TYPE_NOT_SPECIFIED || strView != getDataTypeWord(wordType))
+        return DATA_TYPE_NOT_SPECIFIED;
+      if (wordType < DATA_TYPE_CHAR)
+        type = wordType;
+      else
+        type = (DataType )(wordType - DATA_TYPE_CHAR + DATA_TYPE_INT8);
+      return type;
     }
     // -------------------------------------------------------------------------
     // sizeofDataType
@@ -1346,15 +1716,24 @@ namespace ibc { namespace gl { namespace file
     static ElementType findElementTypetWord(const char *inStr, size_t inLen)
     {
       IBC_GL_FILE_PLY_TRACE();
-      const ElementType  wordIndex[] = {
-        ELEMENT_TYPE_VERTEX, ELEMENT_TYPE_FACE,
-        ELEMENT_TYPE_EDGE, ELEMENT_TYPE_MATERIAL};
-      //
       std::string_view  strView(inStr, inLen);
-      size_t num = sizeof(wordIndex) / sizeof(PropertyType);
-      for (size_t i = 0; i < num; i++)
-        if (strView == getElementTypeWord(wordIndex[i]))
-          return wordIndex[i];
+      ElementType type = ELEMENT_TYPE_USER;
+      switch (inLen)
+      {
+        case 4:
+          type = (inStr[0] == 'f') ? ELEMENT_TYPE_FACE : ELEMENT_TYPE_EDGE;
+          break;
+        case 6:
+          type = ELEMENT_TYPE_VERTEX;
+          break;
+        case 8:
+          type = ELEMENT_TYPE_MATERIAL;
+          break;
+        default:
+          return ELEMENT_TYPE_USER;
+      }
+      if (strView == getElementTypeWord(type))
+        return type;
       //
       return ELEMENT_TYPE_USER;
     }
@@ -1410,22 +1789,50 @@ namespace ibc { namespace gl { namespace file
     static PropertyType findPropertyTypeWord(const char *inStr, size_t inLen)
     {
       IBC_GL_FILE_PLY_TRACE();
-      const PropertyType  wordIndex[] = {
-        PROPERTY_X,   PROPERTY_Y,     PROPERTY_Z,
-        PROPERTY_NX,  PROPERTY_NY,    PROPERTY_NZ,
-        PROPERTY_RED, PROPERTY_GREEN, PROPERTY_BLUE, PROPERTY_ALPHA,
-        PROPERTY_INTENSITY, PROPERTY_CONFIDENCE,
-        PROPERTY_VERTEX_METERIAL_INDEX,
-        PROPERTY_FACE_VERTEX_INDEX,
-        PROPERTY_EDGE_VERTEX1, PROPERTY_EDGE_VERTEX2};
-      //
       std::string_view  strView(inStr, inLen);
-      size_t num = sizeof(wordIndex) / sizeof(PropertyType);
-      for (size_t i = 0; i < num; i++)
+      PropertyType  type = PROPERTY_TYPE_USER;
+      switch (inLen)
       {
-        if (strView == getPropertyTypeWord(wordIndex[i]))
-          return wordIndex[i];
+        case 1:   // x, y, z
+          if (inStr[0] >= 'x' && inStr[0] <= 'z')
+            return (PropertyType )(PROPERTY_X + (inStr[0] - 'x'));
+          return PROPERTY_TYPE_USER;
+        case 2:   // nx, ny, nz
+          if (inStr[0] == 'n' && inStr[1] >= 'x' && inStr[1] <= 'z')
+            return (PropertyType )(PROPERTY_NX + (inStr[1] - 'x'));
+          return PROPERTY_TYPE_USER;
+        case 3:
+          type = PROPERTY_RED;
+          break;
+        case 4:
+          type = PROPERTY_BLUE;
+          break;
+        case 5:
+          type = (inStr[0] == 'g') ? PROPERTY_GREEN : PROPERTY_ALPHA;
+          break;
+        case 7:
+          type = (inStr[6] == '1') ? PROPERTY_EDGE_VERTEX1 : PROPERTY_EDGE_VERTEX2;
+          break;
+        case 9:
+          type = PROPERTY_INTENSITY;
+          break;
+        case 10:
+          type = PROPERTY_CONFIDENCE;
+          break;
+        case 12:
+          type = PROPERTY_FACE_VERTEX_INDEX;
+          break;
+        case 14:
+          // Many tools (e.g. meshlab, blender) write "vertex_indices" instead
+          if (strView == "vertex_indices")
+            return PROPERTY_FACE_VERTEX_INDEX;
+          type = PROPERTY_VERTEX_METERIAL_INDEX;
+          break;
+        default:
+          return PROPERTY_TYPE_USER;
       }
+      if (strView == getPropertyTypeWord(type))
+        return type;
       //
       return PROPERTY_TYPE_USER;
     }
@@ -1516,9 +1923,12 @@ namespace ibc { namespace gl { namespace file
     // -------------------------------------------------------------------------
     // get_glXYZf_RGBAub
     // -------------------------------------------------------------------------
+    // If outMinMax is specified, the bounding box is calculated while decoding
+    // (see BoundingBox::calcFitParam() for the fit parameter)
     static bool get_glXYZf_RGBAub(const PLYHeader &inHeader,
                     const void *inDataPtr, size_t inDataSize,
-                    ibc::gl::glXYZf_RGBAub **outDataPtr, size_t *outDataNum)
+                    ibc::gl::glXYZf_RGBAub **outDataPtr, size_t *outDataNum,
+                    GLfloat outMinMax[6] = NULL)
     {
       IBC_GL_FILE_PLY_TRACE();
       DestinationInfo infos[] = {
@@ -1540,7 +1950,7 @@ namespace ibc { namespace gl { namespace file
         { PLYHeader::PROPERTY_BLUE, PLYHeader::DATA_TYPE_UINT8,
           offsetof(ibc::gl::glXYZf_RGBAub, b),
           false, 255.0, false, 1.0, 0.0, false, 0, 0 },
-        { PLYHeader::PROPERTY_TYPE_NOT_SPECIFIED, PLYHeader::DATA_TYPE_UINT8,
+        { PLYHeader::PROPERTY_ALPHA, PLYHeader::DATA_TYPE_UINT8,
           offsetof(ibc::gl::glXYZf_RGBAub, a),
           false, 255.0, false, 1.0, 0.0, false, 0, 0 }};
       //
@@ -1548,78 +1958,498 @@ namespace ibc { namespace gl { namespace file
                 infos, sizeof(infos)/sizeof(DestinationInfo),
                 sizeof(ibc::gl::glXYZf_RGBAub),
                 inDataPtr, inDataSize,
-                (void **)outDataPtr, outDataNum);
+                (void **)outDataPtr, outDataNum, outMinMax);
     }
     // -------------------------------------------------------------------------
-    // calcFitParam_glXYZf_RGBAub
+    // get_glXYZf
     // -------------------------------------------------------------------------
-    static void calcFitParam_glXYZf_RGBAub(
-                    const ibc::gl::glXYZf_RGBAub *inDataPtr, size_t inDataNum,
-                    GLfloat outParam[4], GLfloat outMinMax[6])
+    static bool get_glXYZf(const PLYHeader &inHeader,
+                    const void *inDataPtr, size_t inDataSize,
+                    ibc::gl::glXYZf **outDataPtr, size_t *outDataNum,
+                    GLfloat outMinMax[6] = NULL)
     {
       IBC_GL_FILE_PLY_TRACE();
-      GLfloat x_min, y_min, z_min;
-      GLfloat x_max, y_max, z_max;
-      x_min = inDataPtr->x;
-      y_min = inDataPtr->y;
-      z_min = inDataPtr->z;
-      x_max = inDataPtr->x;
-      y_max = inDataPtr->y;
-      z_max = inDataPtr->z;
-      for (size_t i = 0; i < inDataNum; i++)
-      {
-        if (inDataPtr[i].x < x_min)
-          x_min = inDataPtr[i].x;
-        if (inDataPtr[i].y < y_min)
-          y_min = inDataPtr[i].y;
-        if (inDataPtr[i].z < z_min)
-          z_min = inDataPtr[i].z;
-        //
-        if (inDataPtr[i].x > x_max)
-          x_max = inDataPtr[i].x;
-        if (inDataPtr[i].y > y_max)
-          y_max = inDataPtr[i].y;
-        if (inDataPtr[i].z > z_max)
-          z_max = inDataPtr[i].z;
-      }
-      GLfloat size_x = x_max - x_min;
-      GLfloat size_y = y_max - y_min;
-      GLfloat size_z = z_max - z_min;
-      GLfloat size_max = size_x;
-      if (size_y > size_max)
-        size_max = size_y;
-      if (size_z > size_max)
-        size_max = size_z;
-      //
-      outParam[0] = -1.0 * (x_min + size_x / 2.0);
-      outParam[1] = -1.0 * (y_min + size_y / 2.0);
-      outParam[2] = -1.0 * (z_min + size_z / 2.0);
-      if (size_max != 0)
-        outParam[3] = 2.0 / size_max;
-      else
-        outParam[3] = 1.0;
+      DestinationInfo infos[] = {
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZf, x, PROPERTY_X, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZf, y, PROPERTY_Y, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZf, z, PROPERTY_Z, DATA_TYPE_FLOAT32, true, 0.0)};
       //
-      outMinMax[0] = x_min;
-      outMinMax[1] = x_max;
-      outMinMax[2] = y_min;
-      outMinMax[3] = y_max;
-      outMinMax[4] = z_min;
-      outMinMax[5] = z_max;
+      return parseData(inHeader, PLYHeader::ELEMENT_TYPE_VERTEX,
+                infos, sizeof(infos)/sizeof(DestinationInfo),
+                sizeof(ibc::gl::glXYZf),
+                inDataPtr, inDataSize,
+                (void **)outDataPtr, outDataNum, outMinMax);
     }
-
-  protected:
-    // Static Functions --------------------------------------------------------
-    typedef struct
+    // -------------------------------------------------------------------------
+    // get_glXYZ_RGBf
+    // -------------------------------------------------------------------------
+    static bool get_glXYZ_RGBf(const PLYHeader &inHeader,
+                    const void *inDataPtr, size_t inDataSize,
+                    ibc::gl::glXYZ_RGBf **outDataPtr, size_t *outDataNum,
+                    GLfloat outMinMax[6] = NULL)
     {
-      PLYHeader::PropertyType sourcePropertyType;
-      PLYHeader::DataType     destinationDataType;
-      size_t  destinationDataOffset;
-      //
-      bool        mandatory;
-      double      defaultValue;
+      IBC_GL_FILE_PLY_TRACE();
+      DestinationInfo infos[] = {
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_RGBf, x, PROPERTY_X, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_RGBf, y, PROPERTY_Y, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_RGBf, z, PROPERTY_Z, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO_COLOR(glXYZ_RGBf, r, PROPERTY_RED),
+        IBC_GL_FILE_PLY_INPUT_INFO_COLOR(glXYZ_RGBf, g, PROPERTY_GREEN),
+        IBC_GL_FILE_PLY_INPUT_INFO_COLOR(glXYZ_RGBf, b, PROPERTY_BLUE)};
       //
-      bool        convert;
-      double      gain;
+      return parseData(inHeader, PLYHeader::ELEMENT_TYPE_VERTEX,
+                infos, sizeof(infos)/sizeof(DestinationInfo),
+                sizeof(ibc::gl::glXYZ_RGBf),
+                inDataPtr, inDataSize,
+                (void **)outDataPtr, outDataNum, outMinMax);
+    }
+    // -------------------------------------------------------------------------
+    // get_glXYZ_If
+    // -------------------------------------------------------------------------
+    static bool get_glXYZ_If(const PLYHeader &inHeader,
+                    const void *inDataPtr, size_t inDataSize,
+                    ibc::gl::glXYZ_If **outDataPtr, size_t *outDataNum,
+                    GLfloat outMinMax[6] = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      DestinationInfo infos[] = {
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_If, x, PROPERTY_X, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_If, y, PROPERTY_Y, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_If, z, PROPERTY_Z, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_If, i, PROPERTY_INTENSITY, DATA_TYPE_FLOAT32, false, 0.0)};
+      //
+      return parseData(inHeader, PLYHeader::ELEMENT_TYPE_VERTEX,
+                infos, sizeof(infos)/sizeof(DestinationInfo),
+                sizeof(ibc::gl::glXYZ_If),
+                inDataPtr, inDataSize,
+                (void **)outDataPtr, outDataNum, outMinMax);
+    }
+    // -------------------------------------------------------------------------
+    // get_glXYZ_NORM_RGBf
+    // -------------------------------------------------------------------------
+    static bool get_glXYZ_NORM_RGBf(const PLYHeader &inHeader,
+                    const void *inDataPtr, size_t inDataSize,
+                    ibc::gl::glXYZ_NORM_RGBf **outDataPtr, size_t *outDataNum,
+                    GLfloat outMinMax[6] = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      DestinationInfo infos[] = {
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_RGBf, x, PROPERTY_X, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_RGBf, y, PROPERTY_Y, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_RGBf, z, PROPERTY_Z, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_RGBf, nx, PROPERTY_NX, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_RGBf, ny, PROPERTY_NY, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_RGBf, nz, PROPERTY_NZ, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO_COLOR(glXYZ_NORM_RGBf, r, PROPERTY_RED),
+        IBC_GL_FILE_PLY_INPUT_INFO_COLOR(glXYZ_NORM_RGBf, g, PROPERTY_GREEN),
+        IBC_GL_FILE_PLY_INPUT_INFO_COLOR(glXYZ_NORM_RGBf, b, PROPERTY_BLUE)};
+      //
+      return parseData(inHeader, PLYHeader::ELEMENT_TYPE_VERTEX,
+                infos, sizeof(infos)/sizeof(DestinationInfo),
+                sizeof(ibc::gl::glXYZ_NORM_RGBf),
+                inDataPtr, inDataSize,
+                (void **)outDataPtr, outDataNum, outMinMax);
+    }
+    // -------------------------------------------------------------------------
+    // get_glXYZ_NORM_If
+    // -------------------------------------------------------------------------
+    static bool get_glXYZ_NORM_If(const PLYHeader &inHeader,
+                    const void *inDataPtr, size_t inDataSize,
+                    ibc::gl::glXYZ_NORM_If **outDataPtr, size_t *outDataNum,
+                    GLfloat outMinMax[6] = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      DestinationInfo infos[] = {
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_If, x, PROPERTY_X, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_If, y, PROPERTY_Y, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_If, z, PROPERTY_Z, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_If, nx, PROPERTY_NX, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_If, ny, PROPERTY_NY, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_If, nz, PROPERTY_NZ, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORM_If, i, PROPERTY_INTENSITY, DATA_TYPE_FLOAT32, false, 0.0)};
+      //
+      return parseData(inHeader, PLYHeader::ELEMENT_TYPE_VERTEX,
+                infos, sizeof(infos)/sizeof(DestinationInfo),
+                sizeof(ibc::gl::glXYZ_NORM_If),
+                inDataPtr, inDataSize,
+                (void **)outDataPtr, outDataNum, outMinMax);
+    }
+    // -------------------------------------------------------------------------
+    // get_glXYZ_NORMf_RGBAub
+    // -------------------------------------------------------------------------
+    static bool get_glXYZ_NORMf_RGBAub(const PLYHeader &inHeader,
+                    const void *inDataPtr, size_t inDataSize,
+                    ibc::gl::glXYZ_NORMf_RGBAub **outDataPtr, size_t *outDataNum,
+                    GLfloat outMinMax[6] = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      DestinationInfo infos[] = {
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_RGBAub, x, PROPERTY_X, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_RGBAub, y, PROPERTY_Y, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_RGBAub, z, PROPERTY_Z, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_RGBAub, nx, PROPERTY_NX, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_RGBAub, ny, PROPERTY_NY, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_RGBAub, nz, PROPERTY_NZ, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_RGBAub, r, PROPERTY_RED, DATA_TYPE_UINT8, false, 255.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_RGBAub, g, PROPERTY_GREEN, DATA_TYPE_UINT8, false, 255.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_RGBAub, b, PROPERTY_BLUE, DATA_TYPE_UINT8, false, 255.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_RGBAub, a, PROPERTY_ALPHA, DATA_TYPE_UINT8, false, 255.0)};
+      //
+      return parseData(inHeader, PLYHeader::ELEMENT_TYPE_VERTEX,
+                infos, sizeof(infos)/sizeof(DestinationInfo),
+                sizeof(ibc::gl::glXYZ_NORMf_RGBAub),
+                inDataPtr, inDataSize,
+                (void **)outDataPtr, outDataNum, outMinMax);
+    }
+    // -------------------------------------------------------------------------
+    // get_glXYZf_Iub
+    // -------------------------------------------------------------------------
+    static bool get_glXYZf_Iub(const PLYHeader &inHeader,
+                    const void *inDataPtr, size_t inDataSize,
+                    ibc::gl::glXYZf_Iub **outDataPtr, size_t *outDataNum,
+                    GLfloat outMinMax[6] = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      DestinationInfo infos[] = {
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZf_Iub, x, PROPERTY_X, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZf_Iub, y, PROPERTY_Y, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZf_Iub, z, PROPERTY_Z, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZf_Iub, i, PROPERTY_INTENSITY, DATA_TYPE_UINT8, false, 0.0)};
+      //
+      return parseData(inHeader, PLYHeader::ELEMENT_TYPE_VERTEX,
+                infos, sizeof(infos)/sizeof(DestinationInfo),
+                sizeof(ibc::gl::glXYZf_Iub),
+                inDataPtr, inDataSize,
+                (void **)outDataPtr, outDataNum, outMinMax);
+    }
+    // -------------------------------------------------------------------------
+    // get_glXYZ_NORMf_Iub
+    // -------------------------------------------------------------------------
+    static bool get_glXYZ_NORMf_Iub(const PLYHeader &inHeader,
+                    const void *inDataPtr, size_t inDataSize,
+                    ibc::gl::glXYZ_NORMf_Iub **outDataPtr, size_t *outDataNum,
+                    GLfloat outMinMax[6] = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      DestinationInfo infos[] = {
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_Iub, x, PROPERTY_X, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_Iub, y, PROPERTY_Y, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_Iub, z, PROPERTY_Z, DATA_TYPE_FLOAT32, true, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_Iub, nx, PROPERTY_NX, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_Iub, ny, PROPERTY_NY, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_Iub, nz, PROPERTY_NZ, DATA_TYPE_FLOAT32, false, 0.0),
+        IBC_GL_FILE_PLY_INPUT_INFO(glXYZ_NORMf_Iub, i, PROPERTY_INTENSITY, DATA_TYPE_UINT8, false, 0.0)};
+      //
+      return parseData(inHeader, PLYHeader::ELEMENT_TYPE_VERTEX,
+                infos, sizeof(infos)/sizeof(DestinationInfo),
+                sizeof(ibc::gl::glXYZ_NORMf_Iub),
+                inDataPtr, inDataSize,
+                (void **)outDataPtr, outDataNum, outMinMax);
+    }
+    // -------------------------------------------------------------------------
+    // get_faces
+    // -------------------------------------------------------------------------
+    static bool get_faces(const PLYHeader &inHeader,
+                    const void *inDataPtr, size_t inDataSize,
+                    ibc::gl::glFacesCSR *outFaces)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      size_t  elementIndex, propertyIndex, offset;
+      outFaces->offsets.clear();
+      outFaces->indices.clear();
+      if (findFaceElement(inHeader, inDataPtr, inDataSize,
+                          &elementIndex, &propertyIndex, &offset) == false)
+        return false;
+      //
+      bool  result;
+      if (inHeader.mDataFormat != PLYHeader::DATA_FORMAT_ASCII)
+        result = parseFacesBinary(inHeader, elementIndex, propertyIndex,
+                          ((const unsigned char *)inDataPtr) + offset, inDataSize - offset,
+                          outFaces);
+      else
+        result = parseFacesAscii(inHeader, elementIndex, propertyIndex,
+                          ((const char *)inDataPtr) + offset, inDataSize - offset,
+                          outFaces);
+      if (result == false)
+      {
+        outFaces->offsets.clear();
+        outFaces->indices.clear();
+      }
+      return result;
+    }
+    // -------------------------------------------------------------------------
+    // get_triangles
+    // -------------------------------------------------------------------------
+    // Returns the triangle index array which can be passed to
+    // GL_ELEMENT_ARRAY_BUFFER as is (GL_TRIANGLES, GL_UNSIGNED_INT).
+    // Polygons which have more than 3 vertices are split as triangle fans.
+    static bool get_triangles(const PLYHeader &inHeader,
+                    const void *inDataPtr, size_t inDataSize,
+                    GLuint **outIndexPtr, size_t *outIndexNum)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      size_t  elementIndex, propertyIndex, offset;
+      *outIndexPtr = NULL;
+      *outIndexNum = 0;
+      if (findFaceElement(inHeader, inDataPtr, inDataSize,
+                          &elementIndex, &propertyIndex, &offset) == false)
+        return false;
+      //
+      // Fast path : binary file which contains triangles only
+      if (parseTrianglesBinary(inHeader, elementIndex, propertyIndex,
+                          ((const unsigned char *)inDataPtr) + offset, inDataSize - offset,
+                          outIndexPtr, outIndexNum))
+        return true;
+      //
+      ibc::gl::glFacesCSR faces;
+      if (get_faces(inHeader, inDataPtr, inDataSize, &faces) == false)
+        return false;
+      size_t  faceNum = faces.offsets.size() - 1;
+      size_t  triangleNum = 0;
+      for (size_t i = 0; i < faceNum; i++)
+      {
+        size_t  num = faces.offsets[i + 1] - faces.offsets[i];
+        if (num >= 3)
+          triangleNum += num - 2;
+      }
+      *outIndexPtr = new GLuint[triangleNum * 3];
+      if (*outIndexPtr == NULL)
+      {
+        IBC_LOG_ERROR("*outIndexPtr == NULL");
+        return false;
+      }
+      GLuint  *indexPtr = *outIndexPtr;
+      for (size_t i = 0; i < faceNum; i++)
+      {
+        const GLuint  *facePtr = &(faces.indices[faces.offsets[i]]);
+        size_t  num = faces.offsets[i + 1] - faces.offsets[i];
+        for (size_t j = 2; j < num; j++)
+        {
+          *(indexPtr++) = facePtr[0];
+          *(indexPtr++) = facePtr[j - 1];
+          *(indexPtr++) = facePtr[j];
+        }
+      }
+      *outIndexNum = triangleNum * 3;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // write (glXYZf)
+    // -------------------------------------------------------------------------
+    static bool write(const char *inFileName,
+                    const ibc::gl::glXYZf *inDataPtr, size_t inDataNum,
+                    PLYHeader::DataFormat inFormat = PLYHeader::DATA_FORMAT_BINARY_LITTLE_ENDIAN,
+                    const ibc::gl::glFacesCSR *inFaces = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      OutputInfo infos[] = {
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf, x, PROPERTY_X, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf, y, PROPERTY_Y, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf, z, PROPERTY_Z, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT)};
+      //
+      return writeData(inFileName, inFormat,
+                infos, sizeof(infos)/sizeof(OutputInfo),
+                sizeof(ibc::gl::glXYZf), inDataPtr, inDataNum, inFaces);
+    }
+    // -------------------------------------------------------------------------
+    // write (glXYZ_RGBf)
+    // -------------------------------------------------------------------------
+    static bool write(const char *inFileName,
+                    const ibc::gl::glXYZ_RGBf *inDataPtr, size_t inDataNum,
+                    PLYHeader::DataFormat inFormat = PLYHeader::DATA_FORMAT_BINARY_LITTLE_ENDIAN,
+                    const ibc::gl::glFacesCSR *inFaces = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      OutputInfo infos[] = {
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_RGBf, x, PROPERTY_X, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_RGBf, y, PROPERTY_Y, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_RGBf, z, PROPERTY_Z, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO_COLOR(glXYZ_RGBf, r, PROPERTY_RED),
+        IBC_GL_FILE_PLY_OUTPUT_INFO_COLOR(glXYZ_RGBf, g, PROPERTY_GREEN),
+        IBC_GL_FILE_PLY_OUTPUT_INFO_COLOR(glXYZ_RGBf, b, PROPERTY_BLUE)};
+      //
+      return writeData(inFileName, inFormat,
+                infos, sizeof(infos)/sizeof(OutputInfo),
+                sizeof(ibc::gl::glXYZ_RGBf), inDataPtr, inDataNum, inFaces);
+    }
+    // -------------------------------------------------------------------------
+    // write (glXYZ_If)
+    // -------------------------------------------------------------------------
+    static bool write(const char *inFileName,
+                    const ibc::gl::glXYZ_If *inDataPtr, size_t inDataNum,
+                    PLYHeader::DataFormat inFormat = PLYHeader::DATA_FORMAT_BINARY_LITTLE_ENDIAN,
+                    const ibc::gl::glFacesCSR *inFaces = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      OutputInfo infos[] = {
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_If, x, PROPERTY_X, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_If, y, PROPERTY_Y, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_If, z, PROPERTY_Z, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_If, i, PROPERTY_INTENSITY, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT)};
+      //
+      return writeData(inFileName, inFormat,
+                infos, sizeof(infos)/sizeof(OutputInfo),
+                sizeof(ibc::gl::glXYZ_If), inDataPtr, inDataNum, inFaces);
+    }
+    // -------------------------------------------------------------------------
+    // write (glXYZ_NORM_RGBf)
+    // -------------------------------------------------------------------------
+    static bool write(const char *inFileName,
+                    const ibc::gl::glXYZ_NORM_RGBf *inDataPtr, size_t inDataNum,
+                    PLYHeader::DataFormat inFormat = PLYHeader::DATA_FORMAT_BINARY_LITTLE_ENDIAN,
+                    const ibc::gl::glFacesCSR *inFaces = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      OutputInfo infos[] = {
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_RGBf, x, PROPERTY_X, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_RGBf, y, PROPERTY_Y, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_RGBf, z, PROPERTY_Z, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_RGBf, nx, PROPERTY_NX, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_RGBf, ny, PROPERTY_NY, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_RGBf, nz, PROPERTY_NZ, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO_COLOR(glXYZ_NORM_RGBf, r, PROPERTY_RED),
+        IBC_GL_FILE_PLY_OUTPUT_INFO_COLOR(glXYZ_NORM_RGBf, g, PROPERTY_GREEN),
+        IBC_GL_FILE_PLY_OUTPUT_INFO_COLOR(glXYZ_NORM_RGBf, b, PROPERTY_BLUE)};
+      //
+      return writeData(inFileName, inFormat,
+                infos, sizeof(infos)/sizeof(OutputInfo),
+                sizeof(ibc::gl::glXYZ_NORM_RGBf), inDataPtr, inDataNum, inFaces);
+    }
+    // -------------------------------------------------------------------------
+    // write (glXYZ_NORM_If)
+    // -------------------------------------------------------------------------
+    static bool write(const char *inFileName,
+                    const ibc::gl::glXYZ_NORM_If *inDataPtr, size_t inDataNum,
+                    PLYHeader::DataFormat inFormat = PLYHeader::DATA_FORMAT_BINARY_LITTLE_ENDIAN,
+                    const ibc::gl::glFacesCSR *inFaces = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      OutputInfo infos[] = {
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_If, x, PROPERTY_X, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_If, y, PROPERTY_Y, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_If, z, PROPERTY_Z, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_If, nx, PROPERTY_NX, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_If, ny, PROPERTY_NY, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_If, nz, PROPERTY_NZ, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORM_If, i, PROPERTY_INTENSITY, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT)};
+      //
+      return writeData(inFileName, inFormat,
+                infos, sizeof(infos)/sizeof(OutputInfo),
+                sizeof(ibc::gl::glXYZ_NORM_If), inDataPtr, inDataNum, inFaces);
+    }
+    // -------------------------------------------------------------------------
+    // write (glXYZf_RGBAub)
+    // -------------------------------------------------------------------------
+    static bool write(const char *inFileName,
+                    const ibc::gl::glXYZf_RGBAub *inDataPtr, size_t inDataNum,
+                    PLYHeader::DataFormat inFormat = PLYHeader::DATA_FORMAT_BINARY_LITTLE_ENDIAN,
+                    const ibc::gl::glFacesCSR *inFaces = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      OutputInfo infos[] = {
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf_RGBAub, x, PROPERTY_X, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf_RGBAub, y, PROPERTY_Y, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf_RGBAub, z, PROPERTY_Z, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf_RGBAub, r, PROPERTY_RED, DATA_TYPE_UCHAR, DATA_TYPE_UCHAR),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf_RGBAub, g, PROPERTY_GREEN, DATA_TYPE_UCHAR, DATA_TYPE_UCHAR),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf_RGBAub, b, PROPERTY_BLUE, DATA_TYPE_UCHAR, DATA_TYPE_UCHAR),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf_RGBAub, a, PROPERTY_ALPHA, DATA_TYPE_UCHAR, DATA_TYPE_UCHAR)};
+      //
+      return writeData(inFileName, inFormat,
+                infos, sizeof(infos)/sizeof(OutputInfo),
+                sizeof(ibc::gl::glXYZf_RGBAub), inDataPtr, inDataNum, inFaces);
+    }
+    // -------------------------------------------------------------------------
+    // write (glXYZ_NORMf_RGBAub)
+    // -------------------------------------------------------------------------
+    static bool write(const char *inFileName,
+                    const ibc::gl::glXYZ_NORMf_RGBAub *inDataPtr, size_t inDataNum,
+                    PLYHeader::DataFormat inFormat = PLYHeader::DATA_FORMAT_BINARY_LITTLE_ENDIAN,
+                    const ibc::gl::glFacesCSR *inFaces = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      OutputInfo infos[] = {
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_RGBAub, x, PROPERTY_X, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_RGBAub, y, PROPERTY_Y, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_RGBAub, z, PROPERTY_Z, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_RGBAub, nx, PROPERTY_NX, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_RGBAub, ny, PROPERTY_NY, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_RGBAub, nz, PROPERTY_NZ, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_RGBAub, r, PROPERTY_RED, DATA_TYPE_UCHAR, DATA_TYPE_UCHAR),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_RGBAub, g, PROPERTY_GREEN, DATA_TYPE_UCHAR, DATA_TYPE_UCHAR),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_RGBAub, b, PROPERTY_BLUE, DATA_TYPE_UCHAR, DATA_TYPE_UCHAR),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_RGBAub, a, PROPERTY_ALPHA, DATA_TYPE_UCHAR, DATA_TYPE_UCHAR)};
+      //
+      return writeData(inFileName, inFormat,
+                infos, sizeof(infos)/sizeof(OutputInfo),
+                sizeof(ibc::gl::glXYZ_NORMf_RGBAub), inDataPtr, inDataNum, inFaces);
+    }
+    // -------------------------------------------------------------------------
+    // write (glXYZf_Iub)
+    // -------------------------------------------------------------------------
+    static bool write(const char *inFileName,
+                    const ibc::gl::glXYZf_Iub *inDataPtr, size_t inDataNum,
+                    PLYHeader::DataFormat inFormat = PLYHeader::DATA_FORMAT_BINARY_LITTLE_ENDIAN,
+                    const ibc::gl::glFacesCSR *inFaces = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      OutputInfo infos[] = {
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf_Iub, x, PROPERTY_X, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf_Iub, y, PROPERTY_Y, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf_Iub, z, PROPERTY_Z, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZf_Iub, i, PROPERTY_INTENSITY, DATA_TYPE_UCHAR, DATA_TYPE_UCHAR)};
+      //
+      return writeData(inFileName, inFormat,
+                infos, sizeof(infos)/sizeof(OutputInfo),
+                sizeof(ibc::gl::glXYZf_Iub), inDataPtr, inDataNum, inFaces);
+    }
+    // -------------------------------------------------------------------------
+    // write (glXYZ_NORMf_Iub)
+    // -------------------------------------------------------------------------
+    static bool write(const char *inFileName,
+                    const ibc::gl::glXYZ_NORMf_Iub *inDataPtr, size_t inDataNum,
+                    PLYHeader::DataFormat inFormat = PLYHeader::DATA_FORMAT_BINARY_LITTLE_ENDIAN,
+                    const ibc::gl::glFacesCSR *inFaces = NULL)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      OutputInfo infos[] = {
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_Iub, x, PROPERTY_X, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_Iub, y, PROPERTY_Y, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_Iub, z, PROPERTY_Z, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_Iub, nx, PROPERTY_NX, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_Iub, ny, PROPERTY_NY, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_Iub, nz, PROPERTY_NZ, DATA_TYPE_FLOAT, DATA_TYPE_FLOAT),
+        IBC_GL_FILE_PLY_OUTPUT_INFO(glXYZ_NORMf_Iub, i, PROPERTY_INTENSITY, DATA_TYPE_UCHAR, DATA_TYPE_UCHAR)};
+      //
+      return writeData(inFileName, inFormat,
+                infos, sizeof(infos)/sizeof(OutputInfo),
+                sizeof(ibc::gl::glXYZ_NORMf_Iub), inDataPtr, inDataNum, inFaces);
+    }
+    // -------------------------------------------------------------------------
+    // calcFitParam_glXYZf_RGBAub
+    // -------------------------------------------------------------------------
+    static void calcFitParam_glXYZf_RGBAub(
+                    const ibc::gl::glXYZf_RGBAub *inDataPtr, size_t inDataNum,
+                    GLfloat outParam[4], GLfloat outMinMax[6])
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      ibc::gl::BoundingBox::calcMinMax(inDataPtr, inDataNum, outMinMax);
+      ibc::gl::BoundingBox::calcFitParam(outMinMax, outParam);
+    }
+
+  protected:
+    // Static Functions --------------------------------------------------------
+    typedef struct
+    {
+      PLYHeader::PropertyType sourcePropertyType;
+      PLYHeader::DataType     destinationDataType;
+      size_t  destinationDataOffset;
+      //
+      bool        mandatory;
+      double      defaultValue;
+      //
+      bool        convert;
+      double      gain;
       double      offset;
       //
       bool        clip;
@@ -1633,6 +2463,129 @@ namespace ibc { namespace gl { namespace file
       size_t  offset;
       PLYHeader::DataType type;
     } SourceInfo;
+    //
+    typedef struct
+    {
+      PLYHeader::PropertyType outputPropertyType;
+      PLYHeader::DataType     outputDataType;
+      PLYHeader::DataType     sourceDataType;
+      size_t  sourceDataOffset;
+      //
+      bool        convert;
+      double      gain;
+      double      offset;
+    } OutputInfo;
+
+    // Constants ---------------------------------------------------------------
+    static const size_t  WRITE_BUFFER_SIZE  = 4 * 1024 * 1024;
+    static const size_t  MAX_VALUE_STR_LEN  = 32;  // enough for to_chars(double)
+    static const size_t  FLIP_BUFFER_SIZE   = 64 * 1024;
+
+    // -------------------------------------------------------------------------
+    // FileWriter class
+    // -------------------------------------------------------------------------
+    // Simple buffered writer on top of the file descriptor.
+    // The data is gathered into one large buffer and written by write(2),
+    // blocks which are larger than the buffer are written directly.
+    class FileWriter
+    {
+    public:
+      // Constructors and Destructor -------------------------------------------
+      FileWriter()
+      {
+        mFD = -1;
+        mBufferedSize = 0;
+      }
+      virtual ~FileWriter()
+      {
+        close();
+      }
+      // Member functions ------------------------------------------------------
+      bool  open(const char *inFileName, size_t inBufferSize)
+      {
+#ifndef Q_OS_WIN
+        mFD = ::open(inFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#else
+        mFD = ::open(inFileName, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+#endif
+        if (mFD == -1)
+          return false;
+        mBuffer.resize(inBufferSize);
+        mBufferedSize = 0;
+        return true;
+      }
+      bool  close()
+      {
+        if (mFD == -1)
+          return true;
+        bool  result = flush();
+        if (::close(mFD) != 0)
+          result = false;
+        mFD = -1;
+        return result;
+      }
+      bool  write(const void *inDataPtr, size_t inDataSize)
+      {
+        if (inDataSize > mBuffer.size() - mBufferedSize)
+        {
+          if (flush() == false)
+            return false;
+          if (inDataSize >= mBuffer.size())
+            return writeAll((const unsigned char *)inDataPtr, inDataSize);
+        }
+        ::memcpy(&(mBuffer[mBufferedSize]), inDataPtr, inDataSize);
+        mBufferedSize += inDataSize;
+        return true;
+      }
+      // Returns the pointer to write at most inMaxSize bytes
+      // (the caller should call commit() with the actually written size)
+      unsigned char *reserve(size_t inMaxSize)
+      {
+        if (inMaxSize > mBuffer.size() - mBufferedSize)
+        {
+          if (flush() == false)
+            return NULL;
+          if (inMaxSize > mBuffer.size())
+            mBuffer.resize(inMaxSize);
+        }
+        return &(mBuffer[mBufferedSize]);
+      }
+      void  commit(size_t inSize)
+      {
+        mBufferedSize += inSize;
+      }
+      bool  flush()
+      {
+        if (mBufferedSize == 0)
+          return true;
+        bool  result = writeAll(mBuffer.data(), mBufferedSize);
+        mBufferedSize = 0;
+        return result;
+      }
+
+    protected:
+      // Member functions ------------------------------------------------------
+      bool  writeAll(const unsigned char *inDataPtr, size_t inDataSize)
+      {
+        while (inDataSize != 0)
+        {
+          auto  size = ::write(mFD, inDataPtr, inDataSize);
+          if (size < 0)
+          {
+            if (errno == EINTR)
+              continue;
+            return false;
+          }
+          inDataPtr += size;
+          inDataSize -= size;
+        }
+        return true;
+      }
+      // Member variables ------------------------------------------------------
+      int     mFD;
+      size_t  mBufferedSize;
+      std::vector<unsigned char>  mBuffer;
+    };
 
     // -------------------------------------------------------------------------
     // parseData
@@ -1641,7 +2594,8 @@ namespace ibc { namespace gl { namespace file
                     const DestinationInfo *inDstInfoPtr, size_t inDstInfoNum,
                     size_t inDstDataStructSize,
                     const void *inSrcDataPtr, size_t inSrcDataSize,
-                    void **outDstDataPtr, size_t *outDstDataNum)
+                    void **outDstDataPtr, size_t *outDstDataNum,
+                    GLfloat *outMinMax = NULL)
     {
       IBC_GL_FILE_PLY_TRACE();
       size_t  index;
@@ -1668,6 +2622,26 @@ namespace ibc { namespace gl { namespace file
             return false;
         }
       }
+      // Destination offsets of x, y and z (for the fused bounding box calculation)
+      size_t  xyzOffsets[3];
+      if (outMinMax != NULL)
+      {
+        ibc::gl::BoundingBox::initMinMax(outMinMax);
+        for (int axis = 0; axis < 3; axis++)
+        {
+          size_t  i;
+          for (i = 0; i < inDstInfoNum; i++)
+            if (inDstInfoPtr[i].sourcePropertyType == PLYHeader::PROPERTY_X + axis &&
+                inDstInfoPtr[i].destinationDataType == PLYHeader::DATA_TYPE_FLOAT32)
+              break;
+          if (i == inDstInfoNum)
+          {
+            IBC_LOG_ERROR("The destination struct doesn't have the float x, y and z");
+            return false;
+          }
+          xyzOffsets[axis] = inDstInfoPtr[i].destinationDataOffset;
+        }
+      }
       //
       bool  containsList;
       size_t  elementSize = inHeader.getElementSingleDataSize(index, &containsList);
@@ -1703,8 +2677,49 @@ namespace ibc { namespace gl { namespace file
         }
         const unsigned char *srcDataPtr = ((unsigned char *)inSrcDataPtr) + offset;
         unsigned char *dstDataPtr = (unsigned char *)*outDstDataPtr;
+        // The big endian data are copied to this buffer block by block and
+        // each property is flipped in bulk, instead of flipping every value
+        std::vector<unsigned char>  flipBuffer;
+        std::vector<size_t>  flipSources;  // each source property only once
+        size_t  flipBlockNum = 0;
+        if (flipEndian)
+        {
+          flipBlockNum = FLIP_BUFFER_SIZE / elementSize;
+          if (flipBlockNum == 0)
+            flipBlockNum = 1;
+          flipBuffer.resize(elementSize * flipBlockNum);
+          for (size_t j = 0; j < inDstInfoNum; j++)
+          {
+            if (sourceInfos[j].exist == false)
+              continue;
+            size_t  k;
+            for (k = 0; k < flipSources.size(); k++)
+              if (sourceInfos[flipSources[k]].offset == sourceInfos[j].offset)
+                break;
+            if (k == flipSources.size())
+              flipSources.push_back(j);
+          }
+        }
+        const unsigned char *elementPtr = srcDataPtr;
         for (size_t i = 0; i < *outDstDataNum; i++)
         {
+          if (flipEndian)
+          {
+            size_t  blockIndex = i % flipBlockNum;
+            if (blockIndex == 0)
+            {
+              size_t  num = *outDstDataNum - i;
+              if (num > flipBlockNum)
+                num = flipBlockNum;
+              ::memcpy(flipBuffer.data(), srcDataPtr, elementSize * num);
+              for (size_t k = 0; k < flipSources.size(); k++)
+                PLYHeader::flipEndian(&(flipBuffer[sourceInfos[flipSources[k]].offset]),
+                                      elementSize, num, sourceInfos[flipSources[k]].type);
+            }
+            elementPtr = &(flipBuffer[elementSize * blockIndex]);
+          }
+          else
+            elementPtr = srcDataPtr;
           for (size_t j = 0; j < inDstInfoNum; j++)
           {
             double v;
@@ -1712,8 +2727,8 @@ namespace ibc { namespace gl { namespace file
               v = inDstInfoPtr[j].defaultValue;
             else
             {
-              v = PLYHeader::getValue(srcDataPtr, sourceInfos[j].offset,
-                          sourceInfos[j].type, flipEndian);
+              v = PLYHeader::getValue(elementPtr, sourceInfos[j].offset,
+                          sourceInfos[j].type, false);
               if (inDstInfoPtr[j].convert)
               {
                 v = v * inDstInfoPtr[j].gain;
@@ -1731,6 +2746,8 @@ namespace ibc { namespace gl { namespace file
             PLYHeader::setValue(v, dstDataPtr, inDstInfoPtr[j].destinationDataOffset,
                     inDstInfoPtr[j].destinationDataType, false);
           }
+          if (outMinMax != NULL)
+            updateMinMax(dstDataPtr, xyzOffsets, outMinMax);
           srcDataPtr += elementSize;
           dstDataPtr += inDstDataStructSize;
         }
@@ -1789,12 +2806,537 @@ namespace ibc { namespace gl { namespace file
           PLYHeader::setValue(v, dstDataPtr, inDstInfoPtr[j].destinationDataOffset,
                   inDstInfoPtr[j].destinationDataType, false);
         }
+        if (outMinMax != NULL)
+          updateMinMax(dstDataPtr, xyzOffsets, outMinMax);
         linePtr += lineLen;
+        inSrcDataSize -= lineLen;
         dstDataPtr += inDstDataStructSize;
       }
 
       return true;
     }
+    // -------------------------------------------------------------------------
+    // updateMinMax
+    // -------------------------------------------------------------------------
+    static void updateMinMax(const unsigned char *inDstDataPtr, const size_t inXYZOffsets[3],
+                    GLfloat *ioMinMax)
+    {
+      IBC_GL_FILE_PLY_TRACE_ONCE();
+      GLfloat xyz[3];
+      for (int axis = 0; axis < 3; axis++)
+        ::memcpy(&(xyz[axis]), inDstDataPtr + inXYZOffsets[axis], sizeof(GLfloat));
+      ibc::gl::BoundingBox::updateMinMax(xyz[0], xyz[1], xyz[2], ioMinMax);
+    }
+    // -------------------------------------------------------------------------
+    // findFaceElement
+    // -------------------------------------------------------------------------
+    static bool findFaceElement(const PLYHeader &inHeader,
+                    const void *inDataPtr, size_t inDataSize,
+                    size_t *outElementIndex, size_t *outPropertyIndex, size_t *outOffset)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      if (inHeader.findElementIndex(PLYHeader::ELEMENT_TYPE_FACE, outElementIndex) == false)
+      {
+        IBC_LOG_ERROR("Can't find the %s element",
+                      PLYHeader::getElementTypeWord(PLYHeader::ELEMENT_TYPE_FACE));
+        return false;
+      }
+      if (inHeader.findPropertyIndex(*outElementIndex,
+                          PLYHeader::PROPERTY_FACE_VERTEX_INDEX, outPropertyIndex) == false ||
+          inHeader.getProperties()[*outPropertyIndex].isList == false)
+      {
+        IBC_LOG_ERROR("Can't find the property list %s in the %s element",
+                      PLYHeader::getPropertyTypeWord(PLYHeader::PROPERTY_FACE_VERTEX_INDEX),
+                      PLYHeader::getElementTypeWord(PLYHeader::ELEMENT_TYPE_FACE));
+        return false;
+      }
+      if (inHeader.getElementDataOffset(*outElementIndex, inDataPtr, inDataSize, outOffset) == false ||
+          *outOffset > inDataSize)
+      {
+        IBC_LOG_ERROR("getElementDataOffset() returned false");
+        return false;
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // getVertexNum
+    // -------------------------------------------------------------------------
+    static size_t getVertexNum(const PLYHeader &inHeader)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      size_t  index;
+      if (inHeader.findElementIndex(PLYHeader::ELEMENT_TYPE_VERTEX, &index) == false)
+        return 0;
+      return inHeader.getElements()[index].num;
+    }
+    // -------------------------------------------------------------------------
+    // parseFacesBinary
+    // -------------------------------------------------------------------------
+    static bool parseFacesBinary(const PLYHeader &inHeader,
+                    size_t inElementIndex, size_t inPropertyIndex,
+                    const unsigned char *inSrcDataPtr, size_t inSrcDataSize,
+                    ibc::gl::glFacesCSR *outFaces)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      const std::vector<PLYHeader::Property> &properties = inHeader.getProperties();
+      const std::vector<size_t> &indices = inHeader.getElementPropertyIndices(inElementIndex);
+      std::vector<const PLYHeader::Property *> elementProperties(indices.size());
+      for (size_t i = 0; i < indices.size(); i++)
+        elementProperties[i] = &(properties[indices[i]]);
+      //
+      bool    flipEndian = PLYHeader::doesNeedToFlipEndian(inHeader.mDataFormat);
+      size_t  vertexNum = getVertexNum(inHeader);
+      size_t  faceNum = inHeader.getElements()[inElementIndex].num;
+      outFaces->offsets.resize(faceNum + 1);
+      outFaces->offsets[0] = 0;
+      outFaces->indices.reserve(faceNum * 3);
+      //
+      size_t  offset = 0;
+      for (size_t i = 0; i < faceNum; i++)
+      {
+        for (size_t j = 0; j < elementProperties.size(); j++)
+        {
+          const PLYHeader::Property *property = elementProperties[j];
+          if (property->isList == false)
+          {
+            offset += PLYHeader::sizeofDataType(property->dataType);
+            continue;
+          }
+          size_t  numSize = PLYHeader::sizeofDataType(property->listNumType);
+          size_t  dataSize = PLYHeader::sizeofDataType(property->dataType);
+          if (offset + numSize > inSrcDataSize)
+          {
+            IBC_LOG_ERROR("The source data buffer is smaller than needed");
+            return false;
+          }
+          int64_t num = PLYHeader::getIntegerValue(inSrcDataPtr, offset,
+                                            property->listNumType, flipEndian);
+          offset += numSize;
+          if (num < 0 || offset + dataSize * num > inSrcDataSize)
+          {
+            IBC_LOG_ERROR("The source data buffer is smaller than needed");
+            return false;
+          }
+          if (property == &(properties[inPropertyIndex]))
+          {
+            for (int64_t k = 0; k < num; k++)
+            {
+              int64_t v = PLYHeader::getIntegerValue(inSrcDataPtr, offset + dataSize * k,
+                                              property->dataType, flipEndian);
+              if (v < 0 || (vertexNum != 0 && (size_t )v >= vertexNum))
+              {
+                IBC_LOG_ERROR("The vertex index is out of range (face %zu)", i);
+                return false;
+              }
+              outFaces->indices.push_back((GLuint )v);
+            }
+          }
+          offset += dataSize * num;
+        }
+        if (offset > inSrcDataSize)
+        {
+          IBC_LOG_ERROR("The source data buffer is smaller than needed");
+          return false;
+        }
+        outFaces->offsets[i + 1] = (GLuint )outFaces->indices.size();
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // parseFacesAscii
+    // -------------------------------------------------------------------------
+    static bool parseFacesAscii(const PLYHeader &inHeader,
+                    size_t inElementIndex, size_t inPropertyIndex,
+                    const char *inSrcDataPtr, size_t inSrcDataSize,
+                    ibc::gl::glFacesCSR *outFaces)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      const std::vector<PLYHeader::Property> &properties = inHeader.getProperties();
+      const std::vector<size_t> &indices = inHeader.getElementPropertyIndices(inElementIndex);
+      std::vector<const PLYHeader::Property *> elementProperties(indices.size());
+      for (size_t i = 0; i < indices.size(); i++)
+        elementProperties[i] = &(properties[indices[i]]);
+      //
+      size_t  vertexNum = getVertexNum(inHeader);
+      size_t  faceNum = inHeader.getElements()[inElementIndex].num;
+      outFaces->offsets.resize(faceNum + 1);
+      outFaces->offsets[0] = 0;
+      outFaces->indices.reserve(faceNum * 3);
+      //
+      const char *linePtr = inSrcDataPtr;
+      std::vector<Common::Range>  words;
+      for (size_t i = 0; i < faceNum; i++)
+      {
+        size_t  lineLen;
+        if (Common::getLineLength(linePtr, inSrcDataSize, &lineLen) == false)
+        {
+          IBC_LOG_ERROR("Can't find line");
+          return false;
+        }
+        words.clear();
+        Common::findWords(linePtr, lineLen, &words);
+        size_t  wordIndex = 0;
+        for (size_t j = 0; j < elementProperties.size(); j++)
+        {
+          const PLYHeader::Property *property = elementProperties[j];
+          if (property->isList == false)
+          {
+            wordIndex++;
+            continue;
+          }
+          int64_t num;
+          if (wordIndex >= words.size() ||
+              PLYHeader::getIntegerFromStr(&(linePtr[words[wordIndex].from]),
+                                           words[wordIndex].len, &num) == false ||
+              num < 0 || wordIndex + 1 + num > words.size())
+          {
+            IBC_LOG_ERROR("Can't find element data (face %zu)", i);
+            return false;
+          }
+          wordIndex++;
+          if (property == &(properties[inPropertyIndex]))
+          {
+            for (int64_t k = 0; k < num; k++)
+            {
+              int64_t v;
+              if (PLYHeader::getIntegerFromStr(&(linePtr[words[wordIndex + k].from]),
+                                               words[wordIndex + k].len, &v) == false ||
+                  v < 0 || (vertexNum != 0 && (size_t )v >= vertexNum))
+              {
+                IBC_LOG_ERROR("The vertex index is out of range (face %zu)", i);
+                return false;
+              }
+              outFaces->indices.push_back((GLuint )v);
+            }
+          }
+          wordIndex += num;
+        }
+        outFaces->offsets[i + 1] = (GLuint )outFaces->indices.size();
+        linePtr += lineLen;
+        inSrcDataSize -= lineLen;
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // parseTrianglesBinary
+    // -------------------------------------------------------------------------
+    // Fast path for the most common mesh layout
+    //   "property list uchar int vertex_indices" with 3 for all the faces
+    // In this case the record size is fixed (13 bytes), so we can copy the
+    // indices directly without going through the CSR form.
+    // Returns false (without logging) when the data doesn't fit this layout,
+    // so that the caller can fall back to the generic path.
+    static bool parseTrianglesBinary(const PLYHeader &inHeader,
+                    size_t inElementIndex, size_t inPropertyIndex,
+                    const unsigned char *inSrcDataPtr, size_t inSrcDataSize,
+                    GLuint **outIndexPtr, size_t *outIndexNum)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      if (inHeader.mDataFormat == PLYHeader::DATA_FORMAT_ASCII)
+        return false;
+      if (inHeader.getElementPropertyIndices(inElementIndex).size() != 1)
+        return false;
+      const PLYHeader::Property &property = inHeader.getProperties()[inPropertyIndex];
+      if (PLYHeader::sizeofDataType(property.listNumType) != 1)
+        return false;
+      switch (property.dataType)
+      {
+        case PLYHeader::DATA_TYPE_INT32:
+        case PLYHeader::DATA_TYPE_INT:
+        case PLYHeader::DATA_TYPE_UINT32:
+        case PLYHeader::DATA_TYPE_UINT:
+          break;
+        default:
+          return false;   // e.g. the float indices (the same size as GLuint)
+      }
+      //
+      const size_t  recordSize = 1 + sizeof(GLuint) * 3;
+      size_t  faceNum = inHeader.getElements()[inElementIndex].num;
+      if (inSrcDataSize < recordSize * faceNum)
+        return false;
+      GLuint  *indexPtr = new GLuint[faceNum * 3];
+      if (indexPtr == NULL)
+        return false;
+      const unsigned char *srcPtr = inSrcDataPtr;
+      for (size_t i = 0; i < faceNum; i++)
+      {
+        if (*srcPtr != 3)
+        {
+          delete[] indexPtr;
+          return false;
+        }
+        ::memcpy(&(indexPtr[i * 3]), srcPtr + 1, sizeof(GLuint) * 3);
+        srcPtr += recordSize;
+      }
+      if (PLYHeader::doesNeedToFlipEndian(inHeader.mDataFormat))
+        ibc::Endian::swapBuffer32(indexPtr, faceNum * 3);
+      //
+      // Negative (signed) indices become huge values here
+      size_t  vertexNum = getVertexNum(inHeader);
+      GLuint  maxIndex = 0;
+      for (size_t i = 0; i < faceNum * 3; i++)
+        if (indexPtr[i] > maxIndex)
+          maxIndex = indexPtr[i];
+      if ((vertexNum != 0 && maxIndex >= vertexNum) ||
+          (vertexNum == 0 && maxIndex > (GLuint )INT32_MAX))
+      {
+        delete[] indexPtr;
+        return false;
+      }
+      *outIndexPtr = indexPtr;
+      *outIndexNum = faceNum * 3;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // writeData
+    // -------------------------------------------------------------------------
+    static bool writeData(const char *inFileName, PLYHeader::DataFormat inFormat,
+                    const OutputInfo *inInfoPtr, size_t inInfoNum,
+                    size_t inSrcDataStructSize,
+                    const void *inSrcDataPtr, size_t inSrcDataNum,
+                    const ibc::gl::glFacesCSR *inFaces)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      if (inFormat != PLYHeader::DATA_FORMAT_ASCII &&
+          inFormat != PLYHeader::DATA_FORMAT_BINARY_LITTLE_ENDIAN &&
+          inFormat != PLYHeader::DATA_FORMAT_BINARY_BIG_ENDIAN)
+      {
+        IBC_LOG_ERROR("Invalid data format");
+        return false;
+      }
+      //
+      // We use the classic type names (float, uchar, int) here, since
+      // some of the old readers don't understand float32, uint8, etc.
+      PLYHeader header;
+      header.setFormat(inFormat, "1.0", 3);
+      size_t  index = header.addElement("vertex", 6, inSrcDataNum);
+      for (size_t i = 0; i < inInfoNum; i++)
+      {
+        const char *nameStr = PLYHeader::getPropertyTypeWord(inInfoPtr[i].outputPropertyType);
+        header.addProperty(index, nameStr, ::strlen(nameStr), inInfoPtr[i].outputDataType);
+      }
+      size_t  faceNum = 0;
+      PLYHeader::DataType listNumType = PLYHeader::DATA_TYPE_UCHAR;
+      if (inFaces != NULL && inFaces->offsets.size() > 1)
+      {
+        faceNum = inFaces->offsets.size() - 1;
+        for (size_t i = 0; i < faceNum; i++)
+          if (inFaces->offsets[i + 1] - inFaces->offsets[i] > 255)
+          {
+            listNumType = PLYHeader::DATA_TYPE_INT;
+            break;
+          }
+        index = header.addElement("face", 4, faceNum);
+        header.addPropertyList(index, "vertex_index", 12,
+                               PLYHeader::DATA_TYPE_INT, listNumType);
+      }
+      //
+      FileWriter  writer;
+      if (writer.open(inFileName, WRITE_BUFFER_SIZE) == false)
+      {
+        IBC_LOG_ERROR("Failed : open()");
+        return false;
+      }
+      std::string headerStr = header.getHeaderStr();
+      bool  result = writer.write(headerStr.data(), headerStr.size());
+      if (inFormat != PLYHeader::DATA_FORMAT_ASCII)
+      {
+        bool  flipEndian = PLYHeader::doesNeedToFlipEndian(inFormat);
+        if (result)
+          result = writeVerticesBinary(&writer, flipEndian, inInfoPtr, inInfoNum,
+                                inSrcDataStructSize, inSrcDataPtr, inSrcDataNum);
+        if (result && faceNum != 0)
+          result = writeFacesBinary(&writer, flipEndian, listNumType, *inFaces);
+      }
+      else
+      {
+        if (result)
+          result = writeVerticesAscii(&writer, inInfoPtr, inInfoNum,
+                                inSrcDataStructSize, inSrcDataPtr, inSrcDataNum);
+        if (result && faceNum != 0)
+          result = writeFacesAscii(&writer, *inFaces);
+      }
+      if (writer.close() == false)
+        result = false;
+      if (result == false)
+        IBC_LOG_ERROR("Failed to write %s", inFileName);
+      return result;
+    }
+    // -------------------------------------------------------------------------
+    // writeVerticesBinary
+    // -------------------------------------------------------------------------
+    static bool writeVerticesBinary(FileWriter *ioWriter, bool inFlipEndian,
+                    const OutputInfo *inInfoPtr, size_t inInfoNum,
+                    size_t inSrcDataStructSize,
+                    const void *inSrcDataPtr, size_t inSrcDataNum)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      // If the struct layout is exactly the same as the record layout
+      // (e.g. glXYZf_RGBAub, glXYZ_NORMf_RGBAub on little endian hosts),
+      // the source array can be written as is
+      size_t  recordSize = 0;
+      bool    isSameLayout = (inFlipEndian == false);
+      for (size_t i = 0; i < inInfoNum; i++)
+      {
+        if (inInfoPtr[i].convert ||
+            inInfoPtr[i].sourceDataType != inInfoPtr[i].outputDataType ||
+            inInfoPtr[i].sourceDataOffset != recordSize)
+          isSameLayout = false;
+        recordSize += PLYHeader::sizeofDataType(inInfoPtr[i].outputDataType);
+      }
+      if (isSameLayout && recordSize == inSrcDataStructSize)
+        return ioWriter->write(inSrcDataPtr, inSrcDataStructSize * inSrcDataNum);
+      //
+      const unsigned char *srcDataPtr = (const unsigned char *)inSrcDataPtr;
+      for (size_t i = 0; i < inSrcDataNum; i++)
+      {
+        unsigned char *dstDataPtr = ioWriter->reserve(recordSize);
+        if (dstDataPtr == NULL)
+          return false;
+        size_t  offset = 0;
+        for (size_t j = 0; j < inInfoNum; j++)
+        {
+          size_t  size = PLYHeader::sizeofDataType(inInfoPtr[j].outputDataType);
+          if (inInfoPtr[j].convert == false &&
+              inInfoPtr[j].sourceDataType == inInfoPtr[j].outputDataType)
+          {
+            ::memcpy(&(dstDataPtr[offset]),
+                     &(srcDataPtr[inInfoPtr[j].sourceDataOffset]), size);
+            if (inFlipEndian)
+              PLYHeader::flipEndian(&(dstDataPtr[offset]), inInfoPtr[j].outputDataType);
+          }
+          else
+          {
+            double  v = getOutputValue(srcDataPtr, inInfoPtr[j]);
+            PLYHeader::setValue(v, dstDataPtr, offset, inInfoPtr[j].outputDataType, inFlipEndian);
+          }
+          offset += size;
+        }
+        ioWriter->commit(recordSize);
+        srcDataPtr += inSrcDataStructSize;
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // writeFacesBinary
+    // -------------------------------------------------------------------------
+    static bool writeFacesBinary(FileWriter *ioWriter, bool inFlipEndian,
+                    PLYHeader::DataType inListNumType, const ibc::gl::glFacesCSR &inFaces)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      size_t  numSize = PLYHeader::sizeofDataType(inListNumType);
+      size_t  faceNum = inFaces.offsets.size() - 1;
+      for (size_t i = 0; i < faceNum; i++)
+      {
+        size_t  num = inFaces.offsets[i + 1] - inFaces.offsets[i];
+        size_t  recordSize = numSize + sizeof(uint32_t) * num;
+        unsigned char *dstDataPtr = ioWriter->reserve(recordSize);
+        if (dstDataPtr == NULL)
+          return false;
+        PLYHeader::setValue((double )num, dstDataPtr, 0, inListNumType, inFlipEndian);
+        ::memcpy(&(dstDataPtr[numSize]), &(inFaces.indices[inFaces.offsets[i]]),
+                 sizeof(uint32_t) * num);
+        if (inFlipEndian)
+          for (size_t j = 0; j < num; j++)
+            PLYHeader::flipEndian(&(dstDataPtr[numSize + sizeof(uint32_t) * j]),
+                                  PLYHeader::DATA_TYPE_INT);
+        ioWriter->commit(recordSize);
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // writeVerticesAscii
+    // -------------------------------------------------------------------------
+    static bool writeVerticesAscii(FileWriter *ioWriter,
+                    const OutputInfo *inInfoPtr, size_t inInfoNum,
+                    size_t inSrcDataStructSize,
+                    const void *inSrcDataPtr, size_t inSrcDataNum)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      size_t  maxLineLen = MAX_VALUE_STR_LEN * inInfoNum + 1;
+      const unsigned char *srcDataPtr = (const unsigned char *)inSrcDataPtr;
+      for (size_t i = 0; i < inSrcDataNum; i++)
+      {
+        char  *lineStr = (char *)ioWriter->reserve(maxLineLen);
+        if (lineStr == NULL)
+          return false;
+        char  *strPtr = lineStr;
+        for (size_t j = 0; j < inInfoNum; j++)
+        {
+          if (j != 0)
+            *(strPtr++) = Common::CHAR_SPACE_CODE;
+          strPtr = getValueStr(strPtr, strPtr + MAX_VALUE_STR_LEN - 1,
+                               getOutputValue(srcDataPtr, inInfoPtr[j]),
+                               inInfoPtr[j].outputDataType);
+        }
+        *(strPtr++) = Common::CHAR_EOL_CODE;
+        ioWriter->commit(strPtr - lineStr);
+        srcDataPtr += inSrcDataStructSize;
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // writeFacesAscii
+    // -------------------------------------------------------------------------
+    static bool writeFacesAscii(FileWriter *ioWriter, const ibc::gl::glFacesCSR &inFaces)
+    {
+      IBC_GL_FILE_PLY_TRACE();
+      size_t  faceNum = inFaces.offsets.size() - 1;
+      for (size_t i = 0; i < faceNum; i++)
+      {
+        size_t  num = inFaces.offsets[i + 1] - inFaces.offsets[i];
+        char  *lineStr = (char *)ioWriter->reserve(MAX_VALUE_STR_LEN * (num + 1) + 1);
+        if (lineStr == NULL)
+          return false;
+        char  *strPtr = std::to_chars(lineStr, lineStr + MAX_VALUE_STR_LEN, num).ptr;
+        for (size_t j = 0; j < num; j++)
+        {
+          *(strPtr++) = Common::CHAR_SPACE_CODE;
+          strPtr = std::to_chars(strPtr, strPtr + MAX_VALUE_STR_LEN,
+                                 inFaces.indices[inFaces.offsets[i] + j]).ptr;
+        }
+        *(strPtr++) = Common::CHAR_EOL_CODE;
+        ioWriter->commit(strPtr - lineStr);
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // getOutputValue
+    // -------------------------------------------------------------------------
+    static double getOutputValue(const unsigned char *inSrcDataPtr, const OutputInfo &inInfo)
+    {
+      IBC_GL_FILE_PLY_TRACE_ONCE();
+      double  v = PLYHeader::getValue(inSrcDataPtr, inInfo.sourceDataOffset,
+                                      inInfo.sourceDataType, false);
+      if (inInfo.convert)
+      {
+        v = v * inInfo.gain;
+        v = v + inInfo.offset;
+      }
+      PLYHeader::clipToDataTypeRange(inInfo.outputDataType, &v);
+      return v;
+    }
+    // -------------------------------------------------------------------------
+    // getValueStr
+    // -------------------------------------------------------------------------
+    // Writes the shortest string which reads back to the same value
+    static char *getValueStr(char *outStrPtr, char *inStrEndPtr,
+                             double inValue, PLYHeader::DataType inType)
+    {
+      IBC_GL_FILE_PLY_TRACE_ONCE();
+      switch (inType)
+      {
+        case PLYHeader::DATA_TYPE_FLOAT32:
+        case PLYHeader::DATA_TYPE_FLOAT:
+          return std::to_chars(outStrPtr, inStrEndPtr, (float )inValue).ptr;
+        case PLYHeader::DATA_TYPE_FLOAT64:
+        case PLYHeader::DATA_TYPE_DOUBLE:
+          return std::to_chars(outStrPtr, inStrEndPtr, inValue).ptr;
+        default:
+          break;
+      }
+      return std::to_chars(outStrPtr, inStrEndPtr, (int64_t )inValue).ptr;
+    }
   };
 };};};
 
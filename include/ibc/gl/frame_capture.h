@@ -0,0 +1,361 @@
+// =============================================================================
+//  frame_capture.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/frame_capture.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the screenshot / video capture of the GL views
+*/
+
+#ifndef IBC_GL_FRAME_CAPTURE_H_
+#define IBC_GL_FRAME_CAPTURE_H_
+
+// Includes --------------------------------------------------------------------
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ibc/base/types.h"
+#include "ibc/gl/async_pixel_reader.h"
+#include "ibc/image/image_buffer.h"
+#include "ibc/image/utils/frame_writer.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // FrameCapture class
+  // ---------------------------------------------------------------------------
+  // Records the rendered frames without stalling the render thread.
+  // The view calls captureFrame() after drawing each frame (with its context
+  // current), which starts an asynchronous read (AsyncPixelReader) and moves
+  // the finished ones to the frame queue. A frame is dropped (and counted)
+  // instead of waiting when the PBO ring or the queue is full.
+  // With a file, the writer thread takes the frames from the queue and writes
+  // them (see FrameWriter), otherwise popFrame() takes them.
+#ifndef QT_VERSION
+  class FrameCapture
+#else
+  class FrameCapture : protected IBC_QOPENGL_CLASS_NAME
+#endif
+  {
+  public:
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // FrameCapture
+    // -------------------------------------------------------------------------
+    FrameCapture()
+    {
+      mIsCapturing = false;
+      mIsWriterRunning = false;
+      mRingSize = 3;
+      mMaxQueueNum = 16;
+      mMaxFrameNum = 0;
+      mRequestedNum = 0;
+      mCapturedNum = 0;
+      mDroppedNum = 0;
+      mWriteErrorNum = 0;
+#ifdef QT_VERSION
+      mOpenGLFunctionsInitialized = false;
+#endif
+    }
+    // -------------------------------------------------------------------------
+    // ~FrameCapture
+    // -------------------------------------------------------------------------
+    virtual ~FrameCapture()
+    {
+      stopWriter();
+    }
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // start
+    // -------------------------------------------------------------------------
+    // inPath == NULL : the frames are kept in the queue for popFrame()
+    // inMaxFrameNum  : stops requesting after this number (0 : no limit,
+    //                  1 : a screenshot)
+    // Doesn't call GL (the PBOs are created by the next captureFrame())
+    bool start(const char *inPath = NULL,
+               ibc::image::utils::FrameWriter::Format inFormat = ibc::image::utils::FrameWriter::FORMAT_Y4M,
+               int inFPS = 30, size_t inMaxFrameNum = 0,
+               int inRingSize = 3, size_t inMaxQueueNum = 16)
+    {
+      if (mIsCapturing)
+        return false;
+      stopWriter();
+      mRingSize = (inRingSize > 0) ? inRingSize : 1;
+      mMaxQueueNum = (inMaxQueueNum > 0) ? inMaxQueueNum : 1;
+      mMaxFrameNum = inMaxFrameNum;
+      mRequestedNum = 0;
+      mCapturedNum = 0;
+      mDroppedNum = 0;
+      mWriteErrorNum = 0;
+      if (inPath != NULL)
+      {
+        if (mWriter.open(inPath, inFormat, inFPS) == false)
+          return false;
+        mIsWriterRunning = true;
+        mWriterThread = std::thread(&FrameCapture::writerLoop, this);
+      }
+      mIsCapturing = true;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // stop
+    // -------------------------------------------------------------------------
+    // Should be called with the GL context current. Waits for the pending
+    // reads, and the writer thread to write all the queued frames
+    void stop()
+    {
+      if (mIsCapturing == false)
+        return;
+      mIsCapturing = false;
+      while (mPixelReader.getPendingNum() != 0)
+        retrieveFrame(true);
+      mPixelReader.dispose();
+      stopWriter();
+    }
+    // -------------------------------------------------------------------------
+    // dispose
+    // -------------------------------------------------------------------------
+    // Called by the view when its GL resources are disposed
+    void dispose()
+    {
+      stop();
+      mPixelReader.dispose();
+    }
+    // -------------------------------------------------------------------------
+    // captureFrame
+    // -------------------------------------------------------------------------
+    // Called after drawing the frame (reads the current viewport of the
+    // current read frame buffer). Never waits for the GPU
+    void captureFrame()
+    {
+      if (mIsCapturing == false)
+        return;
+#ifdef QT_VERSION
+      if (mOpenGLFunctionsInitialized == false)
+      {
+        initializeOpenGLFunctions();
+        mOpenGLFunctionsInitialized = true;
+      }
+#endif
+      GLint viewport[4];
+      glGetIntegerv(GL_VIEWPORT, viewport);
+      if (viewport[2] != mPixelReader.getWidth() || viewport[3] != mPixelReader.getHeight())
+      {
+        // The size was changed (the frames in flight are dropped)
+        mDroppedNum += mPixelReader.getPendingNum();
+        if (mPixelReader.init(viewport[2], viewport[3], mRingSize) == false)
+          return;
+      }
+      while (mPixelReader.isReady())
+        retrieveFrame(false);
+
+      if (mMaxFrameNum != 0 && mRequestedNum >= mMaxFrameNum)
+        return;
+      if (mPixelReader.request((int )mRequestedNum))
+        mRequestedNum++;
+      else
+        mDroppedNum++;
+    }
+    // -------------------------------------------------------------------------
+    // popFrame
+    // -------------------------------------------------------------------------
+    // Copies the oldest queued frame (without a file). Returns false if the
+    // queue is empty
+    bool popFrame(ibc::image::ImageBuffer *outImage)
+    {
+      std::unique_ptr<ibc::image::ImageBuffer>  frame;
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mQueue.empty())
+          return false;
+        frame = std::move(mQueue.front());
+        mQueue.pop_front();
+      }
+      outImage->copyIntoImageBuffer(frame->getImageBufferPtr(), frame->getImageFormat());
+      recycleFrame(std::move(frame));
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // isCapturing
+    // -------------------------------------------------------------------------
+    bool isCapturing() const
+    {
+      return mIsCapturing;
+    }
+    // -------------------------------------------------------------------------
+    // hasPendingReads
+    // -------------------------------------------------------------------------
+    // true if some reads are in flight. They are retrieved by the following
+    // captureFrame() calls, so the view should keep repainting until false
+    bool hasPendingReads() const
+    {
+      return (mIsCapturing && mPixelReader.getPendingNum() != 0);
+    }
+    // -------------------------------------------------------------------------
+    // isCompleted
+    // -------------------------------------------------------------------------
+    // true if inMaxFrameNum frames have been requested and retrieved
+    bool isCompleted() const
+    {
+      return (mMaxFrameNum != 0 && mRequestedNum >= mMaxFrameNum &&
+              mPixelReader.getPendingNum() == 0);
+    }
+    // -------------------------------------------------------------------------
+    // getCapturedNum
+    // -------------------------------------------------------------------------
+    size_t getCapturedNum() const
+    {
+      return mCapturedNum;
+    }
+    // -------------------------------------------------------------------------
+    // getDroppedNum
+    // -------------------------------------------------------------------------
+    size_t getDroppedNum() const
+    {
+      return mDroppedNum;
+    }
+    // -------------------------------------------------------------------------
+    // getWriteErrorNum
+    // -------------------------------------------------------------------------
+    size_t getWriteErrorNum()
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      return mWriteErrorNum;
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    bool    mIsCapturing;
+    bool    mIsWriterRunning;   // guarded by mMutex after the thread starts
+    int     mRingSize;
+    size_t  mMaxQueueNum;
+    size_t  mMaxFrameNum;
+    size_t  mRequestedNum;
+    size_t  mCapturedNum;
+    size_t  mDroppedNum;
+    size_t  mWriteErrorNum;
+    ibc::gl::AsyncPixelReader mPixelReader;
+    ibc::image::utils::FrameWriter  mWriter;
+    ibc::image::ImageBuffer mScratchFrame;    // for the dropped frames
+
+    std::mutex  mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::unique_ptr<ibc::image::ImageBuffer>>  mQueue;
+    std::vector<std::unique_ptr<ibc::image::ImageBuffer>> mFreeFrames;
+    std::thread mWriterThread;
+#ifdef QT_VERSION
+    bool  mOpenGLFunctionsInitialized;
+#endif
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // retrieveFrame
+    // -------------------------------------------------------------------------
+    void retrieveFrame(bool inWait)
+    {
+      std::unique_ptr<ibc::image::ImageBuffer>  frame;
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mQueue.size() >= mMaxQueueNum)
+          frame = nullptr;
+        else if (mFreeFrames.empty() == false)
+        {
+          frame = std::move(mFreeFrames.back());
+          mFreeFrames.pop_back();
+        }
+        else
+          frame.reset(new ibc::image::ImageBuffer());
+      }
+      if (frame == nullptr)
+      {
+        // The queue is full, the frame is read into the scratch buffer
+        // and dropped (the PBO slot should be released anyway)
+        if (mPixelReader.retrieve(&mScratchFrame, NULL, inWait))
+          mDroppedNum++;
+        return;
+      }
+      if (mPixelReader.retrieve(frame.get(), NULL, inWait) == false)
+      {
+        recycleFrame(std::move(frame));
+        return;
+      }
+      mCapturedNum++;
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back(std::move(frame));
+      }
+      mCondition.notify_one();
+    }
+    // -------------------------------------------------------------------------
+    // recycleFrame
+    // -------------------------------------------------------------------------
+    void recycleFrame(std::unique_ptr<ibc::image::ImageBuffer> inFrame)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (mFreeFrames.size() < mMaxQueueNum)
+        mFreeFrames.push_back(std::move(inFrame));
+    }
+    // -------------------------------------------------------------------------
+    // writerLoop
+    // -------------------------------------------------------------------------
+    void writerLoop()
+    {
+      while (true)
+      {
+        std::unique_ptr<ibc::image::ImageBuffer>  frame;
+        {
+          std::unique_lock<std::mutex> lock(mMutex);
+          mCondition.wait(lock, [this]{ return mQueue.empty() == false || mIsWriterRunning == false; });
+          if (mQueue.empty())
+            break;    // stopped and all the frames were written
+          frame = std::move(mQueue.front());
+          mQueue.pop_front();
+        }
+        bool  result = mWriter.write(*frame);
+        if (result == false)
+        {
+          std::lock_guard<std::mutex> lock(mMutex);
+          mWriteErrorNum++;
+        }
+        recycleFrame(std::move(frame));
+      }
+    }
+    // -------------------------------------------------------------------------
+    // stopWriter
+    // -------------------------------------------------------------------------
+    void stopWriter()
+    {
+      if (mWriterThread.joinable())
+      {
+        {
+          std::lock_guard<std::mutex> lock(mMutex);
+          mIsWriterRunning = false;
+        }
+        mCondition.notify_one();
+        mWriterThread.join();
+      }
+      mWriter.close();
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_FRAME_CAPTURE_H_
@@ -0,0 +1,212 @@
+// =============================================================================
+//  frame_uniforms.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/frame_uniforms.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the per-frame uniform buffer (camera and light)
+*/
+
+#ifndef IBC_GL_FRAME_UNIFORMS_H_
+#define IBC_GL_FRAME_UNIFORMS_H_
+
+// Includes --------------------------------------------------------------------
+#include <cstring>
+#include "ibc/base/types.h"
+
+// Macros ----------------------------------------------------------------------
+// The uniform block declaration for the shaders (std140, see FrameUniforms)
+// modelview   : the view matrix of the frame (GL column major)
+// projection  : the projection matrix of the frame
+// lightSource : the light position in the eye space
+// viewport    : x, y, width, height (pixels)
+#define IBC_GL_FRAME_UNIFORMS_GLSL        \
+  "layout(std140) uniform FrameUniforms\n" \
+  "{\n"                                    \
+  "  mat4 modelview;\n"                    \
+  "  mat4 projection;\n"                   \
+  "  vec4 lightSource;\n"                  \
+  "  vec4 viewport;\n"                     \
+  "};\n"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // FrameUniforms class
+  // ---------------------------------------------------------------------------
+  // The uniform buffer shared by all the shaders which declare the
+  // FrameUniforms block (ShaderBase binds the block to BINDING_POINT).
+  // The view updates it once per frame, instead of each model uploading
+  // the same matrices to its own program.
+#ifndef QT_VERSION
+  class FrameUniforms
+#else
+  class FrameUniforms : protected IBC_QOPENGL_CLASS_NAME
+#endif
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static const GLuint BINDING_POINT = 0;
+
+    // Typedefs ----------------------------------------------------------------
+    // The std140 layout of the block (all the members are 16 bytes aligned)
+    typedef struct
+    {
+      GLfloat modelView[16];
+      GLfloat projection[16];
+      GLfloat lightSource[4];
+      GLfloat viewport[4];
+    } Block;
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // FrameUniforms
+    // -------------------------------------------------------------------------
+    FrameUniforms()
+    {
+      mIsInitialized = false;
+      mBuffer = 0;
+      memset(&mBlock, 0, sizeof(mBlock));
+      for (int i = 0; i < 4; i++)
+      {
+        mBlock.modelView[i * 5] = 1.0f;
+        mBlock.projection[i * 5] = 1.0f;
+      }
+      mBlock.lightSource[2] = 100.0f;
+      mBlock.lightSource[3] = 1.0f;
+#ifdef QT_VERSION
+      mOpenGLFunctionsInitialized = false;
+#endif
+    }
+    // -------------------------------------------------------------------------
+    // ~FrameUniforms
+    // -------------------------------------------------------------------------
+    virtual ~FrameUniforms()
+    {
+    }
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // init
+    // -------------------------------------------------------------------------
+    // Should be called with the GL context current
+    bool init()
+    {
+#ifdef QT_VERSION
+      if (mOpenGLFunctionsInitialized == false)
+      {
+        initializeOpenGLFunctions();
+        mOpenGLFunctionsInitialized = true;
+      }
+#endif
+      if (mIsInitialized)
+        return true;
+      glGenBuffers(1, &mBuffer);
+      glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+      glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), &mBlock, GL_DYNAMIC_DRAW);
+      glBindBuffer(GL_UNIFORM_BUFFER, 0);
+      mIsInitialized = true;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // dispose
+    // -------------------------------------------------------------------------
+    void dispose()
+    {
+      if (mIsInitialized == false)
+        return;
+      glDeleteBuffers(1, &mBuffer);
+      mBuffer = 0;
+      mIsInitialized = false;
+    }
+    // -------------------------------------------------------------------------
+    // setMatrices
+    // -------------------------------------------------------------------------
+    void setMatrices(const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      memcpy(mBlock.modelView, inModelView, sizeof(mBlock.modelView));
+      memcpy(mBlock.projection, inProjection, sizeof(mBlock.projection));
+    }
+    // -------------------------------------------------------------------------
+    // setLightSource
+    // -------------------------------------------------------------------------
+    // The position in the eye space (default : 0, 0, 100, 1)
+    void setLightSource(const GLfloat inLightSource[4])
+    {
+      memcpy(mBlock.lightSource, inLightSource, sizeof(mBlock.lightSource));
+    }
+    // -------------------------------------------------------------------------
+    // getLightSource
+    // -------------------------------------------------------------------------
+    const GLfloat *getLightSource() const
+    {
+      return mBlock.lightSource;
+    }
+    // -------------------------------------------------------------------------
+    // setViewport
+    // -------------------------------------------------------------------------
+    void setViewport(const GLint inViewport[4])
+    {
+      for (int i = 0; i < 4; i++)
+        mBlock.viewport[i] = (GLfloat )inViewport[i];
+    }
+    // -------------------------------------------------------------------------
+    // getBlock
+    // -------------------------------------------------------------------------
+    const Block &getBlock() const
+    {
+      return mBlock;
+    }
+    // -------------------------------------------------------------------------
+    // update
+    // -------------------------------------------------------------------------
+    // Uploads the block and binds the buffer to BINDING_POINT
+    // (once per frame, before drawing the models)
+    void update()
+    {
+      if (mIsInitialized == false)
+        return;
+      glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+      glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &mBlock);
+      glBindBuffer(GL_UNIFORM_BUFFER, 0);
+      glBindBufferBase(GL_UNIFORM_BUFFER, BINDING_POINT, mBuffer);
+    }
+    // -------------------------------------------------------------------------
+    // update
+    // -------------------------------------------------------------------------
+    // setMatrices(), setViewport(current viewport) and update()
+    void update(const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      GLint viewport[4];
+      glGetIntegerv(GL_VIEWPORT, viewport);
+      setMatrices(inModelView, inProjection);
+      setViewport(viewport);
+      update();
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    bool    mIsInitialized;
+    GLuint  mBuffer;
+    Block   mBlock;
+#ifdef QT_VERSION
+    bool  mOpenGLFunctionsInitialized;
+#endif
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_FRAME_UNIFORMS_H_
@@ -0,0 +1,200 @@
+// =============================================================================
+//  frustum.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/frustum.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the view frustum culling
+*/
+
+#ifndef IBC_GL_FRUSTUM_H_
+#define IBC_GL_FRUSTUM_H_
+
+// Includes --------------------------------------------------------------------
+#include <cmath>
+#include "ibc/base/types.h"
+#include "ibc/gl/matrix.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // Frustum class
+  // ---------------------------------------------------------------------------
+  // The six clip planes extracted from (projection * modelview).
+  // The boxes are given as the min max array
+  // {x_min, x_max, y_min, y_max, z_min, z_max} (same as BoundingBox).
+  class Frustum
+  {
+  public:
+    // Typedefs ----------------------------------------------------------------
+    enum TestResult
+    {
+      OUTSIDE = 0,
+      INTERSECT,
+      INSIDE
+    };
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // Frustum
+    // -------------------------------------------------------------------------
+    Frustum()
+    {
+      // Everything is inside until set() is called
+      for (int i = 0; i < 6; i++)
+      {
+        mPlanes[i][0] = 0;
+        mPlanes[i][1] = 0;
+        mPlanes[i][2] = 0;
+        mPlanes[i][3] = 1;
+      }
+    }
+    // -------------------------------------------------------------------------
+    // ~Frustum
+    // -------------------------------------------------------------------------
+    virtual ~Frustum()
+    {
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // set
+    // -------------------------------------------------------------------------
+    // The matrices in the OpenGL (column major) order,
+    // i.e. the ones passed to ModelInterface::drawModel()
+    void set(const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      GLfloat mvp[16];
+      multiGLMatrix(inProjection, inModelView, mvp);
+      GLfloat rows[4][4];
+      for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+          rows[i][j] = mvp[j * 4 + i];
+      setFromRows(rows);
+    }
+    // -------------------------------------------------------------------------
+    // set
+    // -------------------------------------------------------------------------
+    void set(const MatrixBase<GLfloat> &inModelView, const MatrixBase<GLfloat> &inProjection)
+    {
+      GLfloat rows[4][4];
+      for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+        {
+          GLfloat v = 0;
+          for (int k = 0; k < 4; k++)
+            v += inProjection.mMat[i][k] * inModelView.mMat[k][j];
+          rows[i][j] = v;
+        }
+      setFromRows(rows);
+    }
+    // -------------------------------------------------------------------------
+    // testBox
+    // -------------------------------------------------------------------------
+    TestResult testBox(const GLfloat inMinMax[6]) const
+    {
+      TestResult  result = INSIDE;
+      for (int i = 0; i < 6; i++)
+      {
+        const GLfloat *p = mPlanes[i];
+        // The corners farthest along / against the plane normal
+        GLfloat farX  = p[0] >= 0 ? inMinMax[1] : inMinMax[0];
+        GLfloat farY  = p[1] >= 0 ? inMinMax[3] : inMinMax[2];
+        GLfloat farZ  = p[2] >= 0 ? inMinMax[5] : inMinMax[4];
+        if (p[0] * farX + p[1] * farY + p[2] * farZ + p[3] < 0)
+          return OUTSIDE;
+        GLfloat nearX = p[0] >= 0 ? inMinMax[0] : inMinMax[1];
+        GLfloat nearY = p[1] >= 0 ? inMinMax[2] : inMinMax[3];
+        GLfloat nearZ = p[2] >= 0 ? inMinMax[4] : inMinMax[5];
+        if (p[0] * nearX + p[1] * nearY + p[2] * nearZ + p[3] < 0)
+          result = INTERSECT;
+      }
+      return result;
+    }
+    // -------------------------------------------------------------------------
+    // isPointInside
+    // -------------------------------------------------------------------------
+    bool isPointInside(GLfloat inX, GLfloat inY, GLfloat inZ) const
+    {
+      for (int i = 0; i < 6; i++)
+      {
+        const GLfloat *p = mPlanes[i];
+        if (p[0] * inX + p[1] * inY + p[2] * inZ + p[3] < 0)
+          return false;
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // getPlane
+    // -------------------------------------------------------------------------
+    // 0 : left, 1 : right, 2 : bottom, 3 : top, 4 : near, 5 : far
+    // (a, b, c, d) with a * x + b * y + c * z + d >= 0 inside, |(a, b, c)| = 1
+    const GLfloat *getPlane(int inIndex) const
+    {
+      return mPlanes[inIndex];
+    }
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // multiGLMatrix
+    // -------------------------------------------------------------------------
+    // outDst = inSrc0 * inSrc1 (column major)
+    static void multiGLMatrix(const GLfloat inSrc0[16], const GLfloat inSrc1[16],
+                              GLfloat outDst[16])
+    {
+      for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+        {
+          GLfloat v = 0;
+          for (int k = 0; k < 4; k++)
+            v += inSrc0[k * 4 + r] * inSrc1[c * 4 + k];
+          outDst[c * 4 + r] = v;
+        }
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    GLfloat mPlanes[6][4];
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setFromRows
+    // -------------------------------------------------------------------------
+    // Gribb & Hartmann: the planes are (row3 +/- row0), (row3 +/- row1) ...
+    void setFromRows(const GLfloat inRows[4][4])
+    {
+      for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+        {
+          mPlanes[i * 2][j]     = inRows[3][j] + inRows[i][j];
+          mPlanes[i * 2 + 1][j] = inRows[3][j] - inRows[i][j];
+        }
+      for (int i = 0; i < 6; i++)
+      {
+        GLfloat len = std::sqrt(mPlanes[i][0] * mPlanes[i][0] +
+                                mPlanes[i][1] * mPlanes[i][1] +
+                                mPlanes[i][2] * mPlanes[i][2]);
+        if (len > 0)
+          for (int j = 0; j < 4; j++)
+            mPlanes[i][j] /= len;
+      }
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_FRUSTUM_H_
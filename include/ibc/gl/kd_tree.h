@@ -0,0 +1,730 @@
+// =============================================================================
+//  kd_tree.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/kd_tree.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the k-d tree of the point clouds
+*/
+
+#ifndef IBC_GL_KD_TREE_H_
+#define IBC_GL_KD_TREE_H_
+
+// Includes --------------------------------------------------------------------
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "ibc/base/types.h"
+#include "ibc/base/parallel.h"
+#include "ibc/gl/bounding_box.h"
+#include "ibc/gl/frustum.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // KdTree class
+  // ---------------------------------------------------------------------------
+  // A balanced k-d tree over the strided xyz array (any of the vertex structs
+  // in ibc/gl/data.h can be passed as is). The points are copied into the
+  // tree order with their original indices, so the tree doesn't refer to the
+  // source array after build() (rebuild it when the points are modified).
+  // The nodes are stored implicitly (the children of i are 2i + 1, 2i + 2)
+  // and each node keeps the tight bounding box of its points.
+  // NaN points are not added to the tree.
+  // The build and the batched queries run on multiple threads. The queries
+  // are const and can be called from multiple threads at the same time.
+  class KdTree
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static const size_t  INVALID_INDEX     = (size_t )-1;
+    static const size_t  DEFAULT_LEAF_SIZE = 32;
+    static const size_t  MIN_TASK_SIZE     = 256 * 1024;  // points per thread
+    static const size_t  MIN_QUERY_TASK_SIZE = 4 * 1024;  // queries per thread
+
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      GLfloat   xyz[3];
+      uint32_t  index;    // the index in the source array
+    } Entry;
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // KdTree
+    // -------------------------------------------------------------------------
+    KdTree()
+    {
+      mLeafSize = DEFAULT_LEAF_SIZE;
+      mDepth = 0;
+    }
+    // -------------------------------------------------------------------------
+    // ~KdTree
+    // -------------------------------------------------------------------------
+    virtual ~KdTree()
+    {
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // build
+    // -------------------------------------------------------------------------
+    // inStride : the byte size of the vertex struct (e.g. sizeof(glXYZf_RGBAub))
+    // (inTaskNum == 0 : the task number is decided from the data size)
+    bool build(const void *inDataPtr, size_t inStride, size_t inDataNum,
+               size_t inLeafSize = DEFAULT_LEAF_SIZE, unsigned int inTaskNum = 0)
+    {
+      clear();
+      if (inDataPtr == NULL || inDataNum == 0 ||
+          inDataNum >= (size_t )std::numeric_limits<uint32_t>::max())
+        return false;
+      mLeafSize = (inLeafSize != 0) ? inLeafSize : DEFAULT_LEAF_SIZE;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inDataNum, MIN_TASK_SIZE);
+
+      // Copies the valid points (counted per task first, to keep the order)
+      const unsigned char *data = (const unsigned char *)inDataPtr;
+      std::vector<size_t> offsets(inTaskNum + 1, 0);
+      Parallel::forEachTask(inDataNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          size_t  num = 0;
+          for (size_t i = inBegin; i < inEnd; i++)
+            if (isValidPoint((const GLfloat *)(data + inStride * i)))
+              num++;
+          offsets[inTaskIndex + 1] = num;
+        });
+      for (unsigned int i = 0; i < inTaskNum; i++)
+        offsets[i + 1] += offsets[i];
+      if (offsets[inTaskNum] == 0)
+        return false;
+      mEntries.resize(offsets[inTaskNum]);
+      Parallel::forEachTask(inDataNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          Entry *e = &(mEntries[offsets[inTaskIndex]]);
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            const GLfloat *p = (const GLfloat *)(data + inStride * i);
+            if (isValidPoint(p) == false)
+              continue;
+            e->xyz[0] = p[0];
+            e->xyz[1] = p[1];
+            e->xyz[2] = p[2];
+            e->index = (uint32_t )i;
+            e++;
+          }
+        });
+
+      mDepth = 0;
+      while ((mEntries.size() >> mDepth) > mLeafSize)
+        mDepth++;
+      mNodes.resize(((size_t )1 << (mDepth + 1)) - 1);
+      mNodes[0].first = 0;
+      mNodes[0].count = (uint32_t )mEntries.size();
+      GLfloat box[6];
+      BoundingBox::calcMinMax(mEntries.data(), mEntries.size(), sizeof(Entry), box, inTaskNum);
+
+      // The levels above threadLevel are split on this thread, then the
+      // subtrees below are built in parallel and the boxes of the upper
+      // nodes are merged from them
+      size_t  threadLevel = 0;
+      while (((size_t )1 << threadLevel) < inTaskNum && threadLevel < mDepth)
+        threadLevel++;
+      size_t  subtreeNum = (size_t )1 << threadLevel;
+      size_t  subtreeFirst = subtreeNum - 1;
+      std::vector<GLfloat>  subtreeBoxes(subtreeNum * 6);
+      buildNode(0, 0, box, threadLevel, subtreeBoxes.data());
+      Parallel::forEachTask(subtreeNum, (unsigned int )std::min((size_t )inTaskNum, subtreeNum),
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t i = inBegin; i < inEnd; i++)
+            buildNode(subtreeFirst + i, threadLevel, &(subtreeBoxes[i * 6]), mDepth + 1, NULL);
+        });
+      for (size_t i = subtreeFirst; i-- > 0; )
+        mergeChildMinMax(i);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // clear
+    // -------------------------------------------------------------------------
+    void clear()
+    {
+      mEntries.clear();
+      mNodes.clear();
+      mDepth = 0;
+    }
+    // -------------------------------------------------------------------------
+    // isBuilt
+    // -------------------------------------------------------------------------
+    bool isBuilt() const
+    {
+      return (mNodes.empty() == false);
+    }
+    // -------------------------------------------------------------------------
+    // getPointNum
+    // -------------------------------------------------------------------------
+    // The number of the points in the tree (without the NaN ones)
+    size_t getPointNum() const
+    {
+      return mEntries.size();
+    }
+    // -------------------------------------------------------------------------
+    // getEntry
+    // -------------------------------------------------------------------------
+    // inIndex is the index in the tree order (not the source index)
+    const Entry &getEntry(size_t inIndex) const
+    {
+      return mEntries[inIndex];
+    }
+    // -------------------------------------------------------------------------
+    // getMinMax
+    // -------------------------------------------------------------------------
+    // The bounding box of all the points (NULL if the tree is empty)
+    const GLfloat *getMinMax() const
+    {
+      if (mNodes.empty())
+        return NULL;
+      return mNodes[0].minMax;
+    }
+    // -------------------------------------------------------------------------
+    // isValidPoint
+    // -------------------------------------------------------------------------
+    // The NaN points are not added to the tree
+    static bool isValidPoint(const GLfloat inPoint[3])
+    {
+      return (std::isnan(inPoint[0]) == false && std::isnan(inPoint[1]) == false &&
+              std::isnan(inPoint[2]) == false);
+    }
+    // -------------------------------------------------------------------------
+    // findNearest
+    // -------------------------------------------------------------------------
+    // Returns the source index of the nearest point, or INVALID_INDEX if there
+    // is no point within inMaxDist
+    size_t findNearest(const GLfloat inPoint[3], GLfloat *outDist2 = NULL,
+                       GLfloat inMaxDist = std::numeric_limits<GLfloat>::infinity()) const
+    {
+      GLfloat bestDist2 = std::isinf(inMaxDist) ? inMaxDist : inMaxDist * inMaxDist;
+      size_t  best = INVALID_INDEX;
+      if (mNodes.empty() || isValidPoint(inPoint) == false)
+        return INVALID_INDEX;
+
+      size_t  stack[STACK_SIZE];
+      size_t  stackNum = 0;
+      stack[stackNum++] = 0;
+      while (stackNum != 0)
+      {
+        size_t  nodeIndex = stack[--stackNum];
+        const Node  &node = mNodes[nodeIndex];
+        if (calcBoxDist2(node.minMax, inPoint) > bestDist2)
+          continue;
+        if (isLeaf(nodeIndex))
+        {
+          const Entry *e = &(mEntries[node.first]);
+          for (uint32_t i = 0; i < node.count; i++, e++)
+          {
+            GLfloat d2 = calcDist2(e->xyz, inPoint);
+            if (d2 < bestDist2 || (d2 == bestDist2 && best == INVALID_INDEX))
+            {
+              bestDist2 = d2;
+              best = e->index;
+            }
+          }
+          continue;
+        }
+        // The nearer child is pushed last (visited first)
+        size_t  left = nodeIndex * 2 + 1;
+        size_t  right = left + 1;
+        if (calcBoxDist2(mNodes[left].minMax, inPoint) <=
+            calcBoxDist2(mNodes[right].minMax, inPoint))
+          std::swap(left, right);
+        stack[stackNum++] = left;
+        stack[stackNum++] = right;
+      }
+      if (best != INVALID_INDEX && outDist2 != NULL)
+        *outDist2 = bestDist2;
+      return best;
+    }
+    // -------------------------------------------------------------------------
+    // findKNearest
+    // -------------------------------------------------------------------------
+    // Up to inK source indices (nearest first) into outIndices[inK].
+    // outDist2 can be NULL. Returns the number of the found points
+    size_t findKNearest(const GLfloat inPoint[3], size_t inK,
+                        size_t *outIndices, GLfloat *outDist2 = NULL,
+                        GLfloat inMaxDist = std::numeric_limits<GLfloat>::infinity()) const
+    {
+      std::vector<std::pair<GLfloat, size_t>> heap;
+      return findKNearest(inPoint, inK, outIndices, outDist2, inMaxDist, &heap);
+    }
+    // -------------------------------------------------------------------------
+    // findKNearest
+    // -------------------------------------------------------------------------
+    // With the work buffer (max heap of the (distance^2, source index)) to
+    // avoid the allocation in the loops of the queries
+    size_t findKNearest(const GLfloat inPoint[3], size_t inK,
+                        size_t *outIndices, GLfloat *outDist2, GLfloat inMaxDist,
+                        std::vector<std::pair<GLfloat, size_t>> *ioHeap) const
+    {
+      std::vector<std::pair<GLfloat, size_t>> &heap = *ioHeap;
+      heap.clear();
+      if (mNodes.empty() || inK == 0 || isValidPoint(inPoint) == false)
+        return 0;
+      GLfloat maxDist2 = std::isinf(inMaxDist) ? inMaxDist : inMaxDist * inMaxDist;
+
+      size_t  stack[STACK_SIZE];
+      size_t  stackNum = 0;
+      stack[stackNum++] = 0;
+      while (stackNum != 0)
+      {
+        size_t  nodeIndex = stack[--stackNum];
+        const Node  &node = mNodes[nodeIndex];
+        GLfloat bound = (heap.size() < inK) ? maxDist2 : heap.front().first;
+        if (calcBoxDist2(node.minMax, inPoint) > bound)
+          continue;
+        if (isLeaf(nodeIndex))
+        {
+          const Entry *e = &(mEntries[node.first]);
+          for (uint32_t i = 0; i < node.count; i++, e++)
+          {
+            GLfloat d2 = calcDist2(e->xyz, inPoint);
+            if (heap.size() < inK)
+            {
+              if (d2 > maxDist2)
+                continue;
+              heap.push_back(std::make_pair(d2, (size_t )e->index));
+              std::push_heap(heap.begin(), heap.end());
+            }
+            else if (d2 < heap.front().first)
+            {
+              std::pop_heap(heap.begin(), heap.end());
+              heap.back() = std::make_pair(d2, (size_t )e->index);
+              std::push_heap(heap.begin(), heap.end());
+            }
+          }
+          continue;
+        }
+        size_t  left = nodeIndex * 2 + 1;
+        size_t  right = left + 1;
+        if (calcBoxDist2(mNodes[left].minMax, inPoint) <=
+            calcBoxDist2(mNodes[right].minMax, inPoint))
+          std::swap(left, right);
+        stack[stackNum++] = left;
+        stack[stackNum++] = right;
+      }
+      std::sort_heap(heap.begin(), heap.end());
+      for (size_t i = 0; i < heap.size(); i++)
+      {
+        outIndices[i] = heap[i].second;
+        if (outDist2 != NULL)
+          outDist2[i] = heap[i].first;
+      }
+      return heap.size();
+    }
+    // -------------------------------------------------------------------------
+    // findRadius
+    // -------------------------------------------------------------------------
+    // The source indices of the points within inRadius (in the tree order,
+    // not sorted by the distance). outDist2 can be NULL.
+    // Returns the number of the found points
+    size_t findRadius(const GLfloat inPoint[3], GLfloat inRadius,
+                      std::vector<size_t> *outIndices,
+                      std::vector<GLfloat> *outDist2 = NULL) const
+    {
+      outIndices->clear();
+      if (outDist2 != NULL)
+        outDist2->clear();
+      appendRadius(inPoint, inRadius, outIndices, outDist2);
+      return outIndices->size();
+    }
+    // -------------------------------------------------------------------------
+    // findBox
+    // -------------------------------------------------------------------------
+    // The source indices of the points in the box (in the tree order)
+    size_t findBox(const GLfloat inMinMax[6], std::vector<size_t> *outIndices) const
+    {
+      outIndices->clear();
+      traverse(
+        [inMinMax](const GLfloat *inNodeMinMax) { return testBox(inMinMax, inNodeMinMax); },
+        [&](const Entry &inEntry, bool inIsInside)
+        {
+          if (inIsInside || isInsideBox(inMinMax, inEntry.xyz))
+            outIndices->push_back(inEntry.index);
+        });
+      return outIndices->size();
+    }
+    // -------------------------------------------------------------------------
+    // findNearestBatch
+    // -------------------------------------------------------------------------
+    // findNearest() for each of the strided query points on multiple threads.
+    // outIndices[inQueryNum] (INVALID_INDEX if not found), outDist2 can be NULL
+    void findNearestBatch(const void *inQueryPtr, size_t inStride, size_t inQueryNum,
+                          size_t *outIndices, GLfloat *outDist2 = NULL,
+                          GLfloat inMaxDist = std::numeric_limits<GLfloat>::infinity(),
+                          unsigned int inTaskNum = 0) const
+    {
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inQueryNum, MIN_QUERY_TASK_SIZE);
+      const unsigned char *query = (const unsigned char *)inQueryPtr;
+      Parallel::forEachTask(inQueryNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            GLfloat dist2 = std::numeric_limits<GLfloat>::infinity();
+            outIndices[i] = findNearest((const GLfloat *)(query + inStride * i),
+                                        &dist2, inMaxDist);
+            if (outDist2 != NULL)
+              outDist2[i] = dist2;
+          }
+        });
+    }
+    // -------------------------------------------------------------------------
+    // findKNearestBatch
+    // -------------------------------------------------------------------------
+    // findKNearest() for each of the strided query points on multiple threads.
+    // outIndices[inQueryNum * inK] is padded with INVALID_INDEX.
+    // outDist2[inQueryNum * inK] and outNums[inQueryNum] can be NULL
+    void findKNearestBatch(const void *inQueryPtr, size_t inStride, size_t inQueryNum,
+                           size_t inK, size_t *outIndices, GLfloat *outDist2 = NULL,
+                           size_t *outNums = NULL,
+                           GLfloat inMaxDist = std::numeric_limits<GLfloat>::infinity(),
+                           unsigned int inTaskNum = 0) const
+    {
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inQueryNum, MIN_QUERY_TASK_SIZE);
+      const unsigned char *query = (const unsigned char *)inQueryPtr;
+      Parallel::forEachTask(inQueryNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          std::vector<std::pair<GLfloat, size_t>> heap;
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            size_t  *indices = outIndices + i * inK;
+            GLfloat *dist2 = (outDist2 != NULL) ? outDist2 + i * inK : NULL;
+            size_t  num = findKNearest((const GLfloat *)(query + inStride * i), inK,
+                                       indices, dist2, inMaxDist, &heap);
+            for (size_t j = num; j < inK; j++)
+            {
+              indices[j] = INVALID_INDEX;
+              if (dist2 != NULL)
+                dist2[j] = std::numeric_limits<GLfloat>::infinity();
+            }
+            if (outNums != NULL)
+              outNums[i] = num;
+          }
+        });
+    }
+    // -------------------------------------------------------------------------
+    // findRadiusBatch
+    // -------------------------------------------------------------------------
+    // findRadius() for each of the strided query points on multiple threads.
+    // The results of the query i are outIndices[outOffsets[i]] to
+    // outIndices[outOffsets[i + 1] - 1] (outOffsets has inQueryNum + 1 items)
+    void findRadiusBatch(const void *inQueryPtr, size_t inStride, size_t inQueryNum,
+                         GLfloat inRadius, std::vector<size_t> *outOffsets,
+                         std::vector<size_t> *outIndices, unsigned int inTaskNum = 0) const
+    {
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inQueryNum, MIN_QUERY_TASK_SIZE);
+      const unsigned char *query = (const unsigned char *)inQueryPtr;
+      outOffsets->resize(inQueryNum + 1);
+      std::vector<std::vector<size_t>>  taskIndices(inTaskNum);
+      Parallel::forEachTask(inQueryNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          std::vector<size_t> &indices = taskIndices[inTaskIndex];
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            (*outOffsets)[i] = indices.size();    // in the task for now
+            appendRadius((const GLfloat *)(query + inStride * i), inRadius, &indices, NULL);
+          }
+        });
+      // The task offsets are added in the second pass
+      std::vector<size_t> taskOffsets(inTaskNum + 1, 0);
+      for (unsigned int i = 0; i < inTaskNum; i++)
+        taskOffsets[i + 1] = taskOffsets[i] + taskIndices[i].size();
+      outIndices->resize(taskOffsets[inTaskNum]);
+      (*outOffsets)[inQueryNum] = taskOffsets[inTaskNum];
+      Parallel::forEachTask(inQueryNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          for (size_t i = inBegin; i < inEnd; i++)
+            (*outOffsets)[i] += taskOffsets[inTaskIndex];
+          std::copy(taskIndices[inTaskIndex].begin(), taskIndices[inTaskIndex].end(),
+                    outIndices->begin() + taskOffsets[inTaskIndex]);
+        });
+    }
+    // -------------------------------------------------------------------------
+    // traverse
+    // -------------------------------------------------------------------------
+    // Calls inVisitor(const Entry &, bool inIsInside) for the points of the
+    // nodes which inBoxTest(const GLfloat minMax[6]) doesn't reject.
+    // inBoxTest returns the Frustum::TestResult, and inIsInside is true if
+    // the whole node was Frustum::INSIDE (the point needs no more tests).
+    template <class BoxTest, class Visitor>
+    void traverse(BoxTest inBoxTest, Visitor inVisitor) const
+    {
+      if (mNodes.empty())
+        return;
+      size_t  stack[STACK_SIZE];
+      size_t  stackNum = 0;
+      stack[stackNum++] = 0;
+      while (stackNum != 0)
+      {
+        size_t  nodeIndex = stack[--stackNum];
+        const Node  &node = mNodes[nodeIndex];
+        Frustum::TestResult result = inBoxTest(node.minMax);
+        if (result == Frustum::OUTSIDE)
+          continue;
+        if (result == Frustum::INSIDE || isLeaf(nodeIndex))
+        {
+          bool  isInside = (result == Frustum::INSIDE);
+          const Entry *e = &(mEntries[node.first]);
+          for (uint32_t i = 0; i < node.count; i++, e++)
+            inVisitor(*e, isInside);
+          continue;
+        }
+        stack[stackNum++] = nodeIndex * 2 + 2;
+        stack[stackNum++] = nodeIndex * 2 + 1;
+      }
+    }
+
+  protected:
+    // Constants ---------------------------------------------------------------
+    static const size_t  STACK_SIZE = 64;  // > the tree depth + 1
+
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      GLfloat   minMax[6];
+      uint32_t  first;
+      uint32_t  count;
+    } Node;
+
+    // Member variables --------------------------------------------------------
+    size_t  mLeafSize;
+    size_t  mDepth;           // the leaves are at this depth
+    std::vector<Entry>  mEntries;
+    std::vector<Node>   mNodes;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // isLeaf
+    // -------------------------------------------------------------------------
+    bool isLeaf(size_t inNodeIndex) const
+    {
+      return (inNodeIndex >= ((size_t )1 << mDepth) - 1);
+    }
+    // -------------------------------------------------------------------------
+    // buildNode
+    // -------------------------------------------------------------------------
+    // inSplitBox is the box of the split planes (only used to select the axis,
+    // the tight boxes are calculated from the leaves on the way back).
+    // Stops at inStopLevel (<= mDepth) and stores the split boxes of the
+    // nodes of the level to outStopBoxes, then the caller builds them and
+    // merges the boxes of the nodes above (mergeChildMinMax())
+    void buildNode(size_t inNodeIndex, size_t inLevel, const GLfloat inSplitBox[6],
+                   size_t inStopLevel, GLfloat *outStopBoxes)
+    {
+      Node  &node = mNodes[inNodeIndex];
+      if (inLevel == inStopLevel)
+      {
+        size_t  levelIndex = inNodeIndex - (((size_t )1 << inLevel) - 1);
+        std::copy(inSplitBox, inSplitBox + 6, outStopBoxes + levelIndex * 6);
+        return;
+      }
+      if (inLevel == mDepth)
+      {
+        calcMinMax(node.first, node.count, node.minMax);
+        return;
+      }
+      int axis = 0;
+      for (int i = 1; i < 3; i++)
+        if (inSplitBox[i * 2 + 1] - inSplitBox[i * 2] >
+            inSplitBox[axis * 2 + 1] - inSplitBox[axis * 2])
+          axis = i;
+
+      uint32_t  half = node.count / 2;
+      Entry *begin = &(mEntries[node.first]);
+      std::nth_element(begin, begin + half, begin + node.count,
+                       [axis](const Entry &a, const Entry &b)
+                       { return a.xyz[axis] < b.xyz[axis]; });
+      GLfloat split = begin[half].xyz[axis];
+
+      size_t  left = inNodeIndex * 2 + 1;
+      size_t  right = left + 1;
+      mNodes[left].first = node.first;
+      mNodes[left].count = half;
+      mNodes[right].first = node.first + half;
+      mNodes[right].count = node.count - half;
+
+      GLfloat leftBox[6], rightBox[6];
+      std::copy(inSplitBox, inSplitBox + 6, leftBox);
+      std::copy(inSplitBox, inSplitBox + 6, rightBox);
+      leftBox[axis * 2 + 1] = split;
+      rightBox[axis * 2] = split;
+      buildNode(left, inLevel + 1, leftBox, inStopLevel, outStopBoxes);
+      buildNode(right, inLevel + 1, rightBox, inStopLevel, outStopBoxes);
+      if (inStopLevel > mDepth)
+        mergeChildMinMax(inNodeIndex);
+    }
+    // -------------------------------------------------------------------------
+    // mergeChildMinMax
+    // -------------------------------------------------------------------------
+    void mergeChildMinMax(size_t inNodeIndex)
+    {
+      GLfloat *minMax = mNodes[inNodeIndex].minMax;
+      const GLfloat *l = mNodes[inNodeIndex * 2 + 1].minMax;
+      const GLfloat *r = mNodes[inNodeIndex * 2 + 2].minMax;
+      for (int i = 0; i < 3; i++)
+      {
+        minMax[i * 2]     = std::min(l[i * 2], r[i * 2]);
+        minMax[i * 2 + 1] = std::max(l[i * 2 + 1], r[i * 2 + 1]);
+      }
+    }
+    // -------------------------------------------------------------------------
+    // calcMinMax
+    // -------------------------------------------------------------------------
+    // An empty range gets the inverted (never hit) box
+    void calcMinMax(size_t inFirst, size_t inCount, GLfloat outMinMax[6]) const
+    {
+      for (int i = 0; i < 3; i++)
+      {
+        outMinMax[i * 2]     =  std::numeric_limits<GLfloat>::max();
+        outMinMax[i * 2 + 1] = -std::numeric_limits<GLfloat>::max();
+      }
+      const Entry *e = mEntries.data() + inFirst;
+      for (size_t j = 0; j < inCount; j++, e++)
+        for (int i = 0; i < 3; i++)
+        {
+          outMinMax[i * 2]     = std::min(outMinMax[i * 2], e->xyz[i]);
+          outMinMax[i * 2 + 1] = std::max(outMinMax[i * 2 + 1], e->xyz[i]);
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // appendRadius
+    // -------------------------------------------------------------------------
+    void appendRadius(const GLfloat inPoint[3], GLfloat inRadius,
+                      std::vector<size_t> *outIndices, std::vector<GLfloat> *outDist2) const
+    {
+      if (isValidPoint(inPoint) == false)
+        return;
+      GLfloat radius2 = inRadius * inRadius;
+      traverse(
+        [inPoint, radius2](const GLfloat *inMinMax)
+        {
+          if (calcBoxDist2(inMinMax, inPoint) > radius2)
+            return Frustum::OUTSIDE;
+          if (calcBoxMaxDist2(inMinMax, inPoint) <= radius2)
+            return Frustum::INSIDE;
+          return Frustum::INTERSECT;
+        },
+        [&](const Entry &inEntry, bool inIsInside)
+        {
+          GLfloat d2 = calcDist2(inEntry.xyz, inPoint);
+          if (inIsInside == false && d2 > radius2)
+            return;
+          outIndices->push_back(inEntry.index);
+          if (outDist2 != NULL)
+            outDist2->push_back(d2);
+        });
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // calcDist2
+    // -------------------------------------------------------------------------
+    static GLfloat calcDist2(const GLfloat inA[3], const GLfloat inB[3])
+    {
+      GLfloat dx = inA[0] - inB[0];
+      GLfloat dy = inA[1] - inB[1];
+      GLfloat dz = inA[2] - inB[2];
+      return dx * dx + dy * dy + dz * dz;
+    }
+    // -------------------------------------------------------------------------
+    // calcBoxDist2
+    // -------------------------------------------------------------------------
+    // The squared distance from the point to the box (0 inside)
+    static GLfloat calcBoxDist2(const GLfloat inMinMax[6], const GLfloat inPoint[3])
+    {
+      GLfloat d2 = 0;
+      for (int i = 0; i < 3; i++)
+      {
+        GLfloat d = 0;
+        if (inPoint[i] < inMinMax[i * 2])
+          d = inMinMax[i * 2] - inPoint[i];
+        else if (inPoint[i] > inMinMax[i * 2 + 1])
+          d = inPoint[i] - inMinMax[i * 2 + 1];
+        d2 += d * d;
+      }
+      return d2;
+    }
+    // -------------------------------------------------------------------------
+    // calcBoxMaxDist2
+    // -------------------------------------------------------------------------
+    // The squared distance from the point to the farthest corner of the box
+    static GLfloat calcBoxMaxDist2(const GLfloat inMinMax[6], const GLfloat inPoint[3])
+    {
+      GLfloat d2 = 0;
+      for (int i = 0; i < 3; i++)
+      {
+        GLfloat d = std::max(inPoint[i] - inMinMax[i * 2], inMinMax[i * 2 + 1] - inPoint[i]);
+        d2 += d * d;
+      }
+      return d2;
+    }
+    // -------------------------------------------------------------------------
+    // testBox
+    // -------------------------------------------------------------------------
+    // inNodeMinMax against the query box inMinMax
+    static Frustum::TestResult testBox(const GLfloat inMinMax[6], const GLfloat inNodeMinMax[6])
+    {
+      Frustum::TestResult result = Frustum::INSIDE;
+      for (int i = 0; i < 3; i++)
+      {
+        if (inNodeMinMax[i * 2] > inMinMax[i * 2 + 1] ||
+            inNodeMinMax[i * 2 + 1] < inMinMax[i * 2])
+          return Frustum::OUTSIDE;
+        if (inNodeMinMax[i * 2] < inMinMax[i * 2] ||
+            inNodeMinMax[i * 2 + 1] > inMinMax[i * 2 + 1])
+          result = Frustum::INTERSECT;
+      }
+      return result;
+    }
+    // -------------------------------------------------------------------------
+    // isInsideBox
+    // -------------------------------------------------------------------------
+    static bool isInsideBox(const GLfloat inMinMax[6], const GLfloat inPoint[3])
+    {
+      for (int i = 0; i < 3; i++)
+        if (inPoint[i] < inMinMax[i * 2] || inPoint[i] > inMinMax[i * 2 + 1])
+          return false;
+      return true;
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_KD_TREE_H_
@@ -23,13 +23,210 @@
 
 // Includes --------------------------------------------------------------------
 #include <iostream>
+#include "ibc/gl/data.h"
 #include "ibc/gl/vector.h"
 
+// Macros ----------------------------------------------------------------------
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IBC_MATRIX_USE_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#define IBC_MATRIX_USE_AVX
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define IBC_MATRIX_USE_NEON
+#include <arm_neon.h>
+#endif
+
 // Namespace -------------------------------------------------------------------
 namespace ibc
 {
  namespace gl
  {
+  // ---------------------------------------------------------------------------
+  // MatrixKernel class
+  // ---------------------------------------------------------------------------
+  // The SIMD kernels of MatrixBase (row major 4x4). IS_ACCELERATED == 0 : the
+  // scalar code of MatrixBase is used. The kernels allow outDst == inSrc
+  template <typename MatrixType> struct MatrixKernel
+  {
+    enum { IS_ACCELERATED = 0 };
+  };
+#if defined(IBC_MATRIX_USE_SSE2) || defined(IBC_MATRIX_USE_NEON)
+  template <> struct MatrixKernel<float>
+  {
+    enum { IS_ACCELERATED = 1 };
+
+    // -------------------------------------------------------------------------
+    // multi
+    // -------------------------------------------------------------------------
+    // row i of outDst = sum_k inSrc0[i][k] * (row k of inSrc1)
+    static void multi(float outDst[], const float inSrc0[], const float inSrc1[])
+    {
+#ifdef IBC_MATRIX_USE_SSE2
+      __m128  b0 = _mm_loadu_ps(inSrc1 + 0);
+      __m128  b1 = _mm_loadu_ps(inSrc1 + 4);
+      __m128  b2 = _mm_loadu_ps(inSrc1 + 8);
+      __m128  b3 = _mm_loadu_ps(inSrc1 + 12);
+      for (int i = 0; i < 4; i++)
+      {
+        __m128  a = _mm_loadu_ps(inSrc0 + i * 4);
+        __m128  r = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+        r = madd(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1, r);
+        r = madd(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2, r);
+        r = madd(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b3, r);
+        _mm_storeu_ps(outDst + i * 4, r);
+      }
+#else
+      float32x4_t b0 = vld1q_f32(inSrc1 + 0);
+      float32x4_t b1 = vld1q_f32(inSrc1 + 4);
+      float32x4_t b2 = vld1q_f32(inSrc1 + 8);
+      float32x4_t b3 = vld1q_f32(inSrc1 + 12);
+      for (int i = 0; i < 4; i++)
+      {
+        float32x4_t a = vld1q_f32(inSrc0 + i * 4);
+        float32x4_t r = vmulq_n_f32(b0, vgetq_lane_f32(a, 0));
+        r = vmlaq_n_f32(r, b1, vgetq_lane_f32(a, 1));
+        r = vmlaq_n_f32(r, b2, vgetq_lane_f32(a, 2));
+        r = vmlaq_n_f32(r, b3, vgetq_lane_f32(a, 3));
+        vst1q_f32(outDst + i * 4, r);
+      }
+#endif
+    }
+    // -------------------------------------------------------------------------
+    // transformPoints
+    // -------------------------------------------------------------------------
+    // (x, y, z) at the top of the strided structs (only 12 bytes are written)
+    static void transformPoints(const float inMat[], const void *inPtr, size_t inStride,
+                                size_t inNum, void *outPtr, size_t inOutStride)
+    {
+      const unsigned char *src = (const unsigned char *)inPtr;
+      unsigned char *dst = (unsigned char *)outPtr;
+#ifdef IBC_MATRIX_USE_SSE2
+      // The columns of the matrix : p' = c0 * x + c1 * y + c2 * z + c3
+      __m128  c0 = _mm_set_ps(0, inMat[8],  inMat[4], inMat[0]);
+      __m128  c1 = _mm_set_ps(0, inMat[9],  inMat[5], inMat[1]);
+      __m128  c2 = _mm_set_ps(0, inMat[10], inMat[6], inMat[2]);
+      __m128  c3 = _mm_set_ps(0, inMat[11], inMat[7], inMat[3]);
+      // 16 bytes are loaded, except for the last point (might be at the end)
+      size_t  num = (inNum > 0) ? inNum - 1 : 0;
+      size_t  i = 0;
+      for (; i < num; i++, src += inStride, dst += inOutStride)
+        storeXYZ((float *)dst, transform(_mm_loadu_ps((const float *)src), c0, c1, c2, c3));
+      for (; i < inNum; i++, src += inStride, dst += inOutStride)
+      {
+        const float *p = (const float *)src;
+        storeXYZ((float *)dst, transform(_mm_set_ps(0, p[2], p[1], p[0]), c0, c1, c2, c3));
+      }
+#else
+      float32x4_t c0 = {inMat[0], inMat[4], inMat[8],  0};
+      float32x4_t c1 = {inMat[1], inMat[5], inMat[9],  0};
+      float32x4_t c2 = {inMat[2], inMat[6], inMat[10], 0};
+      float32x4_t c3 = {inMat[3], inMat[7], inMat[11], 0};
+      for (size_t i = 0; i < inNum; i++, src += inStride, dst += inOutStride)
+      {
+        const float *p = (const float *)src;
+        float32x4_t r = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(c3, c0, p[0]), c1, p[1]), c2, p[2]);
+        vst1_f32((float *)dst, vget_low_f32(r));
+        vst1q_lane_f32((float *)dst + 2, r, 2);
+      }
+#endif
+    }
+
+#ifdef IBC_MATRIX_USE_SSE2
+    // -------------------------------------------------------------------------
+    // madd
+    // -------------------------------------------------------------------------
+    static __m128 madd(__m128 inA, __m128 inB, __m128 inC)
+    {
+#ifdef __FMA__
+      return _mm_fmadd_ps(inA, inB, inC);
+#else
+      return _mm_add_ps(_mm_mul_ps(inA, inB), inC);
+#endif
+    }
+    // -------------------------------------------------------------------------
+    // transform
+    // -------------------------------------------------------------------------
+    static __m128 transform(__m128 inP, __m128 inC0, __m128 inC1, __m128 inC2, __m128 inC3)
+    {
+      __m128  r = madd(_mm_shuffle_ps(inP, inP, _MM_SHUFFLE(0, 0, 0, 0)), inC0, inC3);
+      r = madd(_mm_shuffle_ps(inP, inP, _MM_SHUFFLE(1, 1, 1, 1)), inC1, r);
+      return madd(_mm_shuffle_ps(inP, inP, _MM_SHUFFLE(2, 2, 2, 2)), inC2, r);
+    }
+    // -------------------------------------------------------------------------
+    // storeXYZ
+    // -------------------------------------------------------------------------
+    static void storeXYZ(float *outPtr, __m128 inV)
+    {
+      _mm_storel_pi((__m64 *)outPtr, inV);
+      _mm_store_ss(outPtr + 2, _mm_movehl_ps(inV, inV));
+    }
+#endif
+  };
+#endif
+#if defined(IBC_MATRIX_USE_SSE2)
+  template <> struct MatrixKernel<double>
+  {
+    enum { IS_ACCELERATED = 1 };
+
+    // -------------------------------------------------------------------------
+    // multi
+    // -------------------------------------------------------------------------
+    static void multi(double outDst[], const double inSrc0[], const double inSrc1[])
+    {
+#ifdef IBC_MATRIX_USE_AVX
+      __m256d b[4];
+      for (int k = 0; k < 4; k++)
+        b[k] = _mm256_loadu_pd(inSrc1 + k * 4);
+      __m256d r[4];
+      for (int i = 0; i < 4; i++)
+      {
+        r[i] = _mm256_mul_pd(_mm256_broadcast_sd(inSrc0 + i * 4), b[0]);
+        for (int k = 1; k < 4; k++)
+        {
+#ifdef __FMA__
+          r[i] = _mm256_fmadd_pd(_mm256_broadcast_sd(inSrc0 + i * 4 + k), b[k], r[i]);
+#else
+          r[i] = _mm256_add_pd(_mm256_mul_pd(_mm256_broadcast_sd(inSrc0 + i * 4 + k), b[k]), r[i]);
+#endif
+        }
+      }
+      for (int i = 0; i < 4; i++)
+        _mm256_storeu_pd(outDst + i * 4, r[i]);
+#else
+      // The rows are (lo, hi) pairs of __m128d
+      __m128d lo[4], hi[4];
+      for (int k = 0; k < 4; k++)
+      {
+        lo[k] = _mm_loadu_pd(inSrc1 + k * 4);
+        hi[k] = _mm_loadu_pd(inSrc1 + k * 4 + 2);
+      }
+      __m128d rLo[4], rHi[4];
+      for (int i = 0; i < 4; i++)
+      {
+        __m128d a = _mm_set1_pd(inSrc0[i * 4]);
+        rLo[i] = _mm_mul_pd(a, lo[0]);
+        rHi[i] = _mm_mul_pd(a, hi[0]);
+        for (int k = 1; k < 4; k++)
+        {
+          a = _mm_set1_pd(inSrc0[i * 4 + k]);
+          rLo[i] = _mm_add_pd(_mm_mul_pd(a, lo[k]), rLo[i]);
+          rHi[i] = _mm_add_pd(_mm_mul_pd(a, hi[k]), rHi[i]);
+        }
+      }
+      for (int i = 0; i < 4; i++)
+      {
+        _mm_storeu_pd(outDst + i * 4, rLo[i]);
+        _mm_storeu_pd(outDst + i * 4 + 2, rHi[i]);
+      }
+#endif
+    }
+  };
+#endif
+
   // ---------------------------------------------------------------------------
   // MatrixBase class
   // ---------------------------------------------------------------------------
@@ -42,7 +239,7 @@ namespace ibc
     static const int MATRIX_SIZE       = 16;
 
     // Member variables (public) -----------------------------------------------
-    MatrixType  mMat[4][4];
+    alignas(16) MatrixType  mMat[4][4];
 
     // Constructors and Destructor ---------------------------------------------
     // -------------------------------------------------------------------------
@@ -82,24 +279,17 @@ namespace ibc
     // -------------------------------------------------------------------------
     // MatrixBase (copy constructor)
     // -------------------------------------------------------------------------
-    MatrixBase(const MatrixBase<MatrixType> &inMatrix)
-    {
-      set(inMatrix);
-    }
+    MatrixBase(const MatrixBase<MatrixType> &inMatrix) = default;
     // -------------------------------------------------------------------------
     // ~MatrixBase
     // -------------------------------------------------------------------------
-    virtual ~MatrixBase()
-    {
-    }
+    // Not virtual, so that the matrices are trivially copyable
+    ~MatrixBase() = default;
     // Operator overloading ----------------------------------------------------
     // -------------------------------------------------------------------------
     // =
     // -------------------------------------------------------------------------
-    MatrixBase<MatrixType> &operator=(const MatrixBase<MatrixType> &inMatrix)
-    {
-      return set(inMatrix);
-    }
+    MatrixBase<MatrixType> &operator=(const MatrixBase<MatrixType> &inMatrix) = default;
     // -------------------------------------------------------------------------
     // []
     // -------------------------------------------------------------------------
@@ -471,6 +661,22 @@ namespace ibc
     {
       return MatrixBase<MatrixType>::inverse((MatrixType *)mMat, (MatrixType *)mMat);
     }
+    // -------------------------------------------------------------------------
+    // inverseAffine
+    // -------------------------------------------------------------------------
+    bool inverseAffine()
+    {
+      return MatrixBase<MatrixType>::inverseAffine((MatrixType *)mMat, (MatrixType *)mMat);
+    }
+    // -------------------------------------------------------------------------
+    // transformPoints
+    // -------------------------------------------------------------------------
+    void transformPoints(const glXYZf *inPoints, size_t inNum, glXYZf *outPoints) const
+    {
+      MatrixBase<MatrixType>::transformPoints((const MatrixType *)mMat,
+                                              inPoints, sizeof(glXYZf), inNum,
+                                              outPoints, sizeof(glXYZf));
+    }
 
     // Static Functions --------------------------------------------------------
     // -------------------------------------------------------------------------
@@ -576,6 +782,11 @@ namespace ibc
     // -------------------------------------------------------------------------
     static void  multi(MatrixType outDst[], const MatrixType inSrc0[], const MatrixType inSrc1[])
     {
+      if constexpr (MatrixKernel<MatrixType>::IS_ACCELERATED)
+      {
+        MatrixKernel<MatrixType>::multi(outDst, inSrc0, inSrc1);
+        return;
+      }
       for (int i = 0; i < MATRIX_ROW_SIZE; i++)
         for (int j = 0; j < MATRIX_COL_SIZE; j++)
         {
@@ -595,6 +806,45 @@ namespace ibc
       outVec[2] = inMat[8] * inVec[0] + inMat[9] * inVec[1] + inMat[10] * inVec[2] + inMat[11];
     }
     // -------------------------------------------------------------------------
+    // transformPoints
+    // -------------------------------------------------------------------------
+    // Transforms inNum points (x, y, z GLfloat at the top of the strided
+    // structs) by the affine matrix. outPtr can be inPtr
+    static void transformPoints(const MatrixType inMat[], const void *inPtr, size_t inStride,
+                                size_t inNum, void *outPtr, size_t inOutStride)
+    {
+      float mat[MATRIX_SIZE];
+      for (int i = 0; i < MATRIX_SIZE; i++)
+        mat[i] = (float )inMat[i];
+#if defined(IBC_MATRIX_USE_SSE2) || defined(IBC_MATRIX_USE_NEON)
+      MatrixKernel<float>::transformPoints(mat, inPtr, inStride, inNum, outPtr, inOutStride);
+#else
+      const unsigned char *src = (const unsigned char *)inPtr;
+      unsigned char *dst = (unsigned char *)outPtr;
+      for (size_t i = 0; i < inNum; i++, src += inStride, dst += inOutStride)
+      {
+        float p[3];
+        MatrixBase<float>::multiMatrixByVector(p, mat, (const float *)src);
+        ((float *)dst)[0] = p[0];
+        ((float *)dst)[1] = p[1];
+        ((float *)dst)[2] = p[2];
+      }
+#endif
+    }
+    // -------------------------------------------------------------------------
+    // transformVectors
+    // -------------------------------------------------------------------------
+    // transformPoints() without the translation (e.g. for the normals with
+    // the rigid transforms)
+    static void transformVectors(const MatrixType inMat[], const void *inPtr, size_t inStride,
+                                 size_t inNum, void *outPtr, size_t inOutStride)
+    {
+      MatrixType  mat[MATRIX_SIZE];
+      set(mat, inMat);
+      setTranslation(mat, 0, 0, 0);
+      transformPoints(mat, inPtr, inStride, inNum, outPtr, inOutStride);
+    }
+    // -------------------------------------------------------------------------
     // scale
     // -------------------------------------------------------------------------
     static void scale(MatrixType ioMat[], MatrixType inScale)
@@ -757,6 +1007,37 @@ namespace ibc
           outDst[i] = t[i] * v;
       return true;
     }
+    // -------------------------------------------------------------------------
+    // inverseAffine
+    // -------------------------------------------------------------------------
+    // The inverse of the affine matrix (the bottom row is (0, 0, 0, 1)).
+    // The columns of the inverse of the upper 3x3 (rows r0, r1, r2) are
+    // r1 x r2, r2 x r0 and r0 x r1 divided by the determinant
+    static bool inverseAffine(MatrixType outDst[], const MatrixType inSrc[])
+    {
+      const MatrixType  *r0 = inSrc, *r1 = inSrc + 4, *r2 = inSrc + 8;
+      MatrixType  c[3][3], t[16], v;
+      VectorBase<MatrixType>::cross(c[0], r1, r2);
+      VectorBase<MatrixType>::cross(c[1], r2, r0);
+      VectorBase<MatrixType>::cross(c[2], r0, r1);
+      v = VectorBase<MatrixType>::dot(r0, c[0]);
+      if (v == 0)
+        return false;
+      v = 1.0 / v;
+
+      for (int i = 0; i < 3; i++)
+      {
+        for (int j = 0; j < 3; j++)
+          t[i * 4 + j] = c[j][i] * v;
+        t[i * 4 + 3] = -(t[i * 4 + 0] * inSrc[3] + t[i * 4 + 1] * inSrc[7] +
+                         t[i * 4 + 2] * inSrc[11]);
+      }
+      t[12] = t[13] = t[14] = 0;
+      t[15] = 1;
+      for (int i = 0; i < 16; i++)
+          outDst[i] = t[i];
+      return true;
+    }
   };
 
   // Operator overloading (for other types) ------------------------------------
@@ -67,7 +67,7 @@ namespace ibc { namespace gl { namespace model
       mShaderProgram = mShaderInterface->getShaderProgram();
 
       glGenVertexArrays(1, &mVertexArrayObject);
-      glBindVertexArray(mVertexArrayObject);
+      bindVertexArray(mVertexArrayObject);
 
       glGenBuffers(1, &mVertexBufferObject);
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
@@ -79,14 +79,14 @@ namespace ibc { namespace gl { namespace model
       glBufferData(GL_ELEMENT_ARRAY_BUFFER, (2 * 3 * sizeof(GLuint)), indexData, GL_STATIC_DRAW);
 
       // get the location of the "modelview" uniform
-      mModelViewLocation = glGetUniformLocation (mShaderProgram, "modelview");
+      mModelViewLocation = mShaderInterface->getUniformLocation("modelview");
 
       // get the location of the "projection" uniform
-      mProjectionLocation = glGetUniformLocation (mShaderProgram, "projection");
+      mProjectionLocation = mShaderInterface->getUniformLocation("projection");
 
       // get the location of the "position" and "color" attributes
-      GLint positionLocation = glGetAttribLocation (mShaderProgram, "position");
-      GLint colorLocation = glGetAttribLocation (mShaderProgram, "color");
+      GLint positionLocation = mShaderInterface->getAttribLocation("position");
+      GLint colorLocation = mShaderInterface->getAttribLocation("color");
 
       glEnableVertexAttribArray(0);
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
@@ -148,10 +148,9 @@ namespace ibc { namespace gl { namespace model
       if (mIsBackdropColorModified)
         updateVBO();
 
-      glUseProgram(mShaderProgram);
-      glUniformMatrix4fv(mModelViewLocation, 1, GL_FALSE, &(inModelView[0]));
-      glUniformMatrix4fv(mProjectionLocation, 1, GL_FALSE, &(inProjection[0]));
-      glBindVertexArray(mVertexArrayObject);
+      useProgram(mShaderProgram);
+      setMatrixUniforms(mModelViewLocation, mProjectionLocation, inModelView, inProjection);
+      bindVertexArray(mVertexArrayObject);
       glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     }
 
@@ -34,6 +34,16 @@ namespace ibc { namespace gl { namespace model
   class ColorTriangle : public virtual ibc::gl::model::ModelBase
   {
   public:
+    // structs -----------------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // vertex_info
+    // -------------------------------------------------------------------------
+    struct vertex_info
+    {
+      GLfloat position[3];
+      GLfloat color[3];
+    };
+
     // Constructors and Destructor ---------------------------------------------
     // -------------------------------------------------------------------------
     // ColorTriangle
@@ -57,31 +67,28 @@ namespace ibc { namespace gl { namespace model
       if (ModelBase::initModel() == false)
         return false;
 
-      static const struct vertex_info vertexData[] =
-      {
-        { {  0.0f,  0.500f, 0.0f }, { 1.f, 0.f, 0.f } },
-        { {  0.5f, -0.366f, 0.0f }, { 0.f, 1.f, 0.f } },
-        { { -0.5f, -0.366f, 0.0f }, { 0.f, 0.f, 1.f } },
-      };
+      size_t  vertexNum;
+      const struct vertex_info  *vertexData = getVertexData(&vertexNum);
 
       mShaderProgram = mShaderInterface->getShaderProgram();
 
       glGenVertexArrays(1, &mVertexArrayObject);
-      glBindVertexArray(mVertexArrayObject);
+      bindVertexArray(mVertexArrayObject);
 
       glGenBuffers(1, &mVertexBufferObject);
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-      glBufferData(GL_ARRAY_BUFFER, (9 * 2 * sizeof(GLfloat)), vertexData, GL_STATIC_DRAW);
+      glBufferData(GL_ARRAY_BUFFER, sizeof(struct vertex_info) * vertexNum, vertexData,
+                   GL_STATIC_DRAW);
 
       // get the location of the "modelview" uniform
-      mModelViewLocation = glGetUniformLocation (mShaderProgram, "modelview");
+      mModelViewLocation = mShaderInterface->getUniformLocation("modelview");
 
       // get the location of the "projection" uniform
-      mProjectionLocation = glGetUniformLocation (mShaderProgram, "projection");
+      mProjectionLocation = mShaderInterface->getUniformLocation("projection");
 
       // get the location of the "position" and "color" attributes
-      GLint positionLocation = glGetAttribLocation (mShaderProgram, "position");
-      GLint colorLocation = glGetAttribLocation (mShaderProgram, "color");
+      GLint positionLocation = mShaderInterface->getAttribLocation("position");
+      GLint colorLocation = mShaderInterface->getAttribLocation("color");
 
       glEnableVertexAttribArray(0);
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
@@ -112,24 +119,30 @@ namespace ibc { namespace gl { namespace model
     // -------------------------------------------------------------------------
     virtual void drawModel(const GLfloat inModelView[16], const GLfloat inProjection[16])
     {
-      glUseProgram(mShaderProgram);
-      glUniformMatrix4fv(mModelViewLocation, 1, GL_FALSE, &(inModelView[0]));
-      glUniformMatrix4fv(mProjectionLocation, 1, GL_FALSE, &(inProjection[0]));
-      glBindVertexArray(mVertexArrayObject);
+      useProgram(mShaderProgram);
+      setMatrixUniforms(mModelViewLocation, mProjectionLocation, inModelView, inProjection);
+      bindVertexArray(mVertexArrayObject);
       glDrawArrays(GL_TRIANGLES, 0, 3);
     }
 
-  protected:
-    // structs -----------------------------------------------------------------
+    // Static Member functions -------------------------------------------------
     // -------------------------------------------------------------------------
-    // vertex_info
+    // getVertexData
     // -------------------------------------------------------------------------
-    struct vertex_info
+    // The geometry of the triangle (also drawn by InstancedPrimitives)
+    static const struct vertex_info *getVertexData(size_t *outNum)
     {
-      GLfloat position[3];
-      GLfloat color[3];
-    };
+      static const struct vertex_info vertexData[] =
+      {
+        { {  0.0f,  0.500f, 0.0f }, { 1.f, 0.f, 0.f } },
+        { {  0.5f, -0.366f, 0.0f }, { 0.f, 1.f, 0.f } },
+        { { -0.5f, -0.366f, 0.0f }, { 0.f, 0.f, 1.f } },
+      };
+      *outNum = sizeof(vertexData) / sizeof(vertexData[0]);
+      return vertexData;
+    }
 
+  protected:
     // Member variables --------------------------------------------------------
     GLuint mShaderProgram;
     GLuint mVertexArrayObject;
@@ -0,0 +1,430 @@
+// =============================================================================
+//  instanced_primitives.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/model/instanced_primitives.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for InstancedPrimitives model
+*/
+
+#ifndef IBC_GL_MODEL_INSTANCED_PRIMITIVES_H_
+#define IBC_GL_MODEL_INSTANCED_PRIMITIVES_H_
+
+// Includes --------------------------------------------------------------------
+#include <vector>
+#include "ibc/gl/model/model_base.h"
+#include "ibc/gl/model/color_cube.h"
+#include "ibc/gl/model/color_triangle.h"
+#include "ibc/gl/model/solid_cube.h"
+#include "ibc/gl/model/solid_square.h"
+#include "ibc/gl/model/xyz_axis.h"
+#include "ibc/gl/dirty_range.h"
+
+// Namespace -------------------------------------------------------------------
+//namespace ibc::gl::model // <- nested namespace (C++17)
+namespace ibc { namespace gl { namespace model
+{
+  // ---------------------------------------------------------------------------
+  // InstancedPrimitives class
+  // ---------------------------------------------------------------------------
+  // Draws many copies of one primitive (the geometry of ColorCube, SolidCube,
+  // XYZAxis, SolidSquare or ColorTriangle) with one glDrawArraysInstanced().
+  // Each instance has its own model matrix and color (see Instance), which
+  // are read from the user buffer like Points::setDataPtr().
+  // Should be used with ibc::gl::shader::Instanced
+  class InstancedPrimitives : public virtual ibc::gl::model::ModelBase
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    enum PrimitiveType
+    {
+      PRIMITIVE_WIRE_CUBE = 0,  // ColorCube
+      PRIMITIVE_SOLID_CUBE,     // SolidCube
+      PRIMITIVE_AXIS,           // XYZAxis
+      PRIMITIVE_SQUARE,         // SolidSquare
+      PRIMITIVE_TRIANGLE        // ColorTriangle
+    };
+    enum ColorMode
+    {
+      COLOR_MODULATE = 0,       // vertex color * instance color
+      COLOR_INSTANCE            // instance color only
+    };
+
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      GLfloat matrix[16];       // model matrix (GL column major)
+      GLfloat color[4];         // RGBA
+    } Instance;
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // InstancedPrimitives
+    // -------------------------------------------------------------------------
+    InstancedPrimitives(PrimitiveType inType = PRIMITIVE_WIRE_CUBE)
+    {
+      mShaderInterface = NULL;
+      mPrimitiveType = inType;
+      mColorMode = COLOR_MODULATE;
+      mIsPrimitiveUpdated = true;
+      mIsInstancesModified = false;
+      mIsModelInitialized = false;
+
+      mInstancePtr = NULL;
+      mInstanceNum = 0;
+      mInstanceCapacity = 0;
+      mPrimitiveMode = GL_LINES;
+      mPrimitiveVertexNum = 0;
+    }
+    // -------------------------------------------------------------------------
+    // ~InstancedPrimitives
+    // -------------------------------------------------------------------------
+    virtual ~InstancedPrimitives()
+    {
+    }
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setPrimitiveType
+    // -------------------------------------------------------------------------
+    void setPrimitiveType(PrimitiveType inType)
+    {
+      if (mPrimitiveType == inType)
+        return;
+      mPrimitiveType = inType;
+      mIsPrimitiveUpdated = true;
+    }
+    // -------------------------------------------------------------------------
+    // getPrimitiveType
+    // -------------------------------------------------------------------------
+    PrimitiveType getPrimitiveType()
+    {
+      return mPrimitiveType;
+    }
+    // -------------------------------------------------------------------------
+    // setColorMode
+    // -------------------------------------------------------------------------
+    void setColorMode(ColorMode inMode)
+    {
+      mColorMode = inMode;
+    }
+    // -------------------------------------------------------------------------
+    // setInstancePtr
+    // -------------------------------------------------------------------------
+    // The buffer is not copied (should be kept until the next setInstancePtr).
+    // The instance buffer of GL grows in the power of 2, so changing only the
+    // number (e.g. adding the instances to the end) doesn't reallocate it.
+    void setInstancePtr(const Instance *inInstancePtr, size_t inInstanceNum)
+    {
+      mInstancePtr = inInstancePtr;
+      mInstanceNum = inInstanceNum;
+      mIsInstancesModified = true;
+    }
+    // -------------------------------------------------------------------------
+    // getInstanceNum
+    // -------------------------------------------------------------------------
+    size_t getInstanceNum()
+    {
+      return mInstanceNum;
+    }
+    // -------------------------------------------------------------------------
+    // markInstancesModified
+    // -------------------------------------------------------------------------
+    void markInstancesModified()
+    {
+      mIsInstancesModified = true;
+    }
+    // -------------------------------------------------------------------------
+    // markInstanceRangeModified
+    // -------------------------------------------------------------------------
+    // Only the instances in [inFirst, inFirst + inCount) are uploaded in the
+    // next drawModel() (e.g. a few moving objects in a static scene)
+    void markInstanceRangeModified(size_t inFirst, size_t inCount)
+    {
+      mDirtyRange.add(inFirst, inCount);
+    }
+    // -------------------------------------------------------------------------
+    // initModel
+    // -------------------------------------------------------------------------
+    virtual bool initModel()
+    {
+      if (ModelBase::initModel() == false)
+        return false;
+
+      // Shader program related initialization
+      mShaderProgram = mShaderInterface->getShaderProgram();
+      mModelViewLocation  = mShaderInterface->getUniformLocation("modelview");
+      mProjectionLocation = mShaderInterface->getUniformLocation("projection");
+      mColorModeLocation  = mShaderInterface->getUniformLocation("colorMode");
+      GLint positionLocation  = mShaderInterface->getAttribLocation("position");
+      GLint colorLocation     = mShaderInterface->getAttribLocation("color");
+      GLint matrixLocation    = mShaderInterface->getAttribLocation("instanceMatrix");
+      GLint instColorLocation = mShaderInterface->getAttribLocation("instanceColor");
+
+      glGenVertexArrays(1, &mVertexArrayObject);
+      bindVertexArray(mVertexArrayObject);
+
+      // The primitive vertices (per vertex)
+      glGenBuffers(1, &mVertexBufferObject);
+      glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+      glEnableVertexAttribArray(positionLocation);
+      glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE,
+                            sizeof (struct vertex_info),
+                            (const GLvoid *)offsetof(struct vertex_info, position));
+      glEnableVertexAttribArray(colorLocation);
+      glVertexAttribPointer(colorLocation, 3, GL_FLOAT, GL_FALSE,
+                            sizeof (struct vertex_info),
+                            (const GLvoid *)offsetof(struct vertex_info, color));
+
+      // The instances (per instance, the mat4 takes 4 consecutive locations)
+      glGenBuffers(1, &mInstanceBufferObject);
+      glBindBuffer(GL_ARRAY_BUFFER, mInstanceBufferObject);
+      for (int i = 0; i < 4; i++)
+      {
+        glEnableVertexAttribArray(matrixLocation + i);
+        glVertexAttribPointer(matrixLocation + i, 4, GL_FLOAT, GL_FALSE,
+                              sizeof(Instance),
+                              (const GLvoid *)(offsetof(Instance, matrix) + sizeof(GLfloat) * 4 * i));
+        glVertexAttribDivisor(matrixLocation + i, 1);
+      }
+      glEnableVertexAttribArray(instColorLocation);
+      glVertexAttribPointer(instColorLocation, 4, GL_FLOAT, GL_FALSE,
+                            sizeof(Instance),
+                            (const GLvoid *)offsetof(Instance, color));
+      glVertexAttribDivisor(instColorLocation, 1);
+
+      mInstanceCapacity = 0;
+      mIsPrimitiveUpdated = true;
+      mIsInstancesModified = true;
+      mIsModelInitialized = true;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // disposeModel
+    // -------------------------------------------------------------------------
+    virtual void disposeModel()
+    {
+      if (mIsModelInitialized == false)
+        return;
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      glDeleteBuffers(1, &mVertexBufferObject);
+      glDeleteBuffers(1, &mInstanceBufferObject);
+      deleteVertexArrays(1, &mVertexArrayObject);
+      mInstanceCapacity = 0;
+      mIsModelInitialized = false;
+    }
+    // -------------------------------------------------------------------------
+    // drawModel
+    // -------------------------------------------------------------------------
+    virtual void drawModel(const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      if (mIsModelInitialized == false)
+        return;
+      if (mIsPrimitiveUpdated)
+      {
+        updatePrimitiveVBO();
+        mIsPrimitiveUpdated = false;
+      }
+      if (mIsInstancesModified || mDirtyRange.isEmpty() == false)
+        updateInstanceVBO();
+      if (mInstanceNum == 0 || mPrimitiveVertexNum == 0)
+        return;
+
+      useProgram(mShaderProgram);
+      setMatrixUniforms(mModelViewLocation, mProjectionLocation, inModelView, inProjection);
+      glUniform1i(mColorModeLocation, mColorMode);
+      bindVertexArray(mVertexArrayObject);
+      glDrawArraysInstanced(mPrimitiveMode, 0, mPrimitiveVertexNum, (GLsizei )mInstanceNum);
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setInstance
+    // -------------------------------------------------------------------------
+    // A helper to fill an instance (translation, uniform scale and color)
+    static void setInstance(Instance *outInstance,
+                            GLfloat inX, GLfloat inY, GLfloat inZ, GLfloat inScale,
+                            GLfloat inR = 1.0f, GLfloat inG = 1.0f,
+                            GLfloat inB = 1.0f, GLfloat inA = 1.0f)
+    {
+      for (int i = 0; i < 16; i++)
+        outInstance->matrix[i] = 0.0f;
+      outInstance->matrix[0]  = inScale;
+      outInstance->matrix[5]  = inScale;
+      outInstance->matrix[10] = inScale;
+      outInstance->matrix[12] = inX;
+      outInstance->matrix[13] = inY;
+      outInstance->matrix[14] = inZ;
+      outInstance->matrix[15] = 1.0f;
+      outInstance->color[0] = inR;
+      outInstance->color[1] = inG;
+      outInstance->color[2] = inB;
+      outInstance->color[3] = inA;
+    }
+
+  protected:
+    // structs -----------------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // vertex_info
+    // -------------------------------------------------------------------------
+    struct vertex_info
+    {
+      GLfloat position[3];
+      GLfloat color[3];
+    };
+
+    // Member variables --------------------------------------------------------
+    PrimitiveType mPrimitiveType;
+    ColorMode     mColorMode;
+    bool  mIsPrimitiveUpdated;
+    bool  mIsInstancesModified;
+    bool  mIsModelInitialized;
+    ibc::gl::DirtyRange mDirtyRange;
+
+    const Instance  *mInstancePtr;
+    size_t  mInstanceNum;
+    size_t  mInstanceCapacity;
+    GLenum  mPrimitiveMode;
+    GLsizei mPrimitiveVertexNum;
+
+    GLuint mShaderProgram;
+    GLuint mVertexArrayObject;
+    GLuint mVertexBufferObject;
+    GLuint mInstanceBufferObject;
+
+    GLint mModelViewLocation;
+    GLint mProjectionLocation;
+    GLint mColorModeLocation;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // updatePrimitiveVBO
+    // -------------------------------------------------------------------------
+    void updatePrimitiveVBO()
+    {
+      std::vector<struct vertex_info> vertices;
+      getPrimitiveVertices(mPrimitiveType, &vertices, &mPrimitiveMode);
+      mPrimitiveVertexNum = (GLsizei )vertices.size();
+      glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+      glBufferData(GL_ARRAY_BUFFER, sizeof(struct vertex_info) * vertices.size(),
+                   vertices.data(), GL_STATIC_DRAW);
+    }
+    // -------------------------------------------------------------------------
+    // updateInstanceVBO
+    // -------------------------------------------------------------------------
+    void updateInstanceVBO()
+    {
+      glBindBuffer(GL_ARRAY_BUFFER, mInstanceBufferObject);
+      if (mInstanceNum > mInstanceCapacity)
+      {
+        size_t  capacity = (mInstanceCapacity != 0) ? mInstanceCapacity : 16;
+        while (capacity < mInstanceNum)
+          capacity *= 2;
+        glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * capacity, NULL, GL_DYNAMIC_DRAW);
+        mInstanceCapacity = capacity;
+        mIsInstancesModified = true;
+      }
+      if (mInstanceNum != 0 && mInstancePtr != NULL)
+      {
+        if (mIsInstancesModified)
+          glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Instance) * mInstanceNum, mInstancePtr);
+        else
+        {
+          mDirtyRange.clip(mInstanceNum);
+          const std::vector<ibc::gl::DirtyRange::Range> &ranges = mDirtyRange.getRanges();
+          for (size_t i = 0; i < ranges.size(); i++)
+            glBufferSubData(GL_ARRAY_BUFFER, sizeof(Instance) * ranges[i].first,
+                            sizeof(Instance) * ranges[i].count,
+                            mInstancePtr + ranges[i].first);
+        }
+      }
+      mIsInstancesModified = false;
+      mDirtyRange.clear();
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getPrimitiveVertices
+    // -------------------------------------------------------------------------
+    // Expands the indexed geometry of the primitive models to the vertex list
+    // (the tables are the ones of ColorCube, SolidCube, XYZAxis, SolidSquare
+    // and ColorTriangle, so the both draw the same primitives)
+    static void getPrimitiveVertices(PrimitiveType inType,
+                                     std::vector<struct vertex_info> *outVertices,
+                                     GLenum *outMode)
+    {
+      switch (inType)
+      {
+        case PRIMITIVE_SOLID_CUBE:
+          expandVertices<SolidCube>(outVertices);
+          *outMode = GL_TRIANGLES;
+          break;
+        case PRIMITIVE_AXIS:
+          expandVertices<XYZAxis>(outVertices);
+          *outMode = GL_LINES;
+          break;
+        case PRIMITIVE_SQUARE:
+          expandVertices<SolidSquare>(outVertices);
+          *outMode = GL_TRIANGLES;
+          break;
+        case PRIMITIVE_TRIANGLE:
+          {
+            // ColorTriangle is not indexed (glDrawArrays)
+            size_t  vertexNum;
+            const auto  *data = ColorTriangle::getVertexData(&vertexNum);
+            expandVertices(data, NULL, vertexNum, outVertices);
+          }
+          *outMode = GL_TRIANGLES;
+          break;
+        case PRIMITIVE_WIRE_CUBE:
+        default:
+          expandVertices<ColorCube>(outVertices);
+          *outMode = GL_LINES;
+          break;
+      }
+    }
+    // -------------------------------------------------------------------------
+    // expandVertices
+    // -------------------------------------------------------------------------
+    template <class ModelType>
+    static void expandVertices(std::vector<struct vertex_info> *outVertices)
+    {
+      size_t  vertexNum, indexNum;
+      const auto  *data = ModelType::getVertexData(&vertexNum);
+      const GLuint  *index = ModelType::getIndexData(&indexNum);
+      expandVertices(data, index, indexNum, outVertices);
+    }
+    // -------------------------------------------------------------------------
+    // expandVertices
+    // -------------------------------------------------------------------------
+    // inIndex == NULL : the vertices are used in order
+    template <class VertexType>
+    static void expandVertices(const VertexType *inData, const GLuint *inIndex,
+                               size_t inNum, std::vector<struct vertex_info> *outVertices)
+    {
+      outVertices->resize(inNum);
+      for (size_t i = 0; i < inNum; i++)
+      {
+        const VertexType &src = inData[(inIndex != NULL) ? inIndex[i] : i];
+        struct vertex_info &dst = (*outVertices)[i];
+        for (int j = 0; j < 3; j++)
+        {
+          dst.position[j] = src.position[j];
+          dst.color[j] = src.color[j];
+        }
+      }
+    }
+  };
+};};};
+
+#endif  // #ifdef IBC_GL_MODEL_INSTANCED_PRIMITIVES_H_
@@ -25,6 +25,7 @@
 #include "ibc/base/types.h"
 #include "ibc/gl/shader_interface.h"
 #include "ibc/gl/model_interface.h"
+#include "ibc/gl/state_tracker.h"
 
 // Namespace -------------------------------------------------------------------
 //namespace ibc::gl::model // <- nested namespace (C++17)
@@ -124,6 +125,73 @@ namespace ibc { namespace gl { namespace model
 #ifdef QT_VERSION
     bool  mOpenGLFunctionsInitialized;
 #endif
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setMatrixUniforms
+    // -------------------------------------------------------------------------
+    // The shaders in ibc/gl/shader read the matrices from the FrameUniforms
+    // block updated by the view (the locations are -1, nothing is uploaded).
+    // This is only for the custom shaders with the plain matrix uniforms.
+    void setMatrixUniforms(GLint inModelViewLocation, GLint inProjectionLocation,
+                           const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      if (inModelViewLocation >= 0)
+        glUniformMatrix4fv(inModelViewLocation, 1, GL_FALSE, &(inModelView[0]));
+      if (inProjectionLocation >= 0)
+        glUniformMatrix4fv(inProjectionLocation, 1, GL_FALSE, &(inProjection[0]));
+    }
+    // The binds through the StateTracker (skipped if already bound)
+    // -------------------------------------------------------------------------
+    // useProgram
+    // -------------------------------------------------------------------------
+    void useProgram(GLuint inProgram)
+    {
+      if (ibc::gl::StateTracker::getInstance()->useProgram(inProgram))
+        glUseProgram(inProgram);
+    }
+    // -------------------------------------------------------------------------
+    // bindVertexArray
+    // -------------------------------------------------------------------------
+    void bindVertexArray(GLuint inVertexArray)
+    {
+      if (ibc::gl::StateTracker::getInstance()->bindVertexArray(inVertexArray))
+        glBindVertexArray(inVertexArray);
+    }
+    // -------------------------------------------------------------------------
+    // activeTexture
+    // -------------------------------------------------------------------------
+    void activeTexture(GLenum inTextureUnit)
+    {
+      if (ibc::gl::StateTracker::getInstance()->activeTexture(inTextureUnit))
+        glActiveTexture(inTextureUnit);
+    }
+    // -------------------------------------------------------------------------
+    // bindTexture
+    // -------------------------------------------------------------------------
+    void bindTexture(GLenum inTarget, GLuint inTexture)
+    {
+      if (ibc::gl::StateTracker::getInstance()->bindTexture(inTarget, inTexture))
+        glBindTexture(inTarget, inTexture);
+    }
+    // -------------------------------------------------------------------------
+    // deleteVertexArrays
+    // -------------------------------------------------------------------------
+    void deleteVertexArrays(GLsizei inNum, const GLuint *inVertexArrays)
+    {
+      glDeleteVertexArrays(inNum, inVertexArrays);
+      for (GLsizei i = 0; i < inNum; i++)
+        ibc::gl::StateTracker::getInstance()->deleteVertexArray(inVertexArrays[i]);
+    }
+    // -------------------------------------------------------------------------
+    // deleteTextures
+    // -------------------------------------------------------------------------
+    void deleteTextures(GLsizei inNum, const GLuint *inTextures)
+    {
+      glDeleteTextures(inNum, inTextures);
+      for (GLsizei i = 0; i < inNum; i++)
+        ibc::gl::StateTracker::getInstance()->deleteTexture(inTextures[i]);
+    }
   };
 };};};
 
@@ -0,0 +1,164 @@
+// =============================================================================
+//  octree_points.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/models/octree_points.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the Points model with the octree LOD
+*/
+
+#ifndef IBC_GL_MODEL_OCTREE_POINTS_H_
+#define IBC_GL_MODEL_OCTREE_POINTS_H_
+
+// Includes --------------------------------------------------------------------
+#include "ibc/gl/model/points_rgba8.h"
+#include "ibc/gl/octree.h"
+
+// Namespace -------------------------------------------------------------------
+//namespace ibc::gl::model // <- nested namespace (C++17)
+namespace ibc { namespace gl { namespace model
+{
+  // ---------------------------------------------------------------------------
+  // OctreePoints
+  // ---------------------------------------------------------------------------
+  // Uses the same shader (PointCloudRGBA8) and parameters as PointsRGBA8.
+  // The whole reordered point array is uploaded once, then each frame the
+  // visible nodes are selected by the screen space error and drawn with
+  // glMultiDrawArrays() until the point budget is reached.
+  // (The stream mode of PointsRGBA8 is not used by this model)
+  class OctreePoints : public PointsRGBA8
+  {
+  public:
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // OctreePoints
+    // -------------------------------------------------------------------------
+    OctreePoints()
+    {
+      mPointBudget = 5 * 1000 * 1000;
+      mMaxScreenError = 2.0f;
+      mDrawnPointNum = 0;
+      mDrawnNodeNum = 0;
+      mIsFrustumCulling = false;  // the octree does its own culling
+    }
+    // -------------------------------------------------------------------------
+    // ~OctreePoints
+    // -------------------------------------------------------------------------
+    virtual ~OctreePoints()
+    {
+    }
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // buildOctree
+    // -------------------------------------------------------------------------
+    // Builds the octree in parallel (should not be called while drawing)
+    bool buildOctree(const glXYZf_RGBAub *inDataPtr, size_t inDataNum,
+                     size_t inNodeSampleNum = 4096, size_t inMaxLeafNum = 16384,
+                     unsigned int inTaskNum = 0)
+    {
+      bool  result = mOctree.build(inDataPtr, inDataNum,
+                                   inNodeSampleNum, inMaxLeafNum, inTaskNum);
+      setDataPtr((float *)mOctree.getData(), mOctree.getDataNum());
+      return result;
+    }
+    // -------------------------------------------------------------------------
+    // getOctree
+    // -------------------------------------------------------------------------
+    const ibc::gl::Octree &getOctree() const
+    {
+      return mOctree;
+    }
+    // -------------------------------------------------------------------------
+    // drawModel
+    // -------------------------------------------------------------------------
+    virtual void drawModel(const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      mDrawnPointNum = 0;
+      mDrawnNodeNum = 0;
+      if (mDataNum == 0)
+        return;
+
+      updateDataVBO();
+
+      GLint viewport[4];
+      glGetIntegerv(GL_VIEWPORT, viewport);
+      mDrawnPointNum = mOctree.selectNodes(inModelView, inProjection, mModelFitParam,
+                                           (GLfloat )viewport[3], mMaxScreenError,
+                                           mPointBudget, &mDrawFirsts, &mDrawCounts);
+      mDrawnNodeNum = mDrawFirsts.size();
+      if (mDrawnNodeNum == 0)
+        return;
+
+      beginDraw(inModelView, inProjection);
+      glMultiDrawArrays(GL_POINTS, mDrawFirsts.data(), mDrawCounts.data(),
+                        (GLsizei )mDrawnNodeNum);
+      endDraw();
+    }
+    // -------------------------------------------------------------------------
+    // getPointBudget
+    // -------------------------------------------------------------------------
+    size_t getPointBudget()
+    {
+      return mPointBudget;
+    }
+    // -------------------------------------------------------------------------
+    // setPointBudget
+    // -------------------------------------------------------------------------
+    // The root node is always drawn, even if it has more points than inBudget
+    void setPointBudget(size_t inBudget)
+    {
+      mPointBudget = inBudget;
+    }
+    // -------------------------------------------------------------------------
+    // getMaxScreenError
+    // -------------------------------------------------------------------------
+    float getMaxScreenError()
+    {
+      return mMaxScreenError;
+    }
+    // -------------------------------------------------------------------------
+    // setMaxScreenError
+    // -------------------------------------------------------------------------
+    // The point spacing on the screen (pixels) to stop the refinement
+    void setMaxScreenError(float inError)
+    {
+      mMaxScreenError = inError;
+    }
+    // -------------------------------------------------------------------------
+    // getDrawnPointNum
+    // -------------------------------------------------------------------------
+    // The number of the points drawn in the last frame
+    size_t getDrawnPointNum()
+    {
+      return mDrawnPointNum;
+    }
+    // -------------------------------------------------------------------------
+    // getDrawnNodeNum
+    // -------------------------------------------------------------------------
+    size_t getDrawnNodeNum()
+    {
+      return mDrawnNodeNum;
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    ibc::gl::Octree mOctree;
+    size_t  mPointBudget;
+    float   mMaxScreenError;
+    size_t  mDrawnPointNum;
+    size_t  mDrawnNodeNum;
+  };
+};};};
+
+#endif  // #ifdef IBC_GL_MODEL_OCTREE_POINTS_H_
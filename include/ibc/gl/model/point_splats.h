@@ -0,0 +1,402 @@
+// =============================================================================
+//  point_splats.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/models/point_splats.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the Points model drawn as the sphere splats
+*/
+
+#ifndef IBC_GL_MODEL_POINT_SPLATS_H_
+#define IBC_GL_MODEL_POINT_SPLATS_H_
+
+// Includes --------------------------------------------------------------------
+#include "ibc/gl/model/points_rgba8.h"
+
+// Namespace -------------------------------------------------------------------
+//namespace ibc::gl::model // <- nested namespace (C++17)
+namespace ibc { namespace gl { namespace model
+{
+  // ---------------------------------------------------------------------------
+  // PointSplats
+  // ---------------------------------------------------------------------------
+  // The same data and parameters as PointsRGBA8, drawn with the PointSplat
+  // shader (setShader()). The point size is replaced by the splat radius in
+  // the fitted model space, so the splats scale with the perspective.
+  //
+  // Opaque mode   : one pass, each splat is a depth correct sphere
+  // Blending mode : needs the PointSplatResolve shader (setResolveShader())
+  //   1. visibility pass   : depth only, the splats pushed back by the radius
+  //   2. accumulation pass : the splats within the radius of the nearest
+  //                          surface are added with the weight (1 - r^2)
+  //   3. resolve pass      : rgb / weight is drawn to the current framebuffer
+  //                          with the depth of the visibility pass
+  //   (1 and 2 are rendered to an offscreen framebuffer of the viewport size)
+  //
+  // With the frustum culling enabled, the visible chunks are drawn from the
+  // nearest one (setFrontToBack()), so the early depth test rejects most of
+  // the hidden fragments. (The shader keeps the early depth test only with
+  // GL_ARB_conservative_depth, otherwise the sort has no effect.)
+  // The stream mode of PointsRGBA8 is not used.
+  class PointSplats : public PointsRGBA8
+  {
+  public:
+    // Typedefs ----------------------------------------------------------------
+    enum SplatMode
+    {
+      SPLAT_MODE_OPAQUE     = 0,
+      SPLAT_MODE_VISIBILITY,
+      SPLAT_MODE_ACCUMULATE
+    };
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // PointSplats
+    // -------------------------------------------------------------------------
+    PointSplats()
+    {
+      mSplatRadius = 0.005f;
+      mShadingMode = 1;
+      mIsBlending = false;
+      mIsFrontToBack = true;
+
+      mResolveShaderInterface = NULL;
+      mResolveShaderProgram = 0;
+      mResolveVertexArrayObject = 0;
+
+      mIsFrameBufferInitialized = false;
+      mFrameBuffer = 0;
+      mAccumTexture = 0;
+      mDepthTexture = 0;
+      mFrameBufferWidth = 0;
+      mFrameBufferHeight = 0;
+    }
+    // -------------------------------------------------------------------------
+    // ~PointSplats
+    // -------------------------------------------------------------------------
+    virtual ~PointSplats()
+    {
+    }
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setResolveShader
+    // -------------------------------------------------------------------------
+    // The PointSplatResolve shader for the blending mode
+    void setResolveShader(ibc::gl::ShaderInterface *inShaderInterface)
+    {
+      mResolveShaderInterface = inShaderInterface;
+    }
+    // -------------------------------------------------------------------------
+    // getResolveShader
+    // -------------------------------------------------------------------------
+    ibc::gl::ShaderInterface *getResolveShader()
+    {
+      return mResolveShaderInterface;
+    }
+    // -------------------------------------------------------------------------
+    // initModel
+    // -------------------------------------------------------------------------
+    virtual bool initModel()
+    {
+      if (PointsRGBA8::initModel() == false)
+        return false;
+
+      mSplatRadiusLocation    = mShaderInterface->getUniformLocation("splatRadius");
+      mSplatModeLocation      = mShaderInterface->getUniformLocation("splatMode");
+      mShadingModeLocation    = mShaderInterface->getUniformLocation("shadingMode");
+
+      if (mResolveShaderInterface != NULL)
+      {
+        mResolveShaderProgram = mResolveShaderInterface->getShaderProgram();
+        useProgram(mResolveShaderProgram);
+        glUniform1i(mResolveShaderInterface->getUniformLocation("accumMap"), 0);
+        glUniform1i(mResolveShaderInterface->getUniformLocation("depthMap"), 1);
+        // The full screen triangle has no attributes, but the core profile
+        // still needs a vertex array object to draw
+        glGenVertexArrays(1, &mResolveVertexArrayObject);
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // disposeModel
+    // -------------------------------------------------------------------------
+    virtual void disposeModel()
+    {
+      disposeFrameBuffer();
+      if (mResolveVertexArrayObject != 0)
+      {
+        deleteVertexArrays(1, &mResolveVertexArrayObject);
+        mResolveVertexArrayObject = 0;
+      }
+      PointsRGBA8::disposeModel();
+    }
+    // -------------------------------------------------------------------------
+    // drawModel
+    // -------------------------------------------------------------------------
+    virtual void drawModel(const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      if (mDataNum == 0)
+        return;
+      updateDataVBO();
+
+      if (mIsFrustumCulling)
+      {
+        size_t  num;
+        if (mIsFrontToBack)
+          num = mChunks.selectFrontToBack(inModelView, inProjection, mModelFitParam,
+                                          &mDrawFirsts, &mDrawCounts);
+        else
+          num = mChunks.select(inModelView, inProjection, mModelFitParam,
+                               &mDrawFirsts, &mDrawCounts);
+        if (num == 0)
+          return;
+      }
+      else
+      {
+        mDrawFirsts.assign(1, 0);
+        mDrawCounts.assign(1, (GLsizei )mDataNum);
+      }
+
+      GLint viewport[4];
+      glGetIntegerv(GL_VIEWPORT, viewport);
+      beginDraw(inModelView, inProjection);
+      glUniform1f(mSplatRadiusLocation, mSplatRadius);
+      glUniform1i(mShadingModeLocation, mShadingMode);
+
+      if (mIsBlending && mResolveShaderProgram != 0)
+        drawBlended(viewport);
+      else
+      {
+        glUniform1i(mSplatModeLocation, SPLAT_MODE_OPAQUE);
+        drawSplats();
+      }
+      endDraw();
+    }
+    // -------------------------------------------------------------------------
+    // getSplatRadius
+    // -------------------------------------------------------------------------
+    float getSplatRadius()
+    {
+      return mSplatRadius;
+    }
+    // -------------------------------------------------------------------------
+    // setSplatRadius
+    // -------------------------------------------------------------------------
+    // The radius in the fitted model space (the same unit as the cube model)
+    void setSplatRadius(float inRadius)
+    {
+      mSplatRadius = inRadius;
+    }
+    // -------------------------------------------------------------------------
+    // getShadingMode
+    // -------------------------------------------------------------------------
+    int getShadingMode()
+    {
+      return mShadingMode;
+    }
+    // -------------------------------------------------------------------------
+    // setShadingMode
+    // -------------------------------------------------------------------------
+    // Mode = 0 : flat color
+    // Mode = 1 : shaded by the sphere normal (the light from the viewer)
+    void setShadingMode(int inMode)
+    {
+      mShadingMode = inMode;
+    }
+    // -------------------------------------------------------------------------
+    // isBlending
+    // -------------------------------------------------------------------------
+    bool isBlending()
+    {
+      return mIsBlending;
+    }
+    // -------------------------------------------------------------------------
+    // setBlending
+    // -------------------------------------------------------------------------
+    // The two pass surfel blending (ignored without the resolve shader)
+    void setBlending(bool inEnable)
+    {
+      mIsBlending = inEnable;
+    }
+    // -------------------------------------------------------------------------
+    // isFrontToBack
+    // -------------------------------------------------------------------------
+    bool isFrontToBack()
+    {
+      return mIsFrontToBack;
+    }
+    // -------------------------------------------------------------------------
+    // setFrontToBack
+    // -------------------------------------------------------------------------
+    // Sorts the visible chunks by the depth (only with the frustum culling)
+    void setFrontToBack(bool inEnable)
+    {
+      mIsFrontToBack = inEnable;
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    float mSplatRadius;
+    GLint mShadingMode;
+    bool  mIsBlending;
+    bool  mIsFrontToBack;
+
+    GLint mSplatRadiusLocation;
+    GLint mSplatModeLocation;
+    GLint mShadingModeLocation;
+
+    ibc::gl::ShaderInterface *mResolveShaderInterface;
+    GLuint mResolveShaderProgram;
+    GLuint mResolveVertexArrayObject;
+
+    bool  mIsFrameBufferInitialized;
+    GLuint  mFrameBuffer;
+    GLuint  mAccumTexture;
+    GLuint  mDepthTexture;
+    GLsizei mFrameBufferWidth;
+    GLsizei mFrameBufferHeight;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // drawSplats
+    // -------------------------------------------------------------------------
+    void drawSplats()
+    {
+      glMultiDrawArrays(GL_POINTS, mDrawFirsts.data(), mDrawCounts.data(),
+                        (GLsizei )mDrawFirsts.size());
+    }
+    // -------------------------------------------------------------------------
+    // drawBlended
+    // -------------------------------------------------------------------------
+    // beginDraw() should be called before this. The GL states changed here
+    // are restored before returning.
+    void drawBlended(const GLint inViewport[4])
+    {
+      GLint prevFrameBuffer, depthFunc, blendFunc[4];
+      GLboolean depthMask;
+      glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevFrameBuffer);
+      glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+      glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+      glGetIntegerv(GL_BLEND_SRC_RGB, &(blendFunc[0]));
+      glGetIntegerv(GL_BLEND_DST_RGB, &(blendFunc[1]));
+      glGetIntegerv(GL_BLEND_SRC_ALPHA, &(blendFunc[2]));
+      glGetIntegerv(GL_BLEND_DST_ALPHA, &(blendFunc[3]));
+      GLboolean isBlend = glIsEnabled(GL_BLEND);
+      GLboolean isDepthTest = glIsEnabled(GL_DEPTH_TEST);
+
+      initFrameBuffer(inViewport[2], inViewport[3]);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mFrameBuffer);
+      glViewport(0, 0, mFrameBufferWidth, mFrameBufferHeight);
+      static const GLfloat zeros[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+      static const GLfloat one = 1.0f;
+      glDepthMask(GL_TRUE);
+      glClearBufferfv(GL_COLOR, 0, zeros);
+      glClearBufferfv(GL_DEPTH, 0, &one);
+      glEnable(GL_DEPTH_TEST);
+
+      // Visibility pass
+      glDepthFunc(GL_LESS);
+      glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+      glDisable(GL_BLEND);
+      glUniform1i(mSplatModeLocation, SPLAT_MODE_VISIBILITY);
+      drawSplats();
+
+      // Accumulation pass
+      glDepthFunc(GL_LEQUAL);
+      glDepthMask(GL_FALSE);
+      glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_ONE, GL_ONE);
+      glUniform1i(mSplatModeLocation, SPLAT_MODE_ACCUMULATE);
+      drawSplats();
+
+      // Resolve pass (depth tested against the rest of the scene)
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prevFrameBuffer);
+      glViewport(inViewport[0], inViewport[1], inViewport[2], inViewport[3]);
+      glDisable(GL_BLEND);
+      glDepthFunc(depthFunc);
+      glDepthMask(GL_TRUE);
+      useProgram(mResolveShaderProgram);
+      activeTexture(GL_TEXTURE0);
+      bindTexture(GL_TEXTURE_2D, mAccumTexture);
+      activeTexture(GL_TEXTURE1);
+      bindTexture(GL_TEXTURE_2D, mDepthTexture);
+      bindVertexArray(mResolveVertexArrayObject);
+      glDrawArrays(GL_TRIANGLES, 0, 3);
+      bindTexture(GL_TEXTURE_2D, 0);
+      activeTexture(GL_TEXTURE0);
+      bindTexture(GL_TEXTURE_2D, 0);
+
+      glDepthMask(depthMask);
+      glBlendFuncSeparate(blendFunc[0], blendFunc[1], blendFunc[2], blendFunc[3]);
+      if (isBlend)
+        glEnable(GL_BLEND);
+      if (isDepthTest == GL_FALSE)
+        glDisable(GL_DEPTH_TEST);
+    }
+    // -------------------------------------------------------------------------
+    // initFrameBuffer
+    // -------------------------------------------------------------------------
+    // (Re)creates the offscreen framebuffer when the viewport size changes
+    void initFrameBuffer(GLsizei inWidth, GLsizei inHeight)
+    {
+      if (mIsFrameBufferInitialized &&
+          mFrameBufferWidth == inWidth && mFrameBufferHeight == inHeight)
+        return;
+      disposeFrameBuffer();
+      mFrameBufferWidth = inWidth;
+      mFrameBufferHeight = inHeight;
+
+      glGenTextures(1, &mAccumTexture);
+      bindTexture(GL_TEXTURE_2D, mAccumTexture);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, inWidth, inHeight, 0,
+                   GL_RGBA, GL_FLOAT, NULL);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+      glGenTextures(1, &mDepthTexture);
+      bindTexture(GL_TEXTURE_2D, mDepthTexture);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, inWidth, inHeight, 0,
+                   GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      bindTexture(GL_TEXTURE_2D, 0);
+
+      GLint prevFrameBuffer;
+      glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevFrameBuffer);
+      glGenFramebuffers(1, &mFrameBuffer);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mFrameBuffer);
+      glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                             GL_TEXTURE_2D, mAccumTexture, 0);
+      glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                             GL_TEXTURE_2D, mDepthTexture, 0);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prevFrameBuffer);
+      mIsFrameBufferInitialized = true;
+    }
+    // -------------------------------------------------------------------------
+    // disposeFrameBuffer
+    // -------------------------------------------------------------------------
+    void disposeFrameBuffer()
+    {
+      if (mIsFrameBufferInitialized == false)
+        return;
+      glDeleteFramebuffers(1, &mFrameBuffer);
+      deleteTextures(1, &mAccumTexture);
+      deleteTextures(1, &mDepthTexture);
+      mIsFrameBufferInitialized = false;
+    }
+  };
+};};};
+
+#endif  // #ifdef IBC_GL_MODEL_POINT_SPLATS_H_
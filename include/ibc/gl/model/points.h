@@ -23,6 +23,8 @@
 
 // Includes --------------------------------------------------------------------
 #include "ibc/gl/model/model_base.h"
+#include "ibc/gl/dirty_range.h"
+#include "ibc/gl/point_chunks.h"
 #include "ibc/image/color_map.h"
 
 // Namespace -------------------------------------------------------------------
@@ -47,6 +49,8 @@ namespace ibc { namespace gl { namespace model
 
       mDataNum = 0;
       mDataSize = 0;
+
+      mIsFrustumCulling = false;
     }
     // -------------------------------------------------------------------------
     // ~Points
@@ -79,6 +83,36 @@ namespace ibc { namespace gl { namespace model
       mIsDataModified = true;
     }
     // -------------------------------------------------------------------------
+    // markRangeModified
+    // -------------------------------------------------------------------------
+    // Only the points in [inFirst, inFirst + inCount) are uploaded in the next
+    // drawModel() (e.g. a rolling sweep that rewrites one sector per frame)
+    void markRangeModified(size_t inFirst, size_t inCount)
+    {
+      mDirtyRange.add(inFirst, inCount);
+    }
+    // -------------------------------------------------------------------------
+    // setFrustumCulling
+    // -------------------------------------------------------------------------
+    // When enabled, the points are split into chunks of inChunkSize and only
+    // the chunks in the view frustum are drawn (the chunk bounds are
+    // calculated when the data is uploaded). Disabled by default
+    void setFrustumCulling(bool inEnable, size_t inChunkSize = 0)
+    {
+      if (inChunkSize != 0)
+        mChunks.setChunkSize(inChunkSize);
+      if (inEnable && (mIsFrustumCulling == false || inChunkSize != 0))
+        mIsDataModified = true;   // recalculate all the chunk bounds
+      mIsFrustumCulling = inEnable;
+    }
+    // -------------------------------------------------------------------------
+    // isFrustumCulling
+    // -------------------------------------------------------------------------
+    bool isFrustumCulling()
+    {
+      return mIsFrustumCulling;
+    }
+    // -------------------------------------------------------------------------
     // initModel
     // -------------------------------------------------------------------------
     virtual bool initModel()
@@ -88,14 +122,14 @@ namespace ibc { namespace gl { namespace model
 
       // Shader program related initialization
       mShaderProgram = mShaderInterface->getShaderProgram();
-      mModelViewLocation  = glGetUniformLocation(mShaderProgram, "modelview");
-      mProjectionLocation = glGetUniformLocation(mShaderProgram, "projection");
-      mPositionLocation   = glGetAttribLocation (mShaderProgram, "position");
-      mColorLocation      = glGetAttribLocation (mShaderProgram, "color");
+      mModelViewLocation  = mShaderInterface->getUniformLocation("modelview");
+      mProjectionLocation = mShaderInterface->getUniformLocation("projection");
+      mPositionLocation   = mShaderInterface->getAttribLocation("position");
+      mColorLocation      = mShaderInterface->getAttribLocation("color");
 
       // Initialze Vertex Array Object
       glGenVertexArrays(1, &mVertexArrayObject);
-      glBindVertexArray(mVertexArrayObject);
+      bindVertexArray(mVertexArrayObject);
 
       if (mIsDataNumUpdated)
       {
@@ -127,16 +161,22 @@ namespace ibc { namespace gl { namespace model
       }
       else
       {
-        if (mIsDataModified)
+        if (mIsDataModified || mDirtyRange.isEmpty() == false)
           updateVBO();
       }
 
-      glUseProgram(mShaderProgram);
+      useProgram(mShaderProgram);
 
-      glUniformMatrix4fv(mModelViewLocation, 1, GL_FALSE, &(inModelView[0]));
-      glUniformMatrix4fv(mProjectionLocation, 1, GL_FALSE, &(inProjection[0]));
-      glBindVertexArray(mVertexArrayObject);
-      glDrawArrays(GL_POINTS, 0, mDataNum);
+      setMatrixUniforms(mModelViewLocation, mProjectionLocation, inModelView, inProjection);
+      bindVertexArray(mVertexArrayObject);
+      if (mIsFrustumCulling)
+      {
+        if (mChunks.select(inModelView, inProjection, NULL, &mDrawFirsts, &mDrawCounts) != 0)
+          glMultiDrawArrays(GL_POINTS, mDrawFirsts.data(), mDrawCounts.data(),
+                            (GLsizei )mDrawFirsts.size());
+      }
+      else
+        glDrawArrays(GL_POINTS, 0, mDataNum);
     }
 
   protected:
@@ -153,7 +193,12 @@ namespace ibc { namespace gl { namespace model
     // Member variables --------------------------------------------------------
     bool  mIsDataNumUpdated;
     bool  mIsDataModified;
+    ibc::gl::DirtyRange mDirtyRange;
     bool  mIsVBOInitialized;
+    bool  mIsFrustumCulling;
+    ibc::gl::PointChunks  mChunks;
+    std::vector<GLint>    mDrawFirsts;
+    std::vector<GLsizei>  mDrawCounts;
 
     void  *mDataPtr;
     size_t  mDataNum;
@@ -177,12 +222,13 @@ namespace ibc { namespace gl { namespace model
       if (mIsVBOInitialized)
         disposeVBO();
       //
-      glBindVertexArray(mVertexArrayObject);
+      bindVertexArray(mVertexArrayObject);
       glGenBuffers(1, &mVertexBufferObject);
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
       glBufferData(GL_ARRAY_BUFFER, mDataSize, NULL, GL_DYNAMIC_DRAW);
       mIsVBOInitialized = true;
       //
+      mIsDataModified = true;
       updateVBO();
 
       glEnableVertexAttribArray(0);
@@ -202,8 +248,28 @@ namespace ibc { namespace gl { namespace model
     void updateVBO()
     {
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-      glBufferSubData(GL_ARRAY_BUFFER, 0, mDataSize, mDataPtr);
+      size_t  elementSize = sizeof(struct vertex_info);
+      if (mIsDataModified)
+      {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, mDataSize, mDataPtr);
+        if (mIsFrustumCulling)
+          mChunks.update(mDataPtr, elementSize, mDataNum);
+      }
+      else
+      {
+        mDirtyRange.clip(mDataNum);
+        const std::vector<ibc::gl::DirtyRange::Range> &ranges = mDirtyRange.getRanges();
+        for (size_t i = 0; i < ranges.size(); i++)
+        {
+          glBufferSubData(GL_ARRAY_BUFFER, elementSize * ranges[i].first,
+                          elementSize * ranges[i].count,
+                          ((const unsigned char *)mDataPtr) + elementSize * ranges[i].first);
+          if (mIsFrustumCulling)
+            mChunks.updateRange(mDataPtr, elementSize, ranges[i].first, ranges[i].count);
+        }
+      }
       mIsDataModified = false;
+      mDirtyRange.clear();
     }
     // -------------------------------------------------------------------------
     // disposeVBO
@@ -214,7 +280,7 @@ namespace ibc { namespace gl { namespace model
         return;
       //
       glBindBuffer(GL_ARRAY_BUFFER, 0);
-      glBindVertexArray(0);
+      bindVertexArray(0);
       glDeleteBuffers(1, &mVertexBufferObject);
       mIsVBOInitialized = false;
     }
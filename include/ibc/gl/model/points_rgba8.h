@@ -22,9 +22,26 @@
 #define IBC_GL_MODEL_POINTS_RGBA8H_
 
 // Includes --------------------------------------------------------------------
+#include <cstring>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
 #include "ibc/gl/model/model_base.h"
+#include "ibc/gl/dirty_range.h"
+#include "ibc/gl/point_chunks.h"
 #include "ibc/image/color_map.h"
 
+// Macros ----------------------------------------------------------------------
+// The persistent mapped stream buffer needs glBufferStorage (OpenGL 4.4)
+#ifdef QT_VERSION
+ #if LIBIBC_OPENGL_MAJOR_VER > 4 || \
+     (LIBIBC_OPENGL_MAJOR_VER == 4 && LIBIBC_OPENGL_MINOR_VER >= 4)
+  #define IBC_GL_USE_BUFFER_STORAGE
+ #endif
+#elif defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage)
+ #define IBC_GL_USE_BUFFER_STORAGE
+#endif
+
 // Namespace -------------------------------------------------------------------
 //namespace ibc::gl::model // <- nested namespace (C++17)
 namespace ibc { namespace gl { namespace model
@@ -46,6 +63,7 @@ namespace ibc { namespace gl { namespace model
       mIsVBOInitialized = false;
       mIsColorMapIndexModified = false;
 
+      mDataPtr = NULL;
       mDataNum = 0;
       mDataSize = 0;
 
@@ -69,6 +87,27 @@ namespace ibc { namespace gl { namespace model
       mColorMapParam[1] = 0.0;
       mColorMapParam[2] = 1.0;
       mColorMapParam[3] = 0.0;
+
+      mIsFrustumCulling = false;
+
+      mIsStreamMode = false;
+      mIsNextStreamMode = false;
+      mIsStreamModeUpdated = false;
+      mIsStreamInitialized = false;
+      mIsStreamPersistent = false;
+      mStreamMaxDataNum = 0;
+      mNextStreamMaxDataNum = 0;
+      mStreamMappedPtr = NULL;
+      mStreamDataNum = 0;
+      mDrawSegment = -1;
+      mReadySegment = -1;
+      mWritingSegment = -1;
+      for (int i = 0; i < STREAM_SEGMENT_NUM; i++)
+      {
+        mSegmentStates[i] = SEGMENT_FREE;
+        mSegmentDataNums[i] = 0;
+        mSegmentFences[i] = NULL;
+      }
     }
     // -------------------------------------------------------------------------
     // ~PointsRGBA8
@@ -95,6 +134,27 @@ namespace ibc { namespace gl { namespace model
       mIsDataModified = true;
     }
     // -------------------------------------------------------------------------
+    // getDataPtr
+    // -------------------------------------------------------------------------
+    const void *getDataPtr() const
+    {
+      return mDataPtr;
+    }
+    // -------------------------------------------------------------------------
+    // getDataNum
+    // -------------------------------------------------------------------------
+    size_t getDataNum() const
+    {
+      return mDataNum;
+    }
+    // -------------------------------------------------------------------------
+    // getDataStride
+    // -------------------------------------------------------------------------
+    static size_t getDataStride()
+    {
+      return sizeof(vertex_info);
+    }
+    // -------------------------------------------------------------------------
     // markAsDataModified
     // -------------------------------------------------------------------------
     void markAsDataModified()
@@ -102,6 +162,119 @@ namespace ibc { namespace gl { namespace model
       mIsDataModified = true;
     }
     // -------------------------------------------------------------------------
+    // markRangeModified
+    // -------------------------------------------------------------------------
+    // Only the marked points are uploaded in the next drawModel().
+    // (markAsDataModified() still uploads the whole buffer)
+    void markRangeModified(size_t inFirst, size_t inCount)
+    {
+      mDirtyRange.add(inFirst, inCount);
+    }
+    // -------------------------------------------------------------------------
+    // setFrustumCulling
+    // -------------------------------------------------------------------------
+    // Draws only the chunks (inChunkSize points each) whose bounds are in the
+    // view frustum. Not used in the stream mode. Disabled by default
+    void setFrustumCulling(bool inEnable, size_t inChunkSize = 0)
+    {
+      if (inChunkSize != 0)
+        mChunks.setChunkSize(inChunkSize);
+      if (inEnable && (mIsFrustumCulling == false || inChunkSize != 0))
+        mIsDataModified = true;   // recalculate all the chunk bounds
+      mIsFrustumCulling = inEnable;
+    }
+    // -------------------------------------------------------------------------
+    // isFrustumCulling
+    // -------------------------------------------------------------------------
+    bool isFrustumCulling()
+    {
+      return mIsFrustumCulling;
+    }
+    // -------------------------------------------------------------------------
+    // setStreamMode
+    // -------------------------------------------------------------------------
+    // The stream mode is for the live data (e.g. LiDAR) updated every frame.
+    // The points are written to lockStreamBuffer() instead of setDataPtr().
+    // With OpenGL 4.4, the VBO is a persistent mapped buffer which has three
+    // segments guarded by the fence syncs, so the producer thread can write
+    // to the mapped memory directly. Otherwise the data is uploaded to the
+    // orphaned VBO (glBufferData(NULL)) every time a new segment arrives.
+    // (The mode is switched in the next drawModel() call after the locked
+    // segment, if any, is released by unlockStreamBuffer())
+    void setStreamMode(bool inEnable, size_t inMaxDataNum = 0)
+    {
+      std::lock_guard<std::mutex> lock(mStreamMutex);
+      mIsNextStreamMode = inEnable;
+      mNextStreamMaxDataNum = inMaxDataNum;
+      mIsStreamModeUpdated = true;
+    }
+    // -------------------------------------------------------------------------
+    // isStreamMode
+    // -------------------------------------------------------------------------
+    bool isStreamMode()
+    {
+      return mIsStreamMode;
+    }
+    // -------------------------------------------------------------------------
+    // isStreamPersistent
+    // -------------------------------------------------------------------------
+    // Returns true if the persistent mapped buffer is in use
+    bool isStreamPersistent()
+    {
+      return mIsStreamPersistent;
+    }
+    // -------------------------------------------------------------------------
+    // lockStreamBuffer
+    // -------------------------------------------------------------------------
+    // Returns the segment to write the points (vertex_info layout, up to
+    // outMaxDataNum points), or NULL if none of the segments is available yet
+    // (the stream is not initialized, or the GPU is still reading them).
+    // Can be called from any thread. Only one segment can be locked at a time.
+    void *lockStreamBuffer(size_t *outMaxDataNum = NULL)
+    {
+      std::lock_guard<std::mutex> lock(mStreamMutex);
+      if (mIsStreamInitialized == false || mWritingSegment != -1)
+        return NULL;
+      for (int i = 0; i < STREAM_SEGMENT_NUM; i++)
+      {
+        if (mSegmentStates[i] != SEGMENT_FREE)
+          continue;
+        mSegmentStates[i] = SEGMENT_WRITING;
+        mWritingSegment = i;
+        if (outMaxDataNum != NULL)
+          *outMaxDataNum = mStreamMaxDataNum;
+        return getSegmentPtr(i);
+      }
+      return NULL;
+    }
+    // -------------------------------------------------------------------------
+    // unlockStreamBuffer
+    // -------------------------------------------------------------------------
+    // Publishes inDataNum points written to the locked segment.
+    // (inDataNum == 0 : discards the segment)
+    // If the previous segment has not been drawn yet, it is dropped.
+    void unlockStreamBuffer(size_t inDataNum)
+    {
+      std::lock_guard<std::mutex> lock(mStreamMutex);
+      if (mWritingSegment == -1)
+        return;
+      int segment = mWritingSegment;
+      mWritingSegment = -1;
+      mStreamCondition.notify_all();  // disposeStreamVBO() may be waiting
+      if (inDataNum == 0)
+      {
+        mSegmentStates[segment] = SEGMENT_FREE;
+        return;
+      }
+      if (inDataNum > mStreamMaxDataNum)
+        inDataNum = mStreamMaxDataNum;
+      if (mReadySegment != -1)
+        mSegmentStates[mReadySegment] = SEGMENT_FREE;
+      mSegmentStates[segment] = SEGMENT_READY;
+      mSegmentDataNums[segment] = inDataNum;
+      mReadySegment = segment;
+    }
+    // -------------------------------------------------------------------------
     // initModel
     // -------------------------------------------------------------------------
     virtual bool initModel()
@@ -111,25 +284,28 @@ namespace ibc { namespace gl { namespace model
 
       // Shader program related initialization
       mShaderProgram = mShaderInterface->getShaderProgram();
-      mModelFitLocation     = glGetUniformLocation(mShaderProgram, "fit");
-      mModelViewLocation    = glGetUniformLocation(mShaderProgram, "modelview");
-      mProjectionLocation   = glGetUniformLocation(mShaderProgram, "projection");
-      mPositionLocation     = glGetAttribLocation(mShaderProgram, "position");
-      mColorLocation        = glGetAttribLocation(mShaderProgram, "color");
+      mModelFitLocation     = mShaderInterface->getUniformLocation("fit");
+      mModelViewLocation    = mShaderInterface->getUniformLocation("modelview");
+      mProjectionLocation   = mShaderInterface->getUniformLocation("projection");
+      mPositionLocation     = mShaderInterface->getAttribLocation("position");
+      mColorLocation        = mShaderInterface->getAttribLocation("color");
       //
-      mPointSizeLocation    = glGetUniformLocation(mShaderProgram, "pointSize");
-      mColorModeLocation    = glGetUniformLocation(mShaderProgram, "colorMode");
-      mColorMapParamLocation = glGetUniformLocation(mShaderProgram, "colorMapParam");
-      mSingleColorLocation  = glGetUniformLocation(mShaderProgram, "singleColor");
+      mPointSizeLocation    = mShaderInterface->getUniformLocation("pointSize");
+      mColorModeLocation    = mShaderInterface->getUniformLocation("colorMode");
+      mColorMapParamLocation = mShaderInterface->getUniformLocation("colorMapParam");
+      mSingleColorLocation  = mShaderInterface->getUniformLocation("singleColor");
 
       // Initialze Vertex Array Object
       glGenVertexArrays(1, &mVertexArrayObject);
-      glBindVertexArray(mVertexArrayObject);
+      bindVertexArray(mVertexArrayObject);
 
       initTexture();
       updateTexture();
 
-      if (mIsDataNumUpdated)
+      applyStreamMode();
+      if (mIsStreamMode)
+        initStreamVBO();
+      else if (mIsDataNumUpdated)
       {
         initVBO();
         mIsDataNumUpdated = false;
@@ -142,6 +318,7 @@ namespace ibc { namespace gl { namespace model
     // -------------------------------------------------------------------------
     virtual void disposeModel()
     {
+      disposeStreamVBO();
       disposeVBO();
     }
     // -------------------------------------------------------------------------
@@ -149,41 +326,44 @@ namespace ibc { namespace gl { namespace model
     // -------------------------------------------------------------------------
     virtual void drawModel(const GLfloat inModelView[16], const GLfloat inProjection[16])
     {
-      if (mDataNum == 0)
-        return;
+      if (applyStreamMode())
+      {
+        disposeStreamVBO();
+        disposeVBO();
+        mIsDataNumUpdated = true;
+        if (mIsStreamMode)
+          initStreamVBO();
+      }
 
-      if (mIsDataNumUpdated)
+      GLint first = 0;
+      GLsizei num;
+      if (mIsStreamMode)
       {
-        initVBO();
-        mIsDataNumUpdated = false;
+        if (updateStreamVBO(&first) == false)
+          return;
+        num = (GLsizei )mStreamDataNum;
       }
       else
       {
-        if (mIsDataModified)
-          updateVBO();
+        if (mDataNum == 0)
+          return;
+        updateDataVBO();
+        num = (GLsizei )mDataNum;
       }
 
-      if (mIsColorMapIndexModified)
-        updateTexture();
-
-      glUseProgram(mShaderProgram);
-      glUniformMatrix4fv(mModelViewLocation, 1, GL_FALSE, &(inModelView[0]));
-      glUniformMatrix4fv(mProjectionLocation, 1, GL_FALSE, &(inProjection[0]));
-
-      glUniform4fv(mModelFitLocation, 1, mModelFitParam);
-      glUniform1f(mPointSizeLocation, mPointSize);
-      glUniform1i(mColorModeLocation, mColorMode);
-      glUniform4fv(mColorMapParamLocation, 1, mColorMapParam);
-      glUniform4fv(mSingleColorLocation, 1, mSingleColor);
-
-      glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_1D, mColorMapTexture);
-
-      glBindVertexArray(mVertexArrayObject);
-      glDrawArrays(GL_POINTS, 0, (GLsizei )mDataNum);
-
-      glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_1D, 0);
+      beginDraw(inModelView, inProjection);
+      if (mIsStreamMode == false && mIsFrustumCulling)
+      {
+        if (mChunks.select(inModelView, inProjection, mModelFitParam,
+                           &mDrawFirsts, &mDrawCounts) != 0)
+          glMultiDrawArrays(GL_POINTS, mDrawFirsts.data(), mDrawCounts.data(),
+                            (GLsizei )mDrawFirsts.size());
+      }
+      else
+        glDrawArrays(GL_POINTS, first, num);
+      if (mIsStreamPersistent)
+        fenceStreamSegment();
+      endDraw();
     }
     // -------------------------------------------------------------------------
     // getModelFitParam
@@ -351,10 +531,28 @@ namespace ibc { namespace gl { namespace model
       GLubyte color[4];
     };
 
+    // Constants ---------------------------------------------------------------
+    static const int  STREAM_SEGMENT_NUM  = 3;
+
+    // Typedefs ----------------------------------------------------------------
+    enum SegmentState
+    {
+      SEGMENT_FREE  = 0,
+      SEGMENT_WRITING,    // locked by the producer
+      SEGMENT_READY,      // written, but not drawn yet
+      SEGMENT_DRAWING,    // the current segment
+      SEGMENT_RETIRED     // waiting for the fence (persistent mode only)
+    };
+
     // Member variables --------------------------------------------------------
     bool  mIsDataNumUpdated;
     bool  mIsDataModified;
+    ibc::gl::DirtyRange mDirtyRange;
     bool  mIsVBOInitialized;
+    bool  mIsFrustumCulling;
+    ibc::gl::PointChunks  mChunks;
+    std::vector<GLint>    mDrawFirsts;
+    std::vector<GLsizei>  mDrawCounts;
     bool  mIsColorMapIndexModified;
 
     void  *mDataPtr;
@@ -388,17 +586,69 @@ namespace ibc { namespace gl { namespace model
 
     GLint mPointSizeLocation;
 
+    std::mutex  mStreamMutex;
+    std::condition_variable mStreamCondition;
+    bool  mIsStreamMode;
+    bool  mIsNextStreamMode;      // set by setStreamMode()
+    bool  mIsStreamModeUpdated;
+    bool  mIsStreamInitialized;
+    bool  mIsStreamPersistent;
+    size_t  mStreamMaxDataNum;
+    size_t  mNextStreamMaxDataNum;  // set by setStreamMode()
+    void  *mStreamMappedPtr;
+    std::vector<unsigned char>  mStreamHostBuffer;  // for the orphaning mode
+    size_t  mStreamDataNum;
+    int   mDrawSegment;
+    int   mReadySegment;
+    int   mWritingSegment;
+    SegmentState  mSegmentStates[STREAM_SEGMENT_NUM];
+    size_t  mSegmentDataNums[STREAM_SEGMENT_NUM];
+    GLsync  mSegmentFences[STREAM_SEGMENT_NUM];
+
     // Member functions --------------------------------------------------------
     // -------------------------------------------------------------------------
+    // beginDraw
+    // -------------------------------------------------------------------------
+    // Binds the program, the uniforms, the color map and the VAO
+    // (shared with the derived models which issue their own draw calls)
+    void beginDraw(const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      if (mIsColorMapIndexModified)
+        updateTexture();
+
+      useProgram(mShaderProgram);
+      setMatrixUniforms(mModelViewLocation, mProjectionLocation, inModelView, inProjection);
+
+      glUniform4fv(mModelFitLocation, 1, mModelFitParam);
+      glUniform1f(mPointSizeLocation, mPointSize);
+      glUniform1i(mColorModeLocation, mColorMode);
+      glUniform4fv(mColorMapParamLocation, 1, mColorMapParam);
+      glUniform4fv(mSingleColorLocation, 1, mSingleColor);
+
+      activeTexture(GL_TEXTURE0);
+      bindTexture(GL_TEXTURE_1D, mColorMapTexture);
+
+      bindVertexArray(mVertexArrayObject);
+    }
+    // -------------------------------------------------------------------------
+    // endDraw
+    // -------------------------------------------------------------------------
+    void endDraw()
+    {
+      activeTexture(GL_TEXTURE0);
+      bindTexture(GL_TEXTURE_1D, 0);
+    }
+    // -------------------------------------------------------------------------
     // initTexture
     // -------------------------------------------------------------------------
     void initTexture()
     {
-      glActiveTexture(GL_TEXTURE0);
-      glEnable(GL_TEXTURE_1D);
+      activeTexture(GL_TEXTURE0);
+      if (StateTracker::isCoreProfile() == false)
+        glEnable(GL_TEXTURE_1D);
       glGenTextures(1, &mColorMapTexture);
 
-      glBindTexture(GL_TEXTURE_1D, mColorMapTexture);
+      bindTexture(GL_TEXTURE_1D, mColorMapTexture);
       glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, (GLsizei )mColorMapSize, 0,
                   GL_RGB, GL_UNSIGNED_BYTE, NULL);
       glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -406,10 +656,10 @@ namespace ibc { namespace gl { namespace model
       glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
       glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-      GLint location = glGetUniformLocation(mShaderProgram, "colorMapTexure");
-      glUseProgram(mShaderProgram);
+      GLint location = mShaderInterface->getUniformLocation("colorMapTexure");
+      useProgram(mShaderProgram);
       glUniform1i(location, 0); // since we are using GL_TEXTURE0
-      glBindTexture(GL_TEXTURE_1D, 0);
+      bindTexture(GL_TEXTURE_1D, 0);
     }
     // -------------------------------------------------------------------------
     // updateTexture
@@ -421,10 +671,10 @@ namespace ibc { namespace gl { namespace model
       ibc::image::ColorMap::getColorMap(mColorMapIndex, (GLsizei )mColorMapSize, colorMap,
                               mColorMapRepeatNum, 1.0, 0);
 
-      glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_1D, mColorMapTexture);
+      activeTexture(GL_TEXTURE0);
+      bindTexture(GL_TEXTURE_1D, mColorMapTexture);
       glTexSubImage1D(GL_TEXTURE_1D, 0, 0, (GLsizei )mColorMapSize, GL_RGB, GL_UNSIGNED_BYTE, colorMap);
-      glBindTexture(GL_TEXTURE_1D, 0);
+      bindTexture(GL_TEXTURE_1D, 0);
       delete colorMap;
       mIsColorMapIndexModified = false;
     }
@@ -442,14 +692,21 @@ namespace ibc { namespace gl { namespace model
       if (mIsVBOInitialized)
         disposeVBO();
       //
-      glBindVertexArray(mVertexArrayObject);
+      bindVertexArray(mVertexArrayObject);
       glGenBuffers(1, &mVertexBufferObject);
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
       glBufferData(GL_ARRAY_BUFFER, mDataSize, NULL, GL_DYNAMIC_DRAW);
       mIsVBOInitialized = true;
       //
+      mIsDataModified = true;
       updateVBO();
-
+      initVertexAttributes();
+    }
+    // -------------------------------------------------------------------------
+    // initVertexAttributes
+    // -------------------------------------------------------------------------
+    void initVertexAttributes()
+    {
       glEnableVertexAttribArray(0);
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
       glEnableVertexAttribArray(mPositionLocation);
@@ -467,8 +724,45 @@ namespace ibc { namespace gl { namespace model
     void updateVBO()
     {
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-      glBufferSubData(GL_ARRAY_BUFFER, 0, mDataSize, mDataPtr);
+      size_t  elementSize = sizeof(struct vertex_info);
+      if (mIsDataModified)
+      {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, mDataSize, mDataPtr);
+        if (mIsFrustumCulling)
+          mChunks.update(mDataPtr, elementSize, mDataNum);
+      }
+      else
+      {
+        mDirtyRange.clip(mDataNum);
+        const std::vector<ibc::gl::DirtyRange::Range> &ranges = mDirtyRange.getRanges();
+        for (size_t i = 0; i < ranges.size(); i++)
+        {
+          glBufferSubData(GL_ARRAY_BUFFER, elementSize * ranges[i].first,
+                          elementSize * ranges[i].count,
+                          ((const unsigned char *)mDataPtr) + elementSize * ranges[i].first);
+          if (mIsFrustumCulling)
+            mChunks.updateRange(mDataPtr, elementSize, ranges[i].first, ranges[i].count);
+        }
+      }
       mIsDataModified = false;
+      mDirtyRange.clear();
+    }
+    // -------------------------------------------------------------------------
+    // updateDataVBO
+    // -------------------------------------------------------------------------
+    // (Re)allocates or updates the VBO from setDataPtr() data if needed
+    void updateDataVBO()
+    {
+      if (mIsDataNumUpdated)
+      {
+        initVBO();
+        mIsDataNumUpdated = false;
+      }
+      else
+      {
+        if (mIsDataModified || mDirtyRange.isEmpty() == false)
+          updateVBO();
+      }
     }
     // -------------------------------------------------------------------------
     // disposeVBO
@@ -479,10 +773,207 @@ namespace ibc { namespace gl { namespace model
         return;
       //
       glBindBuffer(GL_ARRAY_BUFFER, 0);
-      glBindVertexArray(0);
+      bindVertexArray(0);
       glDeleteBuffers(1, &mVertexBufferObject);
       mIsVBOInitialized = false;
     }
+    // -------------------------------------------------------------------------
+    // applyStreamMode
+    // -------------------------------------------------------------------------
+    // Takes the mode given by setStreamMode(). Returns false if it is not
+    // updated, or if the producer still holds a segment (retried next frame)
+    bool applyStreamMode()
+    {
+      std::lock_guard<std::mutex> lock(mStreamMutex);
+      if (mIsStreamModeUpdated == false || mWritingSegment != -1)
+        return false;
+      mIsStreamMode = mIsNextStreamMode;
+      mStreamMaxDataNum = mNextStreamMaxDataNum;
+      mIsStreamModeUpdated = false;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // initStreamVBO
+    // -------------------------------------------------------------------------
+    void initStreamVBO()
+    {
+      disposeStreamVBO();
+      disposeVBO();
+      if (mStreamMaxDataNum == 0)
+        return;
+      size_t  segmentSize = sizeof(struct vertex_info) * mStreamMaxDataNum;
+      //
+      bindVertexArray(mVertexArrayObject);
+      glGenBuffers(1, &mVertexBufferObject);
+      glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+#ifdef IBC_GL_USE_BUFFER_STORAGE
+      if (isBufferStorageSupported())
+      {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, segmentSize * STREAM_SEGMENT_NUM, NULL, flags);
+        mStreamMappedPtr = glMapBufferRange(GL_ARRAY_BUFFER, 0,
+                                            segmentSize * STREAM_SEGMENT_NUM, flags);
+        if (mStreamMappedPtr != NULL)
+          mIsStreamPersistent = true;
+        else
+        {
+          // The immutable storage can't be reallocated, so start over
+          glDeleteBuffers(1, &mVertexBufferObject);
+          glGenBuffers(1, &mVertexBufferObject);
+          glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+        }
+      }
+#endif
+      if (mIsStreamPersistent == false)
+      {
+        glBufferData(GL_ARRAY_BUFFER, segmentSize, NULL, GL_STREAM_DRAW);
+        mStreamHostBuffer.resize(segmentSize * STREAM_SEGMENT_NUM);
+      }
+      mIsVBOInitialized = true;
+      initVertexAttributes();
+      //
+      std::lock_guard<std::mutex> lock(mStreamMutex);
+      for (int i = 0; i < STREAM_SEGMENT_NUM; i++)
+      {
+        mSegmentStates[i] = SEGMENT_FREE;
+        mSegmentDataNums[i] = 0;
+      }
+      mDrawSegment = -1;
+      mReadySegment = -1;
+      mWritingSegment = -1;
+      mStreamDataNum = 0;
+      mIsStreamInitialized = true;
+    }
+    // -------------------------------------------------------------------------
+    // updateStreamVBO
+    // -------------------------------------------------------------------------
+    // Switches to the latest segment and returns the first index to draw.
+    // Returns false if there is nothing to draw.
+    bool updateStreamVBO(GLint *outFirst)
+    {
+      if (mIsStreamInitialized == false)
+        return false;
+      std::lock_guard<std::mutex> lock(mStreamMutex);
+      // Release the segments the GPU has finished with
+      for (int i = 0; i < STREAM_SEGMENT_NUM; i++)
+      {
+        if (mSegmentStates[i] != SEGMENT_RETIRED)
+          continue;
+        if (mSegmentFences[i] != NULL)
+        {
+          GLenum result = glClientWaitSync(mSegmentFences[i], 0, 0);
+          if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+            continue;
+          glDeleteSync(mSegmentFences[i]);
+          mSegmentFences[i] = NULL;
+        }
+        mSegmentStates[i] = SEGMENT_FREE;
+      }
+      //
+      if (mReadySegment != -1)
+      {
+        if (mDrawSegment != -1)
+          mSegmentStates[mDrawSegment] = mIsStreamPersistent ? SEGMENT_RETIRED : SEGMENT_FREE;
+        mDrawSegment = mReadySegment;
+        mReadySegment = -1;
+        mSegmentStates[mDrawSegment] = SEGMENT_DRAWING;
+        mStreamDataNum = mSegmentDataNums[mDrawSegment];
+        if (mIsStreamPersistent == false)
+        {
+          // Orphan the storage, so that the driver doesn't wait for the last draw
+          size_t  segmentSize = sizeof(struct vertex_info) * mStreamMaxDataNum;
+          glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+          glBufferData(GL_ARRAY_BUFFER, segmentSize, NULL, GL_STREAM_DRAW);
+          glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(struct vertex_info) * mStreamDataNum,
+                          getSegmentPtr(mDrawSegment));
+        }
+      }
+      if (mDrawSegment == -1 || mStreamDataNum == 0)
+        return false;
+      if (mIsStreamPersistent)
+        *outFirst = (GLint )(mStreamMaxDataNum * mDrawSegment);
+      else
+        *outFirst = 0;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // fenceStreamSegment
+    // -------------------------------------------------------------------------
+    // Called after each draw. The segment is reused only after this fence.
+    void fenceStreamSegment()
+    {
+      std::lock_guard<std::mutex> lock(mStreamMutex);
+      if (mDrawSegment == -1)
+        return;
+      if (mSegmentFences[mDrawSegment] != NULL)
+        glDeleteSync(mSegmentFences[mDrawSegment]);
+      mSegmentFences[mDrawSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    // -------------------------------------------------------------------------
+    // disposeStreamVBO
+    // -------------------------------------------------------------------------
+    // Blocks until the locked segment (if any) is released, since the
+    // producer may still be writing to the mapped memory
+    void disposeStreamVBO()
+    {
+      std::unique_lock<std::mutex> lock(mStreamMutex);
+      if (mIsStreamInitialized == false)
+        return;
+      mIsStreamInitialized = false;   // lockStreamBuffer() fails from here
+      mStreamCondition.wait(lock, [this] { return mWritingSegment == -1; });
+      for (int i = 0; i < STREAM_SEGMENT_NUM; i++)
+      {
+        if (mSegmentFences[i] != NULL)
+          glDeleteSync(mSegmentFences[i]);
+        mSegmentFences[i] = NULL;
+      }
+      if (mIsStreamPersistent)
+      {
+        glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+      }
+      mStreamMappedPtr = NULL;
+      mStreamHostBuffer.clear();
+      mStreamHostBuffer.shrink_to_fit();
+      mIsStreamPersistent = false;
+      //
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      bindVertexArray(0);
+      glDeleteBuffers(1, &mVertexBufferObject);
+      mIsVBOInitialized = false;
+    }
+    // -------------------------------------------------------------------------
+    // getSegmentPtr
+    // -------------------------------------------------------------------------
+    void *getSegmentPtr(int inSegment)
+    {
+      size_t  offset = sizeof(struct vertex_info) * mStreamMaxDataNum * inSegment;
+      if (mIsStreamPersistent)
+        return ((unsigned char *)mStreamMappedPtr) + offset;
+      return &(mStreamHostBuffer[offset]);
+    }
+#ifdef IBC_GL_USE_BUFFER_STORAGE
+    // -------------------------------------------------------------------------
+    // isBufferStorageSupported
+    // -------------------------------------------------------------------------
+    bool isBufferStorageSupported()
+    {
+      GLint major = 0, minor = 0;
+      glGetIntegerv(GL_MAJOR_VERSION, &major);
+      glGetIntegerv(GL_MINOR_VERSION, &minor);
+      if (major > 4 || (major == 4 && minor >= 4))
+        return true;
+      GLint num = 0;
+      glGetIntegerv(GL_NUM_EXTENSIONS, &num);
+      for (GLint i = 0; i < num; i++)
+      {
+        const char *str = (const char *)glGetStringi(GL_EXTENSIONS, i);
+        if (str != NULL && strcmp(str, "GL_ARB_buffer_storage") == 0)
+          return true;
+      }
+      return false;
+    }
+#endif
   };
 };};};
 
@@ -0,0 +1,548 @@
+// =============================================================================
+//  quantized_points.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/model/quantized_points.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the Points model (quantized version)
+*/
+
+#ifndef IBC_GL_MODEL_QUANTIZED_POINTS_H_
+#define IBC_GL_MODEL_QUANTIZED_POINTS_H_
+
+// Includes --------------------------------------------------------------------
+#include <vector>
+#include "ibc/gl/model/model_base.h"
+#include "ibc/gl/data.h"
+#include "ibc/gl/dirty_range.h"
+#include "ibc/image/color_map.h"
+
+// Namespace -------------------------------------------------------------------
+//namespace ibc::gl::model // <- nested namespace (C++17)
+namespace ibc { namespace gl { namespace model
+{
+  // ---------------------------------------------------------------------------
+  // QuantizedPoints
+  // ---------------------------------------------------------------------------
+  // Draws glXYZs_NORMoct_RGBAub points (12 bytes / point) with
+  // ibc::gl::shader::PointCloudQuantized. The data can be made with
+  // ibc::gl::Quantizer. Each chunk is drawn with its own origin and scale.
+  class QuantizedPoints : public virtual ibc::gl::model::ModelBase
+  {
+  public:
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // QuantizedPoints
+    // -------------------------------------------------------------------------
+    QuantizedPoints()
+    {
+      mIsDataNumUpdated = false;
+      mIsDataModified   = false;
+      mIsVBOInitialized = false;
+      mIsColorMapIndexModified = false;
+
+      mDataPtr = NULL;
+      mDataNum = 0;
+      mDataSize = 0;
+
+      mPointSize = 5.0;
+      mColorMode = 2;
+      mShadingMode = 0;
+      mSingleColor[0] = 1.0;
+      mSingleColor[1] = 1.0;
+      mSingleColor[2] = 1.0;
+      mSingleColor[3] = 1.0;
+
+      mColorMapIndex = ibc::image::ColorMap::CMIndex_SpectrumWide;
+      mColorMapRepeatNum = 1;
+      mColorMapSize = 1024; // =2^10
+
+      mModelFitParam[0] = 0.0;
+      mModelFitParam[1] = 0.0;
+      mModelFitParam[2] = 0.0;
+      mModelFitParam[3] = 1.0;
+
+      mColorMapParam[0] = 2.0;
+      mColorMapParam[1] = 0.0;
+      mColorMapParam[2] = 1.0;
+      mColorMapParam[3] = 0.0;
+    }
+    // -------------------------------------------------------------------------
+    // ~QuantizedPoints
+    // -------------------------------------------------------------------------
+    virtual ~QuantizedPoints()
+    {
+    }
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setDataPtr
+    // -------------------------------------------------------------------------
+    // The chunks should cover [0, inDataNum) (the points out of the chunks
+    // are not drawn). The chunk list is copied, but the data is not.
+    void setDataPtr(const ibc::gl::glXYZs_NORMoct_RGBAub *inDataPtr, size_t inDataNum,
+                    const ibc::gl::glQuantizedChunk *inChunks, size_t inChunkNum)
+    {
+      if (mDataNum != inDataNum)
+        mIsDataNumUpdated = true;
+
+      mDataPtr  = inDataPtr;
+      mDataNum  = inDataNum;
+      mDataSize = sizeof(ibc::gl::glXYZs_NORMoct_RGBAub) * mDataNum;
+      mChunks.assign(inChunks, inChunks + inChunkNum);
+      mIsDataModified = true;
+    }
+    // -------------------------------------------------------------------------
+    // markAsDataModified
+    // -------------------------------------------------------------------------
+    void markAsDataModified()
+    {
+      mIsDataModified = true;
+    }
+    // -------------------------------------------------------------------------
+    // markRangeModified
+    // -------------------------------------------------------------------------
+    void markRangeModified(size_t inFirst, size_t inCount)
+    {
+      mDirtyRange.add(inFirst, inCount);
+    }
+    // -------------------------------------------------------------------------
+    // initModel
+    // -------------------------------------------------------------------------
+    virtual bool initModel()
+    {
+      if (ModelBase::initModel() == false)
+        return false;
+
+      // Shader program related initialization
+      mShaderProgram = mShaderInterface->getShaderProgram();
+      mChunkLocation        = mShaderInterface->getUniformLocation("chunk");
+      mModelFitLocation     = mShaderInterface->getUniformLocation("fit");
+      mModelViewLocation    = mShaderInterface->getUniformLocation("modelview");
+      mProjectionLocation   = mShaderInterface->getUniformLocation("projection");
+      mPositionLocation     = mShaderInterface->getAttribLocation("position");
+      mNormalLocation       = mShaderInterface->getAttribLocation("normal");
+      mColorLocation        = mShaderInterface->getAttribLocation("color");
+      //
+      mPointSizeLocation    = mShaderInterface->getUniformLocation("pointSize");
+      mColorModeLocation    = mShaderInterface->getUniformLocation("colorMode");
+      mShadingModeLocation  = mShaderInterface->getUniformLocation("shadingMode");
+      mColorMapParamLocation = mShaderInterface->getUniformLocation("colorMapParam");
+      mSingleColorLocation  = mShaderInterface->getUniformLocation("singleColor");
+
+      // Initialze Vertex Array Object
+      glGenVertexArrays(1, &mVertexArrayObject);
+      bindVertexArray(mVertexArrayObject);
+
+      initTexture();
+      updateTexture();
+
+      if (mIsDataNumUpdated)
+      {
+        initVBO();
+        mIsDataNumUpdated = false;
+      }
+
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // disposeModel
+    // -------------------------------------------------------------------------
+    virtual void disposeModel()
+    {
+      disposeVBO();
+      disposeTexture();
+    }
+    // -------------------------------------------------------------------------
+    // drawModel
+    // -------------------------------------------------------------------------
+    virtual void drawModel(const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      if (mDataNum == 0)
+        return;
+
+      if (mIsDataNumUpdated)
+      {
+        initVBO();
+        mIsDataNumUpdated = false;
+      }
+      else
+      {
+        if (mIsDataModified || mDirtyRange.isEmpty() == false)
+          updateVBO();
+      }
+
+      if (mIsColorMapIndexModified)
+        updateTexture();
+
+      useProgram(mShaderProgram);
+      setMatrixUniforms(mModelViewLocation, mProjectionLocation, inModelView, inProjection);
+
+      glUniform4fv(mModelFitLocation, 1, mModelFitParam);
+      glUniform1f(mPointSizeLocation, mPointSize);
+      glUniform1i(mColorModeLocation, mColorMode);
+      glUniform1i(mShadingModeLocation, mShadingMode);
+      glUniform4fv(mColorMapParamLocation, 1, mColorMapParam);
+      glUniform4fv(mSingleColorLocation, 1, mSingleColor);
+
+      activeTexture(GL_TEXTURE0);
+      bindTexture(GL_TEXTURE_1D, mColorMapTexture);
+
+      bindVertexArray(mVertexArrayObject);
+      for (size_t i = 0; i < mChunks.size(); i++)
+      {
+        const ibc::gl::glQuantizedChunk &chunk = mChunks[i];
+        if (chunk.first >= mDataNum || chunk.count == 0)
+          continue;
+        size_t  count = chunk.count;
+        if (chunk.first + count > mDataNum)
+          count = mDataNum - chunk.first;
+        glUniform4f(mChunkLocation, chunk.origin[0], chunk.origin[1], chunk.origin[2],
+                    chunk.scale);
+        glDrawArrays(GL_POINTS, (GLint )chunk.first, (GLsizei )count);
+      }
+
+      activeTexture(GL_TEXTURE0);
+      bindTexture(GL_TEXTURE_1D, 0);
+    }
+    // -------------------------------------------------------------------------
+    // getShadingMode
+    // -------------------------------------------------------------------------
+    // Mode = 0 : no shading
+    // Mode = 1 : shaded with the normals (lambert)
+    //
+    int getShadingMode()
+    {
+      return mShadingMode;
+    }
+    // -------------------------------------------------------------------------
+    // setShadingMode
+    // -------------------------------------------------------------------------
+    void setShadingMode(int inMode)
+    {
+      mShadingMode = (inMode == 1) ? 1 : 0;
+    }
+    // -------------------------------------------------------------------------
+    // getModelFitParam
+    // -------------------------------------------------------------------------
+    const float *getModelFitParam()
+    {
+      return mModelFitParam;
+    }
+    // -------------------------------------------------------------------------
+    // setModelFitParam
+    // -------------------------------------------------------------------------
+    void setModelFitParam(const GLfloat inParm[4])
+    {
+      for (int i = 0; i < 4; i++)
+        mModelFitParam[i] = inParm[i];
+    }
+    // -------------------------------------------------------------------------
+    // getColorMapAxis
+    // -------------------------------------------------------------------------
+    int getColorMapAxis()
+    {
+      return mColorMapParam[0];
+    }
+    // -------------------------------------------------------------------------
+    // setColorMapAxis
+    // -------------------------------------------------------------------------
+    void setColorMapAxis(int inMapAxis)
+    {
+      mColorMapParam[0] = inMapAxis;
+    }
+    // -------------------------------------------------------------------------
+    // getColorMapOffset
+    // -------------------------------------------------------------------------
+    float getColorMapOffset()
+    {
+      return mColorMapParam[1];
+    }
+    // -------------------------------------------------------------------------
+    // setColorMapOffset
+    // -------------------------------------------------------------------------
+    void setColorMapOffset(float inOffset)
+    {
+      mColorMapParam[1] = inOffset;
+    }
+    // -------------------------------------------------------------------------
+    // getColorMapGain
+    // -------------------------------------------------------------------------
+    float getColorMapGain()
+    {
+      return mColorMapParam[2];
+    }
+    // -------------------------------------------------------------------------
+    // setColorMapGain
+    // -------------------------------------------------------------------------
+    void setColorMapGain(float inGain)
+    {
+      mColorMapParam[2] = inGain;
+    }
+    // -------------------------------------------------------------------------
+    // getColorMapUnmapMode
+    // -------------------------------------------------------------------------
+    // Mode = 0 : display nothing when the colormap is out of range (un-mapped)
+    // Mode = 1 : display using single color when the colormap is out of range
+    //
+    int getColorMapUnmapMode()
+    {
+      return mColorMapParam[3];
+    }
+    // -------------------------------------------------------------------------
+    // setColorMapUnmapMode
+    // -------------------------------------------------------------------------
+    void setColorMapUnmapMode(int inMode)
+    {
+      mColorMapParam[3] = inMode;
+    }
+    // -------------------------------------------------------------------------
+    // getPointSize
+    // -------------------------------------------------------------------------
+    float getPointSize()
+    {
+      return mPointSize;
+    }
+    // -------------------------------------------------------------------------
+    // setPointSize
+    // -------------------------------------------------------------------------
+    void setPointSize(float inSize)
+    {
+      mPointSize = inSize;
+    }
+    // -------------------------------------------------------------------------
+    // getColorMode
+    // -------------------------------------------------------------------------
+    float getColorMode()
+    {
+      return mColorMode;
+    }
+    // -------------------------------------------------------------------------
+    // setColorMode
+    // -------------------------------------------------------------------------
+    void setColorMode(int inMode)
+    {
+      if (inMode < 0)
+        inMode = 0;
+      if (inMode > 2)
+        inMode = 2;
+      mColorMode = inMode;
+    }
+    // -------------------------------------------------------------------------
+    // getSingleColor
+    // -------------------------------------------------------------------------
+    const float *getSingleColor()
+    {
+      return mSingleColor;
+    }
+    // -------------------------------------------------------------------------
+    // setSingleColor
+    // -------------------------------------------------------------------------
+    void setSingleColor(const float inColor[])
+    {
+      mSingleColor[0] = inColor[0];
+      mSingleColor[1] = inColor[1];
+      mSingleColor[2] = inColor[2];
+      mSingleColor[3] = inColor[3];
+    }
+    // -------------------------------------------------------------------------
+    // getColorMapIndex
+    // -------------------------------------------------------------------------
+    ibc::image::ColorMap::ColorMapIndex getColorMapIndex()
+    {
+      return mColorMapIndex;
+    }
+    // -------------------------------------------------------------------------
+    // setColorMapIndex
+    // -------------------------------------------------------------------------
+    void setColorMapIndex(ibc::image::ColorMap::ColorMapIndex inIndex)
+    {
+      mColorMapIndex = inIndex;
+      mIsColorMapIndexModified = true;
+    }
+    // -------------------------------------------------------------------------
+    // getColorMapRepeatNum
+    // -------------------------------------------------------------------------
+    int getColorMapRepeatNum()
+    {
+      return mColorMapRepeatNum;
+    }
+    // -------------------------------------------------------------------------
+    // setColorMapRepeatNum
+    // -------------------------------------------------------------------------
+    void setColorMapRepeatNum(int inNum)
+    {
+      mColorMapRepeatNum = inNum;
+      mIsColorMapIndexModified = true;
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    bool  mIsDataNumUpdated;
+    bool  mIsDataModified;
+    ibc::gl::DirtyRange mDirtyRange;
+    bool  mIsVBOInitialized;
+    bool  mIsColorMapIndexModified;
+
+    const ibc::gl::glXYZs_NORMoct_RGBAub  *mDataPtr;
+    size_t  mDataNum;
+    size_t  mDataSize;
+    std::vector<ibc::gl::glQuantizedChunk>  mChunks;
+
+    float mPointSize;
+    GLint  mColorMode;
+    GLint  mShadingMode;
+    GLfloat mSingleColor[4];
+
+    ibc::image::ColorMap::ColorMapIndex mColorMapIndex;
+    int   mColorMapRepeatNum;
+    size_t  mColorMapSize;
+    GLuint  mColorMapTexture;
+
+    GLfloat mModelFitParam[4];
+    GLfloat mColorMapParam[4];
+
+    GLuint mShaderProgram;
+    GLuint mVertexArrayObject;
+    GLuint mVertexBufferObject;
+
+    GLint mChunkLocation;
+    GLint mModelFitLocation;
+    GLint mModelViewLocation;
+    GLint mProjectionLocation;
+    GLint mPositionLocation;
+    GLint mNormalLocation;
+    GLint mColorLocation;
+    GLint mColorModeLocation;
+    GLint mShadingModeLocation;
+    GLint mColorMapParamLocation;
+    GLint mSingleColorLocation;
+
+    GLint mPointSizeLocation;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // initTexture
+    // -------------------------------------------------------------------------
+    void initTexture()
+    {
+      activeTexture(GL_TEXTURE0);
+      glGenTextures(1, &mColorMapTexture);
+
+      bindTexture(GL_TEXTURE_1D, mColorMapTexture);
+      glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, (GLsizei )mColorMapSize, 0,
+                  GL_RGB, GL_UNSIGNED_BYTE, NULL);
+      glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+      GLint location = mShaderInterface->getUniformLocation("colorMapTexture");
+      useProgram(mShaderProgram);
+      glUniform1i(location, 0); // since we are using GL_TEXTURE0
+      bindTexture(GL_TEXTURE_1D, 0);
+    }
+    // -------------------------------------------------------------------------
+    // updateTexture
+    // -------------------------------------------------------------------------
+    void updateTexture()
+    {
+      unsigned char *colorMap = new unsigned char[mColorMapSize * 3];
+      //getMonoMap <- gamma
+      ibc::image::ColorMap::getColorMap(mColorMapIndex, (GLsizei )mColorMapSize, colorMap,
+                              mColorMapRepeatNum, 1.0, 0);
+
+      activeTexture(GL_TEXTURE0);
+      bindTexture(GL_TEXTURE_1D, mColorMapTexture);
+      glTexSubImage1D(GL_TEXTURE_1D, 0, 0, (GLsizei )mColorMapSize, GL_RGB, GL_UNSIGNED_BYTE, colorMap);
+      bindTexture(GL_TEXTURE_1D, 0);
+      delete[] colorMap;
+      mIsColorMapIndexModified = false;
+    }
+    // -------------------------------------------------------------------------
+    // disposeTexture
+    // -------------------------------------------------------------------------
+    void disposeTexture()
+    {
+      deleteTextures(1, &mColorMapTexture);
+    }
+    // -------------------------------------------------------------------------
+    // initVBO
+    // -------------------------------------------------------------------------
+    void initVBO()
+    {
+      if (mIsVBOInitialized)
+        disposeVBO();
+      //
+      bindVertexArray(mVertexArrayObject);
+      glGenBuffers(1, &mVertexBufferObject);
+      glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+      glBufferData(GL_ARRAY_BUFFER, mDataSize, NULL, GL_DYNAMIC_DRAW);
+      mIsVBOInitialized = true;
+      //
+      mIsDataModified = true;
+      updateVBO();
+
+      // The positions are passed as is (not normalized) and decoded
+      // in the shader with the chunk origin and scale
+      GLsizei stride = sizeof(ibc::gl::glXYZs_NORMoct_RGBAub);
+      glEnableVertexAttribArray(mPositionLocation);
+      glVertexAttribPointer(mPositionLocation, 3, GL_SHORT, GL_FALSE, stride,
+                  (const GLvoid *)offsetof(ibc::gl::glXYZs_NORMoct_RGBAub, x));
+      if (mNormalLocation >= 0)
+      {
+        glEnableVertexAttribArray(mNormalLocation);
+        glVertexAttribPointer(mNormalLocation, 2, GL_UNSIGNED_BYTE, GL_FALSE, stride,
+                  (const GLvoid *)offsetof(ibc::gl::glXYZs_NORMoct_RGBAub, nx));
+      }
+      glEnableVertexAttribArray(mColorLocation);
+      glVertexAttribPointer(mColorLocation, 4, GL_UNSIGNED_BYTE, GL_FALSE, stride,
+                  (const GLvoid *)offsetof(ibc::gl::glXYZs_NORMoct_RGBAub, r));
+    }
+    // -------------------------------------------------------------------------
+    // updateVBO
+    // -------------------------------------------------------------------------
+    void updateVBO()
+    {
+      glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+      if (mIsDataModified)
+        glBufferSubData(GL_ARRAY_BUFFER, 0, mDataSize, mDataPtr);
+      else
+      {
+        size_t  elementSize = sizeof(ibc::gl::glXYZs_NORMoct_RGBAub);
+        mDirtyRange.clip(mDataNum);
+        const std::vector<ibc::gl::DirtyRange::Range> &ranges = mDirtyRange.getRanges();
+        for (size_t i = 0; i < ranges.size(); i++)
+          glBufferSubData(GL_ARRAY_BUFFER, elementSize * ranges[i].first,
+                          elementSize * ranges[i].count, &(mDataPtr[ranges[i].first]));
+      }
+      mIsDataModified = false;
+      mDirtyRange.clear();
+    }
+    // -------------------------------------------------------------------------
+    // disposeVBO
+    // -------------------------------------------------------------------------
+    void disposeVBO()
+    {
+      if (mIsVBOInitialized == false)
+        return;
+      //
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      bindVertexArray(0);
+      glDeleteBuffers(1, &mVertexBufferObject);
+      mIsVBOInitialized = false;
+    }
+  };
+};};};
+
+#endif  // #ifdef IBC_GL_MODEL_QUANTIZED_POINTS_H_
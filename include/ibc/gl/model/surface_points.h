@@ -23,7 +23,12 @@
 
 // Includes --------------------------------------------------------------------
 #include <math.h>
+#include <cstring>
+#include <vector>
+#include "ibc/base/parallel.h"
 #include "ibc/gl/model/model_base.h"
+#include "ibc/gl/dirty_range.h"
+#include "ibc/gl/point_chunks.h"
 #include "ibc/gl/utils.h"
 #include "ibc/image/color_map.h"
 
@@ -34,23 +39,43 @@ namespace ibc { namespace gl { namespace model
   // ---------------------------------------------------------------------------
   // SurfacePoints
   // ---------------------------------------------------------------------------
+  // DRAW_MODE_POINTS : each sample is drawn as a point sprite (PointSprite)
+  // DRAW_MODE_MESH   : the samples are uploaded as a height map texture and
+  //                    drawn as a triangle strip mesh (SurfaceMesh, set by
+  //                    setMeshShader()). The index buffer depends only on
+  //                    the width and the height, so it is kept until they change.
+  // With setTextureStreaming(true), the height map updates of the mesh mode
+  // go through a ring of pixel unpack buffers (PBO), so the copy of the next
+  // frame overlaps with the texture transfer and the drawing of the previous.
   class SurfacePoints : public virtual ibc::gl::model::ModelBase
   {
   public:
+    // Typedefs ----------------------------------------------------------------
+    enum DrawMode
+    {
+      DRAW_MODE_POINTS  = 0,
+      DRAW_MODE_MESH
+    };
+
+    // Constants ---------------------------------------------------------------
+    static const GLuint  PRIMITIVE_RESTART_INDEX = 0xFFFFFFFF;
+    static const int     COLOR_MAP_TEXTURE_MAX_SIZE = 4096;
+    static const int     PIXEL_BUFFER_RING_SIZE = 3;
+
     // Constructors and Destructor ---------------------------------------------
     // -------------------------------------------------------------------------
     // SurfacePoints
     // -------------------------------------------------------------------------
     SurfacePoints()
     {
-      mVertexData = NULL;
-
       mIsDataFormatUpdated  = false;
       mIsDataModified       = false;
       mIsColorMapModified   = false;
 
       mIsVBOInitialized             = false;
       mIsColoMapTextureInitialized  = false;
+      mIsHeightTextureInitialized   = false;
+      mIsIndexBufferInitialized     = false;
 
       mDataPtr     = NULL;
       mWidth       = 0;
@@ -60,6 +85,26 @@ namespace ibc { namespace gl { namespace model
       mDataSize    = 0;
       mColorMapIndex = ibc::image::ColorMap::CMIndex_Rainbow;
       mColorMapSize = 0;
+      mColorMapTextureSize = 0;
+
+      mIsFrustumCulling = false;
+
+      mDrawMode = DRAW_MODE_POINTS;
+      mMeshShaderInterface = NULL;
+      mMeshShaderProgram = 0;
+      mHeightScale = 1.0;
+      mIndexWidth  = 0;
+      mIndexHeight = 0;
+      mIndexNum    = 0;
+
+      mIsTextureStreaming = false;
+      mIsPixelBufferInitialized = false;
+      mPixelBufferIndex = 0;
+      for (int i = 0; i < PIXEL_BUFFER_RING_SIZE; i++)
+      {
+        mPixelBuffers[i] = 0;
+        mPixelBufferFences[i] = NULL;
+      }
     }
     // -------------------------------------------------------------------------
     // ~SurfacePoints
@@ -105,6 +150,87 @@ namespace ibc { namespace gl { namespace model
       mIsDataModified = true;
     }
     // -------------------------------------------------------------------------
+    // markRangeModified
+    // -------------------------------------------------------------------------
+    // Marks [inFirst, inFirst + inCount) as modified. For a band of rows,
+    // inFirst = row * width and inCount = rows * width.
+    void markRangeModified(size_t inFirst, size_t inCount)
+    {
+      mDirtyRange.add(inFirst, inCount);
+    }
+    // -------------------------------------------------------------------------
+    // setFrustumCulling
+    // -------------------------------------------------------------------------
+    // Draws only the chunks of inChunkSize samples (bands of rows) in the
+    // view frustum. The bounds depend only on the width and the height.
+    // (DRAW_MODE_POINTS only, disabled by default)
+    void setFrustumCulling(bool inEnable, size_t inChunkSize = 0)
+    {
+      if (inChunkSize != 0 && inChunkSize != mChunks.getChunkSize())
+      {
+        mChunks.setChunkSize(inChunkSize);
+        updateChunkMinMax();
+      }
+      mIsFrustumCulling = inEnable;
+    }
+    // -------------------------------------------------------------------------
+    // isFrustumCulling
+    // -------------------------------------------------------------------------
+    bool isFrustumCulling()
+    {
+      return mIsFrustumCulling;
+    }
+    // -------------------------------------------------------------------------
+    // setMeshShader
+    // -------------------------------------------------------------------------
+    // The shader for DRAW_MODE_MESH (should be set before initModel())
+    void setMeshShader(ibc::gl::ShaderInterface *inShaderInterface)
+    {
+      mMeshShaderInterface = inShaderInterface;
+    }
+    // -------------------------------------------------------------------------
+    // getMeshShader
+    // -------------------------------------------------------------------------
+    ibc::gl::ShaderInterface *getMeshShader()
+    {
+      return mMeshShaderInterface;
+    }
+    // -------------------------------------------------------------------------
+    // setDrawMode
+    // -------------------------------------------------------------------------
+    void setDrawMode(DrawMode inMode)
+    {
+      if (mDrawMode == inMode)
+        return;
+      mDrawMode = inMode;
+      mIsDataFormatUpdated = true;
+    }
+    // -------------------------------------------------------------------------
+    // getDrawMode
+    // -------------------------------------------------------------------------
+    DrawMode getDrawMode()
+    {
+      return mDrawMode;
+    }
+    // -------------------------------------------------------------------------
+    // setTextureStreaming
+    // -------------------------------------------------------------------------
+    // Uploads the height map through the PBO ring (DRAW_MODE_MESH only)
+    void setTextureStreaming(bool inEnable)
+    {
+      if (mIsTextureStreaming == inEnable)
+        return;
+      mIsTextureStreaming = inEnable;
+      mIsDataFormatUpdated = true;
+    }
+    // -------------------------------------------------------------------------
+    // isTextureStreaming
+    // -------------------------------------------------------------------------
+    bool isTextureStreaming()
+    {
+      return mIsTextureStreaming;
+    }
+    // -------------------------------------------------------------------------
     // initModel
     // -------------------------------------------------------------------------
     virtual bool initModel()
@@ -114,49 +240,28 @@ namespace ibc { namespace gl { namespace model
 
       // Shader program related initialization
       mShaderProgram = mShaderInterface->getShaderProgram();
-      mDataSizeLocation         = glGetUniformLocation(mShaderProgram, "dataSize");
-      mZGainLocation            = glGetUniformLocation(mShaderProgram, "zGain");
-      mZOffsetLocation          = glGetUniformLocation(mShaderProgram, "zOffset");
-      mZClampLocation           = glGetUniformLocation(mShaderProgram, "zClamp");
-      mIntensityMaxLocation     = glGetUniformLocation(mShaderProgram, "intensityMax");
-      mIntensityGainLocation    = glGetUniformLocation(mShaderProgram, "intensityGain");
-      mIntensityOffsetLocation  = glGetUniformLocation(mShaderProgram, "intensityOffset");
-      mIntensityClampLocation   = glGetUniformLocation(mShaderProgram, "intensityClamp");
-      mLightSourceLocation      = glGetUniformLocation(mShaderProgram, "lightSource");
-      mMaterialLocation         = glGetUniformLocation(mShaderProgram, "material");
-      mModelViewLocation        = glGetUniformLocation(mShaderProgram, "modelview");
-      mProjectionLocation       = glGetUniformLocation(mShaderProgram, "projection");
-      GLint intensityLocation   = glGetAttribLocation(mShaderProgram, "intensity");
-
-      // Initialze Vertex Array Object
+      getUniformLocations(mShaderInterface, &mPointLocations);
+      mIntensityLocation = mShaderInterface->getAttribLocation("intensity");
+      if (mMeshShaderInterface != NULL)
+      {
+        mMeshShaderProgram = mMeshShaderInterface->getShaderProgram();
+        getUniformLocations(mMeshShaderInterface, &mMeshLocations);
+        mHeightMapLocation    = mMeshShaderInterface->getUniformLocation("heightMap");
+        mHeightScaleLocation  = mMeshShaderInterface->getUniformLocation("heightScale");
+      }
+
+      // Initialze Vertex Array Objects
       glGenVertexArrays(1, &mVertexArrayObject);
-      glBindVertexArray(mVertexArrayObject);
+      glGenVertexArrays(1, &mMeshVertexArrayObject);
+      bindVertexArray(mVertexArrayObject);
 
+      initColoMapTexture();
       if (mIsDataFormatUpdated)
       {
-        initVBO();
-        initColoMapTexture();
+        initBuffers();
         mIsDataFormatUpdated = false;
       }
 
-      glEnableVertexAttribArray(0);
-      glEnableVertexAttribArray(intensityLocation);
-      glVertexAttribPointer(intensityLocation, 1, GL_UNSIGNED_BYTE, GL_FALSE, 0, NULL);
-
-      // Initialize Texture
-      glEnable(GL_TEXTURE_1D);
-      glGenTextures(1, &mTexture);
-      //glCreateTextures(GL_TEXTURE_1D, 1, &mTexture);
-      //glTextureStorage1D(mTexture, 1, GL_RGB8, 256);
-      glBindTexture(GL_TEXTURE_1D, mTexture);
-
-      unsigned char *colorMap = new unsigned char[256 * 3];
-      ibc::image::ColorMap::getColorMap(ibc::image::ColorMap::CMIndex_Rainbow,
-                                        256, colorMap);
-      glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, 256, 0, GL_RGB, GL_UNSIGNED_BYTE, colorMap);
-      //glTextureSubImage1D(mTexture, 0, 0, 256, GL_RGB, GL_UNSIGNED_BYTE, colorMap);
-      delete colorMap;
-
       return true;
     }
     // -------------------------------------------------------------------------
@@ -166,53 +271,74 @@ namespace ibc { namespace gl { namespace model
     {
       disposeColoMapTexture();
       disposeVBO();
+      disposePixelBuffers();
+      disposeHeightTexture();
+      disposeIndexBuffer();
     }
     // -------------------------------------------------------------------------
     // drawModel
     // -------------------------------------------------------------------------
     virtual void drawModel(const GLfloat inModelView[16], const GLfloat inProjection[16])
     {
+      if (mNumPoints == 0)
+        return;
+
       if (mIsDataFormatUpdated)
       {
-        initVBO();
-        initColoMapTexture();
+        initBuffers();
+        updateColoMapTexture();
         mIsDataFormatUpdated = false;
       }
       else
       {
-        if (mIsDataModified)
-          updateVBO();
+        if (mIsDataModified || mDirtyRange.isEmpty() == false)
+        {
+          if (isMeshMode())
+            updateHeightTexture();
+          else
+            updateVBO();
+        }
         if (mIsColorMapModified)
           updateColoMapTexture();
       }
 
-      glUseProgram(mShaderProgram);
-
-      glUniform2f(mDataSizeLocation, mWidth, mHeight);
-      glUniform1f(mZGainLocation,   1.0 / mColorMapSize);
-      glUniform1f(mZOffsetLocation, 0.0);
-      glUniform2f(mZClampLocation, 0.0, 1.0);
-      glUniform1f(mIntensityMaxLocation,    mColorMapSize);
-      glUniform1f(mIntensityGainLocation,   1.0);
-      glUniform1f(mIntensityOffsetLocation, 0.0);
-      glUniform2f(mIntensityClampLocation, 0.0, mColorMapSize);
-      glUniform4f(mLightSourceLocation, 0.0, 0.0, 100.0, 1.0);
-      glUniform1i(mMaterialLocation, 0);
-      glUniformMatrix4fv(mModelViewLocation, 1, GL_FALSE, &(inModelView[0]));
-      glUniformMatrix4fv(mProjectionLocation, 1, GL_FALSE, &(inProjection[0]));
-
-      glBindVertexArray(mVertexArrayObject);
-      glDrawArrays(GL_POINTS, 0, (GLsizei )mNumPoints);
+      if (isMeshMode())
+        drawMesh(inModelView, inProjection);
+      else
+        drawPoints(inModelView, inProjection);
     }
 
   protected:
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      GLint dataSize;
+      GLint zGain;
+      GLint zOffset;
+      GLint zClamp;
+      GLint intensityMax;
+      GLint intensityGain;
+      GLint intensityOffset;
+      GLint intensityClamp;
+      GLint material;
+      GLint modelView;
+      GLint projection;
+    } UniformLocations;
+
     // Member variables --------------------------------------------------------
     bool  mIsDataFormatUpdated;
     bool  mIsDataModified;
+    ibc::gl::DirtyRange mDirtyRange;
     bool  mIsColorMapModified;
+    bool  mIsFrustumCulling;
+    ibc::gl::PointChunks  mChunks;
+    std::vector<GLint>    mDrawFirsts;
+    std::vector<GLsizei>  mDrawCounts;
 
     bool  mIsVBOInitialized;
     bool  mIsColoMapTextureInitialized;
+    bool  mIsHeightTextureInitialized;
+    bool  mIsIndexBufferInitialized;
 
     void  *mDataPtr;
     GLenum  mDataType;
@@ -221,31 +347,143 @@ namespace ibc { namespace gl { namespace model
     size_t  mDataSize;
     ibc::image::ColorMap::ColorMapIndex mColorMapIndex;
     int mColorMapSize;
+    int mColorMapTextureSize;
 
-    unsigned char  *mVertexData;
+    DrawMode  mDrawMode;
+    ibc::gl::ShaderInterface *mMeshShaderInterface;
 
     GLuint mShaderProgram;
+    GLuint mMeshShaderProgram;
 
     GLuint  mVertexArrayObject;
     GLuint  mVertexBufferObject;
     GLuint  mTexture;
 
-    GLint mDataSizeLocation;
-    GLint mZGainLocation;
-    GLint mZOffsetLocation;
-    GLint mZClampLocation;
-    GLint mIntensityMaxLocation;
-    GLint mIntensityGainLocation;
-    GLint mIntensityOffsetLocation;
-    GLint mIntensityClampLocation;
-    GLint mLightSourceLocation;
-    GLint mMaterialLocation;
+    GLuint  mMeshVertexArrayObject;
+    GLuint  mIndexBufferObject;
+    GLuint  mHeightTexture;
+    GLfloat mHeightScale;
+    size_t  mIndexWidth, mIndexHeight;
+    size_t  mIndexNum;
 
-    GLint mModelViewLocation;
-    GLint mProjectionLocation;
+    bool    mIsTextureStreaming;
+    bool    mIsPixelBufferInitialized;
+    GLuint  mPixelBuffers[PIXEL_BUFFER_RING_SIZE];
+    GLsync  mPixelBufferFences[PIXEL_BUFFER_RING_SIZE];
+    int     mPixelBufferIndex;
+
+    UniformLocations  mPointLocations;
+    UniformLocations  mMeshLocations;
+    GLint mIntensityLocation;
+    GLint mHeightMapLocation;
+    GLint mHeightScaleLocation;
 
     // Member functions --------------------------------------------------------
     // -------------------------------------------------------------------------
+    // isMeshMode
+    // -------------------------------------------------------------------------
+    bool isMeshMode()
+    {
+      return (mDrawMode == DRAW_MODE_MESH && mMeshShaderInterface != NULL);
+    }
+    // -------------------------------------------------------------------------
+    // getUniformLocations
+    // -------------------------------------------------------------------------
+    void getUniformLocations(ibc::gl::ShaderInterface *inShaderInterface,
+                             UniformLocations *outLocations)
+    {
+      outLocations->dataSize        = inShaderInterface->getUniformLocation("dataSize");
+      outLocations->zGain           = inShaderInterface->getUniformLocation("zGain");
+      outLocations->zOffset         = inShaderInterface->getUniformLocation("zOffset");
+      outLocations->zClamp          = inShaderInterface->getUniformLocation("zClamp");
+      outLocations->intensityMax    = inShaderInterface->getUniformLocation("intensityMax");
+      outLocations->intensityGain   = inShaderInterface->getUniformLocation("intensityGain");
+      outLocations->intensityOffset = inShaderInterface->getUniformLocation("intensityOffset");
+      outLocations->intensityClamp  = inShaderInterface->getUniformLocation("intensityClamp");
+      outLocations->material        = inShaderInterface->getUniformLocation("material");
+      outLocations->modelView       = inShaderInterface->getUniformLocation("modelview");
+      outLocations->projection      = inShaderInterface->getUniformLocation("projection");
+    }
+    // -------------------------------------------------------------------------
+    // setUniforms
+    // -------------------------------------------------------------------------
+    void setUniforms(const UniformLocations &inLocations, GLint inMaterial,
+                     const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      // The color map texture may be smaller than the intensity range
+      GLfloat colorMapGain = (GLfloat )mColorMapTextureSize / mColorMapSize;
+
+      glUniform2f(inLocations.dataSize, mWidth, mHeight);
+      glUniform1f(inLocations.zGain,   1.0 / mColorMapSize);
+      glUniform1f(inLocations.zOffset, 0.0);
+      glUniform2f(inLocations.zClamp, 0.0, 1.0);
+      glUniform1f(inLocations.intensityMax,    mColorMapSize);
+      glUniform1f(inLocations.intensityGain,   colorMapGain);
+      glUniform1f(inLocations.intensityOffset, 0.0);
+      glUniform2f(inLocations.intensityClamp, 0.0, mColorMapTextureSize - 1);
+      glUniform1i(inLocations.material, inMaterial);
+      setMatrixUniforms(inLocations.modelView, inLocations.projection, inModelView, inProjection);
+
+      activeTexture(GL_TEXTURE0);
+      bindTexture(GL_TEXTURE_1D, mTexture);
+    }
+    // -------------------------------------------------------------------------
+    // drawPoints
+    // -------------------------------------------------------------------------
+    void drawPoints(const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      useProgram(mShaderProgram);
+      setUniforms(mPointLocations, 0, inModelView, inProjection);
+
+      bindVertexArray(mVertexArrayObject);
+      if (mIsFrustumCulling)
+      {
+        if (mChunks.select(inModelView, inProjection, NULL, &mDrawFirsts, &mDrawCounts) != 0)
+          glMultiDrawArrays(GL_POINTS, mDrawFirsts.data(), mDrawCounts.data(),
+                            (GLsizei )mDrawFirsts.size());
+      }
+      else
+        glDrawArrays(GL_POINTS, 0, (GLsizei )mNumPoints);
+    }
+    // -------------------------------------------------------------------------
+    // drawMesh
+    // -------------------------------------------------------------------------
+    void drawMesh(const GLfloat inModelView[16], const GLfloat inProjection[16])
+    {
+      if (mIndexNum == 0)
+        return;
+
+      useProgram(mMeshShaderProgram);
+      setUniforms(mMeshLocations, 1, inModelView, inProjection);
+      glUniform1i(mHeightMapLocation, 1);
+      glUniform1f(mHeightScaleLocation, mHeightScale);
+      activeTexture(GL_TEXTURE1);
+      bindTexture(GL_TEXTURE_2D, mHeightTexture);
+
+      bindVertexArray(mMeshVertexArrayObject);
+      glEnable(GL_PRIMITIVE_RESTART);
+      glPrimitiveRestartIndex(PRIMITIVE_RESTART_INDEX);
+      glDrawElements(GL_TRIANGLE_STRIP, (GLsizei )mIndexNum, GL_UNSIGNED_INT, NULL);
+      glDisable(GL_PRIMITIVE_RESTART);
+
+      bindTexture(GL_TEXTURE_2D, 0);
+      activeTexture(GL_TEXTURE0);
+    }
+    // -------------------------------------------------------------------------
+    // initBuffers
+    // -------------------------------------------------------------------------
+    void initBuffers()
+    {
+      if (isMeshMode())
+      {
+        initHeightTexture();
+        initIndexBuffer();
+      }
+      else
+        initVBO();
+      updateChunkMinMax();
+    }
+    // -------------------------------------------------------------------------
     // initVBO
     // -------------------------------------------------------------------------
     void initVBO()
@@ -253,12 +491,18 @@ namespace ibc { namespace gl { namespace model
       if (mIsVBOInitialized)
         disposeVBO();
       //
+      bindVertexArray(mVertexArrayObject);
       glGenBuffers(1, &mVertexBufferObject);
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
       glBufferData(GL_ARRAY_BUFFER, mDataSize, NULL, GL_DYNAMIC_DRAW);
       mIsVBOInitialized = true;
       //
+      mIsDataModified = true;
       updateVBO();
+
+      glEnableVertexAttribArray(mIntensityLocation);
+      // The raw (not normalized) values of any integer or float type
+      glVertexAttribPointer(mIntensityLocation, 1, mDataType, GL_FALSE, 0, NULL);
     }
     // -------------------------------------------------------------------------
     // updateVBO
@@ -266,8 +510,20 @@ namespace ibc { namespace gl { namespace model
     void updateVBO()
     {
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-      glBufferSubData(GL_ARRAY_BUFFER, 0, mDataSize, mDataPtr);
+      if (mIsDataModified)
+        glBufferSubData(GL_ARRAY_BUFFER, 0, mDataSize, mDataPtr);
+      else
+      {
+        size_t  elementSize = ibc::gl::Utils::sizeofGLDataType(mDataType);
+        mDirtyRange.clip(mNumPoints);
+        const std::vector<ibc::gl::DirtyRange::Range> &ranges = mDirtyRange.getRanges();
+        for (size_t i = 0; i < ranges.size(); i++)
+          glBufferSubData(GL_ARRAY_BUFFER, elementSize * ranges[i].first,
+                          elementSize * ranges[i].count,
+                          ((const unsigned char *)mDataPtr) + elementSize * ranges[i].first);
+      }
       mIsDataModified = false;
+      mDirtyRange.clear();
     }
     // -------------------------------------------------------------------------
     // disposeVBO
@@ -281,6 +537,255 @@ namespace ibc { namespace gl { namespace model
       mIsVBOInitialized = false;
     }
     // -------------------------------------------------------------------------
+    // initHeightTexture
+    // -------------------------------------------------------------------------
+    void initHeightTexture()
+    {
+      if (mIsHeightTextureInitialized)
+        disposeHeightTexture();
+      //
+      GLint internalFormat;
+      if (getHeightTextureFormat(mDataType, &internalFormat, &mHeightScale) == false)
+        return;
+      activeTexture(GL_TEXTURE1);
+      glGenTextures(1, &mHeightTexture);
+      bindTexture(GL_TEXTURE_2D, mHeightTexture);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, (GLsizei )mWidth, (GLsizei )mHeight,
+                   0, GL_RED, mDataType, mDataPtr);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      bindTexture(GL_TEXTURE_2D, 0);
+      activeTexture(GL_TEXTURE0);
+      mIsHeightTextureInitialized = true;
+      //
+      mIsDataModified = false;
+      mDirtyRange.clear();
+      if (mIsTextureStreaming)
+        initPixelBuffers();
+      else
+        disposePixelBuffers();
+    }
+    // -------------------------------------------------------------------------
+    // updateHeightTexture
+    // -------------------------------------------------------------------------
+    // The modified ranges are uploaded as the bands of rows which cover them
+    void updateHeightTexture()
+    {
+      if (mIsHeightTextureInitialized == false)
+        return;
+      std::vector<ibc::gl::DirtyRange::Range> bands;
+      if (mIsDataModified)
+      {
+        ibc::gl::DirtyRange::Range band = {0, mHeight};
+        bands.push_back(band);
+      }
+      else
+      {
+        mDirtyRange.clip(mNumPoints);
+        const std::vector<ibc::gl::DirtyRange::Range> &ranges = mDirtyRange.getRanges();
+        for (size_t i = 0; i < ranges.size(); i++)
+        {
+          size_t  row0 = ranges[i].first / mWidth;
+          size_t  row1 = (ranges[i].first + ranges[i].count - 1) / mWidth;
+          ibc::gl::DirtyRange::Range band = {row0, row1 - row0 + 1};
+          bands.push_back(band);
+        }
+      }
+      mIsDataModified = false;
+      mDirtyRange.clear();
+      //
+      size_t  lineSize = ibc::gl::Utils::sizeofGLDataType(mDataType) * mWidth;
+      const unsigned char *srcPtr = (const unsigned char *)mDataPtr;
+      activeTexture(GL_TEXTURE1);
+      bindTexture(GL_TEXTURE_2D, mHeightTexture);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      unsigned char *pixelBufferPtr = NULL;
+      if (mIsPixelBufferInitialized)
+        pixelBufferPtr = mapPixelBuffer();
+      if (pixelBufferPtr != NULL)
+      {
+        // The bands are placed at the same offsets as in the image
+        for (size_t i = 0; i < bands.size(); i++)
+          ::memcpy(pixelBufferPtr + lineSize * bands[i].first,
+                   srcPtr + lineSize * bands[i].first, lineSize * bands[i].count);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        for (size_t i = 0; i < bands.size(); i++)
+          glTexSubImage2D(GL_TEXTURE_2D, 0, 0, (GLint )bands[i].first,
+                          (GLsizei )mWidth, (GLsizei )bands[i].count, GL_RED, mDataType,
+                          (const GLvoid *)(lineSize * bands[i].first));
+        fencePixelBuffer();
+      }
+      else
+      {
+        for (size_t i = 0; i < bands.size(); i++)
+          glTexSubImage2D(GL_TEXTURE_2D, 0, 0, (GLint )bands[i].first,
+                          (GLsizei )mWidth, (GLsizei )bands[i].count, GL_RED, mDataType,
+                          srcPtr + lineSize * bands[i].first);
+      }
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      bindTexture(GL_TEXTURE_2D, 0);
+      activeTexture(GL_TEXTURE0);
+    }
+    // -------------------------------------------------------------------------
+    // disposeHeightTexture
+    // -------------------------------------------------------------------------
+    void disposeHeightTexture()
+    {
+      if (mIsHeightTextureInitialized == false)
+        return;
+      deleteTextures(1, &mHeightTexture);
+      mIsHeightTextureInitialized = false;
+    }
+    // -------------------------------------------------------------------------
+    // initPixelBuffers
+    // -------------------------------------------------------------------------
+    void initPixelBuffers()
+    {
+      disposePixelBuffers();
+      glGenBuffers(PIXEL_BUFFER_RING_SIZE, mPixelBuffers);
+      for (int i = 0; i < PIXEL_BUFFER_RING_SIZE; i++)
+      {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mPixelBuffers[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, mDataSize, NULL, GL_STREAM_DRAW);
+      }
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      mPixelBufferIndex = 0;
+      mIsPixelBufferInitialized = true;
+    }
+    // -------------------------------------------------------------------------
+    // mapPixelBuffer
+    // -------------------------------------------------------------------------
+    // Binds and maps the next buffer of the ring. The fence of its previous
+    // use is waited first (it was issued PIXEL_BUFFER_RING_SIZE uploads ago,
+    // so this normally returns immediately).
+    unsigned char *mapPixelBuffer()
+    {
+      GLsync  &fence = mPixelBufferFences[mPixelBufferIndex];
+      if (fence != NULL)
+      {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);  // 1s
+        glDeleteSync(fence);
+        fence = NULL;
+      }
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mPixelBuffers[mPixelBufferIndex]);
+      void  *ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, mDataSize,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT |
+                                    GL_MAP_UNSYNCHRONIZED_BIT);
+      if (ptr == NULL)
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      return (unsigned char *)ptr;
+    }
+    // -------------------------------------------------------------------------
+    // fencePixelBuffer
+    // -------------------------------------------------------------------------
+    void fencePixelBuffer()
+    {
+      mPixelBufferFences[mPixelBufferIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      mPixelBufferIndex = (mPixelBufferIndex + 1) % PIXEL_BUFFER_RING_SIZE;
+    }
+    // -------------------------------------------------------------------------
+    // disposePixelBuffers
+    // -------------------------------------------------------------------------
+    void disposePixelBuffers()
+    {
+      if (mIsPixelBufferInitialized == false)
+        return;
+      for (int i = 0; i < PIXEL_BUFFER_RING_SIZE; i++)
+      {
+        if (mPixelBufferFences[i] != NULL)
+          glDeleteSync(mPixelBufferFences[i]);
+        mPixelBufferFences[i] = NULL;
+      }
+      glDeleteBuffers(PIXEL_BUFFER_RING_SIZE, mPixelBuffers);
+      mIsPixelBufferInitialized = false;
+    }
+    // -------------------------------------------------------------------------
+    // initIndexBuffer
+    // -------------------------------------------------------------------------
+    // One strip per pair of rows, separated by the primitive restart index
+    void initIndexBuffer()
+    {
+      if (mIsIndexBufferInitialized &&
+          mIndexWidth == mWidth && mIndexHeight == mHeight)
+        return;
+      disposeIndexBuffer();
+      mIndexWidth  = mWidth;
+      mIndexHeight = mHeight;
+      mIndexNum    = 0;
+      if (mWidth < 2 || mHeight < 2)
+        return;
+      //
+      size_t  stripSize = mWidth * 2 + 1;
+      std::vector<GLuint> indices(stripSize * (mHeight - 1));
+      ibc::Parallel::forEach(mHeight - 1, 256,
+        [&](size_t inBegin, size_t inEnd)
+        {
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            GLuint  *p = &(indices[stripSize * i]);
+            for (size_t j = 0; j < mWidth; j++)
+            {
+              *p++ = (GLuint )((i + 1) * mWidth + j);
+              *p++ = (GLuint )(i * mWidth + j);
+            }
+            *p = PRIMITIVE_RESTART_INDEX;
+          }
+        });
+      mIndexNum = indices.size();
+      //
+      bindVertexArray(mMeshVertexArrayObject);
+      glGenBuffers(1, &mIndexBufferObject);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBufferObject);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * mIndexNum,
+                   indices.data(), GL_STATIC_DRAW);
+      bindVertexArray(mVertexArrayObject);
+      mIsIndexBufferInitialized = true;
+    }
+    // -------------------------------------------------------------------------
+    // disposeIndexBuffer
+    // -------------------------------------------------------------------------
+    void disposeIndexBuffer()
+    {
+      if (mIsIndexBufferInitialized == false)
+        return;
+      glDeleteBuffers(1, &mIndexBufferObject);
+      mIsIndexBufferInitialized = false;
+      mIndexNum = 0;
+    }
+    // -------------------------------------------------------------------------
+    // updateChunkMinMax
+    // -------------------------------------------------------------------------
+    // The same grid as the vertex shader (pitch = 2 / width, z in zClamp)
+    void updateChunkMinMax()
+    {
+      mChunks.resize(mNumPoints);
+      if (mWidth == 0)
+        return;
+      GLfloat pitch = 2.0f / mWidth;
+      for (size_t i = 0; i < mChunks.getChunkNum(); i++)
+      {
+        size_t  first, count;
+        mChunks.getChunkRange(i, &first, &count);
+        size_t  row0 = first / mWidth;
+        size_t  row1 = (first + count - 1) / mWidth;
+        size_t  col0 = 0, col1 = mWidth - 1;
+        if (row0 == row1)
+        {
+          col0 = first % mWidth;
+          col1 = (first + count - 1) % mWidth;
+        }
+        GLfloat minMax[6] = {-1.0f + pitch * col0, -1.0f + pitch * col1,
+                             -1.0f + pitch * row0, -1.0f + pitch * row1,
+                             0.0f, 1.0f};
+        mChunks.setMinMax(i, minMax);
+      }
+    }
+    // -------------------------------------------------------------------------
     // initColoMapTexture
     // -------------------------------------------------------------------------
     void initColoMapTexture()
@@ -288,11 +793,14 @@ namespace ibc { namespace gl { namespace model
       if (mIsColoMapTextureInitialized)
         disposeColoMapTexture();
       //
-      glEnable(GL_TEXTURE_1D);
+      activeTexture(GL_TEXTURE0);
       glGenTextures(1, &mTexture);
       //glCreateTextures(GL_TEXTURE_1D, 1, &mTexture);
       //glTextureStorage1D(mTexture, 1, GL_RGB8, mColorMapSize);
-      glBindTexture(GL_TEXTURE_1D, mTexture);
+      bindTexture(GL_TEXTURE_1D, mTexture);
+      // texelFetch() needs a complete texture (no mipmaps)
+      glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
       mIsColoMapTextureInitialized = true;
       //
       updateColoMapTexture();
@@ -302,12 +810,18 @@ namespace ibc { namespace gl { namespace model
     // -------------------------------------------------------------------------
     void updateColoMapTexture()
     {
-      unsigned char *colorMap = new unsigned char[mColorMapSize * 3];
-      ibc::image::ColorMap::getColorMap(ibc::image::ColorMap::CMIndex_Rainbow,
-                                        mColorMapSize, colorMap);
+      mColorMapTextureSize = mColorMapSize;
+      if (mColorMapTextureSize <= 0)
+        mColorMapTextureSize = 256;
+      if (mColorMapTextureSize > COLOR_MAP_TEXTURE_MAX_SIZE)
+        mColorMapTextureSize = COLOR_MAP_TEXTURE_MAX_SIZE;
+      std::vector<unsigned char> colorMap(mColorMapTextureSize * 3);
+      ibc::image::ColorMap::getColorMap(mColorMapIndex, mColorMapTextureSize, colorMap.data());
+      activeTexture(GL_TEXTURE0);
+      bindTexture(GL_TEXTURE_1D, mTexture);
       //glTextureSubImage1D(mTexture, 0, 0, mColorMapSize, GL_RGB, GL_UNSIGNED_BYTE, colorMap);
-      glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, 256, 0, GL_RGB, GL_UNSIGNED_BYTE, colorMap);
-      delete colorMap;
+      glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, mColorMapTextureSize, 0,
+                   GL_RGB, GL_UNSIGNED_BYTE, colorMap.data());
       mIsColorMapModified = false;
     }
     // -------------------------------------------------------------------------
@@ -317,10 +831,47 @@ namespace ibc { namespace gl { namespace model
     {
       if (mIsColoMapTextureInitialized == false)
         return;
-      glBindTexture(GL_TEXTURE_1D, 0);
-      glDeleteTextures(1, &mTexture);
+      bindTexture(GL_TEXTURE_1D, 0);
+      deleteTextures(1, &mTexture);
       mIsColoMapTextureInitialized = false;
     }
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getHeightTextureFormat
+    // -------------------------------------------------------------------------
+    // The samples are stored normalized, outScale restores the raw values
+    // (the same values as the intensity attribute of the points mode)
+    static bool getHeightTextureFormat(GLenum inType, GLint *outInternalFormat,
+                                       GLfloat *outScale)
+    {
+      switch (inType)
+      {
+        case GL_UNSIGNED_BYTE:
+          *outInternalFormat = GL_R8;
+          *outScale = 255.0f;
+          return true;
+        case GL_BYTE:
+          *outInternalFormat = GL_R8_SNORM;
+          *outScale = 127.0f;
+          return true;
+        case GL_UNSIGNED_SHORT:
+          *outInternalFormat = GL_R16;
+          *outScale = 65535.0f;
+          return true;
+        case GL_SHORT:
+          *outInternalFormat = GL_R16_SNORM;
+          *outScale = 32767.0f;
+          return true;
+        case GL_FLOAT:
+          *outInternalFormat = GL_R32F;
+          *outScale = 1.0f;
+          return true;
+        default:
+          return false;
+      }
+      return false;
+    }
   };
 };};};
 
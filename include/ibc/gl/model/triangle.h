@@ -68,7 +68,7 @@ namespace ibc { namespace gl { namespace model
       mShaderProgram = mShaderInterface->getShaderProgram();
 
       glGenVertexArrays(1, &mVertexArrayObject);
-      glBindVertexArray(mVertexArrayObject);
+      bindVertexArray(mVertexArrayObject);
 
       glGenBuffers(1, &mVertexBufferObject);
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
@@ -94,8 +94,8 @@ namespace ibc { namespace gl { namespace model
       UNUSED(inModelView);
       UNUSED(inProjection);
       //
-      glUseProgram(mShaderProgram);
-      glBindVertexArray(mVertexArrayObject);
+      useProgram(mShaderProgram);
+      bindVertexArray(mVertexArrayObject);
       glDrawArrays(GL_TRIANGLES, 0, 3);
     }
 
@@ -34,6 +34,16 @@ namespace ibc { namespace gl { namespace model
   class XYZAxis : public virtual ibc::gl::model::ModelBase
   {
   public:
+    // structs -----------------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // vertex_info
+    // -------------------------------------------------------------------------
+    struct vertex_info
+    {
+      GLfloat position[3];
+      GLfloat color[3];
+    };
+
     // Constructors and Destructor ---------------------------------------------
     // -------------------------------------------------------------------------
     // XYZAxis
@@ -57,59 +67,35 @@ namespace ibc { namespace gl { namespace model
       if (ModelBase::initModel() == false)
         return false;
 
-      static const struct vertex_info vertexData[] =
-      {
-        { { -1.0f,  0.0f,  0.0f }, { 1.0f, 0.7f, 0.7f } },
-        { {  1.0f,  0.0f,  0.0f }, { 1.0f, 0.0f, 0.0f } },
-        { {  0.0f, -1.0f,  0.0f }, { 0.7f, 1.0f, 0.7f } },
-        { {  0.0f,  1.0f,  0.0f }, { 0.0f, 1.0f, 0.0f } },
-        { {  0.0f,  0.0f, -1.0f }, { 0.7f, 0.7f, 1.0f } },
-        { {  0.0f,  0.0f,  1.0f }, { 0.0f, 0.0f, 1.0f } },
-        //
-        { {  0.95f,  0.025f,  0.0f }, { 1.0f, 0.0f, 0.0f } },
-        { {  0.95f, -0.025f,  0.0f }, { 1.0f, 0.0f, 0.0f } },
-
-        { {  0.025f,  0.95f,  0.0f }, { 0.0f, 1.0f, 0.0f } },
-        { { -0.025f,  0.95f,  0.0f }, { 0.0f, 1.0f, 0.0f } },
-        { {  0.0f,  0.025f,  0.95f }, { 0.0f, 0.0f, 1.0f } },
-        { {  0.0f, -0.025f,  0.95f }, { 0.0f, 0.0f, 1.0f } }
-      };
-      static const GLuint indexData[] =
-      {
-        0, 1,
-        2, 3,
-        4, 5,
-        //
-        1, 6,
-        1, 7,
-        3, 8,
-        3, 9,
-        5, 10,
-        5, 11
-      };
+      size_t  vertexNum;
+      const struct vertex_info  *vertexData = getVertexData(&vertexNum);
+      size_t  indexNum;
+      const GLuint  *indexData = getIndexData(&indexNum);
 
       mShaderProgram = mShaderInterface->getShaderProgram();
 
       glGenVertexArrays(1, &mVertexArrayObject);
-      glBindVertexArray(mVertexArrayObject);
+      bindVertexArray(mVertexArrayObject);
 
       glGenBuffers(1, &mVertexBufferObject);
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-      glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
+      glBufferData(GL_ARRAY_BUFFER, sizeof(struct vertex_info) * vertexNum, vertexData,
+                   GL_STATIC_DRAW);
 
       glGenBuffers(1, &mIndexBufferObject);
       glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBufferObject);
-      glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indexData), indexData, GL_STATIC_DRAW);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indexNum, indexData,
+                   GL_STATIC_DRAW);
 
       // get the location of the "modelview" uniform
-      mModelViewLocation = glGetUniformLocation (mShaderProgram, "modelview");
+      mModelViewLocation = mShaderInterface->getUniformLocation("modelview");
 
       // get the location of the "projection" uniform
-      mProjectionLocation = glGetUniformLocation (mShaderProgram, "projection");
+      mProjectionLocation = mShaderInterface->getUniformLocation("projection");
 
       // get the location of the "position" and "color" attributes
-      GLint positionLocation = glGetAttribLocation (mShaderProgram, "position");
-      GLint colorLocation = glGetAttribLocation (mShaderProgram, "color");
+      GLint positionLocation = mShaderInterface->getAttribLocation("position");
+      GLint colorLocation = mShaderInterface->getAttribLocation("color");
 
       glEnableVertexAttribArray(0);
       glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
@@ -139,24 +125,62 @@ namespace ibc { namespace gl { namespace model
     // -------------------------------------------------------------------------
     virtual void drawModel(const GLfloat inModelView[16], const GLfloat inProjection[16])
     {
-      glUseProgram(mShaderProgram);
-      glUniformMatrix4fv(mModelViewLocation, 1, GL_FALSE, &(inModelView[0]));
-      glUniformMatrix4fv(mProjectionLocation, 1, GL_FALSE, &(inProjection[0]));
-      glBindVertexArray(mVertexArrayObject);
+      useProgram(mShaderProgram);
+      setMatrixUniforms(mModelViewLocation, mProjectionLocation, inModelView, inProjection);
+      bindVertexArray(mVertexArrayObject);
       glDrawElements(GL_LINES, 18, GL_UNSIGNED_INT, 0);
     }
 
-  protected:
-    // structs -----------------------------------------------------------------
+    // Static Member functions -------------------------------------------------
     // -------------------------------------------------------------------------
-    // vertex_info
+    // getVertexData
     // -------------------------------------------------------------------------
-    struct vertex_info
+    // The geometry of the axis (also drawn by InstancedPrimitives)
+    static const struct vertex_info *getVertexData(size_t *outNum)
     {
-      GLfloat position[3];
-      GLfloat color[3];
-    };
+      static const struct vertex_info vertexData[] =
+      {
+        { { -1.0f,  0.0f,  0.0f }, { 1.0f, 0.7f, 0.7f } },
+        { {  1.0f,  0.0f,  0.0f }, { 1.0f, 0.0f, 0.0f } },
+        { {  0.0f, -1.0f,  0.0f }, { 0.7f, 1.0f, 0.7f } },
+        { {  0.0f,  1.0f,  0.0f }, { 0.0f, 1.0f, 0.0f } },
+        { {  0.0f,  0.0f, -1.0f }, { 0.7f, 0.7f, 1.0f } },
+        { {  0.0f,  0.0f,  1.0f }, { 0.0f, 0.0f, 1.0f } },
+        //
+        { {  0.95f,  0.025f,  0.0f }, { 1.0f, 0.0f, 0.0f } },
+        { {  0.95f, -0.025f,  0.0f }, { 1.0f, 0.0f, 0.0f } },
 
+        { {  0.025f,  0.95f,  0.0f }, { 0.0f, 1.0f, 0.0f } },
+        { { -0.025f,  0.95f,  0.0f }, { 0.0f, 1.0f, 0.0f } },
+        { {  0.0f,  0.025f,  0.95f }, { 0.0f, 0.0f, 1.0f } },
+        { {  0.0f, -0.025f,  0.95f }, { 0.0f, 0.0f, 1.0f } }
+      };
+      *outNum = sizeof(vertexData) / sizeof(vertexData[0]);
+      return vertexData;
+    }
+    // -------------------------------------------------------------------------
+    // getIndexData
+    // -------------------------------------------------------------------------
+    static const GLuint *getIndexData(size_t *outNum)
+    {
+      static const GLuint indexData[] =
+      {
+        0, 1,
+        2, 3,
+        4, 5,
+        //
+        1, 6,
+        1, 7,
+        3, 8,
+        3, 9,
+        5, 10,
+        5, 11
+      };
+      *outNum = sizeof(indexData) / sizeof(indexData[0]);
+      return indexData;
+    }
+
+  protected:
     // Member variables --------------------------------------------------------
     GLuint mShaderProgram;
     GLuint mVertexArrayObject;
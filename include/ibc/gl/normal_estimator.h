@@ -0,0 +1,402 @@
+// =============================================================================
+//  normal_estimator.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/normal_estimator.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the normal estimation of the point clouds
+*/
+
+#ifndef IBC_GL_NORMAL_ESTIMATOR_H_
+#define IBC_GL_NORMAL_ESTIMATOR_H_
+
+// Includes --------------------------------------------------------------------
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "ibc/base/types.h"
+#include "ibc/base/parallel.h"
+#include "ibc/gl/data.h"
+#include "ibc/gl/kd_tree.h"
+#include "ibc/gl/vector.h"
+
+// Macros ----------------------------------------------------------------------
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define IBC_GL_NORMAL_ESTIMATOR_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // NormalEstimator class
+  // ---------------------------------------------------------------------------
+  // Estimates the normals of the points:
+  //  estimate()          : PCA of the k nearest neighbors (unorganized clouds)
+  //  estimateOrganized() : the cross product of the neighbors on the grid
+  //                        (the back projected depth images)
+  //  estimateHeightMap() : the gradient of the height map (SurfacePoints)
+  // With inViewpoint, the normals are flipped to face the viewpoint.
+  // The normals of the NaN points (or with too few neighbors) are (0, 0, 0).
+  // All the functions run on multiple threads.
+  class NormalEstimator
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static const size_t  MIN_TASK_SIZE = 16 * 1024;  // points per thread
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // estimate
+    // -------------------------------------------------------------------------
+    // Writes the normals to the vertex structs with a normal (in place)
+    template <typename DataType>
+    static bool estimate(DataType *ioDataPtr, size_t inDataNum, size_t inK,
+                         const GLfloat *inViewpoint = NULL, unsigned int inTaskNum = 0)
+    {
+      static_assert(VertexTraits<DataType>::NORMAL_OFFSET >= 0, "DataType has no normal");
+      return estimate(ioDataPtr, sizeof(DataType), inDataNum, inK,
+                      ((GLfloat *)ioDataPtr) + VertexTraits<DataType>::NORMAL_OFFSET,
+                      sizeof(DataType), inViewpoint, inTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // estimate
+    // -------------------------------------------------------------------------
+    // The strided version. The normals (3 GLfloat) are written to outNormalPtr
+    // with inNormalStride. inKdTree can be the tree of the same points built
+    // beforehand (NULL : built here)
+    static bool estimate(const void *inDataPtr, size_t inStride, size_t inDataNum, size_t inK,
+                         GLfloat *outNormalPtr, size_t inNormalStride,
+                         const GLfloat *inViewpoint = NULL, unsigned int inTaskNum = 0,
+                         const KdTree *inKdTree = NULL)
+    {
+      if (inDataPtr == NULL || inDataNum == 0 || inK < 3)
+        return false;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inDataNum, MIN_TASK_SIZE);
+      KdTree  tree;
+      if (inKdTree == NULL)
+      {
+        if (tree.build(inDataPtr, inStride, inDataNum, KdTree::DEFAULT_LEAF_SIZE,
+                       inTaskNum) == false)
+          return false;
+        inKdTree = &tree;
+      }
+      const unsigned char *data = (const unsigned char *)inDataPtr;
+      Parallel::forEachTask(inDataNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          std::vector<std::pair<GLfloat, size_t>> heap;
+          std::vector<size_t>   indices(inK);
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            const GLfloat *p = (const GLfloat *)(data + inStride * i);
+            GLfloat *n = (GLfloat *)(((unsigned char *)outNormalPtr) + inNormalStride * i);
+            size_t  num = inKdTree->findKNearest(p, inK, indices.data(), NULL,
+                                                 std::numeric_limits<GLfloat>::infinity(),
+                                                 &heap);
+            GLfloat cov[6];
+            if (num < 3 ||
+                calcCovariance(data, inStride, indices.data(), num, p, cov) == false ||
+                calcSmallestEigenVector(cov, n) == false)
+            {
+              n[0] = n[1] = n[2] = 0;
+              continue;
+            }
+            if (inViewpoint != NULL)
+              orientNormal(p, inViewpoint, n);
+          }
+        });
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // estimateOrganized
+    // -------------------------------------------------------------------------
+    // inWidth x inHeight points in the row major order (in place)
+    template <typename DataType>
+    static bool estimateOrganized(DataType *ioDataPtr, size_t inWidth, size_t inHeight,
+                                  const GLfloat *inViewpoint = NULL, unsigned int inTaskNum = 0)
+    {
+      static_assert(VertexTraits<DataType>::NORMAL_OFFSET >= 0, "DataType has no normal");
+      return estimateOrganized(ioDataPtr, sizeof(DataType), inWidth, inHeight,
+                               ((GLfloat *)ioDataPtr) + VertexTraits<DataType>::NORMAL_OFFSET,
+                               sizeof(DataType), inViewpoint, inTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // estimateOrganized
+    // -------------------------------------------------------------------------
+    // n = (lower - upper) x (right - left) with the central differences (or
+    // the one side ones next to the NaN points and the edges). Without
+    // inViewpoint, the normals face +z when x grows with the column and y
+    // decreases with the row (the image layout in the y up space)
+    static bool estimateOrganized(const void *inDataPtr, size_t inStride,
+                                  size_t inWidth, size_t inHeight,
+                                  GLfloat *outNormalPtr, size_t inNormalStride,
+                                  const GLfloat *inViewpoint = NULL, unsigned int inTaskNum = 0)
+    {
+      if (inDataPtr == NULL || inWidth == 0 || inHeight == 0)
+        return false;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inWidth * inHeight, MIN_TASK_SIZE * 4);
+      const unsigned char *data = (const unsigned char *)inDataPtr;
+      auto  getPoint = [&](size_t inX, size_t inY)
+      {
+        const GLfloat *p = (const GLfloat *)(data + inStride * (inY * inWidth + inX));
+        return KdTree::isValidPoint(p) ? p : NULL;
+      };
+      Parallel::forEachTask(inHeight, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t y = inBegin; y < inEnd; y++)
+            for (size_t x = 0; x < inWidth; x++)
+            {
+              const GLfloat *p = getPoint(x, y);
+              GLfloat *n = (GLfloat *)(((unsigned char *)outNormalPtr) +
+                                       inNormalStride * (y * inWidth + x));
+              GLfloat dx[3], dy[3];
+              if (p == NULL ||
+                  calcDifference(p, (x > 0) ? getPoint(x - 1, y) : NULL,
+                                 (x + 1 < inWidth) ? getPoint(x + 1, y) : NULL, dx) == false ||
+                  calcDifference(p, (y > 0) ? getPoint(x, y - 1) : NULL,
+                                 (y + 1 < inHeight) ? getPoint(x, y + 1) : NULL, dy) == false)
+              {
+                n[0] = n[1] = n[2] = 0;
+                continue;
+              }
+              n[0] = -(dx[1] * dy[2] - dx[2] * dy[1]);
+              n[1] = -(dx[2] * dy[0] - dx[0] * dy[2]);
+              n[2] = -(dx[0] * dy[1] - dx[1] * dy[0]);
+              if (VectorBase<GLfloat>::normalize(n) == false)
+                continue;   // (0, 0, 0)
+              if (inViewpoint != NULL)
+                orientNormal(p, inViewpoint, n);
+            }
+        });
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // estimateHeightMap
+    // -------------------------------------------------------------------------
+    // The normals of the surface z = value * inZScale on the grid of
+    // (inPitchX, inPitchY), e.g. inPitchX = inPitchY = 2.0 / width and
+    // inZScale = zGain for SurfacePoints. outNormalPtr has inWidth x inHeight
+    // normals (3 GLfloat with inNormalStride)
+    template <typename ValueType>
+    static bool estimateHeightMap(const ValueType *inDataPtr, size_t inWidth, size_t inHeight,
+                                  GLfloat inPitchX, GLfloat inPitchY, GLfloat inZScale,
+                                  GLfloat *outNormalPtr, size_t inNormalStride = sizeof(GLfloat) * 3,
+                                  unsigned int inTaskNum = 0)
+    {
+      if (inDataPtr == NULL || inWidth == 0 || inHeight == 0)
+        return false;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inWidth * inHeight, MIN_TASK_SIZE * 4);
+      Parallel::forEachTask(inHeight, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t y = inBegin; y < inEnd; y++)
+          {
+            size_t  y0 = (y > 0) ? y - 1 : y;
+            size_t  y1 = (y + 1 < inHeight) ? y + 1 : y;
+            for (size_t x = 0; x < inWidth; x++)
+            {
+              size_t  x0 = (x > 0) ? x - 1 : x;
+              size_t  x1 = (x + 1 < inWidth) ? x + 1 : x;
+              GLfloat *n = (GLfloat *)(((unsigned char *)outNormalPtr) +
+                                       inNormalStride * (y * inWidth + x));
+              GLfloat dzdx = 0, dzdy = 0;
+              if (x1 != x0)
+                dzdx = ((GLfloat )inDataPtr[y * inWidth + x1] -
+                        (GLfloat )inDataPtr[y * inWidth + x0]) * inZScale /
+                       (inPitchX * (x1 - x0));
+              if (y1 != y0)
+                dzdy = ((GLfloat )inDataPtr[y1 * inWidth + x] -
+                        (GLfloat )inDataPtr[y0 * inWidth + x]) * inZScale /
+                       (inPitchY * (y1 - y0));
+              n[0] = -dzdx;
+              n[1] = -dzdy;
+              n[2] = 1;
+              VectorBase<GLfloat>::normalize(n);
+            }
+          }
+        });
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // calcSmallestEigenVector
+    // -------------------------------------------------------------------------
+    // The unit eigen vector of the smallest eigen value of the symmetric 3x3
+    // matrix {xx, yy, zz, xy, yz, zx} (the closed form solution)
+    static bool calcSmallestEigenVector(const GLfloat inCov[6], GLfloat outVec[3])
+    {
+      double  a00 = inCov[0], a11 = inCov[1], a22 = inCov[2];
+      double  a01 = inCov[3], a12 = inCov[4], a02 = inCov[5];
+      double  scale = std::max(std::max(std::fabs(a00), std::fabs(a11)),
+                               std::max(std::fabs(a22), std::max(std::fabs(a01),
+                               std::max(std::fabs(a12), std::fabs(a02)))));
+      if (!(scale > 0))
+        return false;
+      // Scaled to avoid the underflow of the small clouds
+      a00 /= scale; a11 /= scale; a22 /= scale;
+      a01 /= scale; a12 /= scale; a02 /= scale;
+
+      double  eigen;
+      double  p1 = a01 * a01 + a02 * a02 + a12 * a12;
+      double  q = (a00 + a11 + a22) / 3.0;
+      double  p2 = (a00 - q) * (a00 - q) + (a11 - q) * (a11 - q) +
+                   (a22 - q) * (a22 - q) + 2.0 * p1;
+      double  p = std::sqrt(p2 / 6.0);
+      if (p == 0)
+        return false;   // isotropic
+      double  b00 = (a00 - q) / p, b11 = (a11 - q) / p, b22 = (a22 - q) / p;
+      double  b01 = a01 / p, b12 = a12 / p, b02 = a02 / p;
+      double  r = (b00 * (b11 * b22 - b12 * b12) - b01 * (b01 * b22 - b12 * b02) +
+                   b02 * (b01 * b12 - b11 * b02)) / 2.0;
+      r = std::min(std::max(r, -1.0), 1.0);
+      double  phi = std::acos(r) / 3.0;
+      eigen = q + 2.0 * p * std::cos(phi + 2.0 * M_PI / 3.0);
+
+      // The cross product of the two rows of (A - eigen * I) with the largest norm
+      double  rows[3][3] = {{a00 - eigen, a01, a02},
+                            {a01, a11 - eigen, a12},
+                            {a02, a12, a22 - eigen}};
+      double  best[3] = {0, 0, 0};
+      double  bestLen2 = 0;
+      for (int i = 0; i < 3; i++)
+      {
+        const double  *u = rows[i];
+        const double  *v = rows[(i + 1) % 3];
+        double  c[3] = {u[1] * v[2] - u[2] * v[1],
+                        u[2] * v[0] - u[0] * v[2],
+                        u[0] * v[1] - u[1] * v[0]};
+        double  len2 = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+        if (len2 > bestLen2)
+        {
+          bestLen2 = len2;
+          std::copy(c, c + 3, best);
+        }
+      }
+      if (!(bestLen2 > 0))
+        return false;
+      double  len = std::sqrt(bestLen2);
+      for (int i = 0; i < 3; i++)
+        outVec[i] = (GLfloat )(best[i] / len);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // orientNormal
+    // -------------------------------------------------------------------------
+    // Flips ioNormal to face inViewpoint
+    static void orientNormal(const GLfloat inPoint[3], const GLfloat inViewpoint[3],
+                             GLfloat ioNormal[3])
+    {
+      GLfloat dot = (inViewpoint[0] - inPoint[0]) * ioNormal[0] +
+                    (inViewpoint[1] - inPoint[1]) * ioNormal[1] +
+                    (inViewpoint[2] - inPoint[2]) * ioNormal[2];
+      if (dot < 0)
+      {
+        ioNormal[0] = -ioNormal[0];
+        ioNormal[1] = -ioNormal[1];
+        ioNormal[2] = -ioNormal[2];
+      }
+    }
+
+  protected:
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // calcCovariance
+    // -------------------------------------------------------------------------
+    // The covariance {xx, yy, zz, xy, yz, zx} of the points inIndices.
+    // The points are relative to inCenter for the precision
+    static bool calcCovariance(const unsigned char *inDataPtr, size_t inStride,
+                               const size_t *inIndices, size_t inNum,
+                               const GLfloat inCenter[3], GLfloat outCov[6])
+    {
+      GLfloat sum[4], sq[4], cross[4];
+#ifdef IBC_GL_NORMAL_ESTIMATOR_USE_SSE
+      // sum += v, sq += v * v, cross += v * (y, z, x)
+      __m128  center = _mm_set_ps(0, inCenter[2], inCenter[1], inCenter[0]);
+      __m128  sumV = _mm_setzero_ps();
+      __m128  sqV = _mm_setzero_ps();
+      __m128  crossV = _mm_setzero_ps();
+      for (size_t i = 0; i < inNum; i++)
+      {
+        const GLfloat *p = (const GLfloat *)(inDataPtr + inStride * inIndices[i]);
+        // Only xyz is loaded (the next float can be the normal written by
+        // another thread in the in-place estimate())
+        __m128  v = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)p);
+        v = _mm_movelh_ps(v, _mm_load_ss(p + 2));
+        v = _mm_sub_ps(v, center);
+        sumV = _mm_add_ps(sumV, v);
+        sqV = _mm_add_ps(sqV, _mm_mul_ps(v, v));
+        crossV = _mm_add_ps(crossV,
+                            _mm_mul_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1))));
+      }
+      _mm_storeu_ps(sum, sumV);
+      _mm_storeu_ps(sq, sqV);
+      _mm_storeu_ps(cross, crossV);
+#else
+      for (int j = 0; j < 3; j++)
+        sum[j] = sq[j] = cross[j] = 0;
+      for (size_t i = 0; i < inNum; i++)
+      {
+        const GLfloat *p = (const GLfloat *)(inDataPtr + inStride * inIndices[i]);
+        GLfloat v[3] = {p[0] - inCenter[0], p[1] - inCenter[1], p[2] - inCenter[2]};
+        for (int j = 0; j < 3; j++)
+        {
+          sum[j] += v[j];
+          sq[j] += v[j] * v[j];
+          cross[j] += v[j] * v[(j + 1) % 3];
+        }
+      }
+#endif
+      if (inNum == 0)
+        return false;
+      GLfloat scale = 1.0f / (GLfloat )inNum;
+      GLfloat mean[3] = {sum[0] * scale, sum[1] * scale, sum[2] * scale};
+      for (int j = 0; j < 3; j++)
+      {
+        outCov[j]     = sq[j] * scale - mean[j] * mean[j];
+        outCov[j + 3] = cross[j] * scale - mean[j] * mean[(j + 1) % 3];
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // calcDifference
+    // -------------------------------------------------------------------------
+    // The central difference (or the one side one) of the grid neighbors
+    static bool calcDifference(const GLfloat inCenter[3], const GLfloat *inPrev,
+                               const GLfloat *inNext, GLfloat outDiff[3])
+    {
+      if (inPrev == NULL && inNext == NULL)
+        return false;
+      const GLfloat *a = (inPrev != NULL) ? inPrev : inCenter;
+      const GLfloat *b = (inNext != NULL) ? inNext : inCenter;
+      for (int i = 0; i < 3; i++)
+        outDiff[i] = b[i] - a[i];
+      return true;
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_NORMAL_ESTIMATOR_H_
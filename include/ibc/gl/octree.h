@@ -0,0 +1,533 @@
+// =============================================================================
+//  octree.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/octree.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the level of detail (LOD) point octree
+*/
+
+#ifndef IBC_GL_OCTREE_H_
+#define IBC_GL_OCTREE_H_
+
+// Includes --------------------------------------------------------------------
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <vector>
+#include <algorithm>
+#include "ibc/base/types.h"
+#include "ibc/base/parallel.h"
+#include "ibc/gl/data.h"
+#include "ibc/gl/bounding_box.h"
+#include "ibc/gl/frustum.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // Octree class
+  // ---------------------------------------------------------------------------
+  // The points are sorted in the Morton (z-order) and each node owns a
+  // contiguous range of the reordered array:
+  //  - an inner node owns a uniform subsample of the points in its cell
+  //  - a leaf node owns all the rest
+  // Drawing a node and all its ancestors shows every point in the cell, so
+  // the LOD is refined by just adding the children's ranges (additive LOD).
+  // Since the nodes are plain (first, count) ranges of one array, the array
+  // and the node list can be saved and paged as they are.
+  class Octree
+  {
+  public:
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      GLfloat minMax[6];    // cell bounds {x_min, x_max, y_min, y_max, z_min, z_max}
+      GLfloat spacing;      // approximate point spacing of the owned points
+      GLuint  first;        // owned range of the reordered array
+      GLuint  count;
+      GLuint  level;
+      GLuint  children[8];  // 0 : no child (the root is never a child)
+    } Node;
+
+    // Constants ---------------------------------------------------------------
+    static const int     MAX_LEVEL      = 21;   // 21 bits per axis (63bit code)
+    static const size_t  MIN_TASK_SIZE  = 256 * 1024;
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // Octree
+    // -------------------------------------------------------------------------
+    Octree()
+    {
+    }
+    // -------------------------------------------------------------------------
+    // ~Octree
+    // -------------------------------------------------------------------------
+    virtual ~Octree()
+    {
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // build
+    // -------------------------------------------------------------------------
+    // inNodeSampleNum : the points owned by an inner node
+    // inMaxLeafNum    : a node which has fewer points than this is not split
+    // NaN points are dropped.
+    bool build(const glXYZf_RGBAub *inDataPtr, size_t inDataNum,
+               size_t inNodeSampleNum = 4096, size_t inMaxLeafNum = 16384,
+               unsigned int inTaskNum = 0)
+    {
+      clear();
+      if (inDataPtr == NULL || inDataNum == 0 || inDataNum > (size_t )INT32_MAX)
+        return false;
+      if (inNodeSampleNum == 0)
+        inNodeSampleNum = 1;
+      if (inMaxLeafNum < inNodeSampleNum)
+        inMaxLeafNum = inNodeSampleNum;
+      mNodeSampleNum = inNodeSampleNum;
+      mMaxLeafNum = inMaxLeafNum;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inDataNum, MIN_TASK_SIZE);
+
+      // The root cell (cube)
+      GLfloat minMax[6];
+      if (BoundingBox::calcMinMax(inDataPtr, inDataNum, minMax, inTaskNum) == false)
+        return false;
+      GLfloat size = 0;
+      for (int i = 0; i < 3; i++)
+        if (minMax[i * 2 + 1] - minMax[i * 2] > size)
+          size = minMax[i * 2 + 1] - minMax[i * 2];
+      size = (size > 0) ? size * 1.0001f : 1.0f;
+      GLfloat rootMin[3];
+      for (int i = 0; i < 3; i++)
+        rootMin[i] = (minMax[i * 2] + minMax[i * 2 + 1] - size) / 2.0f;
+
+      // Morton codes and sort
+      std::vector<MortonItem> items(inDataNum);
+      GLfloat gain = (GLfloat )(1 << MAX_LEVEL) / size;
+      Parallel::forEachTask(inDataNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            items[i].code  = calcMortonCode(&(inDataPtr[i].x), rootMin, gain);
+            items[i].index = (uint32_t )i;
+          }
+        });
+      Parallel::sort(items.begin(), items.end(),
+        [](const MortonItem &inA, const MortonItem &inB)
+        {
+          if (inA.code != inB.code)
+            return inA.code < inB.code;
+          return inA.index < inB.index;
+        }, 0, inTaskNum);
+      while (items.empty() == false && items.back().code == INVALID_CODE)
+        items.pop_back();
+      if (items.empty())
+        return false;
+
+      // The nodes (the root, then the subtrees in parallel)
+      std::vector<MortonItem> temp;
+      size_t  childBegins[9];
+      buildNode(&items, &temp, 0, items.size(), 0, rootMin, size, &mNodes, childBegins);
+      std::vector<std::vector<Node>>  subtrees(8);
+      Parallel::forEachTask(8, std::min(inTaskNum, 8u),
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          std::vector<MortonItem> localTemp;
+          for (size_t d = inBegin; d < inEnd; d++)
+          {
+            if (childBegins[d] == childBegins[d + 1])
+              continue;
+            GLfloat childMin[3];
+            getChildMin(rootMin, size, (int )d, childMin);
+            buildSubtree(&items, &localTemp, childBegins[d], childBegins[d + 1], 1,
+                         childMin, size / 2.0f, &(subtrees[d]));
+          }
+        });
+      for (int d = 0; d < 8; d++)
+      {
+        if (subtrees[d].empty())
+          continue;
+        GLuint  base = (GLuint )mNodes.size();
+        for (size_t i = 0; i < subtrees[d].size(); i++)
+        {
+          Node  node = subtrees[d][i];
+          for (int c = 0; c < 8; c++)
+            if (node.children[c] != 0)
+              node.children[c] += base;
+          mNodes.push_back(node);
+        }
+        mNodes[0].children[d] = base;
+      }
+
+      // The reordered data
+      mData.resize(items.size());
+      Parallel::forEachTask(items.size(), inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t i = inBegin; i < inEnd; i++)
+            mData[i] = inDataPtr[items[i].index];
+        });
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // clear
+    // -------------------------------------------------------------------------
+    void clear()
+    {
+      mData.clear();
+      mNodes.clear();
+    }
+    // -------------------------------------------------------------------------
+    // getData
+    // -------------------------------------------------------------------------
+    // The reordered points (the nodes refer to this array)
+    const glXYZf_RGBAub *getData() const
+    {
+      return mData.data();
+    }
+    // -------------------------------------------------------------------------
+    // getDataNum
+    // -------------------------------------------------------------------------
+    size_t getDataNum() const
+    {
+      return mData.size();
+    }
+    // -------------------------------------------------------------------------
+    // getNodes
+    // -------------------------------------------------------------------------
+    const std::vector<Node> &getNodes() const
+    {
+      return mNodes;
+    }
+    // -------------------------------------------------------------------------
+    // selectNodes
+    // -------------------------------------------------------------------------
+    // Selects the visible nodes, coarse to fine in the order of the screen
+    // space error, until the error is below inMaxScreenError (pixels) or the
+    // point budget is used up. The result can be passed to glMultiDrawArrays().
+    // inFitParam is the model fit parameter of the point cloud shaders
+    // (NULL : no fit). Returns the number of the selected points.
+    // The root is always selected (as a whole, its points are a subsample
+    // in the Morton order and a part of them covers only a part of the cell),
+    // so the budget is at least the number of the root points.
+    size_t selectNodes(const GLfloat inModelView[16], const GLfloat inProjection[16],
+                       const GLfloat inFitParam[4], GLfloat inViewportHeight,
+                       GLfloat inMaxScreenError, size_t inPointBudget,
+                       std::vector<GLint> *outFirsts, std::vector<GLsizei> *outCounts) const
+    {
+      outFirsts->clear();
+      outCounts->clear();
+      if (mNodes.empty())
+        return 0;
+      Frustum frustum;
+      frustum.set(inModelView, inProjection);
+      ViewInfo  view;
+      initViewInfo(inModelView, inProjection, inFitParam, inViewportHeight, &view);
+      //
+      std::priority_queue<Candidate> queue;
+      Candidate root;
+      if (testNode(0, frustum, view, false, &root) == false)
+        return 0;
+      queue.push(root);
+      size_t  total = 0;
+      while (queue.empty() == false)
+      {
+        Candidate candidate = queue.top();
+        queue.pop();
+        const Node &node = mNodes[candidate.index];
+        if (total != 0 && total + node.count > inPointBudget)
+          break;
+        total += node.count;
+        outFirsts->push_back((GLint )node.first);
+        outCounts->push_back((GLsizei )node.count);
+        if (candidate.error <= inMaxScreenError)
+          continue;
+        for (int c = 0; c < 8; c++)
+        {
+          Candidate child;
+          if (node.children[c] != 0 &&
+              testNode(node.children[c], frustum, view, candidate.isInside, &child))
+            queue.push(child);
+        }
+      }
+      return total;
+    }
+
+  protected:
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      uint64_t  code;
+      uint32_t  index;
+    } MortonItem;
+    typedef struct
+    {
+      GLfloat modelView[16];
+      GLfloat fit[4];
+      GLfloat modelViewScale;
+      GLfloat pixelScale;     // pixels per unit length at distance 1
+      bool    isOrtho;
+    } ViewInfo;
+    struct Candidate
+    {
+      GLfloat error;
+      GLuint  index;
+      bool    isInside;
+      bool operator<(const Candidate &inCandidate) const
+      {
+        return error < inCandidate.error;
+      }
+    };
+
+    // Constants ---------------------------------------------------------------
+    static const uint64_t  INVALID_CODE = ~((uint64_t )0);
+
+    // Member variables --------------------------------------------------------
+    std::vector<glXYZf_RGBAub>  mData;
+    std::vector<Node>  mNodes;
+    size_t  mNodeSampleNum;
+    size_t  mMaxLeafNum;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // buildSubtree
+    // -------------------------------------------------------------------------
+    void buildSubtree(std::vector<MortonItem> *ioItems, std::vector<MortonItem> *ioTemp,
+                      size_t inBegin, size_t inEnd, GLuint inLevel,
+                      const GLfloat inCellMin[3], GLfloat inCellSize,
+                      std::vector<Node> *ioNodes)
+    {
+      size_t  childBegins[9];
+      size_t  index = buildNode(ioItems, ioTemp, inBegin, inEnd, inLevel,
+                                inCellMin, inCellSize, ioNodes, childBegins);
+      for (int d = 0; d < 8; d++)
+      {
+        if (childBegins[d] == childBegins[d + 1])
+          continue;
+        GLfloat childMin[3];
+        getChildMin(inCellMin, inCellSize, d, childMin);
+        GLuint  childIndex = (GLuint )ioNodes->size();
+        buildSubtree(ioItems, ioTemp, childBegins[d], childBegins[d + 1], inLevel + 1,
+                     childMin, inCellSize / 2.0f, ioNodes);
+        (*ioNodes)[index].children[d] = childIndex;
+      }
+    }
+    // -------------------------------------------------------------------------
+    // buildNode
+    // -------------------------------------------------------------------------
+    // Moves the owned points to the front of [inBegin, inEnd) and returns
+    // the ranges of the children in outChildBegins[0..8]
+    size_t buildNode(std::vector<MortonItem> *ioItems, std::vector<MortonItem> *ioTemp,
+                     size_t inBegin, size_t inEnd, GLuint inLevel,
+                     const GLfloat inCellMin[3], GLfloat inCellSize,
+                     std::vector<Node> *ioNodes, size_t outChildBegins[9])
+    {
+      size_t  num = inEnd - inBegin;
+      size_t  owned = num;
+      if (num > mMaxLeafNum && inLevel < MAX_LEVEL)
+      {
+        // Every k-th point in the Morton order is a uniform subsample
+        size_t  k = (num + mNodeSampleNum - 1) / mNodeSampleNum;
+        MortonItem  *items = &((*ioItems)[inBegin]);
+        ioTemp->assign(items, items + num);
+        owned = 0;
+        for (size_t i = 0; i < num; i += k)
+          items[owned++] = (*ioTemp)[i];
+        size_t  j = owned;
+        for (size_t i = 0; i < num; i++)
+          if (i % k != 0)
+            items[j++] = (*ioTemp)[i];
+      }
+      //
+      Node  node;
+      for (int i = 0; i < 3; i++)
+      {
+        node.minMax[i * 2]     = inCellMin[i];
+        node.minMax[i * 2 + 1] = inCellMin[i] + inCellSize;
+      }
+      node.spacing = inCellSize / std::sqrt((GLfloat )owned);
+      node.first = (GLuint )inBegin;
+      node.count = (GLuint )owned;
+      node.level = inLevel;
+      for (int c = 0; c < 8; c++)
+        node.children[c] = 0;
+      size_t  index = ioNodes->size();
+      ioNodes->push_back(node);
+      //
+      // The rest is still sorted, so the children are found by the digit
+      int  shift = 3 * (MAX_LEVEL - 1 - (int )inLevel);
+      std::vector<MortonItem>::iterator it = ioItems->begin() + inBegin + owned;
+      std::vector<MortonItem>::iterator end = ioItems->begin() + inEnd;
+      outChildBegins[0] = inBegin + owned;
+      for (int d = 0; d < 8; d++)
+      {
+        if (shift >= 0)
+          it = std::partition_point(it, end,
+                  [shift, d](const MortonItem &inItem)
+                  {
+                    return (int )((inItem.code >> shift) & 7) <= d;
+                  });
+        else
+          it = end;
+        outChildBegins[d + 1] = it - ioItems->begin();
+      }
+      return index;
+    }
+    // -------------------------------------------------------------------------
+    // initViewInfo
+    // -------------------------------------------------------------------------
+    static void initViewInfo(const GLfloat inModelView[16], const GLfloat inProjection[16],
+                             const GLfloat inFitParam[4], GLfloat inViewportHeight,
+                             ViewInfo *outView)
+    {
+      ::memcpy(outView->modelView, inModelView, sizeof(GLfloat) * 16);
+      if (inFitParam != NULL)
+        ::memcpy(outView->fit, inFitParam, sizeof(GLfloat) * 4);
+      else
+      {
+        outView->fit[0] = outView->fit[1] = outView->fit[2] = 0;
+        outView->fit[3] = 1;
+      }
+      outView->modelViewScale = getModelViewScale(inModelView);
+      outView->isOrtho = (inProjection[15] == 1.0f);
+      outView->pixelScale = std::fabs(inProjection[5]) * inViewportHeight / 2.0f *
+                            outView->modelViewScale * std::fabs(outView->fit[3]);
+    }
+    // -------------------------------------------------------------------------
+    // testNode
+    // -------------------------------------------------------------------------
+    // Returns false if the node is outside of the frustum
+    bool testNode(GLuint inIndex, const Frustum &inFrustum, const ViewInfo &inView,
+                  bool inIsParentInside, Candidate *outCandidate) const
+    {
+      const Node &node = mNodes[inIndex];
+      // The cell in the space after the model fit
+      GLfloat box[6];
+      for (int i = 0; i < 3; i++)
+      {
+        box[i * 2]     = (node.minMax[i * 2]     + inView.fit[i]) * inView.fit[3];
+        box[i * 2 + 1] = (node.minMax[i * 2 + 1] + inView.fit[i]) * inView.fit[3];
+      }
+      outCandidate->index = inIndex;
+      outCandidate->isInside = inIsParentInside;
+      if (inIsParentInside == false)
+      {
+        Frustum::TestResult result = inFrustum.testBox(box);
+        if (result == Frustum::OUTSIDE)
+          return false;
+        outCandidate->isInside = (result == Frustum::INSIDE);
+      }
+      //
+      GLfloat pixels = node.spacing * inView.pixelScale;
+      if (inView.isOrtho == false)
+      {
+        // The distance from the eye to the cell (minus the radius)
+        GLfloat center[3], radius = 0;
+        for (int i = 0; i < 3; i++)
+        {
+          center[i] = (box[i * 2] + box[i * 2 + 1]) / 2.0f;
+          GLfloat half = (box[i * 2 + 1] - box[i * 2]) / 2.0f;
+          radius += half * half;
+        }
+        const GLfloat *m = inView.modelView;
+        GLfloat dist = 0;
+        for (int i = 0; i < 3; i++)
+        {
+          GLfloat v = m[i] * center[0] + m[4 + i] * center[1] + m[8 + i] * center[2] + m[12 + i];
+          dist += v * v;
+        }
+        dist = std::sqrt(dist) - std::sqrt(radius) * inView.modelViewScale;
+        if (dist <= 1e-6f)
+          pixels = std::numeric_limits<GLfloat>::max();
+        else
+          pixels /= dist;
+      }
+      outCandidate->error = pixels;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // getModelViewScale
+    // -------------------------------------------------------------------------
+    // The modelview may have a scale (the length of the first column)
+    static GLfloat getModelViewScale(const GLfloat inModelView[16])
+    {
+      return std::sqrt(inModelView[0] * inModelView[0] +
+                       inModelView[1] * inModelView[1] +
+                       inModelView[2] * inModelView[2]);
+    }
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getChildMin
+    // -------------------------------------------------------------------------
+    static void getChildMin(const GLfloat inCellMin[3], GLfloat inCellSize, int inDigit,
+                            GLfloat outChildMin[3])
+    {
+      for (int i = 0; i < 3; i++)
+        outChildMin[i] = inCellMin[i] + (((inDigit >> i) & 1) ? inCellSize / 2.0f : 0);
+    }
+    // -------------------------------------------------------------------------
+    // calcMortonCode
+    // -------------------------------------------------------------------------
+    // x : bit 0, y : bit 1, z : bit 2 of each 3bit digit
+    static uint64_t calcMortonCode(const GLfloat inXYZ[3], const GLfloat inRootMin[3],
+                                   GLfloat inGain)
+    {
+      uint64_t  code = 0;
+      const uint32_t maxValue = (1u << MAX_LEVEL) - 1;
+      for (int i = 0; i < 3; i++)
+      {
+        GLfloat v = (inXYZ[i] - inRootMin[i]) * inGain;
+        if (std::isnan(v))
+          return INVALID_CODE;
+        uint32_t  q;
+        if (v <= 0)
+          q = 0;
+        else if (v >= (GLfloat )maxValue)
+          q = maxValue;
+        else
+          q = (uint32_t )v;
+        code |= spreadBits(q) << i;
+      }
+      return code;
+    }
+    // -------------------------------------------------------------------------
+    // spreadBits
+    // -------------------------------------------------------------------------
+    // Inserts two zero bits between each of the lower 21 bits
+    static uint64_t spreadBits(uint32_t inValue)
+    {
+      uint64_t  v = inValue & 0x1FFFFF;
+      v = (v | (v << 32)) & 0x001F00000000FFFFULL;
+      v = (v | (v << 16)) & 0x001F0000FF0000FFULL;
+      v = (v | (v << 8))  & 0x100F00F00F00F00FULL;
+      v = (v | (v << 4))  & 0x10C30C30C30C30C3ULL;
+      v = (v | (v << 2))  & 0x1249249249249249ULL;
+      return v;
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_OCTREE_H_
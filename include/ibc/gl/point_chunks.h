@@ -0,0 +1,317 @@
+// =============================================================================
+//  point_chunks.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/point_chunks.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the chunked frustum culling of the vertex arrays
+*/
+
+#ifndef IBC_GL_POINT_CHUNKS_H_
+#define IBC_GL_POINT_CHUNKS_H_
+
+// Includes --------------------------------------------------------------------
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "ibc/base/types.h"
+#include "ibc/base/parallel.h"
+#include "ibc/gl/matrix.h"
+#include "ibc/gl/bounding_box.h"
+#include "ibc/gl/frustum.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // PointChunks class
+  // ---------------------------------------------------------------------------
+  // Splits a vertex array into fixed-size chunks of consecutive points and
+  // keeps the bounding box of each chunk. The chunks which survive the view
+  // frustum test are returned as (first, count) lists for glMultiDrawArrays()
+  // (adjacent survivors are merged into one range).
+  // This works well when the consecutive points are spatially coherent,
+  // e.g. the scan lines of a sensor or the rows of a depth map.
+  class PointChunks
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static const size_t  DEFAULT_CHUNK_SIZE = 16 * 1024;
+    static const size_t  MIN_TASK_SIZE      = 256 * 1024;  // points per thread
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // PointChunks
+    // -------------------------------------------------------------------------
+    PointChunks(size_t inChunkSize = DEFAULT_CHUNK_SIZE)
+    {
+      mChunkSize = (inChunkSize != 0) ? inChunkSize : DEFAULT_CHUNK_SIZE;
+      mDataNum = 0;
+    }
+    // -------------------------------------------------------------------------
+    // ~PointChunks
+    // -------------------------------------------------------------------------
+    virtual ~PointChunks()
+    {
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setChunkSize
+    // -------------------------------------------------------------------------
+    // The bounding boxes are invalidated (update() should be called again)
+    void setChunkSize(size_t inChunkSize)
+    {
+      if (inChunkSize == 0 || inChunkSize == mChunkSize)
+        return;
+      mChunkSize = inChunkSize;
+      resize(mDataNum);
+    }
+    // -------------------------------------------------------------------------
+    // getChunkSize
+    // -------------------------------------------------------------------------
+    size_t getChunkSize() const
+    {
+      return mChunkSize;
+    }
+    // -------------------------------------------------------------------------
+    // getChunkNum
+    // -------------------------------------------------------------------------
+    size_t getChunkNum() const
+    {
+      return mMinMax.size() / 6;
+    }
+    // -------------------------------------------------------------------------
+    // resize
+    // -------------------------------------------------------------------------
+    // All the bounding boxes become empty (nothing is drawn until set)
+    void resize(size_t inDataNum)
+    {
+      mDataNum = inDataNum;
+      mMinMax.resize(((mDataNum + mChunkSize - 1) / mChunkSize) * 6);
+      for (size_t i = 0; i < getChunkNum(); i++)
+        BoundingBox::initMinMax(&(mMinMax[i * 6]));
+    }
+    // -------------------------------------------------------------------------
+    // update
+    // -------------------------------------------------------------------------
+    // Recalculates all the bounding boxes. The first 3 floats of each
+    // element (inStride bytes) should be x, y, z.
+    void update(const void *inDataPtr, size_t inStride, size_t inDataNum,
+                unsigned int inTaskNum = 0)
+    {
+      if (inDataNum != mDataNum || mMinMax.size() != getChunkNum() * 6)
+        resize(inDataNum);
+      size_t  chunkNum = getChunkNum();
+      if (inDataPtr == NULL || chunkNum == 0)
+        return;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inDataNum, MIN_TASK_SIZE);
+      Parallel::forEachTask(chunkNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t i = inBegin; i < inEnd; i++)
+            updateChunk(inDataPtr, inStride, i);
+        });
+    }
+    // -------------------------------------------------------------------------
+    // updateRange
+    // -------------------------------------------------------------------------
+    // Recalculates only the chunks which overlap [inFirst, inFirst + inCount)
+    void updateRange(const void *inDataPtr, size_t inStride, size_t inFirst, size_t inCount)
+    {
+      if (inDataPtr == NULL || inCount == 0 || inFirst >= mDataNum)
+        return;
+      size_t  last = inFirst + inCount;
+      if (last > mDataNum)
+        last = mDataNum;
+      for (size_t i = inFirst / mChunkSize; i * mChunkSize < last; i++)
+        updateChunk(inDataPtr, inStride, i);
+    }
+    // -------------------------------------------------------------------------
+    // setMinMax
+    // -------------------------------------------------------------------------
+    // For the models which know the bounds without reading the points
+    void setMinMax(size_t inChunkIndex, const GLfloat inMinMax[6])
+    {
+      for (int i = 0; i < 6; i++)
+        mMinMax[inChunkIndex * 6 + i] = inMinMax[i];
+    }
+    // -------------------------------------------------------------------------
+    // getMinMax
+    // -------------------------------------------------------------------------
+    const GLfloat *getMinMax(size_t inChunkIndex) const
+    {
+      return &(mMinMax[inChunkIndex * 6]);
+    }
+    // -------------------------------------------------------------------------
+    // getChunkRange
+    // -------------------------------------------------------------------------
+    void getChunkRange(size_t inChunkIndex, size_t *outFirst, size_t *outCount) const
+    {
+      *outFirst = inChunkIndex * mChunkSize;
+      *outCount = mChunkSize;
+      if (*outFirst + *outCount > mDataNum)
+        *outCount = mDataNum - *outFirst;
+    }
+    // -------------------------------------------------------------------------
+    // select
+    // -------------------------------------------------------------------------
+    // Returns the number of the points in the visible chunks
+    size_t select(const Frustum &inFrustum,
+                  std::vector<GLint> *outFirsts, std::vector<GLsizei> *outCounts) const
+    {
+      outFirsts->clear();
+      outCounts->clear();
+      size_t  total = 0;
+      bool  isPrevVisible = false;
+      for (size_t i = 0; i < getChunkNum(); i++)
+      {
+        const GLfloat *minMax = getMinMax(i);
+        if (BoundingBox::isValidMinMax(minMax) == false ||
+            inFrustum.testBox(minMax) == Frustum::OUTSIDE)
+        {
+          isPrevVisible = false;
+          continue;
+        }
+        size_t  first, count;
+        getChunkRange(i, &first, &count);
+        if (isPrevVisible)
+          outCounts->back() += (GLsizei )count;
+        else
+        {
+          outFirsts->push_back((GLint )first);
+          outCounts->push_back((GLsizei )count);
+        }
+        total += count;
+        isPrevVisible = true;
+      }
+      return total;
+    }
+    // -------------------------------------------------------------------------
+    // select
+    // -------------------------------------------------------------------------
+    // The matrices passed to ModelInterface::drawModel() (column major).
+    // inFitParam is the model fit of the point cloud shaders,
+    // (position + fit.xyz) * fit.w (NULL : no fit).
+    size_t select(const GLfloat inModelView[16], const GLfloat inProjection[16],
+                  const GLfloat inFitParam[4],
+                  std::vector<GLint> *outFirsts, std::vector<GLsizei> *outCounts) const
+    {
+      glMatrix4f  modelView, projection;
+      getFittedMatrices(inModelView, inProjection, inFitParam, &modelView, &projection);
+      Frustum frustum;
+      frustum.set(modelView, projection);
+      return select(frustum, outFirsts, outCounts);
+    }
+    // -------------------------------------------------------------------------
+    // selectFrontToBack
+    // -------------------------------------------------------------------------
+    // Same as select(), but the visible chunks are sorted by the view depth
+    // of their centers (nearest first), so that the early depth test can
+    // reject the hidden fragments of the farther chunks. Chunks which are
+    // adjacent both in the array and in the sorted order are still merged.
+    size_t selectFrontToBack(const GLfloat inModelView[16], const GLfloat inProjection[16],
+                             const GLfloat inFitParam[4],
+                             std::vector<GLint> *outFirsts,
+                             std::vector<GLsizei> *outCounts)
+    {
+      glMatrix4f  modelView, projection;
+      getFittedMatrices(inModelView, inProjection, inFitParam, &modelView, &projection);
+      Frustum frustum;
+      frustum.set(modelView, projection);
+
+      mSortBuffer.clear();
+      for (size_t i = 0; i < getChunkNum(); i++)
+      {
+        const GLfloat *minMax = getMinMax(i);
+        if (BoundingBox::isValidMinMax(minMax) == false ||
+            frustum.testBox(minMax) == Frustum::OUTSIDE)
+          continue;
+        GLfloat depth = 0;
+        for (int j = 0; j < 3; j++)
+          depth -= modelView[2][j] * (minMax[j * 2] + minMax[j * 2 + 1]) * 0.5f;
+        mSortBuffer.push_back(std::make_pair(depth - modelView[2][3], i));
+      }
+      std::sort(mSortBuffer.begin(), mSortBuffer.end());
+
+      outFirsts->clear();
+      outCounts->clear();
+      size_t  total = 0;
+      size_t  prevIndex = 0;
+      for (size_t i = 0; i < mSortBuffer.size(); i++)
+      {
+        size_t  index = mSortBuffer[i].second;
+        size_t  first, count;
+        getChunkRange(index, &first, &count);
+        if (i != 0 && index == prevIndex + 1)
+          outCounts->back() += (GLsizei )count;
+        else
+        {
+          outFirsts->push_back((GLint )first);
+          outCounts->push_back((GLsizei )count);
+        }
+        total += count;
+        prevIndex = index;
+      }
+      return total;
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getFittedMatrices
+    // -------------------------------------------------------------------------
+    // The GL matrices to the row major ones, with the model fit applied
+    // (also used by PointPicker)
+    static void getFittedMatrices(const GLfloat inModelView[16], const GLfloat inProjection[16],
+                                  const GLfloat inFitParam[4],
+                                  glMatrix4f *outModelView, glMatrix4f *outProjection)
+    {
+      outModelView->setTransposedMatrix(inModelView);
+      outProjection->setTransposedMatrix(inProjection);
+      if (inFitParam != NULL)
+      {
+        glMatrix4f  scale, translation;
+        scale.setScaleMatrix(inFitParam[3], inFitParam[3], inFitParam[3]);
+        translation.setTranslationMatrix(inFitParam[0], inFitParam[1], inFitParam[2]);
+        *outModelView = (*outModelView) * scale * translation;
+      }
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    size_t  mChunkSize;
+    size_t  mDataNum;
+    std::vector<GLfloat>  mMinMax;
+    std::vector<std::pair<GLfloat, size_t>> mSortBuffer;  // (depth, chunk index)
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // updateChunk
+    // -------------------------------------------------------------------------
+    void updateChunk(const void *inDataPtr, size_t inStride, size_t inChunkIndex)
+    {
+      size_t  first, count;
+      getChunkRange(inChunkIndex, &first, &count);
+      BoundingBox::calcMinMax(((const unsigned char *)inDataPtr) + inStride * first,
+                              count, inStride, &(mMinMax[inChunkIndex * 6]), 1);
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_POINT_CHUNKS_H_
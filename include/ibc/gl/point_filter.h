@@ -0,0 +1,538 @@
+// =============================================================================
+//  point_filter.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/point_filter.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the point cloud filters (downsample, outliers)
+*/
+
+#ifndef IBC_GL_POINT_FILTER_H_
+#define IBC_GL_POINT_FILTER_H_
+
+// Includes --------------------------------------------------------------------
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "ibc/base/types.h"
+#include "ibc/base/parallel.h"
+#include "ibc/gl/data.h"
+#include "ibc/gl/bounding_box.h"
+#include "ibc/gl/kd_tree.h"
+#include "ibc/gl/vector.h"
+#include "ibc/gl/voxel_grid.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // PointFilter class
+  // ---------------------------------------------------------------------------
+  // The filters for the vertex structs in ibc/gl/data.h (see VertexTraits).
+  // Each filter writes either to a std::vector (resized to the result), or
+  // to a raw array of inMaxOutNum points (e.g. PointsRGBA8::lockStreamBuffer())
+  // and returns the number of the written points.
+  // All the filters run on multiple threads and remove the NaN points.
+  class PointFilter
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static const size_t  MIN_TASK_SIZE = 256 * 1024;  // points per thread
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // voxelDownsample
+    // -------------------------------------------------------------------------
+    // Replaces the points in each voxel of inVoxelSize by their average
+    // (the position, the color and the intensity are averaged, and the
+    // normal is normalized after). The voxels with less than inMinPointNum
+    // points are removed. The result is sorted by the voxel (z, y, x), so
+    // the consecutive points are spatially coherent (see PointChunks).
+    // The extra voxels over inMaxOutNum are dropped
+    template <typename DataType>
+    static size_t voxelDownsample(const DataType *inDataPtr, size_t inDataNum,
+                                  GLfloat inVoxelSize,
+                                  DataType *outDataPtr, size_t inMaxOutNum,
+                                  size_t inMinPointNum = 1, unsigned int inTaskNum = 0)
+    {
+      return voxelDownsample(inDataPtr, inDataNum, inVoxelSize, (std::vector<DataType> *)NULL,
+                             outDataPtr, inMaxOutNum, inMinPointNum, inTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // voxelDownsample
+    // -------------------------------------------------------------------------
+    template <typename DataType>
+    static size_t voxelDownsample(const DataType *inDataPtr, size_t inDataNum,
+                                  GLfloat inVoxelSize, std::vector<DataType> *outData,
+                                  size_t inMinPointNum = 1, unsigned int inTaskNum = 0)
+    {
+      return voxelDownsample(inDataPtr, inDataNum, inVoxelSize, outData,
+                             (DataType *)NULL, 0, inMinPointNum, inTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // randomDecimate
+    // -------------------------------------------------------------------------
+    // Keeps about inRatio (0 to 1) of the points in the original order.
+    // Each point is kept by the hash of its index and inSeed, so the result
+    // doesn't depend on the number of the threads
+    template <typename DataType>
+    static size_t randomDecimate(const DataType *inDataPtr, size_t inDataNum, double inRatio,
+                                 DataType *outDataPtr, size_t inMaxOutNum,
+                                 uint32_t inSeed = 0, unsigned int inTaskNum = 0)
+    {
+      uint64_t  threshold = getRandomThreshold(inRatio);
+      return compact(inDataPtr, inDataNum,
+                     [threshold, inSeed](size_t inIndex)
+                     { return (hashIndex(inIndex, inSeed) >> 32) < threshold; },
+                     (std::vector<DataType> *)NULL, outDataPtr, inMaxOutNum, inTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // randomDecimate
+    // -------------------------------------------------------------------------
+    template <typename DataType>
+    static size_t randomDecimate(const DataType *inDataPtr, size_t inDataNum, double inRatio,
+                                 std::vector<DataType> *outData,
+                                 uint32_t inSeed = 0, unsigned int inTaskNum = 0)
+    {
+      uint64_t  threshold = getRandomThreshold(inRatio);
+      return compact(inDataPtr, inDataNum,
+                     [threshold, inSeed](size_t inIndex)
+                     { return (hashIndex(inIndex, inSeed) >> 32) < threshold; },
+                     outData, (DataType *)NULL, 0, inTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // strideDecimate
+    // -------------------------------------------------------------------------
+    // Keeps every inStep-th point (0, inStep, 2 * inStep, ...)
+    template <typename DataType>
+    static size_t strideDecimate(const DataType *inDataPtr, size_t inDataNum, size_t inStep,
+                                 DataType *outDataPtr, size_t inMaxOutNum,
+                                 unsigned int inTaskNum = 0)
+    {
+      if (inStep == 0)
+        inStep = 1;
+      return compact(inDataPtr, inDataNum,
+                     [inStep](size_t inIndex) { return (inIndex % inStep) == 0; },
+                     (std::vector<DataType> *)NULL, outDataPtr, inMaxOutNum, inTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // strideDecimate
+    // -------------------------------------------------------------------------
+    template <typename DataType>
+    static size_t strideDecimate(const DataType *inDataPtr, size_t inDataNum, size_t inStep,
+                                 std::vector<DataType> *outData, unsigned int inTaskNum = 0)
+    {
+      if (inStep == 0)
+        inStep = 1;
+      return compact(inDataPtr, inDataNum,
+                     [inStep](size_t inIndex) { return (inIndex % inStep) == 0; },
+                     outData, (DataType *)NULL, 0, inTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // removeStatisticalOutliers
+    // -------------------------------------------------------------------------
+    // Removes the points whose mean distance to the inK nearest neighbors is
+    // larger than (mean + inStdDevMul * standard deviation) of all the points
+    template <typename DataType>
+    static size_t removeStatisticalOutliers(const DataType *inDataPtr, size_t inDataNum,
+                                            size_t inK, double inStdDevMul,
+                                            DataType *outDataPtr, size_t inMaxOutNum,
+                                            unsigned int inTaskNum = 0)
+    {
+      std::vector<GLfloat>  meanDists;
+      GLfloat threshold;
+      if (calcMeanDistances(inDataPtr, inDataNum, inK, inStdDevMul, inTaskNum,
+                            &meanDists, &threshold) == false)
+        return 0;
+      return compact(inDataPtr, inDataNum,
+                     [&meanDists, threshold](size_t inIndex)
+                     { return meanDists[inIndex] <= threshold; },
+                     (std::vector<DataType> *)NULL, outDataPtr, inMaxOutNum, inTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // removeStatisticalOutliers
+    // -------------------------------------------------------------------------
+    template <typename DataType>
+    static size_t removeStatisticalOutliers(const DataType *inDataPtr, size_t inDataNum,
+                                            size_t inK, double inStdDevMul,
+                                            std::vector<DataType> *outData,
+                                            unsigned int inTaskNum = 0)
+    {
+      outData->clear();
+      std::vector<GLfloat>  meanDists;
+      GLfloat threshold;
+      if (calcMeanDistances(inDataPtr, inDataNum, inK, inStdDevMul, inTaskNum,
+                            &meanDists, &threshold) == false)
+        return 0;
+      return compact(inDataPtr, inDataNum,
+                     [&meanDists, threshold](size_t inIndex)
+                     { return meanDists[inIndex] <= threshold; },
+                     outData, (DataType *)NULL, 0, inTaskNum);
+    }
+
+  protected:
+    // Constants ---------------------------------------------------------------
+    static const uint32_t  EMPTY_SLOT = (uint32_t )-1;
+
+    // -------------------------------------------------------------------------
+    // VoxelBins class
+    // -------------------------------------------------------------------------
+    // The (count, sums of the fields) of the voxels in an open addressing
+    // hash table (the keys of VoxelGrid::makeKey())
+    class VoxelBins
+    {
+    public:
+      // -----------------------------------------------------------------------
+      // VoxelBins
+      // -----------------------------------------------------------------------
+      VoxelBins(size_t inFieldNum = 0)
+      {
+        mFieldNum = inFieldNum;
+        mTable.assign(1024, (uint32_t )EMPTY_SLOT);
+      }
+      // -----------------------------------------------------------------------
+      // find
+      // -----------------------------------------------------------------------
+      // Returns the bin index of the key (a new bin is added if not found)
+      size_t find(uint64_t inKey)
+      {
+        size_t  mask = mTable.size() - 1;
+        size_t  slot = (size_t )(VoxelGrid::hashKey(inKey) >> 32) & mask;
+        while (mTable[slot] != EMPTY_SLOT)
+        {
+          if (mKeys[mTable[slot]] == inKey)
+            return mTable[slot];
+          slot = (slot + 1) & mask;
+        }
+        size_t  index = mKeys.size();
+        mTable[slot] = (uint32_t )index;
+        mKeys.push_back(inKey);
+        mCounts.push_back(0);
+        mSums.resize(mSums.size() + mFieldNum, 0.0);
+        if (mKeys.size() * 2 > mTable.size())
+          rehash(mTable.size() * 2);
+        return index;
+      }
+      // -----------------------------------------------------------------------
+      // rehash
+      // -----------------------------------------------------------------------
+      void rehash(size_t inTableSize)
+      {
+        mTable.assign(inTableSize, (uint32_t )EMPTY_SLOT);
+        size_t  mask = inTableSize - 1;
+        for (size_t i = 0; i < mKeys.size(); i++)
+        {
+          size_t  slot = (size_t )(VoxelGrid::hashKey(mKeys[i]) >> 32) & mask;
+          while (mTable[slot] != EMPTY_SLOT)
+            slot = (slot + 1) & mask;
+          mTable[slot] = (uint32_t )i;
+        }
+      }
+
+      // Member variables ------------------------------------------------------
+      size_t  mFieldNum;
+      std::vector<uint64_t> mKeys;
+      std::vector<uint32_t> mCounts;
+      std::vector<double>   mSums;    // mFieldNum per bin
+      std::vector<uint32_t> mTable;   // the bin indices (the size is 2^n)
+    };
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // voxelDownsample
+    // -------------------------------------------------------------------------
+    // Writes to outData (resized) if it isn't NULL, otherwise to outDataPtr
+    template <typename DataType>
+    static size_t voxelDownsample(const DataType *inDataPtr, size_t inDataNum,
+                                  GLfloat inVoxelSize, std::vector<DataType> *outData,
+                                  DataType *outDataPtr, size_t inMaxOutNum,
+                                  size_t inMinPointNum, unsigned int inTaskNum)
+    {
+      typedef VertexTraits<DataType>  Traits;
+      const size_t  fieldNum = Traits::FLOAT_NUM + Traits::UBYTE_NUM;
+      if (outData != NULL)
+        outData->clear();
+      if (inDataPtr == NULL || inDataNum == 0 || !(inVoxelSize > 0))
+        return 0;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inDataNum, MIN_TASK_SIZE);
+      GLfloat minMax[6];
+      if (BoundingBox::calcMinMax(inDataPtr, inDataNum, sizeof(DataType),
+                                  minMax, inTaskNum) == false)
+        return 0;
+      GLfloat origin[3] = {minMax[0], minMax[2], minMax[4]};
+      for (int i = 0; i < 3; i++)
+        if (!(std::floor((minMax[i * 2 + 1] - origin[i]) / inVoxelSize) <= VoxelGrid::MAX_COORD))
+          return 0;   // inVoxelSize is too small
+
+      // Accumulates the points on each task, into the bins of the partition
+      // of the key hash (taskBins[task * inTaskNum + partition])
+      std::vector<VoxelBins>  taskBins(inTaskNum * inTaskNum, VoxelBins(fieldNum));
+      Parallel::forEachTask(inDataNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          VoxelBins *partBins = &(taskBins[inTaskIndex * inTaskNum]);
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            const GLfloat *f = (const GLfloat *)&(inDataPtr[i]);
+            if (std::isnan(f[0]) || std::isnan(f[1]) || std::isnan(f[2]))
+              continue;
+            int coord[3];
+            for (int j = 0; j < 3; j++)
+              coord[j] = (int )std::floor((f[j] - origin[j]) / inVoxelSize);
+            uint64_t  key = VoxelGrid::makeKey(coord);
+            VoxelBins &bins = partBins[getPartition(key, inTaskNum)];
+            size_t  index = bins.find(key);
+            bins.mCounts[index]++;
+            double  *sum = &(bins.mSums[index * fieldNum]);
+            for (int j = 0; j < Traits::FLOAT_NUM; j++)
+              sum[j] += f[j];
+            const GLubyte *b = (const GLubyte *)(f + Traits::FLOAT_NUM);
+            for (int j = 0; j < Traits::UBYTE_NUM; j++)
+              sum[Traits::FLOAT_NUM + j] += b[j];
+          }
+        });
+
+      // Merges the bins of each partition on its own task
+      std::vector<VoxelBins>  bins(inTaskNum, VoxelBins(fieldNum));
+      if (inTaskNum == 1)
+        bins.swap(taskBins);
+      else
+        Parallel::forEachTask(inTaskNum, inTaskNum,
+          [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+          {
+            UNUSED(inBegin);
+            UNUSED(inEnd);
+            VoxelBins &dst = bins[inTaskIndex];
+            for (unsigned int t = 0; t < inTaskNum; t++)
+            {
+              const VoxelBins &src = taskBins[t * inTaskNum + inTaskIndex];
+              for (size_t i = 0; i < src.mKeys.size(); i++)
+              {
+                size_t  index = dst.find(src.mKeys[i]);
+                dst.mCounts[index] += src.mCounts[i];
+                for (size_t j = 0; j < fieldNum; j++)
+                  dst.mSums[index * fieldNum + j] += src.mSums[i * fieldNum + j];
+              }
+            }
+          });
+      taskBins.clear();
+
+      // Sorts the voxels by the key, (key, (partition, bin index))
+      std::vector<std::pair<uint64_t, uint64_t>>  voxels;
+      for (unsigned int t = 0; t < inTaskNum; t++)
+        for (size_t i = 0; i < bins[t].mKeys.size(); i++)
+          if (bins[t].mCounts[i] >= inMinPointNum)
+            voxels.push_back(std::make_pair(bins[t].mKeys[i], ((uint64_t )t << 32) | i));
+      Parallel::sort(voxels.begin(), voxels.end(),
+                     std::less<std::pair<uint64_t, uint64_t>>(), MIN_TASK_SIZE, inTaskNum);
+
+      size_t  num = voxels.size();
+      if (outData != NULL)
+      {
+        outData->resize(num);
+        outDataPtr = outData->data();
+      }
+      else if (num > inMaxOutNum)
+        num = inMaxOutNum;
+      Parallel::forEachTask(num, Parallel::getTaskNum(num, MIN_TASK_SIZE / 16, inTaskNum),
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            const VoxelBins &src = bins[voxels[i].second >> 32];
+            size_t  index = (size_t )(voxels[i].second & 0xFFFFFFFF);
+            double  count = src.mCounts[index];
+            const double  *sum = &(src.mSums[index * fieldNum]);
+            GLfloat *f = (GLfloat *)&(outDataPtr[i]);
+            for (int j = 0; j < Traits::FLOAT_NUM; j++)
+              f[j] = (GLfloat )(sum[j] / count);
+            if (Traits::NORMAL_OFFSET >= 0)
+              VectorBase<GLfloat>::normalize(f + Traits::NORMAL_OFFSET);
+            GLubyte *b = (GLubyte *)(f + Traits::FLOAT_NUM);
+            for (int j = 0; j < Traits::UBYTE_NUM; j++)
+              b[j] = (GLubyte )(sum[Traits::FLOAT_NUM + j] / count + 0.5);
+          }
+        });
+      return num;
+    }
+    // -------------------------------------------------------------------------
+    // compact
+    // -------------------------------------------------------------------------
+    // Copies the valid points which inKeep(index) accepts in the original
+    // order. Writes to outData (resized) if it isn't NULL, otherwise to
+    // outDataPtr (up to inMaxOutNum)
+    template <typename DataType, typename KeepFuncType>
+    static size_t compact(const DataType *inDataPtr, size_t inDataNum, KeepFuncType inKeep,
+                          std::vector<DataType> *outData,
+                          DataType *outDataPtr, size_t inMaxOutNum, unsigned int inTaskNum)
+    {
+      if (outData != NULL)
+        outData->clear();
+      if (inDataPtr == NULL || inDataNum == 0)
+        return 0;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inDataNum, MIN_TASK_SIZE);
+      auto  isKept = [&](size_t inIndex)
+      {
+        const GLfloat *f = (const GLfloat *)&(inDataPtr[inIndex]);
+        if (std::isnan(f[0]) || std::isnan(f[1]) || std::isnan(f[2]))
+          return false;
+        return (bool )inKeep(inIndex);
+      };
+      std::vector<size_t> offsets(inTaskNum + 1, 0);
+      Parallel::forEachTask(inDataNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          size_t  num = 0;
+          for (size_t i = inBegin; i < inEnd; i++)
+            if (isKept(i))
+              num++;
+          offsets[inTaskIndex + 1] = num;
+        });
+      for (unsigned int i = 0; i < inTaskNum; i++)
+        offsets[i + 1] += offsets[i];
+      size_t  num = offsets[inTaskNum];
+      if (outData != NULL)
+      {
+        outData->resize(num);
+        outDataPtr = outData->data();
+      }
+      else if (num > inMaxOutNum)
+        num = inMaxOutNum;
+      Parallel::forEachTask(inDataNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          size_t  dst = offsets[inTaskIndex];
+          for (size_t i = inBegin; i < inEnd && dst < num; i++)
+            if (isKept(i))
+              outDataPtr[dst++] = inDataPtr[i];
+        });
+      return num;
+    }
+    // -------------------------------------------------------------------------
+    // calcMeanDistances
+    // -------------------------------------------------------------------------
+    // The mean distance to the inK nearest neighbors of each point (NaN for
+    // the NaN points) and the outlier threshold
+    template <typename DataType>
+    static bool calcMeanDistances(const DataType *inDataPtr, size_t inDataNum,
+                                  size_t inK, double inStdDevMul, unsigned int inTaskNum,
+                                  std::vector<GLfloat> *outMeanDists, GLfloat *outThreshold)
+    {
+      if (inDataPtr == NULL || inDataNum == 0 || inK == 0)
+        return false;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inDataNum, MIN_TASK_SIZE);
+      KdTree  tree;
+      if (tree.build(inDataPtr, sizeof(DataType), inDataNum,
+                     KdTree::DEFAULT_LEAF_SIZE, inTaskNum) == false)
+        return false;
+
+      // The nearest one is the point itself (or a duplicate of it)
+      outMeanDists->resize(inDataNum);
+      unsigned int  queryTaskNum = Parallel::getTaskNum(inDataNum, KdTree::MIN_QUERY_TASK_SIZE,
+                                                        inTaskNum);
+      std::vector<double> sums(queryTaskNum * 3, 0.0);  // (sum, sum^2, number)
+      Parallel::forEachTask(inDataNum, queryTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          std::vector<std::pair<GLfloat, size_t>> heap;
+          std::vector<size_t>   indices(inK + 1);
+          std::vector<GLfloat>  dist2(inK + 1);
+          double  sum = 0, sum2 = 0, num = 0;
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            size_t  n = tree.findKNearest((const GLfloat *)&(inDataPtr[i]), inK + 1,
+                                          indices.data(), dist2.data(),
+                                          std::numeric_limits<GLfloat>::infinity(), &heap);
+            if (n <= 1)
+            {
+              // NaN, or the only point
+              (*outMeanDists)[i] = (n == 0) ? std::numeric_limits<GLfloat>::quiet_NaN() : 0;
+              continue;
+            }
+            double  mean = 0;
+            for (size_t j = 1; j < n; j++)
+              mean += std::sqrt((double )dist2[j]);
+            mean /= (double )(n - 1);
+            (*outMeanDists)[i] = (GLfloat )mean;
+            sum += mean;
+            sum2 += mean * mean;
+            num += 1;
+          }
+          sums[inTaskIndex * 3]     = sum;
+          sums[inTaskIndex * 3 + 1] = sum2;
+          sums[inTaskIndex * 3 + 2] = num;
+        });
+      double  sum = 0, sum2 = 0, num = 0;
+      for (unsigned int i = 0; i < queryTaskNum; i++)
+      {
+        sum  += sums[i * 3];
+        sum2 += sums[i * 3 + 1];
+        num  += sums[i * 3 + 2];
+      }
+      if (num == 0)
+      {
+        *outThreshold = std::numeric_limits<GLfloat>::max();
+        return true;
+      }
+      double  mean = sum / num;
+      double  variance = std::max(sum2 / num - mean * mean, 0.0);
+      *outThreshold = (GLfloat )(mean + inStdDevMul * std::sqrt(variance));
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // getRandomThreshold
+    // -------------------------------------------------------------------------
+    static uint64_t getRandomThreshold(double inRatio)
+    {
+      if (!(inRatio > 0))
+        return 0;
+      if (inRatio >= 1)
+        return (uint64_t )1 << 32;
+      return (uint64_t )(inRatio * 4294967296.0);
+    }
+    // -------------------------------------------------------------------------
+    // hashIndex
+    // -------------------------------------------------------------------------
+    // SplitMix64 finalizer
+    static uint64_t hashIndex(uint64_t inIndex, uint32_t inSeed)
+    {
+      uint64_t  z = inIndex + ((uint64_t )inSeed << 32) + 0x9E3779B97F4A7C15ULL;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+    // -------------------------------------------------------------------------
+    // getPartition
+    // -------------------------------------------------------------------------
+    // 0 to inPartNum - 1 from the top bits of the key hash (VoxelBins uses
+    // the lower bits of the upper half for the slot)
+    static unsigned int getPartition(uint64_t inKey, unsigned int inPartNum)
+    {
+      return (unsigned int )(((VoxelGrid::hashKey(inKey) >> 32) * inPartNum) >> 32);
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_POINT_FILTER_H_
@@ -0,0 +1,293 @@
+// =============================================================================
+//  point_picker.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/point_picker.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the point picking and selection
+*/
+
+#ifndef IBC_GL_POINT_PICKER_H_
+#define IBC_GL_POINT_PICKER_H_
+
+// Includes --------------------------------------------------------------------
+#include <algorithm>
+#include <vector>
+#include "ibc/base/types.h"
+#include "ibc/gl/matrix.h"
+#include "ibc/gl/frustum.h"
+#include "ibc/gl/kd_tree.h"
+#include "ibc/gl/point_chunks.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // PointPicker class
+  // ---------------------------------------------------------------------------
+  // Picks and selects the points of a KdTree on the CPU with the matrices of
+  // the last drawn frame (no extra render pass). The window rectangle is
+  // turned into a frustum (like gluPickMatrix) which culls the tree nodes,
+  // so only the points near the cursor are projected.
+  // The window coordinates are in the viewport units with the origin at the
+  // bottom left (GL convention). The returned indices are the source ones.
+  class PointPicker
+  {
+  public:
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      size_t  index;      // the source index
+      GLfloat xyz[3];     // the source position (without the model fit)
+      GLfloat win[3];     // the window position (z : the depth, 0 to 1)
+    } PickResult;
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // PointPicker
+    // -------------------------------------------------------------------------
+    PointPicker(const KdTree *inKdTree = NULL)
+    {
+      mKdTree = inKdTree;
+      mModelView.setIdentity();
+      mProjection.setIdentity();
+      mMVP.setIdentity();
+      mViewport[0] = 0;
+      mViewport[1] = 0;
+      mViewport[2] = 1;
+      mViewport[3] = 1;
+    }
+    // -------------------------------------------------------------------------
+    // ~PointPicker
+    // -------------------------------------------------------------------------
+    virtual ~PointPicker()
+    {
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setKdTree
+    // -------------------------------------------------------------------------
+    void setKdTree(const KdTree *inKdTree)
+    {
+      mKdTree = inKdTree;
+    }
+    // -------------------------------------------------------------------------
+    // setMatrices
+    // -------------------------------------------------------------------------
+    // The matrices passed to ModelInterface::drawModel() (column major).
+    // inFitParam is the model fit of the point cloud shaders (NULL : no fit)
+    void setMatrices(const GLfloat inModelView[16], const GLfloat inProjection[16],
+                     const GLint inViewport[4], const GLfloat inFitParam[4] = NULL)
+    {
+      PointChunks::getFittedMatrices(inModelView, inProjection, inFitParam,
+                                     &mModelView, &mProjection);
+      mMVP = mProjection * mModelView;
+      for (int i = 0; i < 4; i++)
+        mViewport[i] = inViewport[i];
+    }
+    // -------------------------------------------------------------------------
+    // project
+    // -------------------------------------------------------------------------
+    // Returns false if the point is clipped (outside of the near / far planes)
+    bool project(const GLfloat inXYZ[3], GLfloat outWin[3]) const
+    {
+      GLfloat clip[4];
+      for (int i = 0; i < 4; i++)
+        clip[i] = mMVP.mMat[i][0] * inXYZ[0] + mMVP.mMat[i][1] * inXYZ[1] +
+                  mMVP.mMat[i][2] * inXYZ[2] + mMVP.mMat[i][3];
+      if (clip[3] <= 0)
+        return false;
+      GLfloat z = clip[2] / clip[3];
+      if (z < -1 || z > 1)
+        return false;
+      outWin[0] = mViewport[0] + (clip[0] / clip[3] + 1) * 0.5f * mViewport[2];
+      outWin[1] = mViewport[1] + (clip[1] / clip[3] + 1) * 0.5f * mViewport[3];
+      outWin[2] = (z + 1) * 0.5f;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // pick
+    // -------------------------------------------------------------------------
+    // The front most point within inTolerance (in the window units) from
+    // (inWinX, inWinY). Returns false if there is no point
+    bool pick(GLfloat inWinX, GLfloat inWinY, GLfloat inTolerance,
+              PickResult *outResult) const
+    {
+      if (mKdTree == NULL || mKdTree->isBuilt() == false)
+        return false;
+      if (inTolerance < 0.5f)
+        inTolerance = 0.5f;
+      Frustum frustum;
+      setPickFrustum(inWinX - inTolerance, inWinY - inTolerance,
+                     inWinX + inTolerance, inWinY + inTolerance, &frustum);
+
+      GLfloat tolerance2 = inTolerance * inTolerance;
+      const KdTree::Entry *best = NULL;
+      GLfloat bestWin[3] = {0, 0, 0};
+      mKdTree->traverse(
+        [&frustum](const GLfloat *inMinMax) { return frustum.testBox(inMinMax); },
+        [&](const KdTree::Entry &inEntry, bool inIsInside)
+        {
+          UNUSED(inIsInside);
+          GLfloat win[3];
+          if (project(inEntry.xyz, win) == false)
+            return;
+          GLfloat dx = win[0] - inWinX;
+          GLfloat dy = win[1] - inWinY;
+          if (dx * dx + dy * dy > tolerance2)
+            return;
+          if (best == NULL || win[2] < bestWin[2])
+          {
+            best = &inEntry;
+            std::copy(win, win + 3, bestWin);
+          }
+        });
+      if (best == NULL)
+        return false;
+      outResult->index = best->index;
+      std::copy(best->xyz, best->xyz + 3, outResult->xyz);
+      std::copy(bestWin, bestWin + 3, outResult->win);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // selectRect
+    // -------------------------------------------------------------------------
+    // All the points (including the hidden ones) in the rectangle.
+    // outIndices is sorted. Returns the number of the points
+    size_t selectRect(GLfloat inX0, GLfloat inY0, GLfloat inX1, GLfloat inY1,
+                      std::vector<size_t> *outIndices) const
+    {
+      outIndices->clear();
+      if (mKdTree == NULL || mKdTree->isBuilt() == false)
+        return 0;
+      if (inX0 > inX1)
+        std::swap(inX0, inX1);
+      if (inY0 > inY1)
+        std::swap(inY0, inY1);
+      if (inX0 == inX1 || inY0 == inY1)
+        return 0;
+      Frustum frustum;
+      setPickFrustum(inX0, inY0, inX1, inY1, &frustum);
+      mKdTree->traverse(
+        [&frustum](const GLfloat *inMinMax) { return frustum.testBox(inMinMax); },
+        [&](const KdTree::Entry &inEntry, bool inIsInside)
+        {
+          if (inIsInside == false)
+          {
+            GLfloat win[3];
+            if (project(inEntry.xyz, win) == false ||
+                win[0] < inX0 || win[0] > inX1 || win[1] < inY0 || win[1] > inY1)
+              return;
+          }
+          outIndices->push_back(inEntry.index);
+        });
+      std::sort(outIndices->begin(), outIndices->end());
+      return outIndices->size();
+    }
+    // -------------------------------------------------------------------------
+    // selectLasso
+    // -------------------------------------------------------------------------
+    // inXY : the polygon vertices {x0, y0, x1, y1, ...} (closed implicitly,
+    // the even-odd rule). outIndices is sorted. Returns the number of the points
+    size_t selectLasso(const GLfloat *inXY, size_t inVertexNum,
+                       std::vector<size_t> *outIndices) const
+    {
+      outIndices->clear();
+      if (mKdTree == NULL || mKdTree->isBuilt() == false || inVertexNum < 3)
+        return 0;
+      GLfloat x0 = inXY[0], x1 = inXY[0];
+      GLfloat y0 = inXY[1], y1 = inXY[1];
+      for (size_t i = 1; i < inVertexNum; i++)
+      {
+        x0 = std::min(x0, inXY[i * 2]);
+        x1 = std::max(x1, inXY[i * 2]);
+        y0 = std::min(y0, inXY[i * 2 + 1]);
+        y1 = std::max(y1, inXY[i * 2 + 1]);
+      }
+      if (x0 == x1 || y0 == y1)
+        return 0;
+      Frustum frustum;
+      setPickFrustum(x0, y0, x1, y1, &frustum);
+      mKdTree->traverse(
+        [&frustum](const GLfloat *inMinMax) { return frustum.testBox(inMinMax); },
+        [&](const KdTree::Entry &inEntry, bool inIsInside)
+        {
+          UNUSED(inIsInside);
+          GLfloat win[3];
+          if (project(inEntry.xyz, win) == false ||
+              isInsidePolygon(inXY, inVertexNum, win[0], win[1]) == false)
+            return;
+          outIndices->push_back(inEntry.index);
+        });
+      std::sort(outIndices->begin(), outIndices->end());
+      return outIndices->size();
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // isInsidePolygon
+    // -------------------------------------------------------------------------
+    static bool isInsidePolygon(const GLfloat *inXY, size_t inVertexNum,
+                                GLfloat inX, GLfloat inY)
+    {
+      bool  isInside = false;
+      for (size_t i = 0, j = inVertexNum - 1; i < inVertexNum; j = i++)
+      {
+        GLfloat xi = inXY[i * 2], yi = inXY[i * 2 + 1];
+        GLfloat xj = inXY[j * 2], yj = inXY[j * 2 + 1];
+        if ((yi > inY) != (yj > inY) &&
+            inX < (xj - xi) * (inY - yi) / (yj - yi) + xi)
+          isInside = !isInside;
+      }
+      return isInside;
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    const KdTree  *mKdTree;
+    glMatrix4f  mModelView;     // with the model fit
+    glMatrix4f  mProjection;
+    glMatrix4f  mMVP;
+    GLint   mViewport[4];
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setPickFrustum
+    // -------------------------------------------------------------------------
+    // The frustum of the window rectangle (the projection is scaled so that
+    // the rectangle fills the clip space, same as gluPickMatrix)
+    void setPickFrustum(GLfloat inX0, GLfloat inY0, GLfloat inX1, GLfloat inY1,
+                        Frustum *outFrustum) const
+    {
+      GLfloat w = inX1 - inX0;
+      GLfloat h = inY1 - inY0;
+      GLfloat cx = (inX0 + inX1) * 0.5f;
+      GLfloat cy = (inY0 + inY1) * 0.5f;
+      glMatrix4f  pick;
+      pick.setIdentity();
+      pick.mMat[0][0] = mViewport[2] / w;
+      pick.mMat[1][1] = mViewport[3] / h;
+      pick.mMat[0][3] = (mViewport[2] + 2 * (mViewport[0] - cx)) / w;
+      pick.mMat[1][3] = (mViewport[3] + 2 * (mViewport[1] - cy)) / h;
+      glMatrix4f  projection = mProjection;
+      outFrustum->set(mModelView, pick * projection);
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_POINT_PICKER_H_
@@ -0,0 +1,450 @@
+// =============================================================================
+//  point_registration.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/point_registration.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the point cloud registration (ICP)
+*/
+
+#ifndef IBC_GL_POINT_REGISTRATION_H_
+#define IBC_GL_POINT_REGISTRATION_H_
+
+// Includes --------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "ibc/base/types.h"
+#include "ibc/base/parallel.h"
+#include "ibc/gl/data.h"
+#include "ibc/gl/matrix.h"
+#include "ibc/gl/quaternion.h"
+#include "ibc/gl/kd_tree.h"
+#include "ibc/gl/point_transform.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // PointRegistration class
+  // ---------------------------------------------------------------------------
+  // Point to point ICP. The target is indexed by KdTree once (setTarget()) and
+  // the sources are aligned to it (align()). For the consecutive scans, the
+  // aligned scan can be the target of the next one.
+  // Each iteration transforms the source (PointTransform), finds the nearest
+  // target points (KdTree, bounded by the distances to the correspondences of
+  // the previous iteration) and solves the rigid transform of the
+  // correspondences in the closed form (Horn's quaternion method), all on
+  // multiple threads.
+  class PointRegistration
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static const unsigned int  DEFAULT_MAX_ITERATION_NUM = 30;
+    static const size_t  MIN_TASK_SIZE = 16 * 1024;  // points per thread
+
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      bool          isConverged;
+      unsigned int  iterationNum;
+      size_t        correspondenceNum;  // of the last iteration
+      double        rmse;               // of the correspondences of the last iteration
+    } Result;
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // PointRegistration
+    // -------------------------------------------------------------------------
+    PointRegistration()
+    {
+      mMaxIterationNum = DEFAULT_MAX_ITERATION_NUM;
+      mMaxDistance = std::numeric_limits<GLfloat>::infinity();
+      mTranslationThreshold = 1e-6;
+      mRotationThreshold = 1e-6;
+      mTaskNum = 0;
+    }
+    // -------------------------------------------------------------------------
+    // ~PointRegistration
+    // -------------------------------------------------------------------------
+    virtual ~PointRegistration()
+    {
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setTarget
+    // -------------------------------------------------------------------------
+    template <typename DataType>
+    bool setTarget(const DataType *inDataPtr, size_t inDataNum)
+    {
+      return setTarget(inDataPtr, sizeof(DataType), inDataNum);
+    }
+    // -------------------------------------------------------------------------
+    // setTarget
+    // -------------------------------------------------------------------------
+    // The positions are copied (the data can be released after this)
+    bool setTarget(const void *inDataPtr, size_t inStride, size_t inDataNum)
+    {
+      mTargetPoints.clear();
+      mTree.clear();
+      if (inDataPtr == NULL || inDataNum == 0)
+        return false;
+      mTargetPoints.resize(inDataNum);
+      const unsigned char *data = (const unsigned char *)inDataPtr;
+      Parallel::forEachTask(inDataNum, getTaskNum(inDataNum),
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            const GLfloat *p = (const GLfloat *)(data + inStride * i);
+            mTargetPoints[i].x = p[0];
+            mTargetPoints[i].y = p[1];
+            mTargetPoints[i].z = p[2];
+          }
+        });
+      return mTree.build(mTargetPoints.data(), sizeof(glXYZf), inDataNum,
+                         KdTree::DEFAULT_LEAF_SIZE, mTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // isTargetSet
+    // -------------------------------------------------------------------------
+    bool isTargetSet() const
+    {
+      return mTree.isBuilt();
+    }
+    // -------------------------------------------------------------------------
+    // getTargetTree
+    // -------------------------------------------------------------------------
+    const KdTree &getTargetTree() const
+    {
+      return mTree;
+    }
+    // -------------------------------------------------------------------------
+    // setMaxIterationNum
+    // -------------------------------------------------------------------------
+    void setMaxIterationNum(unsigned int inNum)
+    {
+      mMaxIterationNum = inNum;
+    }
+    // -------------------------------------------------------------------------
+    // setMaxDistance
+    // -------------------------------------------------------------------------
+    // The correspondences farther than inDistance are rejected
+    void setMaxDistance(GLfloat inDistance)
+    {
+      mMaxDistance = inDistance;
+    }
+    // -------------------------------------------------------------------------
+    // setConvergenceThreshold
+    // -------------------------------------------------------------------------
+    // Converged when the update of an iteration is less than inTranslation
+    // and inRotation (radian)
+    void setConvergenceThreshold(double inTranslation, double inRotation)
+    {
+      mTranslationThreshold = inTranslation;
+      mRotationThreshold = inRotation;
+    }
+    // -------------------------------------------------------------------------
+    // setTaskNum
+    // -------------------------------------------------------------------------
+    // 0 : decided by the point number
+    void setTaskNum(unsigned int inTaskNum)
+    {
+      mTaskNum = inTaskNum;
+    }
+    // -------------------------------------------------------------------------
+    // align
+    // -------------------------------------------------------------------------
+    template <typename DataType>
+    bool align(const DataType *inDataPtr, size_t inDataNum,
+               MatrixBase<double> *ioMatrix, Result *outResult = NULL)
+    {
+      return align(inDataPtr, sizeof(DataType), inDataNum, ioMatrix, outResult);
+    }
+    // -------------------------------------------------------------------------
+    // align
+    // -------------------------------------------------------------------------
+    // ioMatrix : the initial guess (source to target) and the result.
+    // Returns false if the target is not set or the correspondences are
+    // less than 3 (ioMatrix is the last estimation)
+    bool align(const void *inDataPtr, size_t inStride, size_t inDataNum,
+               MatrixBase<double> *ioMatrix, Result *outResult = NULL)
+    {
+      Result  result = {false, 0, 0, 0};
+      if (outResult != NULL)
+        *outResult = result;
+      if (mTree.isBuilt() == false || inDataPtr == NULL || inDataNum == 0 || ioMatrix == NULL)
+        return false;
+      unsigned int  taskNum = getTaskNum(inDataNum);
+      mSourcePoints.resize(inDataNum);
+      mIndices.resize(inDataNum);
+      std::vector<Moments> moments(taskNum);
+
+      bool  isSucceeded = true;
+      MatrixBase<double>  transform = *ioMatrix;
+      for (unsigned int iteration = 0; iteration < mMaxIterationNum; iteration++)
+      {
+        PointTransform::transformPoints(transform, inDataPtr, inStride, inDataNum,
+                                        mSourcePoints.data(), sizeof(glXYZf), taskNum);
+        Parallel::forEachTask(inDataNum, taskNum,
+          [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+          {
+            findCorrespondences(inBegin, inEnd, iteration != 0, &(moments[inTaskIndex]));
+          });
+        Moments sum = moments[0];
+        for (unsigned int i = 1; i < taskNum; i++)
+          sum.add(moments[i]);
+
+        result.iterationNum = iteration + 1;
+        result.correspondenceNum = sum.num;
+        result.rmse = (sum.num != 0) ? std::sqrt(sum.dist2 / (double )sum.num) : 0;
+        MatrixBase<double>  update;
+        double  angle, translation;
+        if (sum.num < 3 || solve(sum, &update, &angle, &translation) == false)
+        {
+          isSucceeded = false;
+          break;
+        }
+        transform = update * transform;
+        if (angle < mRotationThreshold && translation < mTranslationThreshold)
+        {
+          result.isConverged = true;
+          break;
+        }
+      }
+      *ioMatrix = transform;
+      if (outResult != NULL)
+        *outResult = result;
+      return isSucceeded;
+    }
+
+  protected:
+    // Typedefs ----------------------------------------------------------------
+    // The sums of the correspondences (p : source, q : target)
+    typedef struct Moments
+    {
+      size_t  num;
+      double  p[3], q[3];
+      double  pq[3][3];
+      double  dist2;
+      //
+      void clear()
+      {
+        num = 0;
+        dist2 = 0;
+        for (int i = 0; i < 3; i++)
+        {
+          p[i] = q[i] = 0;
+          for (int j = 0; j < 3; j++)
+            pq[i][j] = 0;
+        }
+      }
+      void add(const Moments &inMoments)
+      {
+        num += inMoments.num;
+        dist2 += inMoments.dist2;
+        for (int i = 0; i < 3; i++)
+        {
+          p[i] += inMoments.p[i];
+          q[i] += inMoments.q[i];
+          for (int j = 0; j < 3; j++)
+            pq[i][j] += inMoments.pq[i][j];
+        }
+      }
+    } Moments;
+
+    // Member variables --------------------------------------------------------
+    KdTree  mTree;
+    std::vector<glXYZf> mTargetPoints;
+    std::vector<glXYZf> mSourcePoints;  // transformed
+    std::vector<size_t> mIndices;       // the correspondences
+    unsigned int  mMaxIterationNum;
+    GLfloat mMaxDistance;
+    double  mTranslationThreshold;
+    double  mRotationThreshold;
+    unsigned int  mTaskNum;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getTaskNum
+    // -------------------------------------------------------------------------
+    unsigned int getTaskNum(size_t inDataNum) const
+    {
+      if (mTaskNum != 0)
+        return mTaskNum;
+      return Parallel::getTaskNum(inDataNum, MIN_TASK_SIZE);
+    }
+    // -------------------------------------------------------------------------
+    // findCorrespondences
+    // -------------------------------------------------------------------------
+    // Finds the nearest target points of the source points [inBegin, inEnd)
+    // and sums them up. With inIsBounded, the search is bounded by the
+    // distance to the previous correspondence (the nearest is not farther)
+    void findCorrespondences(size_t inBegin, size_t inEnd, bool inIsBounded,
+                             Moments *outMoments)
+    {
+      outMoments->clear();
+      for (size_t i = inBegin; i < inEnd; i++)
+      {
+        const glXYZf  &src = mSourcePoints[i];
+        GLfloat maxDist = mMaxDistance;
+        if (inIsBounded && mIndices[i] != KdTree::INVALID_INDEX)
+        {
+          const glXYZf  &prev = mTargetPoints[mIndices[i]];
+          GLfloat d = std::sqrt((src.x - prev.x) * (src.x - prev.x) +
+                                (src.y - prev.y) * (src.y - prev.y) +
+                                (src.z - prev.z) * (src.z - prev.z)) * (1.0f + 1e-5f);
+          if (d < maxDist)
+            maxDist = d;
+        }
+        GLfloat dist2 = 0;
+        mIndices[i] = mTree.findNearest(&(src.x), &dist2, maxDist);
+        if (mIndices[i] == KdTree::INVALID_INDEX)
+          continue;
+        const glXYZf  &dst = mTargetPoints[mIndices[i]];
+        double  p[3] = {src.x, src.y, src.z};
+        double  q[3] = {dst.x, dst.y, dst.z};
+        outMoments->num++;
+        outMoments->dist2 += dist2;
+        for (int j = 0; j < 3; j++)
+        {
+          outMoments->p[j] += p[j];
+          outMoments->q[j] += q[j];
+          for (int k = 0; k < 3; k++)
+            outMoments->pq[j][k] += p[j] * q[k];
+        }
+      }
+    }
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // solve
+    // -------------------------------------------------------------------------
+    // The rigid transform minimizing sum |R p + t - q|^2. The rotation is the
+    // eigen vector (w, x, y, z) of the largest eigen value of Horn's 4x4 matrix
+    // of the cross covariance S
+    static bool solve(const Moments &inMoments, MatrixBase<double> *outMatrix,
+                      double *outAngle, double *outTranslation)
+    {
+      double  n = (double )inMoments.num;
+      double  mp[3], mq[3], s[3][3];
+      for (int i = 0; i < 3; i++)
+      {
+        mp[i] = inMoments.p[i] / n;
+        mq[i] = inMoments.q[i] / n;
+      }
+      for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+          s[i][j] = inMoments.pq[i][j] / n - mp[i] * mq[j];
+
+      double  a[4][4] =
+      {
+        {s[0][0] + s[1][1] + s[2][2], s[1][2] - s[2][1], s[2][0] - s[0][2], s[0][1] - s[1][0]},
+        {s[1][2] - s[2][1], s[0][0] - s[1][1] - s[2][2], s[0][1] + s[1][0], s[2][0] + s[0][2]},
+        {s[2][0] - s[0][2], s[0][1] + s[1][0], -s[0][0] + s[1][1] - s[2][2], s[1][2] + s[2][1]},
+        {s[0][1] - s[1][0], s[2][0] + s[0][2], s[1][2] + s[2][1], -s[0][0] - s[1][1] + s[2][2]}
+      };
+      double  wxyz[4];
+      if (calcLargestEigenVector(a, wxyz) == false)
+        return false;
+
+      double  q[4];
+      q[QuaternionBase<double>::Qw] = wxyz[0];
+      q[QuaternionBase<double>::Qx] = wxyz[1];
+      q[QuaternionBase<double>::Qy] = wxyz[2];
+      q[QuaternionBase<double>::Qz] = wxyz[3];
+      // glRotationMatrix() is R in the row major order
+      QuaternionBase<double>::glRotationMatrix(outMatrix->mMat, q);
+      double  rp[3];
+      MatrixBase<double>::multiMatrixByVector(rp, (const double *)outMatrix->mMat, mp);
+      outMatrix->setTranslation(mq[0] - rp[0], mq[1] - rp[1], mq[2] - rp[2]);
+
+      *outAngle = 2.0 * std::acos(std::min(std::fabs(wxyz[0]), 1.0));
+      *outTranslation = std::sqrt((mq[0] - rp[0]) * (mq[0] - rp[0]) +
+                                  (mq[1] - rp[1]) * (mq[1] - rp[1]) +
+                                  (mq[2] - rp[2]) * (mq[2] - rp[2]));
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // calcLargestEigenVector
+    // -------------------------------------------------------------------------
+    // The cyclic Jacobi method for the symmetric 4x4 matrix (ioMat is destroyed)
+    static bool calcLargestEigenVector(double ioMat[4][4], double outVec[4])
+    {
+      double  v[4][4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+      for (int sweep = 0; sweep < 50; sweep++)
+      {
+        double  off = 0, diag = 0;
+        for (int i = 0; i < 4; i++)
+        {
+          diag += ioMat[i][i] * ioMat[i][i];
+          for (int j = i + 1; j < 4; j++)
+            off += ioMat[i][j] * ioMat[i][j];
+        }
+        if (off <= diag * 1e-30 || off == 0)
+          break;
+        for (int p = 0; p < 3; p++)
+          for (int q = p + 1; q < 4; q++)
+          {
+            if (ioMat[p][q] == 0)
+              continue;
+            double  theta = (ioMat[q][q] - ioMat[p][p]) / (2.0 * ioMat[p][q]);
+            double  t = ((theta >= 0) ? 1.0 : -1.0) /
+                        (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+            double  c = 1.0 / std::sqrt(t * t + 1.0);
+            double  s = t * c;
+            for (int k = 0; k < 4; k++)
+            {
+              double  kp = ioMat[k][p], kq = ioMat[k][q];
+              ioMat[k][p] = c * kp - s * kq;
+              ioMat[k][q] = s * kp + c * kq;
+            }
+            for (int k = 0; k < 4; k++)
+            {
+              double  pk = ioMat[p][k], qk = ioMat[q][k];
+              ioMat[p][k] = c * pk - s * qk;
+              ioMat[q][k] = s * pk + c * qk;
+            }
+            for (int k = 0; k < 4; k++)
+            {
+              double  kp = v[k][p], kq = v[k][q];
+              v[k][p] = c * kp - s * kq;
+              v[k][q] = s * kp + c * kq;
+            }
+          }
+      }
+      int largest = 0;
+      for (int i = 1; i < 4; i++)
+        if (ioMat[i][i] > ioMat[largest][largest])
+          largest = i;
+      double  len = 0;
+      for (int i = 0; i < 4; i++)
+        len += v[i][largest] * v[i][largest];
+      len = std::sqrt(len);
+      if (!(len > 0))
+        return false;
+      for (int i = 0; i < 4; i++)
+        outVec[i] = v[i][largest] / len;
+      return true;
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_POINT_REGISTRATION_H_
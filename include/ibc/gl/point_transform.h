@@ -0,0 +1,144 @@
+// =============================================================================
+//  point_transform.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/point_transform.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for transforming the point clouds
+*/
+
+#ifndef IBC_GL_POINT_TRANSFORM_H_
+#define IBC_GL_POINT_TRANSFORM_H_
+
+// Includes --------------------------------------------------------------------
+#include <algorithm>
+#include <cstring>
+#include "ibc/base/types.h"
+#include "ibc/base/parallel.h"
+#include "ibc/gl/data.h"
+#include "ibc/gl/matrix.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // PointTransform class
+  // ---------------------------------------------------------------------------
+  // Transforms the vertex structs (data.h) by the affine matrix on multiple
+  // threads with the SIMD kernels of MatrixBase. The positions are transformed
+  // by the whole matrix and the normals by the upper 3x3 only
+  // (MatrixBase::transformVectors, the normals stay normalized with the rigid
+  // transforms).
+  // The other attributes are copied as they are.
+  class PointTransform
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static constexpr size_t  MIN_TASK_SIZE = 64 * 1024;  // points per thread
+    static constexpr size_t  BLOCK_SIZE = 4096;          // copied and transformed in the cache
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // transform
+    // -------------------------------------------------------------------------
+    // outDataPtr can be inDataPtr
+    template <typename DataType, typename MatrixType>
+    static void transform(const MatrixBase<MatrixType> &inMatrix,
+                          const DataType *inDataPtr, size_t inDataNum,
+                          DataType *outDataPtr, unsigned int inTaskNum = 0)
+    {
+      if (inDataPtr == NULL || outDataPtr == NULL || inDataNum == 0)
+        return;
+      GLfloat mat[16];
+      toFloatMatrix(inMatrix, mat);
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inDataNum, MIN_TASK_SIZE);
+      Parallel::forEachTask(inDataNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t i = inBegin; i < inEnd; i += BLOCK_SIZE)
+          {
+            size_t  num = std::min(BLOCK_SIZE, inEnd - i);
+            DataType  *out = outDataPtr + i;
+            if (out != inDataPtr + i)
+              std::memcpy(out, inDataPtr + i, sizeof(DataType) * num);
+            MatrixBase<GLfloat>::transformPoints(mat, out, sizeof(DataType), num,
+                                                 out, sizeof(DataType));
+            if constexpr (VertexTraits<DataType>::NORMAL_OFFSET >= 0)
+            {
+              GLfloat *normal = ((GLfloat *)out) + VertexTraits<DataType>::NORMAL_OFFSET;
+              MatrixBase<GLfloat>::transformVectors(mat, normal, sizeof(DataType), num,
+                                                    normal, sizeof(DataType));
+            }
+          }
+        });
+    }
+    // -------------------------------------------------------------------------
+    // transform
+    // -------------------------------------------------------------------------
+    // In place
+    template <typename DataType, typename MatrixType>
+    static void transform(const MatrixBase<MatrixType> &inMatrix,
+                          DataType *ioDataPtr, size_t inDataNum, unsigned int inTaskNum = 0)
+    {
+      transform(inMatrix, (const DataType *)ioDataPtr, inDataNum, ioDataPtr, inTaskNum);
+    }
+    // -------------------------------------------------------------------------
+    // transformPoints
+    // -------------------------------------------------------------------------
+    // Only the strided positions (x, y, z GLfloat) are written to outPtr
+    // (outPtr can be inPtr)
+    template <typename MatrixType>
+    static void transformPoints(const MatrixBase<MatrixType> &inMatrix,
+                                const void *inPtr, size_t inStride, size_t inNum,
+                                void *outPtr, size_t inOutStride, unsigned int inTaskNum = 0)
+    {
+      if (inPtr == NULL || outPtr == NULL || inNum == 0)
+        return;
+      GLfloat mat[16];
+      toFloatMatrix(inMatrix, mat);
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inNum, MIN_TASK_SIZE);
+      Parallel::forEachTask(inNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          MatrixBase<GLfloat>::transformPoints(mat,
+                                               ((const unsigned char *)inPtr) + inStride * inBegin,
+                                               inStride, inEnd - inBegin,
+                                               ((unsigned char *)outPtr) + inOutStride * inBegin,
+                                               inOutStride);
+        });
+    }
+
+  protected:
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // toFloatMatrix
+    // -------------------------------------------------------------------------
+    template <typename MatrixType>
+    static void toFloatMatrix(const MatrixBase<MatrixType> &inMatrix, GLfloat outMat[16])
+    {
+      const MatrixType  *mat = (const MatrixType *)inMatrix.mMat;
+      for (int i = 0; i < 16; i++)
+        outMat[i] = (GLfloat )mat[i];
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_POINT_TRANSFORM_H_
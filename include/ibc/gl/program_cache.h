@@ -0,0 +1,362 @@
+// =============================================================================
+//  program_cache.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/program_cache.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the shader program binary cache and registry
+*/
+
+#ifndef IBC_GL_PROGRAM_CACHE_H_
+#define IBC_GL_PROGRAM_CACHE_H_
+
+// Includes --------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ibc/base/types.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // ProgramCache class
+  // ---------------------------------------------------------------------------
+  // Stores the linked program binaries (glGetProgramBinary) on the disk.
+  // The file name is the hash of the shader sources and the driver strings
+  // (vendor, renderer, version), so a driver update just misses the cache.
+  // The cache is disabled until setCacheDir() is called, or the environment
+  // variable IBC_GL_PROGRAM_CACHE_DIR is set.
+  // (The GL calls are made by ShaderBase, this class only does the file I/O)
+  class ProgramCache
+  {
+  public:
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // setCacheDir
+    // -------------------------------------------------------------------------
+    // The directory should exist ("" : disables the cache)
+    static void setCacheDir(const char *inDir)
+    {
+      std::lock_guard<std::mutex> lock(getMutex());
+      getCacheDirStr() = (inDir != NULL) ? inDir : "";
+      isCacheDirSet() = true;
+    }
+    // -------------------------------------------------------------------------
+    // getCacheDir
+    // -------------------------------------------------------------------------
+    static std::string getCacheDir()
+    {
+      std::lock_guard<std::mutex> lock(getMutex());
+      if (isCacheDirSet() == false)
+      {
+        const char *env = getenv("IBC_GL_PROGRAM_CACHE_DIR");
+        getCacheDirStr() = (env != NULL) ? env : "";
+        isCacheDirSet() = true;
+      }
+      return getCacheDirStr();
+    }
+    // -------------------------------------------------------------------------
+    // isEnabled
+    // -------------------------------------------------------------------------
+    static bool isEnabled()
+    {
+      return getCacheDir().empty() == false;
+    }
+    // -------------------------------------------------------------------------
+    // makeKey
+    // -------------------------------------------------------------------------
+    // 64bit FNV-1a hash of the strings (NULL is allowed) as 16 hex digits
+    static std::string makeKey(const char *const inStrs[], int inNum)
+    {
+      uint64_t  hash = 14695981039346656037ULL;
+      for (int i = 0; i < inNum; i++)
+      {
+        const char *str = (inStrs[i] != NULL) ? inStrs[i] : "";
+        for (; *str != 0; str++)
+          hash = (hash ^ (unsigned char )*str) * 1099511628211ULL;
+        hash = (hash ^ 0xFF) * 1099511628211ULL;   // separator
+      }
+      char  buf[17];
+      snprintf(buf, sizeof(buf), "%016llx", (unsigned long long )hash);
+      return std::string(buf);
+    }
+    // -------------------------------------------------------------------------
+    // read
+    // -------------------------------------------------------------------------
+    static bool read(const std::string &inKey,
+                     GLenum *outFormat, std::vector<unsigned char> *outBinary)
+    {
+      std::string fileName = getFileName(inKey);
+      if (fileName.empty())
+        return false;
+      FILE  *fp = fopen(fileName.c_str(), "rb");
+      if (fp == NULL)
+        return false;
+      FileHeader  header;
+      bool  result = false;
+      if (fread(&header, sizeof(header), 1, fp) == 1 &&
+          header.magic == FILE_MAGIC && header.size != 0)
+      {
+        outBinary->resize((size_t )header.size);
+        if (fread(outBinary->data(), 1, outBinary->size(), fp) == outBinary->size())
+        {
+          *outFormat = (GLenum )header.format;
+          result = true;
+        }
+      }
+      fclose(fp);
+      return result;
+    }
+    // -------------------------------------------------------------------------
+    // write
+    // -------------------------------------------------------------------------
+    // Written to a temporary file (unique to the process and the call) and
+    // renamed, so that the other processes never read a partial file
+    static bool write(const std::string &inKey,
+                      GLenum inFormat, const std::vector<unsigned char> &inBinary)
+    {
+      std::string fileName = getFileName(inKey);
+      if (fileName.empty() || inBinary.empty())
+        return false;
+      std::string tmpName = fileName + "." + getUniqueStr() + ".tmp";
+      FILE  *fp = fopen(tmpName.c_str(), "wb");
+      if (fp == NULL)
+        return false;
+      FileHeader  header;
+      header.magic = FILE_MAGIC;
+      header.format = (uint32_t )inFormat;
+      header.size = (uint64_t )inBinary.size();
+      bool  result = (fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                      fwrite(inBinary.data(), 1, inBinary.size(), fp) == inBinary.size());
+      if (fclose(fp) != 0)
+        result = false;
+      if (result)
+        result = (rename(tmpName.c_str(), fileName.c_str()) == 0);
+      if (result == false)
+        remove(tmpName.c_str());
+      return result;
+    }
+
+  protected:
+    // Constants ---------------------------------------------------------------
+    static const uint32_t FILE_MAGIC = 0x31504249;  // "IBP1"
+
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      uint32_t  magic;
+      uint32_t  format;
+      uint64_t  size;
+    } FileHeader;
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getFileName
+    // -------------------------------------------------------------------------
+    static std::string getFileName(const std::string &inKey)
+    {
+      std::string dir = getCacheDir();
+      if (dir.empty())
+        return dir;
+      if (dir.back() != '/' && dir.back() != '\\')
+        dir += '/';
+      return dir + "ibc_program_" + inKey + ".bin";
+    }
+    // -------------------------------------------------------------------------
+    // getUniqueStr
+    // -------------------------------------------------------------------------
+    // The process ID and the counter of the calls
+    static std::string getUniqueStr()
+    {
+      static std::atomic<unsigned int>  sCounter(0);
+#ifdef _WIN32
+      unsigned long pid = (unsigned long )_getpid();
+#else
+      unsigned long pid = (unsigned long )getpid();
+#endif
+      char  buf[64];
+      snprintf(buf, sizeof(buf), "%lu_%u", pid, sCounter++);
+      return std::string(buf);
+    }
+    // -------------------------------------------------------------------------
+    // getCacheDirStr
+    // -------------------------------------------------------------------------
+    static std::string &getCacheDirStr()
+    {
+      static std::string  sCacheDir;
+      return sCacheDir;
+    }
+    // -------------------------------------------------------------------------
+    // isCacheDirSet
+    // -------------------------------------------------------------------------
+    static bool &isCacheDirSet()
+    {
+      static bool sIsCacheDirSet = false;
+      return sIsCacheDirSet;
+    }
+    // -------------------------------------------------------------------------
+    // getMutex
+    // -------------------------------------------------------------------------
+    static std::mutex &getMutex()
+    {
+      static std::mutex sMutex;
+      return sMutex;
+    }
+  };
+
+  // ---------------------------------------------------------------------------
+  // ProgramRegistry class
+  // ---------------------------------------------------------------------------
+  // Shares one linked program among the views whose GL contexts are in the
+  // same share group. The view sets the share group of its context before
+  // initializing the shaders (setCurrentShareGroup(), per thread), then the
+  // first ShaderBase with the same sources builds the program and the others
+  // just take a reference. NULL share group : no sharing.
+  // The uniform and attribute locations are cached with the program, so the
+  // models of the other views don't query them again.
+  class ProgramRegistry
+  {
+  public:
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      std::mutex  mutex;
+      std::map<std::string, GLint>  uniforms;
+      std::map<std::string, GLint>  attribs;
+    } LocationCache;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // acquire
+    // -------------------------------------------------------------------------
+    // Returns false if the program is not registered yet
+    bool acquire(const void *inShareGroup, const std::string &inKey,
+                 GLuint *outProgram, std::shared_ptr<LocationCache> *outLocations)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      auto it = mEntries.find(std::make_pair(inShareGroup, inKey));
+      if (it == mEntries.end())
+        return false;
+      it->second.refCount++;
+      *outProgram = it->second.program;
+      *outLocations = it->second.locations;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // add
+    // -------------------------------------------------------------------------
+    // Registers a new program with the reference count 1. If another thread
+    // has registered the same program in the meantime, takes a reference to
+    // it instead, returns it in ioProgram and ioLocations and returns false
+    // (the caller deletes its own program)
+    bool add(const void *inShareGroup, const std::string &inKey,
+             GLuint *ioProgram, std::shared_ptr<LocationCache> *ioLocations)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      auto result = mEntries.try_emplace(std::make_pair(inShareGroup, inKey));
+      Entry &entry = result.first->second;
+      if (result.second == false)
+      {
+        entry.refCount++;
+        *ioProgram = entry.program;
+        *ioLocations = entry.locations;
+        return false;
+      }
+      entry.program = *ioProgram;
+      entry.refCount = 1;
+      entry.locations = *ioLocations;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // release
+    // -------------------------------------------------------------------------
+    // Returns true if it was the last reference (the caller deletes the program)
+    bool release(const void *inShareGroup, const std::string &inKey)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      auto it = mEntries.find(std::make_pair(inShareGroup, inKey));
+      if (it == mEntries.end())
+        return true;
+      if (--(it->second.refCount) > 0)
+        return false;
+      mEntries.erase(it);
+      return true;
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getInstance
+    // -------------------------------------------------------------------------
+    static ProgramRegistry *getInstance()
+    {
+      static ProgramRegistry  sInstance;
+      return &sInstance;
+    }
+    // -------------------------------------------------------------------------
+    // setCurrentShareGroup
+    // -------------------------------------------------------------------------
+    static void setCurrentShareGroup(const void *inShareGroup)
+    {
+      getCurrentShareGroupRef() = inShareGroup;
+    }
+    // -------------------------------------------------------------------------
+    // getCurrentShareGroup
+    // -------------------------------------------------------------------------
+    static const void *getCurrentShareGroup()
+    {
+      return getCurrentShareGroupRef();
+    }
+
+  protected:
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      GLuint  program;
+      int     refCount;
+      std::shared_ptr<LocationCache>  locations;
+    } Entry;
+
+    // Member variables --------------------------------------------------------
+    std::mutex  mMutex;
+    std::map<std::pair<const void *, std::string>, Entry> mEntries;
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getCurrentShareGroupRef
+    // -------------------------------------------------------------------------
+    static const void *&getCurrentShareGroupRef()
+    {
+      thread_local const void *sShareGroup = NULL;
+      return sShareGroup;
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_PROGRAM_CACHE_H_
@@ -0,0 +1,340 @@
+// =============================================================================
+//  quantizer.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/quantizer.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the quantized point encoder
+*/
+
+#ifndef IBC_GL_QUANTIZER_H_
+#define IBC_GL_QUANTIZER_H_
+
+// Includes --------------------------------------------------------------------
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "ibc/base/types.h"
+#include "ibc/base/parallel.h"
+#include "ibc/gl/data.h"
+#include "ibc/gl/bounding_box.h"
+
+// Macros ----------------------------------------------------------------------
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IBC_GL_QUANTIZER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // Quantizer class
+  // ---------------------------------------------------------------------------
+  // Encodes the float points to glXYZs_NORMoct_RGBAub (12 bytes / point).
+  // The positions are stored relative to the chunk (origin, scale), so the
+  // error is about (chunk size / 65535). Use encodeChunked() for the large
+  // scans so that each chunk gets its own origin and scale.
+  // NaN points should be removed beforehand.
+  class Quantizer
+  {
+  public:
+    // Typedefs ----------------------------------------------------------------
+    // The source arrays (normalPtr and colorPtr can be NULL)
+    typedef struct
+    {
+      const void  *xyzPtr;
+      size_t      xyzStride;
+      const void  *normalPtr;     // 3 GLfloat
+      size_t      normalStride;
+      const void  *colorPtr;      // 4 GLubyte
+      size_t      colorStride;
+      size_t      dataNum;
+    } SourceInfo;
+
+    // Constants ---------------------------------------------------------------
+    static const size_t  MIN_TASK_SIZE  = 64 * 1024;  // points per thread
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getSourceInfo
+    // -------------------------------------------------------------------------
+    static SourceInfo getSourceInfo(const glXYZf_RGBAub *inDataPtr, size_t inDataNum)
+    {
+      SourceInfo  info;
+      info.xyzPtr       = &(inDataPtr->x);
+      info.xyzStride    = sizeof(glXYZf_RGBAub);
+      info.normalPtr    = NULL;
+      info.normalStride = 0;
+      info.colorPtr     = &(inDataPtr->r);
+      info.colorStride  = sizeof(glXYZf_RGBAub);
+      info.dataNum      = inDataNum;
+      return info;
+    }
+    // -------------------------------------------------------------------------
+    // getSourceInfo
+    // -------------------------------------------------------------------------
+    static SourceInfo getSourceInfo(const glXYZ_NORMf_RGBAub *inDataPtr, size_t inDataNum)
+    {
+      SourceInfo  info;
+      info.xyzPtr       = &(inDataPtr->x);
+      info.xyzStride    = sizeof(glXYZ_NORMf_RGBAub);
+      info.normalPtr    = &(inDataPtr->nx);
+      info.normalStride = sizeof(glXYZ_NORMf_RGBAub);
+      info.colorPtr     = &(inDataPtr->r);
+      info.colorStride  = sizeof(glXYZ_NORMf_RGBAub);
+      info.dataNum      = inDataNum;
+      return info;
+    }
+    // -------------------------------------------------------------------------
+    // getSourceInfo
+    // -------------------------------------------------------------------------
+    static SourceInfo getSourceInfo(const glXYZf *inDataPtr, size_t inDataNum)
+    {
+      SourceInfo  info;
+      info.xyzPtr       = &(inDataPtr->x);
+      info.xyzStride    = sizeof(glXYZf);
+      info.normalPtr    = NULL;
+      info.normalStride = 0;
+      info.colorPtr     = NULL;
+      info.colorStride  = 0;
+      info.dataNum      = inDataNum;
+      return info;
+    }
+    // -------------------------------------------------------------------------
+    // calcChunk
+    // -------------------------------------------------------------------------
+    // Sets origin and scale so that the min max box fits in [-1, 1]
+    static void calcChunk(const GLfloat inMinMax[6], size_t inFirst, size_t inCount,
+                          glQuantizedChunk *outChunk)
+    {
+      GLfloat scale = 0;
+      for (int i = 0; i < 3; i++)
+      {
+        outChunk->origin[i] = (inMinMax[i * 2] + inMinMax[i * 2 + 1]) / 2.0f;
+        GLfloat half = (inMinMax[i * 2 + 1] - inMinMax[i * 2]) / 2.0f;
+        if (half > scale)
+          scale = half;
+      }
+      if (!(scale > 0))   // also catches NaN (empty box)
+        scale = 1.0f;
+      outChunk->scale = scale;
+      outChunk->first = (GLuint )inFirst;
+      outChunk->count = (GLuint )inCount;
+    }
+    // -------------------------------------------------------------------------
+    // encode
+    // -------------------------------------------------------------------------
+    // Encodes all the points with one chunk (calculated if outChunk != NULL)
+    static bool encode(const SourceInfo &inSource, glXYZs_NORMoct_RGBAub *outDataPtr,
+                       glQuantizedChunk *outChunk, unsigned int inTaskNum = 0)
+    {
+      if (inSource.xyzPtr == NULL || outDataPtr == NULL || outChunk == NULL)
+        return false;
+      GLfloat minMax[6];
+      BoundingBox::calcMinMax(inSource.xyzPtr, inSource.dataNum, inSource.xyzStride,
+                              minMax, inTaskNum);
+      calcChunk(minMax, 0, inSource.dataNum, outChunk);
+      //
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inSource.dataNum, MIN_TASK_SIZE);
+      Parallel::forEachTask(inSource.dataNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          encodeKernel(inSource, inBegin, inEnd, *outChunk, outDataPtr);
+        });
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // encodeChunked
+    // -------------------------------------------------------------------------
+    // Splits the points into the chunks of inChunkSize points (in the source
+    // order) and encodes each chunk with its own origin and scale.
+    // The scanner order is usually coherent enough, otherwise sort the points
+    // spatially first.
+    static bool encodeChunked(const SourceInfo &inSource, size_t inChunkSize,
+                              glXYZs_NORMoct_RGBAub *outDataPtr,
+                              std::vector<glQuantizedChunk> *outChunks,
+                              unsigned int inTaskNum = 0)
+    {
+      if (inSource.xyzPtr == NULL || outDataPtr == NULL || outChunks == NULL ||
+          inChunkSize == 0)
+        return false;
+      size_t  chunkNum = (inSource.dataNum + inChunkSize - 1) / inChunkSize;
+      outChunks->resize(chunkNum);
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inSource.dataNum, MIN_TASK_SIZE);
+      if (inTaskNum > chunkNum)
+        inTaskNum = (unsigned int )(chunkNum == 0 ? 1 : chunkNum);
+      Parallel::forEachTask(chunkNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            size_t  first = inChunkSize * i;
+            size_t  count = inSource.dataNum - first;
+            if (count > inChunkSize)
+              count = inChunkSize;
+            GLfloat minMax[6];
+            BoundingBox::calcMinMax(
+              ((const unsigned char *)inSource.xyzPtr) + inSource.xyzStride * first,
+              count, inSource.xyzStride, minMax, 1);
+            calcChunk(minMax, first, count, &((*outChunks)[i]));
+            encodeKernel(inSource, first, first + count, (*outChunks)[i], outDataPtr);
+          }
+        });
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // encodeOct
+    // -------------------------------------------------------------------------
+    // Octahedral normal encoding (the normal doesn't need to be normalized)
+    static void encodeOct(GLfloat inX, GLfloat inY, GLfloat inZ, GLubyte outOct[2])
+    {
+      GLfloat l1 = std::fabs(inX) + std::fabs(inY) + std::fabs(inZ);
+      if (!(l1 > 0))
+      {
+        inX = 0;
+        inY = 0;
+        inZ = 1;
+        l1 = 1;
+      }
+      GLfloat px = inX / l1;
+      GLfloat py = inY / l1;
+      if (inZ < 0)
+      {
+        GLfloat tx = (1.0f - std::fabs(py)) * (px >= 0 ? 1.0f : -1.0f);
+        GLfloat ty = (1.0f - std::fabs(px)) * (py >= 0 ? 1.0f : -1.0f);
+        px = tx;
+        py = ty;
+      }
+      outOct[0] = (GLubyte )std::lround((px * 0.5f + 0.5f) * 255.0f);
+      outOct[1] = (GLubyte )std::lround((py * 0.5f + 0.5f) * 255.0f);
+    }
+    // -------------------------------------------------------------------------
+    // decodeOct
+    // -------------------------------------------------------------------------
+    // Same as the vertex shader (ibc/gl/shader/point_cloud_quantized.h)
+    static void decodeOct(const GLubyte inOct[2], GLfloat outNormal[3])
+    {
+      GLfloat x = inOct[0] / 255.0f * 2.0f - 1.0f;
+      GLfloat y = inOct[1] / 255.0f * 2.0f - 1.0f;
+      GLfloat z = 1.0f - std::fabs(x) - std::fabs(y);
+      GLfloat t = z < 0 ? -z : 0;
+      x += (x >= 0) ? -t : t;
+      y += (y >= 0) ? -t : t;
+      GLfloat len = std::sqrt(x * x + y * y + z * z);
+      outNormal[0] = x / len;
+      outNormal[1] = y / len;
+      outNormal[2] = z / len;
+    }
+    // -------------------------------------------------------------------------
+    // decodePosition
+    // -------------------------------------------------------------------------
+    static void decodePosition(const glXYZs_NORMoct_RGBAub &inData,
+                               const glQuantizedChunk &inChunk, GLfloat outXYZ[3])
+    {
+      GLshort q[3] = {inData.x, inData.y, inData.z};
+      for (int i = 0; i < 3; i++)
+      {
+        GLfloat v = q[i] / 32767.0f;
+        if (v < -1.0f)
+          v = -1.0f;
+        outXYZ[i] = inChunk.origin[i] + v * inChunk.scale;
+      }
+    }
+
+  protected:
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // encodeKernel
+    // -------------------------------------------------------------------------
+    static void encodeKernel(const SourceInfo &inSource, size_t inBegin, size_t inEnd,
+                             const glQuantizedChunk &inChunk,
+                             glXYZs_NORMoct_RGBAub *outDataPtr)
+    {
+      const unsigned char *xyzPtr = (const unsigned char *)inSource.xyzPtr;
+      GLfloat gain = 32767.0f / inChunk.scale;
+      size_t  i = inBegin;
+#ifdef IBC_GL_QUANTIZER_USE_SSE2
+      // 16 bytes are loaded for each point (see BoundingBox::calcMinMaxKernel)
+      size_t  vectorEnd = inEnd;
+      if (inSource.xyzStride < 16 && vectorEnd == inSource.dataNum)
+        vectorEnd--;
+      __m128  origin = _mm_setr_ps(inChunk.origin[0], inChunk.origin[1], inChunk.origin[2], 0);
+      __m128  gain4 = _mm_set1_ps(gain);
+      __m128  lower = _mm_set1_ps(-32767.0f);
+      __m128  upper = _mm_set1_ps(32767.0f);
+      for (; i < vectorEnd; i++)
+      {
+        __m128  v = _mm_loadu_ps((const float *)(xyzPtr + inSource.xyzStride * i));
+        v = _mm_mul_ps(_mm_sub_ps(v, origin), gain4);
+        v = _mm_min_ps(_mm_max_ps(v, lower), upper);
+        __m128i q = _mm_cvtps_epi32(v);
+        q = _mm_packs_epi32(q, q);
+        int32_t xy = _mm_cvtsi128_si32(q);
+        int32_t zw = _mm_cvtsi128_si32(_mm_srli_si128(q, 4));
+        ::memcpy(&(outDataPtr[i].x), &xy, sizeof(GLshort) * 2);
+        ::memcpy(&(outDataPtr[i].z), &zw, sizeof(GLshort));
+      }
+#endif
+      for (; i < inEnd; i++)
+      {
+        GLfloat xyz[3];
+        GLshort q[3];
+        ::memcpy(xyz, xyzPtr + inSource.xyzStride * i, sizeof(xyz));
+        for (int j = 0; j < 3; j++)
+        {
+          GLfloat v = (xyz[j] - inChunk.origin[j]) * gain;
+          if (!(v > -32767.0f))
+            v = -32767.0f;
+          if (v > 32767.0f)
+            v = 32767.0f;
+          q[j] = (GLshort )std::lrint(v);
+        }
+        outDataPtr[i].x = q[0];
+        outDataPtr[i].y = q[1];
+        outDataPtr[i].z = q[2];
+      }
+      //
+      const unsigned char *normalPtr = (const unsigned char *)inSource.normalPtr;
+      const unsigned char *colorPtr  = (const unsigned char *)inSource.colorPtr;
+      for (i = inBegin; i < inEnd; i++)
+      {
+        if (normalPtr != NULL)
+        {
+          GLfloat n[3];
+          ::memcpy(n, normalPtr + inSource.normalStride * i, sizeof(n));
+          encodeOct(n[0], n[1], n[2], &(outDataPtr[i].nx));
+        }
+        else
+        {
+          outDataPtr[i].nx = 128;
+          outDataPtr[i].ny = 128;
+        }
+        if (colorPtr != NULL)
+          ::memcpy(&(outDataPtr[i].r), colorPtr + inSource.colorStride * i, 4);
+        else
+          ::memset(&(outDataPtr[i].r), 255, 4);
+      }
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_QUANTIZER_H_
@@ -23,6 +23,7 @@
 
 // Includes --------------------------------------------------------------------
 #include <iostream>
+#include <type_traits>
 #include <math.h>
 #include "ibc/gl/vector.h"
 #include "ibc/gl/matrix.h"
@@ -48,7 +49,7 @@ namespace ibc
     static const int Qw   = 3;
 
     // Member variables (public) -----------------------------------------------
-    QuaternionType  mQ[4];
+    alignas(16) QuaternionType  mQ[4];
 
     // Constructors and Destructor ---------------------------------------------
     // -------------------------------------------------------------------------
@@ -75,24 +76,17 @@ namespace ibc
     // -------------------------------------------------------------------------
     // QuaternionBase (copy constructor)
     // -------------------------------------------------------------------------
-    QuaternionBase(const QuaternionBase<QuaternionType> &inQuaternion)
-    {
-      set(inQuaternion);
-    }
+    QuaternionBase(const QuaternionBase<QuaternionType> &inQuaternion) = default;
     // -------------------------------------------------------------------------
     // ~QuaternionBase
     // -------------------------------------------------------------------------
-    virtual ~QuaternionBase()
-    {
-    }
+    // Not virtual, so that the quaternions are trivially copyable
+    ~QuaternionBase() = default;
     // Operator overloading ----------------------------------------------------
     // -------------------------------------------------------------------------
     // =
     // -------------------------------------------------------------------------
-    QuaternionBase<QuaternionType> &operator=(const QuaternionBase<QuaternionType> &inQuaternion)
-    {
-      return set(inQuaternion);
-    }
+    QuaternionBase<QuaternionType> &operator=(const QuaternionBase<QuaternionType> &inQuaternion) = default;
     // -------------------------------------------------------------------------
     // []
     // -------------------------------------------------------------------------
@@ -487,6 +481,27 @@ namespace ibc
     // -------------------------------------------------------------------------
     static void  multi(QuaternionType outA[], const QuaternionType inB[], const QuaternionType inC[])
     {
+#ifdef IBC_MATRIX_USE_SSE2
+      if constexpr (std::is_same<QuaternionType, float>::value)
+      {
+        // A = Bw * C + Bx * (Cw, -Cz, Cy, -Cx) + By * (Cz, Cw, -Cx, -Cy)
+        //            + Bz * (-Cy, Cx, Cw, -Cz)
+        __m128  b = _mm_loadu_ps(inB);
+        __m128  c = _mm_loadu_ps(inC);
+        __m128  r = _mm_mul_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 3, 3)), c);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 0, 0, 0)),
+                _mm_xor_ps(_mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 1, 2, 3)),
+                           _mm_set_ps(-0.0f, 0, -0.0f, 0))));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 1, 1)),
+                _mm_xor_ps(_mm_shuffle_ps(c, c, _MM_SHUFFLE(1, 0, 3, 2)),
+                           _mm_set_ps(-0.0f, -0.0f, 0, 0))));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 2, 2)),
+                _mm_xor_ps(_mm_shuffle_ps(c, c, _MM_SHUFFLE(2, 3, 0, 1)),
+                           _mm_set_ps(-0.0f, 0, 0, -0.0f))));
+        _mm_storeu_ps(outA, r);
+        return;
+      }
+#endif
       outA[Qx] = inB[Qw] * inC[Qx] + inB[Qx] * inC[Qw] + inB[Qy] * inC[Qz] - inB[Qz] * inC[Qy];
       outA[Qy] = inB[Qw] * inC[Qy] - inB[Qx] * inC[Qz] + inB[Qy] * inC[Qw] + inB[Qz] * inC[Qx];
       outA[Qz] = inB[Qw] * inC[Qz] + inB[Qx] * inC[Qy] - inB[Qy] * inC[Qx] + inB[Qz] * inC[Qw];
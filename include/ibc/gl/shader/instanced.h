@@ -0,0 +1,86 @@
+// =============================================================================
+//  instanced.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/shader/instanced.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the Instanced shader
+*/
+
+#ifndef IBC_GL_SHADER_INSTANCED_H_
+#define IBC_GL_SHADER_INSTANCED_H_
+
+// Includes --------------------------------------------------------------------
+#include "ibc/gl/shader/shader_base.h"
+#include "ibc/gl/frame_uniforms.h"
+
+
+// Namespace -------------------------------------------------------------------
+//namespace ibc::gl::shader // <- nested namespace (C++17)
+namespace ibc { namespace gl { namespace shader
+{
+  // ---------------------------------------------------------------------------
+  // Instanced
+  // ---------------------------------------------------------------------------
+  // The Simple shader with the per-instance attributes (divisor 1)
+  // instanceMatrix : the model matrix of the instance (4 attribute slots)
+  // instanceColor  : the color of the instance
+  // colorMode 0 : vertex color * instance color
+  // colorMode 1 : instance color only
+  class Instanced : public virtual ibc::gl::shader::ShaderBase
+  {
+  public:
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // Instanced
+    // -------------------------------------------------------------------------
+    Instanced()
+    {
+      static const char *vertexShaderStr =
+        "#version 330\n"
+        "in vec3 position;\n"
+        "in vec3 color;\n"
+        "in mat4 instanceMatrix;\n"
+        "in vec4 instanceColor;\n"
+        IBC_GL_FRAME_UNIFORMS_GLSL
+        "uniform int colorMode;\n"
+        "smooth out vec4 vertexColor;\n"
+        "void main() {\n"
+        "  gl_Position = projection * modelview * instanceMatrix * vec4(position, 1.0);\n"
+        "  if (colorMode == 1)\n"
+        "    vertexColor = instanceColor;\n"
+        "  else\n"
+        "    vertexColor = vec4(color, 1.0) * instanceColor;\n"
+        "}\n";
+      static const char *fragmentShaderStr =
+        "#version 330\n"
+        "smooth in vec4 vertexColor;\n"
+        "out vec4 outputColor;\n"
+        "void main() {\n"
+        "  outputColor = vertexColor;\n"
+        "}\n";
+
+      mVertexShaderStr = vertexShaderStr;
+      mFragmentShaderStr = fragmentShaderStr;
+    }
+    // -------------------------------------------------------------------------
+    // ~Instanced
+    // -------------------------------------------------------------------------
+    virtual ~Instanced()
+    {
+    }
+  };
+};};};
+
+#endif  // #ifdef IBC_GL_SHADER_INSTANCED_H_
@@ -23,6 +23,7 @@
 
 // Includes --------------------------------------------------------------------
 #include "ibc/gl/shader/shader_base.h"
+#include "ibc/gl/frame_uniforms.h"
 
 
 // Namespace -------------------------------------------------------------------
@@ -45,11 +46,9 @@ namespace ibc { namespace gl { namespace shader
         "#version 330\n"
         "in vec3 position;"
         "in vec3 color;"
-        "uniform mat4 modelview;"
-        "uniform mat4 projection;"
+        IBC_GL_FRAME_UNIFORMS_GLSL
         "smooth out vec4 vertexColor;"
         "varying out vec3 light;"
-        "const vec4 lightSource = vec4(0.0, 0.0, 100.0, 1.0);"
         "void main() {"
         "  gl_Position = projection * modelview * vec4(position, 1.0);"
         "  gl_PointSize = 25 / gl_Position.w;"
@@ -92,7 +91,8 @@ namespace ibc { namespace gl { namespace shader
         return false;
       ShaderBase::initShader();
       glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
-      glEnable(GL_POINT_SPRITE);
+      if (StateTracker::isCoreProfile() == false)
+        glEnable(GL_POINT_SPRITE);  // always on in the core profile
       return true;
     }
   };
@@ -0,0 +1,138 @@
+// =============================================================================
+//  point_cloud_quantized.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/shader/point_cloud_quantized.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for PointCloud shader for the quantized points
+*/
+
+#ifndef IBC_GL_SHADER_POINT_CLOUD_QUANTIZED_H_
+#define IBC_GL_SHADER_POINT_CLOUD_QUANTIZED_H_
+
+// Includes --------------------------------------------------------------------
+#include "ibc/gl/shader/shader_base.h"
+#include "ibc/gl/frame_uniforms.h"
+
+
+// Namespace -------------------------------------------------------------------
+//namespace ibc::gl::shader // <- nested namespace (C++17)
+namespace ibc { namespace gl { namespace shader
+{
+  // ---------------------------------------------------------------------------
+  // PointCloudQuantized
+  // ---------------------------------------------------------------------------
+  class PointCloudQuantized : public virtual ibc::gl::shader::ShaderBase
+  {
+  public:
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // PointCloudQuantized
+    // -------------------------------------------------------------------------
+    PointCloudQuantized()
+    {
+      // position : glXYZs_NORMoct_RGBAub x, y, z (not normalized by GL)
+      // normal   : octahedral encoded nx, ny
+      // chunk    : origin (xyz) and scale (w) of glQuantizedChunk
+      static const char *vertexShaderStr =
+        "#version 330\n"
+        "in vec3 position;"
+        "in vec2 normal;"
+        "in vec4 color;"
+        "uniform vec4 chunk;"
+        "uniform vec4 fit;"
+        IBC_GL_FRAME_UNIFORMS_GLSL
+        "uniform float pointSize;"
+        "uniform int colorMode;"
+        "uniform int shadingMode;"
+        "uniform vec4 colorMapParam;"
+        "uniform vec4 singleColor;"
+        "uniform highp sampler1D colorMapTexture;"
+        "smooth out vec4 vertexColor;"
+        "vec3 decodeOct(vec2 e) {"
+        "  e = e / 255.0 * 2.0 - 1.0;"
+        "  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));"
+        "  float t = max(-n.z, 0.0);"
+        "  n.x += (n.x >= 0.0) ? -t : t;"
+        "  n.y += (n.y >= 0.0) ? -t : t;"
+        "  return normalize(n);"
+        "}"
+        "void main() {"
+        "  vec3 decoded = chunk.xyz + max(position / 32767.0, -1.0) * chunk.w;"
+        "  vec3 scaled = (decoded + vec3(fit.x, fit.y, fit.z)) * fit.w;"
+        "  gl_Position = projection * modelview * vec4(scaled, 1.0);"
+        "  gl_PointSize = pointSize / gl_Position.w;"
+        "  float colorIndex;"
+        "  if (colorMapParam.x == 0)"
+        "    colorIndex = decoded.x;"
+        "  else if (colorMapParam.x == 1)"
+        "    colorIndex = decoded.y;"
+        "  else"
+        "    colorIndex = decoded.z;"
+        "  colorIndex = (colorIndex - colorMapParam.y) * colorMapParam.z;"
+        "  vec4 mappedColor;"
+        "  if (colorIndex < 0 || colorIndex > 1)"
+        "    mappedColor = vec4(singleColor.rgb, colorMapParam.w);"
+        "  else"
+        "    mappedColor = texture(colorMapTexture, colorIndex);"
+        "  if (colorMode == 0)"
+        "    vertexColor = singleColor;"
+        "  else if (colorMode == 1)"
+        "    vertexColor = mappedColor;"
+        "  else"
+        "    vertexColor = color / 255.0;"
+        "  if (shadingMode == 1) {"
+        "    vec4 viewPos = modelview * vec4(scaled, 1.0);"
+        "    vec3 n = normalize(mat3(modelview) * decodeOct(normal));"
+        "    vec3 light = normalize(vec3(lightSource - viewPos));"
+        "    float d = abs(dot(n, light));"
+        "    vertexColor.rgb = vertexColor.rgb * (0.2 + 0.8 * d);"
+        "  }"
+        "}";
+      static const char *fragmentShaderStr =
+        "#version 330\n"
+        "smooth in vec4 vertexColor;"
+        "out vec4 outputColor;"
+        "void main() {"
+        "  if (vertexColor.w == 0)"
+        "    discard;"
+        "  vec2 p = gl_PointCoord * 2.0 - 1.0;"
+        "  if (dot(p, p) > 1.0) discard;" // To make it circle
+        "  outputColor = vertexColor;"
+        "}";
+
+      mVertexShaderStr = vertexShaderStr;
+      mFragmentShaderStr = fragmentShaderStr;
+    }
+    // -------------------------------------------------------------------------
+    // ~PointCloudQuantized
+    // -------------------------------------------------------------------------
+    virtual ~PointCloudQuantized()
+    {
+    }
+    // Member functions -------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // initShader
+    // -------------------------------------------------------------------------
+    virtual bool initShader()
+    {
+      if (ShaderBase::initShader() == false)
+        return false;
+      glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+      return true;
+    }
+  };
+};};};
+
+#endif  // #ifdef IBC_GL_SHADER_POINT_CLOUD_QUANTIZED_H_
@@ -23,6 +23,7 @@
 
 // Includes --------------------------------------------------------------------
 #include "ibc/gl/shader/shader_base.h"
+#include "ibc/gl/frame_uniforms.h"
 
 
 // Namespace -------------------------------------------------------------------
@@ -46,8 +47,7 @@ namespace ibc { namespace gl { namespace shader
         "in vec3 position;"
         "in vec4 color;"
         "uniform vec4 fit;"
-        "uniform mat4 modelview;"
-        "uniform mat4 projection;"
+        IBC_GL_FRAME_UNIFORMS_GLSL
         "uniform float pointSize;"
         "uniform int colorMode;"
         "uniform vec4 colorMapParam;"
@@ -56,7 +56,6 @@ namespace ibc { namespace gl { namespace shader
         "smooth out vec4 vertexColor;"
 //      "varying out vec3 light;"
         "out vec3 light;"
-        "const vec4 lightSource = vec4(0.0, 0.0, 100.0, 1.0);"
         "void main() {"
         "  vec3 scaled;"
         "  scaled = (position + vec3(fit.x, fit.y, fit.z)) * fit.w;"
@@ -122,7 +121,8 @@ namespace ibc { namespace gl { namespace shader
         return false;
       ShaderBase::initShader();
       glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
-      glEnable(GL_POINT_SPRITE);
+      if (StateTracker::isCoreProfile() == false)
+        glEnable(GL_POINT_SPRITE);  // always on in the core profile
       return true;
     }
   };
@@ -0,0 +1,204 @@
+// =============================================================================
+//  point_splat.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/models/point_splat.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the PointSplat shaders (sphere impostors)
+*/
+
+#ifndef IBC_GL_SHADER_POINT_SPLAT_H_
+#define IBC_GL_SHADER_POINT_SPLAT_H_
+
+// Includes --------------------------------------------------------------------
+#include "ibc/gl/shader/shader_base.h"
+#include "ibc/gl/frame_uniforms.h"
+
+
+// Namespace -------------------------------------------------------------------
+//namespace ibc::gl::shader // <- nested namespace (C++17)
+namespace ibc { namespace gl { namespace shader
+{
+  // ---------------------------------------------------------------------------
+  // PointSplat
+  // ---------------------------------------------------------------------------
+  // The same inputs as PointCloudRGBA8, but each point is drawn as a sphere
+  // of splatRadius (in the fitted model space) and the fragment depth is the
+  // depth of the sphere surface, so the overlapping splats intersect
+  // correctly instead of stacking flat discs.
+  // The point itself is rasterized at the depth of the sphere front, so the
+  // fragment depth can only move back (depth_greater of
+  // GL_ARB_conservative_depth) and the early depth test is kept.
+  // splatMode 0 : opaque spheres
+  // splatMode 1 : visibility pass (depth only, pushed back by splatRadius)
+  // splatMode 2 : accumulation pass (color * weight, weight) for blending
+  class PointSplat : public virtual ibc::gl::shader::ShaderBase
+  {
+  public:
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // PointSplat
+    // -------------------------------------------------------------------------
+    PointSplat()
+    {
+      static const char *vertexShaderStr =
+        "#version 330\n"
+        "in vec3 position;\n"
+        "in vec4 color;\n"
+        "uniform vec4 fit;\n"
+        IBC_GL_FRAME_UNIFORMS_GLSL
+        "uniform float splatRadius;\n"
+        "uniform int colorMode;\n"
+        "uniform vec4 colorMapParam;\n"
+        "uniform vec4 singleColor;\n"
+        "uniform highp sampler1D colorMapTexture;\n"
+        "smooth out vec4 vertexColor;\n"
+        "flat out vec3 center;\n"
+        "void main() {\n"
+        "  vec3 scaled = (position + vec3(fit.x, fit.y, fit.z)) * fit.w;\n"
+        "  vec4 p = modelview * vec4(scaled, 1.0);\n"
+        "  center = p.xyz;\n"
+        "  gl_Position = projection * p;\n"
+        "  gl_PointSize = max(splatRadius * projection[1][1] * viewport.w\n"
+        "                     / gl_Position.w, 1.0);\n"
+        "  vec4 front = projection * vec4(p.xy, p.z + splatRadius, 1.0);\n"
+        "  gl_Position.z = max(front.z / front.w, -1.0) * gl_Position.w;\n"
+        "  float colorIndex;\n"
+        "  if (colorMapParam.x == 0)\n"
+        "    colorIndex = position.x;\n"
+        "  else if (colorMapParam.x == 1)\n"
+        "    colorIndex = position.y;\n"
+        "  else\n"
+        "    colorIndex = position.z;\n"
+        "  colorIndex = (colorIndex - colorMapParam.y) * colorMapParam.z;\n"
+        "  vec4 mappedColor;\n"
+        "  if (colorIndex < 0 || colorIndex > 1)\n"
+        "    mappedColor = vec4(singleColor.rgb, colorMapParam.w);\n"
+        "  else\n"
+        "    mappedColor = texture(colorMapTexture, colorIndex);\n"
+        "  if (colorMode == 0)\n"
+        "    vertexColor = singleColor;\n"
+        "  else if (colorMode == 1)\n"
+        "    vertexColor = mappedColor;\n"
+        "  else\n"
+        "    vertexColor = color / 255.0;\n"
+        "}\n";
+      static const char *fragmentShaderStr =
+        "#version 330\n"
+        "#extension GL_ARB_conservative_depth : enable\n"
+        "#ifdef GL_ARB_conservative_depth\n"
+        "layout(depth_greater) out float gl_FragDepth;\n"
+        "#endif\n"
+        "smooth in vec4 vertexColor;\n"
+        "flat in vec3 center;\n"
+        IBC_GL_FRAME_UNIFORMS_GLSL
+        "uniform float splatRadius;\n"
+        "uniform int splatMode;\n"
+        "uniform int shadingMode;\n"
+        "out vec4 outputColor;\n"
+        "void main() {\n"
+        "  if (vertexColor.w == 0)\n"
+        "    discard;\n"
+        "  vec3 n;\n"
+        "  n.xy = gl_PointCoord * 2.0 - 1.0;\n"
+        "  n.y = -n.y;\n"
+        "  float r2 = dot(n.xy, n.xy);\n"
+        "  if (r2 > 1.0) discard;\n"
+        "  n.z = sqrt(1.0 - r2);\n"
+        "  vec3 p = center + n * splatRadius;\n"
+        "  if (splatMode == 1)\n"
+        "    p.z -= splatRadius;\n"
+        "  vec4 clip = projection * vec4(p, 1.0);\n"
+        "  gl_FragDepth = (gl_DepthRange.diff * clip.z / clip.w +\n"
+        "                  gl_DepthRange.near + gl_DepthRange.far) * 0.5;\n"
+        "  float d = 1.0;\n"
+        "  if (shadingMode == 1)\n"
+        "    d = 0.3 + 0.7 * n.z;\n"
+        "  if (splatMode == 2) {\n"
+        "    float w = 1.0 - r2;\n"
+        "    outputColor = vec4(vertexColor.rgb * d * w, w);\n"
+        "  } else\n"
+        "    outputColor = vec4(vertexColor.rgb * d, vertexColor.a);\n"
+        "}\n";
+
+      mVertexShaderStr = vertexShaderStr;
+      mFragmentShaderStr = fragmentShaderStr;
+    }
+    // -------------------------------------------------------------------------
+    // ~PointSplat
+    // -------------------------------------------------------------------------
+    virtual ~PointSplat()
+    {
+    }
+    // Member functions -------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // initShader
+    // -------------------------------------------------------------------------
+    virtual bool initShader()
+    {
+      if (ShaderBase::initShader() == false)
+        return false;
+      glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+      return true;
+    }
+  };
+
+  // ---------------------------------------------------------------------------
+  // PointSplatResolve
+  // ---------------------------------------------------------------------------
+  // Normalizes the accumulated splats (rgb / weight) and writes the depth of
+  // the visibility pass, drawn as a full screen triangle (no vertex data)
+  class PointSplatResolve : public virtual ibc::gl::shader::ShaderBase
+  {
+  public:
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // PointSplatResolve
+    // -------------------------------------------------------------------------
+    PointSplatResolve()
+    {
+      static const char *vertexShaderStr =
+        "#version 330\n"
+        "void main() {\n"
+        "  vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+        "  gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+        "}\n";
+      static const char *fragmentShaderStr =
+        "#version 330\n"
+        "uniform sampler2D accumMap;\n"
+        "uniform sampler2D depthMap;\n"
+        IBC_GL_FRAME_UNIFORMS_GLSL
+        "out vec4 outputColor;\n"
+        "void main() {\n"
+        "  ivec2 p = ivec2(gl_FragCoord.xy - viewport.xy);\n"
+        "  vec4 accum = texelFetch(accumMap, p, 0);\n"
+        "  if (accum.a <= 0.0)\n"
+        "    discard;\n"
+        "  outputColor = vec4(accum.rgb / accum.a, 1.0);\n"
+        "  gl_FragDepth = texelFetch(depthMap, p, 0).r;\n"
+        "}\n";
+
+      mVertexShaderStr = vertexShaderStr;
+      mFragmentShaderStr = fragmentShaderStr;
+    }
+    // -------------------------------------------------------------------------
+    // ~PointSplatResolve
+    // -------------------------------------------------------------------------
+    virtual ~PointSplatResolve()
+    {
+    }
+  };
+};};};
+
+#endif  // #ifdef IBC_GL_SHADER_POINT_SPLAT_H_
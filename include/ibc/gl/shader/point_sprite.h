@@ -23,6 +23,7 @@
 
 // Includes --------------------------------------------------------------------
 #include "ibc/gl/shader/shader_base.h"
+#include "ibc/gl/frame_uniforms.h"
 
 
 // Namespace -------------------------------------------------------------------
@@ -52,9 +53,7 @@ namespace ibc { namespace gl { namespace shader
         "uniform float intensityGain;\n"
         "uniform float intensityOffset;\n"
         "uniform vec2  intensityClamp;\n"
-        "uniform vec4 lightSource;\n"
-        "uniform mat4 modelview;\n"
-        "uniform mat4 projection;\n"
+        IBC_GL_FRAME_UNIFORMS_GLSL
         "flat out int colorMapIndex;\n"
         "out vec3 light;\n"
         "void main() {\n"
@@ -116,7 +115,8 @@ namespace ibc { namespace gl { namespace shader
       if (ShaderBase::initShader() == false)
         return false;
       glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
-      glEnable(GL_POINT_SPRITE);
+      if (StateTracker::isCoreProfile() == false)
+        glEnable(GL_POINT_SPRITE);  // always on in the core profile
       return true;
     }
   };
@@ -22,7 +22,26 @@
 #define IBC_GL_SHADER_SHADER_BASE_H_
 
 // Includes --------------------------------------------------------------------
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "ibc/gl/shader_interface.h"
+#include "ibc/gl/program_cache.h"
+#include "ibc/gl/frame_uniforms.h"
+#include "ibc/gl/state_tracker.h"
+
+// Macros ----------------------------------------------------------------------
+// The program binary (glGetProgramBinary) needs OpenGL 4.1
+// or GL_ARB_get_program_binary
+#ifdef QT_VERSION
+ #if LIBIBC_OPENGL_MAJOR_VER > 4 || \
+     (LIBIBC_OPENGL_MAJOR_VER == 4 && LIBIBC_OPENGL_MINOR_VER >= 1)
+  #define IBC_GL_USE_PROGRAM_BINARY
+ #endif
+#elif defined(GL_VERSION_4_1) || defined(GL_ARB_get_program_binary)
+ #define IBC_GL_USE_PROGRAM_BINARY
+#endif
 
 
 // Namespace -------------------------------------------------------------------
@@ -51,6 +70,7 @@ namespace ibc { namespace gl { namespace shader
       mFragmentShader   = 0;
       mGeometryShader  = 0;
       mShaderProgram    = 0;
+      mShareGroup       = NULL;
 
       mVertexShaderStr     = inVetexShaderStr;
       mFragmentShaderStr  = inFragmentShaderStr;
@@ -70,6 +90,10 @@ namespace ibc { namespace gl { namespace shader
     // -------------------------------------------------------------------------
     // initShader
     // -------------------------------------------------------------------------
+    // The program is taken from (in this order)
+    //  1. ProgramRegistry : the same program built by another view
+    //  2. ProgramCache    : the program binary on the disk
+    //  3. the shader sources
     virtual bool initShader()
     {
 #ifdef QT_VERSION
@@ -82,48 +106,38 @@ namespace ibc { namespace gl { namespace shader
       if (initCheck() == false)
         return false;
 
+      const char *sources[3] =
+        {getVertexShaderStr(), getFragmentShaderStr(), getGeometryShaderStr()};
+      mProgramKey = ProgramCache::makeKey(sources, 3);
+      mShareGroup = ProgramRegistry::getCurrentShareGroup();
+      if (mShareGroup != NULL &&
+          ProgramRegistry::getInstance()->acquire(mShareGroup, mProgramKey,
+                                                  &mShaderProgram, &mLocationCache))
+        return true;
+
       mShaderProgram = glCreateProgram();
       if (mShaderProgram == 0)
         return false;
+      mLocationCache = std::make_shared<ProgramRegistry::LocationCache>();
 
-      const GLchar  *shaderStr[1];
-      shaderStr[0] = getVertexShaderStr();
-      if (shaderStr[0] != NULL)
+      if (loadProgramBinary() == false)
       {
-        mVertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(mVertexShader, 1, shaderStr, NULL);
-        glCompileShader(mVertexShader);
-        if (handleShaderCompileError(mVertexShader, "mVertexShader"))
+        if (compileProgram() == false)
+        {
+          glDeleteProgram(mShaderProgram);
+          mShaderProgram = 0;
           return false;
-        glAttachShader(mShaderProgram, mVertexShader);
+        }
+        saveProgramBinary();
       }
+      bindFrameUniforms();
 
-      shaderStr[0] = getFragmentShaderStr();
-      if (shaderStr[0] != NULL)
-      {
-        mFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(mFragmentShader, 1, shaderStr, NULL);
-        glCompileShader(mFragmentShader);
-        if (handleShaderCompileError(mFragmentShader, "mFragmentShader"))
-          return false;
-        glAttachShader(mShaderProgram, mFragmentShader);
-      }
-
-      shaderStr[0] = getGeometryShaderStr();
-      if (shaderStr[0] != NULL)
-      {
-        mGeometryShader = glCreateShader(GL_GEOMETRY_SHADER);
-        glShaderSource(mGeometryShader, 1, shaderStr, NULL);
-        glCompileShader(mGeometryShader);
-        if (handleShaderCompileError(mGeometryShader, "mGeometryShader"))
-          return false;
-        glAttachShader(mShaderProgram, mGeometryShader);
-      }
-
-      glLinkProgram(mShaderProgram);
-      if (handleProgramError(mShaderProgram))
-        return false;
-
+      // Another view may have built the same program at the same time
+      GLuint  program = mShaderProgram;
+      if (mShareGroup != NULL &&
+          ProgramRegistry::getInstance()->add(mShareGroup, mProgramKey,
+                                              &mShaderProgram, &mLocationCache) == false)
+        glDeleteProgram(program);
       return true;
     }
     // -------------------------------------------------------------------------
@@ -159,8 +173,30 @@ namespace ibc { namespace gl { namespace shader
     // -------------------------------------------------------------------------
     // disposeShader
     // -------------------------------------------------------------------------
+    // The program is deleted when the last view sharing it is disposed
     virtual void disposeShader()
     {
+      if (mShaderProgram == 0)
+        return;
+      bool  isLast = true;
+      if (mShareGroup != NULL)
+        isLast = ProgramRegistry::getInstance()->release(mShareGroup, mProgramKey);
+      if (isLast)
+      {
+        if (mVertexShader != 0)
+          glDeleteShader(mVertexShader);
+        if (mFragmentShader != 0)
+          glDeleteShader(mFragmentShader);
+        if (mGeometryShader != 0)
+          glDeleteShader(mGeometryShader);
+        glDeleteProgram(mShaderProgram);
+        StateTracker::getInstance()->deleteProgram(mShaderProgram);
+      }
+      mVertexShader = 0;
+      mFragmentShader = 0;
+      mGeometryShader = 0;
+      mShaderProgram = 0;
+      mLocationCache.reset();
     }
     // -------------------------------------------------------------------------
     // getShaderProgram
@@ -190,6 +226,37 @@ namespace ibc { namespace gl { namespace shader
     {
       return mGeometryShader;
     }
+    // -------------------------------------------------------------------------
+    // getUniformLocation
+    // -------------------------------------------------------------------------
+    // Cached per program (shared by all the views using the same program)
+    virtual GLint getUniformLocation(const char *inName)
+    {
+      if (mLocationCache == NULL)
+        return -1;
+      std::lock_guard<std::mutex> lock(mLocationCache->mutex);
+      auto it = mLocationCache->uniforms.find(inName);
+      if (it != mLocationCache->uniforms.end())
+        return it->second;
+      GLint location = glGetUniformLocation(mShaderProgram, inName);
+      mLocationCache->uniforms[inName] = location;
+      return location;
+    }
+    // -------------------------------------------------------------------------
+    // getAttribLocation
+    // -------------------------------------------------------------------------
+    virtual GLint getAttribLocation(const char *inName)
+    {
+      if (mLocationCache == NULL)
+        return -1;
+      std::lock_guard<std::mutex> lock(mLocationCache->mutex);
+      auto it = mLocationCache->attribs.find(inName);
+      if (it != mLocationCache->attribs.end())
+        return it->second;
+      GLint location = glGetAttribLocation(mShaderProgram, inName);
+      mLocationCache->attribs[inName] = location;
+      return location;
+    }
 
   protected:
     // Member variables --------------------------------------------------------
@@ -200,6 +267,9 @@ namespace ibc { namespace gl { namespace shader
     GLuint mGeometryShader;
     const char  *mGeometryShaderStr;
     GLuint mShaderProgram;
+    std::string mProgramKey;    // hash of the sources
+    const void  *mShareGroup;
+    std::shared_ptr<ProgramRegistry::LocationCache> mLocationCache;
 #ifdef QT_VERSION
     bool  mOpenGLFunctionsInitialized;
 #endif
@@ -239,6 +309,133 @@ namespace ibc { namespace gl { namespace shader
         return false;
       return true;
     }
+    // -------------------------------------------------------------------------
+    // bindFrameUniforms
+    // -------------------------------------------------------------------------
+    // Connects the FrameUniforms block (if declared) to the view's buffer
+    void bindFrameUniforms()
+    {
+      GLuint  index = glGetUniformBlockIndex(mShaderProgram, "FrameUniforms");
+      if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(mShaderProgram, index, FrameUniforms::BINDING_POINT);
+    }
+    // -------------------------------------------------------------------------
+    // compileProgram
+    // -------------------------------------------------------------------------
+    bool compileProgram()
+    {
+      const GLchar  *shaderStr[1];
+      shaderStr[0] = getVertexShaderStr();
+      if (shaderStr[0] != NULL)
+      {
+        mVertexShader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(mVertexShader, 1, shaderStr, NULL);
+        glCompileShader(mVertexShader);
+        if (handleShaderCompileError(mVertexShader, "mVertexShader"))
+          return false;
+        glAttachShader(mShaderProgram, mVertexShader);
+      }
+
+      shaderStr[0] = getFragmentShaderStr();
+      if (shaderStr[0] != NULL)
+      {
+        mFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(mFragmentShader, 1, shaderStr, NULL);
+        glCompileShader(mFragmentShader);
+        if (handleShaderCompileError(mFragmentShader, "mFragmentShader"))
+          return false;
+        glAttachShader(mShaderProgram, mFragmentShader);
+      }
+
+      shaderStr[0] = getGeometryShaderStr();
+      if (shaderStr[0] != NULL)
+      {
+        mGeometryShader = glCreateShader(GL_GEOMETRY_SHADER);
+        glShaderSource(mGeometryShader, 1, shaderStr, NULL);
+        glCompileShader(mGeometryShader);
+        if (handleShaderCompileError(mGeometryShader, "mGeometryShader"))
+          return false;
+        glAttachShader(mShaderProgram, mGeometryShader);
+      }
+
+#ifdef IBC_GL_USE_PROGRAM_BINARY
+      if (isProgramBinaryEnabled())
+        glProgramParameteri(mShaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+      glLinkProgram(mShaderProgram);
+      if (handleProgramError(mShaderProgram))
+        return false;
+
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // loadProgramBinary
+    // -------------------------------------------------------------------------
+    // Returns false if the cache is disabled, missed or rejected by the driver
+    bool loadProgramBinary()
+    {
+#ifdef IBC_GL_USE_PROGRAM_BINARY
+      if (isProgramBinaryEnabled() == false)
+        return false;
+      GLenum  format;
+      std::vector<unsigned char>  binary;
+      if (ProgramCache::read(getBinaryKey(), &format, &binary) == false)
+        return false;
+      glProgramBinary(mShaderProgram, format, binary.data(), (GLsizei )binary.size());
+      GLint result = GL_FALSE;
+      glGetProgramiv(mShaderProgram, GL_LINK_STATUS, &result);
+      return (result != GL_FALSE);
+#else
+      return false;
+#endif
+    }
+    // -------------------------------------------------------------------------
+    // saveProgramBinary
+    // -------------------------------------------------------------------------
+    void saveProgramBinary()
+    {
+#ifdef IBC_GL_USE_PROGRAM_BINARY
+      if (isProgramBinaryEnabled() == false)
+        return;
+      GLint length = 0;
+      glGetProgramiv(mShaderProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+      if (length <= 0)
+        return;
+      std::vector<unsigned char>  binary(length);
+      GLenum  format;
+      glGetProgramBinary(mShaderProgram, length, &length, &format, binary.data());
+      binary.resize(length);
+      ProgramCache::write(getBinaryKey(), format, binary);
+#endif
+    }
+#ifdef IBC_GL_USE_PROGRAM_BINARY
+    // -------------------------------------------------------------------------
+    // isProgramBinaryEnabled
+    // -------------------------------------------------------------------------
+    bool isProgramBinaryEnabled()
+    {
+      if (ProgramCache::isEnabled() == false)
+        return false;
+      GLint num = 0;
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num);
+      return (num > 0);
+    }
+    // -------------------------------------------------------------------------
+    // getBinaryKey
+    // -------------------------------------------------------------------------
+    // The binary is valid only for the same driver
+    std::string getBinaryKey()
+    {
+      const char *strs[4] =
+      {
+        mProgramKey.c_str(),
+        (const char *)glGetString(GL_VENDOR),
+        (const char *)glGetString(GL_RENDERER),
+        (const char *)glGetString(GL_VERSION)
+      };
+      return ProgramCache::makeKey(strs, 4);
+    }
+#endif
     // -------------------------------------------------------------------------
     // getShaderCompileError
     // -------------------------------------------------------------------------
@@ -23,6 +23,7 @@
 
 // Includes --------------------------------------------------------------------
 #include "ibc/gl/shader/shader_base.h"
+#include "ibc/gl/frame_uniforms.h"
 
 
 // Namespace -------------------------------------------------------------------
@@ -45,8 +46,7 @@ namespace ibc { namespace gl { namespace shader
         "#version 330\n"
         "in vec3 position;"
         "in vec3 color;"
-        "uniform mat4 modelview;"
-        "uniform mat4 projection;"
+        IBC_GL_FRAME_UNIFORMS_GLSL
         "smooth out vec4 vertexColor;"
         "void main() {"
         "  gl_Position = projection * modelview * vec4(position, 1.0);"
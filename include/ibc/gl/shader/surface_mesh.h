@@ -0,0 +1,121 @@
+// =============================================================================
+//  surface_mesh.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/models/surface_mesh.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the SurfaceMesh shader (for the SurfacePlot)
+*/
+
+#ifndef IBC_GL_SHADER_SURFACE_MESH_H_
+#define IBC_GL_SHADER_SURFACE_MESH_H_
+
+// Includes --------------------------------------------------------------------
+#include "ibc/gl/shader/shader_base.h"
+#include "ibc/gl/frame_uniforms.h"
+
+
+// Namespace -------------------------------------------------------------------
+//namespace ibc::gl::shader // <- nested namespace (C++17)
+namespace ibc { namespace gl { namespace shader
+{
+  // ---------------------------------------------------------------------------
+  // SurfaceMesh
+  // ---------------------------------------------------------------------------
+  // The mesh version of PointSprite. The vertex index (gl_VertexID) selects
+  // the sample of the height map texture, so no vertex attribute is needed.
+  // The normal is calculated from the neighbor samples.
+  class SurfaceMesh : public virtual ibc::gl::shader::ShaderBase
+  {
+  public:
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // SurfaceMesh
+    // -------------------------------------------------------------------------
+    SurfaceMesh()
+    {
+      static const char *vertexShaderStr =
+        "#version 330\n"
+        "uniform sampler2D heightMap;\n"
+        "uniform float heightScale;\n"
+        "uniform sampler1D s;\n"
+        "uniform vec2 dataSize;\n"
+        "uniform float zGain;\n"
+        "uniform float zOffset;\n"
+        "uniform vec2  zClamp;\n"
+        "uniform float intensityGain;\n"
+        "uniform float intensityOffset;\n"
+        "uniform vec2  intensityClamp;\n"
+        IBC_GL_FRAME_UNIFORMS_GLSL
+        "out vec4 color;\n"
+        "out vec3 normal;\n"
+        "out vec3 light;\n"
+        "float intensityAt(int i, int j) {\n"
+        "  ivec2 p = clamp(ivec2(j, i), ivec2(0), ivec2(dataSize) - 1);\n"
+        "  return texelFetch(heightMap, p, 0).r * heightScale;\n"
+        "}\n"
+        "float heightAt(int i, int j) {\n"
+        "  return clamp(intensityAt(i, j) * zGain + zOffset, zClamp.x, zClamp.y);\n"
+        "}\n"
+        "void main() {\n"
+        "  float pitch = 2.0 / dataSize.x;\n"
+        "  int i = gl_VertexID / int(dataSize.x);\n"
+        "  int j = gl_VertexID - int(dataSize.x) * i;\n"
+        "  float intensity = intensityAt(i, j);\n"
+        "  vec3 position;\n"
+        "  position.x = -1.0 + pitch * j;\n"
+        "  position.y = -1.0 + pitch * i;\n"
+        "  position.z = clamp(intensity * zGain + zOffset, zClamp.x, zClamp.y);\n"
+        "  vec3 n;\n"
+        "  n.x = (heightAt(i, j - 1) - heightAt(i, j + 1)) / (2.0 * pitch);\n"
+        "  n.y = (heightAt(i - 1, j) - heightAt(i + 1, j)) / (2.0 * pitch);\n"
+        "  n.z = 1.0;\n"
+        "  vec4 p = modelview * vec4(position, 1.0);\n"
+        "  gl_Position = projection * p;\n"
+        "  normal = mat3(modelview) * normalize(n);\n"
+        "  light = lightSource.xyz - p.xyz;\n"
+        "  float v = clamp(intensity * intensityGain + intensityOffset,\n"
+        "                  intensityClamp.x, intensityClamp.y);\n"
+        "  color = texelFetch(s, int(v), 0);\n"
+        "}\n";
+
+      static const char *fragmentShaderStr =
+        "#version 330\n"
+        "uniform int material;\n"
+        "in vec4 color;\n"
+        "in vec3 normal;\n"
+        "in vec3 light;\n"
+        "out vec4 outputColor;\n"
+        "void main() {\n"
+        "  float d;\n"
+        "  if (material == 0)\n"
+        "    d = 1.0;\n"
+        "  else\n"
+        "    d = 0.2 + 0.8 * abs(dot(normalize(light), normalize(normal)));\n"
+        "  outputColor = vec4(color.rgb * d, 1.0);\n"
+        "}";
+
+      mVertexShaderStr = vertexShaderStr;
+      mFragmentShaderStr = fragmentShaderStr;
+    }
+    // -------------------------------------------------------------------------
+    // ~SurfaceMesh
+    // -------------------------------------------------------------------------
+    virtual ~SurfaceMesh()
+    {
+    }
+  };
+};};};
+
+#endif  // #ifdef IBC_GL_SHADER_SURFACE_MESH_H_
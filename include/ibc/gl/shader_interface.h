@@ -38,6 +38,8 @@ namespace ibc
     virtual GLuint  getVertexShader() = 0;
     virtual GLuint  getFragmentShader() = 0;
     virtual GLuint  geGeometryShader() = 0;
+    virtual GLint   getUniformLocation(const char *inName) = 0;
+    virtual GLint   getAttribLocation(const char *inName) = 0;
   };
  };
 };
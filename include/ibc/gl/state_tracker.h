@@ -0,0 +1,196 @@
+// =============================================================================
+//  state_tracker.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/state_tracker.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the GL binding state tracker
+*/
+
+#ifndef IBC_GL_STATE_TRACKER_H_
+#define IBC_GL_STATE_TRACKER_H_
+
+// Includes --------------------------------------------------------------------
+#include "ibc/base/types.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // StateTracker class
+  // ---------------------------------------------------------------------------
+  // Remembers the current program, vertex array and textures (1D and 2D),
+  // so that the redundant binds between the models can be skipped.
+  // Each set function returns true if the GL call is needed. The tracker
+  // doesn't call GL (the models call it with their own GL functions),
+  // except isCoreProfile().
+  //
+  // There is one tracker per thread, not per context, so the view should
+  // call invalidate() after making its context current (the view classes
+  // do this before the initialization and each frame). The code which binds
+  // the objects without the tracker should also call invalidate().
+  class StateTracker
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static const int    TEXTURE_UNIT_NUM  = 16;
+    static const GLuint UNKNOWN           = 0xFFFFFFFF;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // invalidate
+    // -------------------------------------------------------------------------
+    void invalidate()
+    {
+      mProgram = UNKNOWN;
+      mVertexArray = UNKNOWN;
+      mActiveTexture = UNKNOWN;
+      for (int i = 0; i < TEXTURE_UNIT_NUM; i++)
+      {
+        mTextures[i][0] = UNKNOWN;
+        mTextures[i][1] = UNKNOWN;
+      }
+    }
+    // -------------------------------------------------------------------------
+    // useProgram
+    // -------------------------------------------------------------------------
+    bool useProgram(GLuint inProgram)
+    {
+      if (mProgram == inProgram)
+        return false;
+      mProgram = inProgram;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // bindVertexArray
+    // -------------------------------------------------------------------------
+    bool bindVertexArray(GLuint inVertexArray)
+    {
+      if (mVertexArray == inVertexArray)
+        return false;
+      mVertexArray = inVertexArray;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // activeTexture
+    // -------------------------------------------------------------------------
+    bool activeTexture(GLenum inTextureUnit)
+    {
+      GLuint  unit = (GLuint )(inTextureUnit - GL_TEXTURE0);
+      if (mActiveTexture == unit)
+        return false;
+      mActiveTexture = unit;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // bindTexture
+    // -------------------------------------------------------------------------
+    // Only GL_TEXTURE_1D and GL_TEXTURE_2D are tracked
+    bool bindTexture(GLenum inTarget, GLuint inTexture)
+    {
+      int target = getTargetIndex(inTarget);
+      if (target < 0 || mActiveTexture >= (GLuint )TEXTURE_UNIT_NUM)
+        return true;
+      if (mTextures[mActiveTexture][target] == inTexture)
+        return false;
+      mTextures[mActiveTexture][target] = inTexture;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // deleteProgram
+    // -------------------------------------------------------------------------
+    // Called when the object is deleted (GL unbinds it, and the name can be
+    // reused by a new object)
+    void deleteProgram(GLuint inProgram)
+    {
+      if (mProgram == inProgram)
+        mProgram = UNKNOWN;
+    }
+    // -------------------------------------------------------------------------
+    // deleteVertexArray
+    // -------------------------------------------------------------------------
+    void deleteVertexArray(GLuint inVertexArray)
+    {
+      if (mVertexArray == inVertexArray)
+        mVertexArray = UNKNOWN;
+    }
+    // -------------------------------------------------------------------------
+    // deleteTexture
+    // -------------------------------------------------------------------------
+    void deleteTexture(GLuint inTexture)
+    {
+      for (int i = 0; i < TEXTURE_UNIT_NUM; i++)
+        for (int j = 0; j < 2; j++)
+          if (mTextures[i][j] == inTexture)
+            mTextures[i][j] = UNKNOWN;
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // isCoreProfile
+    // -------------------------------------------------------------------------
+    // The legacy enables (GL_POINT_SPRITE, GL_TEXTURE_1D) are invalid in the
+    // core profile (e.g. ibc::egl::OffscreenRenderer), where they are not needed.
+    // (glGetIntegerv() is exported by every GL library, also used with Qt)
+    static bool isCoreProfile()
+    {
+      GLint mask = 0;
+      ::glGetIntegerv(GL_CONTEXT_PROFILE_MASK, &mask);
+      return ((mask & GL_CONTEXT_CORE_PROFILE_BIT) != 0);
+    }
+    // -------------------------------------------------------------------------
+    // getInstance
+    // -------------------------------------------------------------------------
+    static StateTracker *getInstance()
+    {
+      thread_local StateTracker sInstance;
+      return &sInstance;
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    GLuint  mProgram;
+    GLuint  mVertexArray;
+    GLuint  mActiveTexture;   // unit index
+    GLuint  mTextures[TEXTURE_UNIT_NUM][2];
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getTargetIndex
+    // -------------------------------------------------------------------------
+    static int getTargetIndex(GLenum inTarget)
+    {
+      if (inTarget == GL_TEXTURE_1D)
+        return 0;
+      if (inTarget == GL_TEXTURE_2D)
+        return 1;
+      return -1;
+    }
+
+  private:
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // StateTracker
+    // -------------------------------------------------------------------------
+    StateTracker()
+    {
+      invalidate();
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_STATE_TRACKER_H_
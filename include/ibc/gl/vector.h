@@ -37,7 +37,7 @@ namespace ibc
   {
   public:
     // Member variables (public) -----------------------------------------------
-    VectorType  mVec[3];
+    alignas(16) VectorType  mVec[3];
 
     // Constructors and Destructor ---------------------------------------------
     // -------------------------------------------------------------------------
@@ -64,24 +64,17 @@ namespace ibc
     // -------------------------------------------------------------------------
     // VectorBase (copy constructor)
     // -------------------------------------------------------------------------
-    VectorBase(const VectorBase<VectorType> &inVector)
-    {
-      set(inVector);
-    }
+    VectorBase(const VectorBase<VectorType> &inVector) = default;
     // -------------------------------------------------------------------------
     // ~VectorBase
     // -------------------------------------------------------------------------
-    virtual ~VectorBase()
-    {
-    }
+    // Not virtual, so that the vectors are trivially copyable
+    ~VectorBase() = default;
     // Operator overloading ----------------------------------------------------
     // -------------------------------------------------------------------------
     // =
     // -------------------------------------------------------------------------
-    VectorBase<VectorType> &operator=(const VectorBase<VectorType> &inVector)
-    {
-      return set(inVector);
-    }
+    VectorBase<VectorType> &operator=(const VectorBase<VectorType> &inVector) = default;
     // -------------------------------------------------------------------------
     // []
     // -------------------------------------------------------------------------
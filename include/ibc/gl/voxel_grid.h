@@ -0,0 +1,531 @@
+// =============================================================================
+//  voxel_grid.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/gl/voxel_grid.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for the hashed voxel grid of the point clouds
+*/
+
+#ifndef IBC_GL_VOXEL_GRID_H_
+#define IBC_GL_VOXEL_GRID_H_
+
+// Includes --------------------------------------------------------------------
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "ibc/base/types.h"
+#include "ibc/base/parallel.h"
+#include "ibc/gl/bounding_box.h"
+
+// Namespace -------------------------------------------------------------------
+namespace ibc
+{
+ namespace gl
+ {
+  // ---------------------------------------------------------------------------
+  // VoxelGrid class
+  // ---------------------------------------------------------------------------
+  // Bins the strided xyz array (see KdTree) into the cubic voxels of
+  // inVoxelSize from the min corner of the points. The points are sorted by
+  // the voxel key (in parallel) and copied, so the points of a voxel are
+  // contiguous, and only the occupied voxels (cells) are kept in an open
+  // addressing hash table.
+  // The voxel coordinates are packed into 21 bits each of the key.
+  // NaN points are not added. The queries can be called from multiple threads.
+  class VoxelGrid
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static const size_t  INVALID_INDEX = (size_t )-1;
+    static const int     KEY_BITS      = 21;              // per axis
+    static const int     MAX_COORD     = (1 << KEY_BITS) - 1;
+    static const size_t  MIN_TASK_SIZE = 256 * 1024;      // points per thread
+    static const size_t  MIN_QUERY_TASK_SIZE = 4 * 1024;  // queries per thread
+
+    // Typedefs ----------------------------------------------------------------
+    typedef struct
+    {
+      GLfloat   xyz[3];
+      uint32_t  index;    // the index in the source array
+    } Entry;
+    typedef struct
+    {
+      uint64_t  key;
+      uint32_t  first;    // the first entry of the cell
+      uint32_t  count;
+    } Cell;
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // VoxelGrid
+    // -------------------------------------------------------------------------
+    VoxelGrid()
+    {
+      mVoxelSize = 1;
+      mTableMask = 0;
+      for (int i = 0; i < 3; i++)
+      {
+        mOrigin[i] = 0;
+        mDims[i] = 0;
+      }
+    }
+    // -------------------------------------------------------------------------
+    // ~VoxelGrid
+    // -------------------------------------------------------------------------
+    virtual ~VoxelGrid()
+    {
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // build
+    // -------------------------------------------------------------------------
+    // Returns false if there is no valid point, or the points span more than
+    // MAX_COORD voxels (inVoxelSize is too small)
+    bool build(const void *inDataPtr, size_t inStride, size_t inDataNum,
+               GLfloat inVoxelSize, unsigned int inTaskNum = 0)
+    {
+      clear();
+      if (inDataPtr == NULL || inDataNum == 0 || !(inVoxelSize > 0) ||
+          inDataNum >= (size_t )std::numeric_limits<uint32_t>::max())
+        return false;
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inDataNum, MIN_TASK_SIZE);
+      GLfloat minMax[6];
+      if (BoundingBox::calcMinMax(inDataPtr, inDataNum, inStride, minMax, inTaskNum) == false)
+        return false;
+      mVoxelSize = inVoxelSize;
+      for (int i = 0; i < 3; i++)
+      {
+        mOrigin[i] = minMax[i * 2];
+        // Same as getCoord() of the max corner
+        GLfloat dim = std::floor((minMax[i * 2 + 1] - mOrigin[i]) / mVoxelSize) + 1;
+        if (!(dim <= MAX_COORD))
+          return false;
+        mDims[i] = (int )dim;
+      }
+
+      // (key, source index) sorted by the key, the NaN points go to the end
+      const unsigned char *data = (const unsigned char *)inDataPtr;
+      std::vector<std::pair<uint64_t, uint32_t>>  keys(inDataNum);
+      Parallel::forEachTask(inDataNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            const GLfloat *p = (const GLfloat *)(data + inStride * i);
+            if (std::isnan(p[0]) || std::isnan(p[1]) || std::isnan(p[2]))
+              keys[i].first = INVALID_KEY;
+            else
+            {
+              int coord[3];
+              getCoord(p, coord);
+              keys[i].first = makeKey(coord);
+            }
+            keys[i].second = (uint32_t )i;
+          }
+        });
+      Parallel::sort(keys.begin(), keys.end(),
+                     std::less<std::pair<uint64_t, uint32_t>>(), MIN_TASK_SIZE, inTaskNum);
+      size_t  num = keys.size();
+      while (num != 0 && keys[num - 1].first == INVALID_KEY)
+        num--;
+
+      mEntries.resize(num);
+      Parallel::forEachTask(num, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          UNUSED(inTaskIndex);
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            const GLfloat *p = (const GLfloat *)(data + inStride * keys[i].second);
+            Entry &e = mEntries[i];
+            e.xyz[0] = p[0];
+            e.xyz[1] = p[1];
+            e.xyz[2] = p[2];
+            e.index = keys[i].second;
+          }
+        });
+      for (size_t i = 0; i < num; i++)
+      {
+        if (i == 0 || keys[i].first != keys[i - 1].first)
+        {
+          Cell  cell = {keys[i].first, (uint32_t )i, 0};
+          mCells.push_back(cell);
+        }
+        mCells.back().count++;
+      }
+
+      size_t  tableSize = 16;
+      while (tableSize < mCells.size() * 2)
+        tableSize *= 2;
+      mTable.assign(tableSize, (uint32_t )EMPTY_SLOT);
+      mTableMask = tableSize - 1;
+      for (size_t i = 0; i < mCells.size(); i++)
+      {
+        size_t  slot = getSlot(mCells[i].key);
+        while (mTable[slot] != EMPTY_SLOT)
+          slot = (slot + 1) & mTableMask;
+        mTable[slot] = (uint32_t )i;
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // clear
+    // -------------------------------------------------------------------------
+    void clear()
+    {
+      mEntries.clear();
+      mCells.clear();
+      mTable.clear();
+      mTableMask = 0;
+    }
+    // -------------------------------------------------------------------------
+    // isBuilt
+    // -------------------------------------------------------------------------
+    bool isBuilt() const
+    {
+      return (mCells.empty() == false);
+    }
+    // -------------------------------------------------------------------------
+    // getVoxelSize
+    // -------------------------------------------------------------------------
+    GLfloat getVoxelSize() const
+    {
+      return mVoxelSize;
+    }
+    // -------------------------------------------------------------------------
+    // getOrigin
+    // -------------------------------------------------------------------------
+    // The min corner of the voxel (0, 0, 0)
+    const GLfloat *getOrigin() const
+    {
+      return mOrigin;
+    }
+    // -------------------------------------------------------------------------
+    // getPointNum
+    // -------------------------------------------------------------------------
+    size_t getPointNum() const
+    {
+      return mEntries.size();
+    }
+    // -------------------------------------------------------------------------
+    // getEntry
+    // -------------------------------------------------------------------------
+    // inIndex is the index in the voxel order (see Cell::first)
+    const Entry &getEntry(size_t inIndex) const
+    {
+      return mEntries[inIndex];
+    }
+    // -------------------------------------------------------------------------
+    // getCellNum
+    // -------------------------------------------------------------------------
+    // The number of the occupied voxels
+    size_t getCellNum() const
+    {
+      return mCells.size();
+    }
+    // -------------------------------------------------------------------------
+    // getCell
+    // -------------------------------------------------------------------------
+    const Cell &getCell(size_t inIndex) const
+    {
+      return mCells[inIndex];
+    }
+    // -------------------------------------------------------------------------
+    // getCoord
+    // -------------------------------------------------------------------------
+    // The voxel coordinates of the point (can be out of the grid)
+    void getCoord(const GLfloat inPoint[3], int outCoord[3]) const
+    {
+      for (int i = 0; i < 3; i++)
+        outCoord[i] = (int )std::floor((inPoint[i] - mOrigin[i]) / mVoxelSize);
+    }
+    // -------------------------------------------------------------------------
+    // makeKey
+    // -------------------------------------------------------------------------
+    // The coordinates should be 0 to MAX_COORD
+    static uint64_t makeKey(const int inCoord[3])
+    {
+      return ((uint64_t )inCoord[0]) | (((uint64_t )inCoord[1]) << KEY_BITS) |
+             (((uint64_t )inCoord[2]) << (KEY_BITS * 2));
+    }
+    // -------------------------------------------------------------------------
+    // hashKey
+    // -------------------------------------------------------------------------
+    // The golden ratio (Fibonacci) hash of the key (use the upper bits)
+    static uint64_t hashKey(uint64_t inKey)
+    {
+      return inKey * 0x9E3779B97F4A7C15ULL;
+    }
+    // -------------------------------------------------------------------------
+    // getCoord
+    // -------------------------------------------------------------------------
+    static void getCoord(uint64_t inKey, int outCoord[3])
+    {
+      for (int i = 0; i < 3; i++)
+        outCoord[i] = (int )((inKey >> (i * KEY_BITS)) & MAX_COORD);
+    }
+    // -------------------------------------------------------------------------
+    // findCell
+    // -------------------------------------------------------------------------
+    // Returns the cell index of the voxel, or INVALID_INDEX if it is empty
+    size_t findCell(const int inCoord[3]) const
+    {
+      if (mCells.empty())
+        return INVALID_INDEX;
+      for (int i = 0; i < 3; i++)
+        if (inCoord[i] < 0 || inCoord[i] >= mDims[i])
+          return INVALID_INDEX;
+      uint64_t  key = makeKey(inCoord);
+      size_t  slot = getSlot(key);
+      while (mTable[slot] != EMPTY_SLOT)
+      {
+        if (mCells[mTable[slot]].key == key)
+          return mTable[slot];
+        slot = (slot + 1) & mTableMask;
+      }
+      return INVALID_INDEX;
+    }
+    // -------------------------------------------------------------------------
+    // findCell
+    // -------------------------------------------------------------------------
+    // The cell which contains the point
+    size_t findCell(const GLfloat inPoint[3]) const
+    {
+      int coord[3];
+      getCoord(inPoint, coord);
+      return findCell(coord);
+    }
+    // -------------------------------------------------------------------------
+    // findNearest
+    // -------------------------------------------------------------------------
+    // Returns the source index of the nearest point within inMaxDist
+    // (the voxels within inMaxDist are scanned), or INVALID_INDEX
+    size_t findNearest(const GLfloat inPoint[3], GLfloat inMaxDist,
+                       GLfloat *outDist2 = NULL) const
+    {
+      GLfloat bestDist2 = inMaxDist * inMaxDist;
+      size_t  best = INVALID_INDEX;
+      forEachCell(inPoint, inMaxDist,
+        [&](const Cell &inCell)
+        {
+          const Entry *e = &(mEntries[inCell.first]);
+          for (uint32_t i = 0; i < inCell.count; i++, e++)
+          {
+            GLfloat d2 = calcDist2(e->xyz, inPoint);
+            if (d2 < bestDist2 || (d2 == bestDist2 && best == INVALID_INDEX))
+            {
+              bestDist2 = d2;
+              best = e->index;
+            }
+          }
+        });
+      if (best != INVALID_INDEX && outDist2 != NULL)
+        *outDist2 = bestDist2;
+      return best;
+    }
+    // -------------------------------------------------------------------------
+    // findRadius
+    // -------------------------------------------------------------------------
+    // The source indices of the points within inRadius (not sorted).
+    // outDist2 can be NULL. Returns the number of the found points
+    size_t findRadius(const GLfloat inPoint[3], GLfloat inRadius,
+                      std::vector<size_t> *outIndices,
+                      std::vector<GLfloat> *outDist2 = NULL) const
+    {
+      outIndices->clear();
+      if (outDist2 != NULL)
+        outDist2->clear();
+      appendRadius(inPoint, inRadius, outIndices, outDist2);
+      return outIndices->size();
+    }
+    // -------------------------------------------------------------------------
+    // findBox
+    // -------------------------------------------------------------------------
+    // The source indices of the points in the box {x_min, x_max, ...}
+    size_t findBox(const GLfloat inMinMax[6], std::vector<size_t> *outIndices) const
+    {
+      outIndices->clear();
+      if (mCells.empty())
+        return 0;
+      GLfloat minPoint[3] = {inMinMax[0], inMinMax[2], inMinMax[4]};
+      GLfloat maxPoint[3] = {inMinMax[1], inMinMax[3], inMinMax[5]};
+      int begin[3], end[3];
+      getCoord(minPoint, begin);
+      getCoord(maxPoint, end);
+      forEachCell(begin, end,
+        [&](const Cell &inCell)
+        {
+          const Entry *e = &(mEntries[inCell.first]);
+          for (uint32_t i = 0; i < inCell.count; i++, e++)
+            if (e->xyz[0] >= inMinMax[0] && e->xyz[0] <= inMinMax[1] &&
+                e->xyz[1] >= inMinMax[2] && e->xyz[1] <= inMinMax[3] &&
+                e->xyz[2] >= inMinMax[4] && e->xyz[2] <= inMinMax[5])
+              outIndices->push_back(e->index);
+        });
+      return outIndices->size();
+    }
+    // -------------------------------------------------------------------------
+    // findRadiusBatch
+    // -------------------------------------------------------------------------
+    // findRadius() for each of the strided query points on multiple threads
+    // (the same output as KdTree::findRadiusBatch())
+    void findRadiusBatch(const void *inQueryPtr, size_t inStride, size_t inQueryNum,
+                         GLfloat inRadius, std::vector<size_t> *outOffsets,
+                         std::vector<size_t> *outIndices, unsigned int inTaskNum = 0) const
+    {
+      if (inTaskNum == 0)
+        inTaskNum = Parallel::getTaskNum(inQueryNum, MIN_QUERY_TASK_SIZE);
+      const unsigned char *query = (const unsigned char *)inQueryPtr;
+      outOffsets->resize(inQueryNum + 1);
+      std::vector<std::vector<size_t>>  taskIndices(inTaskNum);
+      Parallel::forEachTask(inQueryNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          std::vector<size_t> &indices = taskIndices[inTaskIndex];
+          for (size_t i = inBegin; i < inEnd; i++)
+          {
+            (*outOffsets)[i] = indices.size();
+            appendRadius((const GLfloat *)(query + inStride * i), inRadius, &indices, NULL);
+          }
+        });
+      std::vector<size_t> taskOffsets(inTaskNum + 1, 0);
+      for (unsigned int i = 0; i < inTaskNum; i++)
+        taskOffsets[i + 1] = taskOffsets[i] + taskIndices[i].size();
+      outIndices->resize(taskOffsets[inTaskNum]);
+      (*outOffsets)[inQueryNum] = taskOffsets[inTaskNum];
+      Parallel::forEachTask(inQueryNum, inTaskNum,
+        [&](unsigned int inTaskIndex, size_t inBegin, size_t inEnd)
+        {
+          for (size_t i = inBegin; i < inEnd; i++)
+            (*outOffsets)[i] += taskOffsets[inTaskIndex];
+          std::copy(taskIndices[inTaskIndex].begin(), taskIndices[inTaskIndex].end(),
+                    outIndices->begin() + taskOffsets[inTaskIndex]);
+        });
+    }
+    // -------------------------------------------------------------------------
+    // forEachCell
+    // -------------------------------------------------------------------------
+    // Calls inFunc(const Cell &) for the occupied voxels from inBegin to
+    // inEnd (inclusive, clipped to the grid)
+    template <class FuncType>
+    void forEachCell(const int inBegin[3], const int inEnd[3], FuncType inFunc) const
+    {
+      if (mCells.empty())
+        return;
+      int begin[3], end[3];
+      for (int i = 0; i < 3; i++)
+      {
+        begin[i] = std::max(inBegin[i], 0);
+        end[i] = std::min(inEnd[i], mDims[i] - 1);
+        if (begin[i] > end[i])
+          return;
+      }
+      int coord[3];
+      for (coord[2] = begin[2]; coord[2] <= end[2]; coord[2]++)
+        for (coord[1] = begin[1]; coord[1] <= end[1]; coord[1]++)
+          for (coord[0] = begin[0]; coord[0] <= end[0]; coord[0]++)
+          {
+            size_t  index = findCell(coord);
+            if (index != INVALID_INDEX)
+              inFunc(mCells[index]);
+          }
+    }
+    // -------------------------------------------------------------------------
+    // forEachCell
+    // -------------------------------------------------------------------------
+    // The occupied voxels which overlap the bounding cube of the sphere
+    template <class FuncType>
+    void forEachCell(const GLfloat inPoint[3], GLfloat inRadius, FuncType inFunc) const
+    {
+      GLfloat minPoint[3], maxPoint[3];
+      for (int i = 0; i < 3; i++)
+      {
+        minPoint[i] = inPoint[i] - inRadius;
+        maxPoint[i] = inPoint[i] + inRadius;
+      }
+      int begin[3], end[3];
+      getCoord(minPoint, begin);
+      getCoord(maxPoint, end);
+      forEachCell(begin, end, inFunc);
+    }
+
+  protected:
+    // Constants ---------------------------------------------------------------
+    static const uint64_t  INVALID_KEY = (uint64_t )-1;
+    static const uint32_t  EMPTY_SLOT  = (uint32_t )-1;
+
+    // Member variables --------------------------------------------------------
+    GLfloat mVoxelSize;
+    GLfloat mOrigin[3];
+    int     mDims[3];
+    std::vector<Entry>  mEntries;
+    std::vector<Cell>   mCells;       // sorted by the key
+    std::vector<uint32_t> mTable;     // the cell indices (open addressing)
+    size_t  mTableMask;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // getSlot
+    // -------------------------------------------------------------------------
+    size_t getSlot(uint64_t inKey) const
+    {
+      return (size_t )(hashKey(inKey) >> 32) & mTableMask;
+    }
+    // -------------------------------------------------------------------------
+    // appendRadius
+    // -------------------------------------------------------------------------
+    void appendRadius(const GLfloat inPoint[3], GLfloat inRadius,
+                      std::vector<size_t> *outIndices, std::vector<GLfloat> *outDist2) const
+    {
+      GLfloat radius2 = inRadius * inRadius;
+      forEachCell(inPoint, inRadius,
+        [&](const Cell &inCell)
+        {
+          const Entry *e = &(mEntries[inCell.first]);
+          for (uint32_t i = 0; i < inCell.count; i++, e++)
+          {
+            GLfloat d2 = calcDist2(e->xyz, inPoint);
+            if (d2 > radius2)
+              continue;
+            outIndices->push_back(e->index);
+            if (outDist2 != NULL)
+              outDist2->push_back(d2);
+          }
+        });
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // calcDist2
+    // -------------------------------------------------------------------------
+    static GLfloat calcDist2(const GLfloat inA[3], const GLfloat inB[3])
+    {
+      GLfloat dx = inA[0] - inB[0];
+      GLfloat dy = inA[1] - inB[1];
+      GLfloat dz = inA[2] - inB[2];
+      return dx * dx + dy * dy + dz * dz;
+    }
+  };
+ };
+};
+
+#endif  // #ifdef IBC_GL_VOXEL_GRID_H_
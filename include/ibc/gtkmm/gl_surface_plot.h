@@ -36,6 +36,7 @@
 #include "ibc/gl/model/surface_points.h"
 #include "ibc/gl/shader/simple.h"
 #include "ibc/gl/shader/point_sprite.h"
+#include "ibc/gl/shader/surface_mesh.h"
 
 // Namespace -------------------------------------------------------------------
 namespace ibc
@@ -61,9 +62,11 @@ namespace ibc
       mModel.setShader(&mShader);
       mAxis.setShader(&mShader);
       mDataModel.setShader(&mPointSpriteShader);
+      mDataModel.setMeshShader(&mSurfaceMeshShader);
 
       addShader(&mShader);
       addShader(&mPointSpriteShader);
+      addShader(&mSurfaceMeshShader);
       addModel(&mModel);
       addModel(&mAxis);
       addModel(&mDataModel);
@@ -107,6 +110,14 @@ namespace ibc
                             type);
     }
     // -------------------------------------------------------------------------
+    // setDrawMode
+    // -------------------------------------------------------------------------
+    void  setDrawMode(ibc::gl::model::SurfacePoints::DrawMode inMode)
+    {
+      mDataModel.setDrawMode(inMode);
+      queue_render();
+    }
+    // -------------------------------------------------------------------------
     // isImageSizeChanged
     // -------------------------------------------------------------------------
     bool  isImageSizeChanged() const
@@ -118,6 +129,7 @@ namespace ibc
     // Member variables --------------------------------------------------------
     ibc::gl::shader::Simple  mShader;
     ibc::gl::shader::PointSprite  mPointSpriteShader;
+    ibc::gl::shader::SurfaceMesh  mSurfaceMeshShader;
     ibc::gl::model::ColorCube  mModel;
     ibc::gl::model::XYZAxis  mAxis;
     ibc::gl::model::SurfacePoints  mDataModel;
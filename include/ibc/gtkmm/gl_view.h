@@ -38,6 +38,10 @@
 #include "ibc/gl/matrix.h"
 #include "ibc/gl/model_interface.h"
 #include "ibc/gl/shader_interface.h"
+#include "ibc/gl/program_cache.h"
+#include "ibc/gl/frame_uniforms.h"
+#include "ibc/gl/frame_capture.h"
+#include "ibc/gl/state_tracker.h"
 
 // Namespace -------------------------------------------------------------------
 namespace ibc
@@ -104,6 +108,29 @@ namespace ibc
         return;
       mShaderList.erase(it);
     }
+    // -------------------------------------------------------------------------
+    // startCapture
+    // -------------------------------------------------------------------------
+    // Records the following frames (see ibc::gl::FrameCapture::start)
+    // e.g. startCapture("fly.y4m"), startCapture("shot_%d.png", FORMAT_PNG, 30, 1)
+    bool  startCapture(const char *inPath = NULL,
+                       ibc::image::utils::FrameWriter::Format inFormat = ibc::image::utils::FrameWriter::FORMAT_Y4M,
+                       int inFPS = 30, size_t inMaxFrameNum = 0)
+    {
+      if (mFrameCapture.start(inPath, inFormat, inFPS, inMaxFrameNum) == false)
+        return false;
+      queue_render();
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // stopCapture
+    // -------------------------------------------------------------------------
+    // Waits for the frames in flight and the writer thread
+    void  stopCapture()
+    {
+      make_current();
+      mFrameCapture.stop();
+    }
 
   protected:
     // Member functions --------------------------------------------------------
@@ -175,6 +202,13 @@ namespace ibc
       glDepthFunc(GL_LESS);
       glEnable(GL_DEPTH_TEST);
 
+      mFrameUniforms.init();
+
+      // The GLAreas sharing with the same context use the same shader programs
+      ibc::gl::StateTracker::getInstance()->invalidate();
+      Glib::RefPtr<Gdk::GLContext> sharedContext = get_context()->get_shared_context();
+      ibc::gl::ProgramRegistry::setCurrentShareGroup(
+        sharedContext ? sharedContext->gobj() : NULL);
       for (auto it = mShaderList.begin(); it != mShaderList.end(); it++)
         (*it)->initShader();
 
@@ -186,6 +220,9 @@ namespace ibc
     // -------------------------------------------------------------------------
     virtual void  glDispose()
     {
+      ibc::gl::StateTracker::getInstance()->invalidate();
+      mFrameCapture.dispose();
+      mFrameUniforms.dispose();
       for (auto it = mModelList.begin(); it != mModelList.end(); it++)
         (*it)->disposeModel();
 
@@ -209,10 +246,15 @@ namespace ibc
     virtual void  glDisplay()
     {
       make_current();
+      ibc::gl::StateTracker::getInstance()->invalidate();
+      mFrameUniforms.update(mGLModelView, mGLProjection);
 
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
       for (auto it = mModelList.begin(); it != mModelList.end(); it++)
         (*it)->drawModel(mGLModelView, mGLProjection);
+      mFrameCapture.captureFrame();
+      if (mFrameCapture.hasPendingReads())
+        queue_render();  // to retrieve the requested frames (even if the view is static)
     }
 
     // Member variables --------------------------------------------------------
@@ -223,6 +265,8 @@ namespace ibc
     std::vector<ibc::gl::ModelInterface *>    mModelList;
 
     GLfloat mGLModelView[16], mGLProjection[16];
+    ibc::gl::FrameUniforms  mFrameUniforms; // the matrices and the light for the shaders
+    ibc::gl::FrameCapture   mFrameCapture;  // the screenshot / video recording
 
   private:
     // Member functions --------------------------------------------------------
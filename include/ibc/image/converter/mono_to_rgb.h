@@ -23,6 +23,7 @@
 
 // Includes ------------------------------------------------------ --------------
 #include <cstring>
+#include <vector>
 //#include <arpa/inet.h>  // <- for byte swapping
 #include "ibc/image/image.h"
 #include "ibc/image/image_converter_interface.h"
@@ -495,6 +496,8 @@ namespace ibc { namespace image { namespace converter
     static void  convertMono16_ColorMap_BigEndian(Mono_to_RGB *inObj, const void *inImage, void *outImage)
     {
       size_t  srcPixStep = inObj->mSrcFormat->mPixelStep;
+      // Each line is converted to the native endian in bulk first
+      std::vector<uint16_t> lineBuf(inObj->mWidth);
 
       inObj->updateColorMap();
 
@@ -505,10 +508,16 @@ namespace ibc { namespace image { namespace converter
         unsigned char *dstPtr =
           (unsigned char *)inObj->mDstFormat->getLinePtr(outImage, i);
 
+      #ifdef __LITTLE_ENDIAN__
+        ibc::Endian::swapBuffer16Strided(srcPtr, srcPixStep,
+                                         lineBuf.data(), sizeof(uint16_t), inObj->mWidth);
+      #else
+        for (int j = 0; j < inObj->mWidth; j++)
+          ::memcpy(&(lineBuf[j]), srcPtr + srcPixStep * j, sizeof(uint16_t));
+      #endif
         for (int j = 0; j < inObj->mWidth; j++)
         {
-          unsigned short v = CONV_FROM_BIG_ENDIAN(*((const unsigned short *)srcPtr));
-          srcPtr+=srcPixStep;
+          unsigned short v = lineBuf[j];
           //
           unsigned char *mapPtr = &(inObj->mColorMapPtr[v * 3]);
           *dstPtr = *mapPtr;
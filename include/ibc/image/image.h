@@ -494,6 +494,10 @@ namespace ibc
         case DATA_TYPE_64BIT:
         case DATA_TYPE_64BIT_SIGNED:
           return 8;
+        case DATA_TYPE_FLOAT:
+          return sizeof(float);
+        case DATA_TYPE_DOUBLE:
+          return sizeof(double);
         default:
           break;
       }
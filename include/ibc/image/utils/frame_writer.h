@@ -0,0 +1,338 @@
+// =============================================================================
+//  frame_writer.h
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     ibc/image/utils/frame_writer.h
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Header file for writing RGBA frames (raw, Y4M, PNG sequence)
+*/
+
+#ifndef IBC_IMAGE_UTILS_FRAME_WRITER_H_
+#define IBC_IMAGE_UTILS_FRAME_WRITER_H_
+
+// Includes --------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "ibc/image/image_buffer.h"
+
+// Namespace -------------------------------------------------------------------
+//namespace ibc::image::utils // <- nested namespace (C++17)
+namespace ibc { namespace image { namespace utils
+{
+  // ---------------------------------------------------------------------------
+  // FrameWriter class
+  // ---------------------------------------------------------------------------
+  // Writes a sequence of RGBA 8bit frames of the same size
+  // FORMAT_RAW : the frames are concatenated into one file (top-down RGBA)
+  // FORMAT_Y4M : YUV4MPEG2 stream (4:4:4, BT.601 limited range), which can
+  //              be encoded by ffmpeg (ffmpeg -i in.y4m out.mp4)
+  // FORMAT_PNG : one file per frame, the path is a printf format with one
+  //              integer (e.g. "frame_%05d.png"). The image data is stored
+  //              without compression (no zlib dependency)
+  class  FrameWriter
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    enum Format
+    {
+      FORMAT_RAW = 0,
+      FORMAT_Y4M,
+      FORMAT_PNG
+    };
+
+    // Constructors and Destructor ---------------------------------------------
+    // -------------------------------------------------------------------------
+    // FrameWriter
+    // -------------------------------------------------------------------------
+    FrameWriter()
+    {
+      mFile = NULL;
+      mFormat = FORMAT_RAW;
+      mFPS = 30;
+      mWidth = 0;
+      mHeight = 0;
+      mFrameNum = 0;
+      mIsOpened = false;
+    }
+    // -------------------------------------------------------------------------
+    // ~FrameWriter
+    // -------------------------------------------------------------------------
+    virtual ~FrameWriter()
+    {
+      close();
+    }
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // open
+    // -------------------------------------------------------------------------
+    // The frame size is taken from the first frame
+    bool open(const char *inPath, Format inFormat, int inFPS = 30)
+    {
+      close();
+      if (inPath == NULL || inFPS <= 0)
+        return false;
+      mPath = inPath;
+      mFormat = inFormat;
+      mFPS = inFPS;
+      mWidth = 0;
+      mHeight = 0;
+      mFrameNum = 0;
+      if (mFormat != FORMAT_PNG)
+      {
+        mFile = fopen(inPath, "wb");
+        if (mFile == NULL)
+          return false;
+      }
+      mIsOpened = true;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // close
+    // -------------------------------------------------------------------------
+    void close()
+    {
+      if (mFile != NULL)
+        fclose(mFile);
+      mFile = NULL;
+      mIsOpened = false;
+    }
+    // -------------------------------------------------------------------------
+    // isOpened
+    // -------------------------------------------------------------------------
+    bool isOpened() const
+    {
+      return mIsOpened;
+    }
+    // -------------------------------------------------------------------------
+    // getFrameNum
+    // -------------------------------------------------------------------------
+    size_t getFrameNum() const
+    {
+      return mFrameNum;
+    }
+    // -------------------------------------------------------------------------
+    // write
+    // -------------------------------------------------------------------------
+    // The image should be RGBA 8bit (pixel aligned, top-down).
+    // Returns false if the size differs from the first frame
+    bool write(const ibc::image::ImageBuffer &inImage)
+    {
+      if (mIsOpened == false || inImage.checkImageBufferPtr() == false)
+        return false;
+      int width = inImage.getWidth();
+      int height = inImage.getHeight();
+      if (mFrameNum == 0)
+      {
+        mWidth = width;
+        mHeight = height;
+        if (mFormat == FORMAT_Y4M)
+          fprintf(mFile, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", mWidth, mHeight, mFPS);
+      }
+      else if (width != mWidth || height != mHeight)
+        return false;
+
+      bool  result;
+      switch (mFormat)
+      {
+        case FORMAT_Y4M:
+          result = writeY4MFrame(inImage);
+          break;
+        case FORMAT_PNG:
+          {
+            char  fileName[1024];
+            snprintf(fileName, sizeof(fileName), mPath.c_str(), (int )mFrameNum);
+            result = writePNG(fileName, inImage);
+          }
+          break;
+        case FORMAT_RAW:
+        default:
+          result = true;
+          for (int y = 0; y < mHeight && result; y++)
+            result = (fwrite(inImage.getImageBufferLinePtr(y), (size_t )mWidth * 4, 1, mFile) == 1);
+          break;
+      }
+      if (result)
+        mFrameNum++;
+      return result;
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // writePNG
+    // -------------------------------------------------------------------------
+    // Writes an RGBA 8bit image as a PNG file (stored deflate blocks)
+    static bool writePNG(const char *inFileName, const ibc::image::ImageBuffer &inImage)
+    {
+      if (inImage.checkImageBufferPtr() == false)
+        return false;
+      uint32_t  width = (uint32_t )inImage.getWidth();
+      uint32_t  height = (uint32_t )inImage.getHeight();
+      size_t  lineSize = (size_t )width * 4 + 1;   // + filter type byte
+      size_t  dataSize = lineSize * height;
+
+      // zlib stream (stored blocks of up to 65535 bytes)
+      std::vector<unsigned char>  idat;
+      idat.reserve(dataSize + dataSize / 65535 * 5 + 16);
+      idat.push_back(0x78);
+      idat.push_back(0x01);
+      std::vector<unsigned char>  line(lineSize);
+      uint32_t  adlerA = 1, adlerB = 0;
+      size_t  blockLeft = 0;
+      size_t  totalLeft = dataSize;
+      for (uint32_t y = 0; y < height; y++)
+      {
+        line[0] = 0;  // no filter
+        memcpy(&(line[1]), inImage.getImageBufferLinePtr(y), lineSize - 1);
+        for (size_t i = 0; i < lineSize; i++)
+        {
+          if (blockLeft == 0)
+          {
+            blockLeft = (totalLeft > 65535) ? 65535 : totalLeft;
+            idat.push_back((totalLeft == blockLeft) ? 1 : 0);   // BFINAL
+            idat.push_back((unsigned char )(blockLeft & 0xFF));
+            idat.push_back((unsigned char )(blockLeft >> 8));
+            idat.push_back((unsigned char )(~blockLeft & 0xFF));
+            idat.push_back((unsigned char )((~blockLeft >> 8) & 0xFF));
+          }
+          idat.push_back(line[i]);
+          adlerA = (adlerA + line[i]) % 65521;
+          adlerB = (adlerB + adlerA) % 65521;
+          blockLeft--;
+          totalLeft--;
+        }
+      }
+      putBE32(&idat, (adlerB << 16) | adlerA);
+
+      FILE  *fp = fopen(inFileName, "wb");
+      if (fp == NULL)
+        return false;
+      static const unsigned char  signature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+      std::vector<unsigned char>  ihdr;
+      putBE32(&ihdr, width);
+      putBE32(&ihdr, height);
+      ihdr.push_back(8);    // bit depth
+      ihdr.push_back(6);    // color type : RGBA
+      ihdr.push_back(0);    // compression
+      ihdr.push_back(0);    // filter
+      ihdr.push_back(0);    // interlace
+      bool  result = (fwrite(signature, sizeof(signature), 1, fp) == 1 &&
+                      writeChunk(fp, "IHDR", ihdr) &&
+                      writeChunk(fp, "IDAT", idat) &&
+                      writeChunk(fp, "IEND", std::vector<unsigned char>()));
+      if (fclose(fp) != 0)
+        result = false;
+      return result;
+    }
+
+  protected:
+    // Member variables --------------------------------------------------------
+    std::string mPath;
+    FILE    *mFile;
+    Format  mFormat;
+    int     mFPS;
+    int     mWidth;
+    int     mHeight;
+    size_t  mFrameNum;
+    bool    mIsOpened;
+    std::vector<unsigned char>  mPlaneBuffer;
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // writeY4MFrame
+    // -------------------------------------------------------------------------
+    bool writeY4MFrame(const ibc::image::ImageBuffer &inImage)
+    {
+      size_t  planeSize = (size_t )mWidth * mHeight;
+      mPlaneBuffer.resize(planeSize * 3);
+      unsigned char *yPlane = mPlaneBuffer.data();
+      unsigned char *uPlane = yPlane + planeSize;
+      unsigned char *vPlane = uPlane + planeSize;
+      for (int y = 0; y < mHeight; y++)
+      {
+        const unsigned char *src = (const unsigned char *)inImage.getImageBufferLinePtr(y);
+        for (int x = 0; x < mWidth; x++, src += 4)
+        {
+          int r = src[0], g = src[1], b = src[2];
+          *yPlane++ = (unsigned char )((( 66 * r + 129 * g +  25 * b + 128) >> 8) + 16);
+          *uPlane++ = (unsigned char )(((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128);
+          *vPlane++ = (unsigned char )(((112 * r -  94 * g -  18 * b + 128) >> 8) + 128);
+        }
+      }
+      return (fwrite("FRAME\n", 6, 1, mFile) == 1 &&
+              fwrite(mPlaneBuffer.data(), mPlaneBuffer.size(), 1, mFile) == 1);
+    }
+
+    // Static Member functions -------------------------------------------------
+    // -------------------------------------------------------------------------
+    // putBE32
+    // -------------------------------------------------------------------------
+    static void putBE32(std::vector<unsigned char> *ioBuffer, uint32_t inValue)
+    {
+      ioBuffer->push_back((unsigned char )(inValue >> 24));
+      ioBuffer->push_back((unsigned char )(inValue >> 16));
+      ioBuffer->push_back((unsigned char )(inValue >> 8));
+      ioBuffer->push_back((unsigned char )(inValue));
+    }
+    // -------------------------------------------------------------------------
+    // writeChunk
+    // -------------------------------------------------------------------------
+    static bool writeChunk(FILE *inFile, const char inType[4],
+                           const std::vector<unsigned char> &inData)
+    {
+      std::vector<unsigned char>  header;
+      putBE32(&header, (uint32_t )inData.size());
+      header.insert(header.end(), inType, inType + 4);
+      uint32_t  crc = updateCRC(0xFFFFFFFF, header.data() + 4, 4);
+      if (inData.empty() == false)
+        crc = updateCRC(crc, inData.data(), inData.size());
+      std::vector<unsigned char>  footer;
+      putBE32(&footer, crc ^ 0xFFFFFFFF);
+      if (fwrite(header.data(), header.size(), 1, inFile) != 1)
+        return false;
+      if (inData.empty() == false &&
+          fwrite(inData.data(), inData.size(), 1, inFile) != 1)
+        return false;
+      return (fwrite(footer.data(), footer.size(), 1, inFile) == 1);
+    }
+    // -------------------------------------------------------------------------
+    // updateCRC
+    // -------------------------------------------------------------------------
+    static uint32_t updateCRC(uint32_t inCRC, const unsigned char *inData, size_t inLen)
+    {
+      static const std::vector<uint32_t> table = makeCRCTable();
+      for (size_t i = 0; i < inLen; i++)
+        inCRC = table[(inCRC ^ inData[i]) & 0xFF] ^ (inCRC >> 8);
+      return inCRC;
+    }
+    // -------------------------------------------------------------------------
+    // makeCRCTable
+    // -------------------------------------------------------------------------
+    static std::vector<uint32_t> makeCRCTable()
+    {
+      std::vector<uint32_t> table(256);
+      for (uint32_t n = 0; n < 256; n++)
+      {
+        uint32_t  c = n;
+        for (int k = 0; k < 8; k++)
+          c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        table[n] = c;
+      }
+      return table;
+    }
+  };
+};};};
+
+#endif  // #ifdef IBC_IMAGE_UTILS_FRAME_WRITER_H_
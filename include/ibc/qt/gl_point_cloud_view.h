@@ -26,6 +26,8 @@
 #include "ibc/gl/matrix.h"
 #include "ibc/gl/utils.h"
 #include "ibc/gl/trackball.h"
+#include "ibc/gl/kd_tree.h"
+#include "ibc/gl/point_picker.h"
 #include "ibc/qt/gl_obj_view.h"
 #include "ibc/qt/image_data.h"
 //#include "ibc/qt/view_data_interface.h"
@@ -72,6 +74,11 @@ namespace ibc
       addModel(&mAxisModel);
       addModel(&mDataModel);
       addModel(&mBackdropModel);
+
+      mPointPicker.setKdTree(&mPickTree);
+      mPickTreeDataPtr = NULL;
+      mPickTreeDataNum = 0;
+      mIsPickTreeModified = true;
     }
     // -------------------------------------------------------------------------
     // ~GLPointCloudView
@@ -80,6 +87,68 @@ namespace ibc
     {
     }
 
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // pickPoint
+    // -------------------------------------------------------------------------
+    // The front most point of mDataModel within inTolerance pixels from the
+    // widget position (inX, inY) in the last drawn frame
+    bool pickPoint(int inX, int inY, ibc::gl::PointPicker::PickResult *outResult,
+                   GLfloat inTolerance = 5.0f)
+    {
+      if (updatePointPicker() == false)
+        return false;
+      return mPointPicker.pick(inX + 0.5f, height() - (inY + 0.5f), inTolerance, outResult);
+    }
+    // -------------------------------------------------------------------------
+    // selectPoints
+    // -------------------------------------------------------------------------
+    // The indices of the points (including the hidden ones) in the rectangle
+    size_t selectPoints(const QRect &inRect, std::vector<size_t> *outIndices)
+    {
+      outIndices->clear();
+      if (updatePointPicker() == false)
+        return 0;
+      return mPointPicker.selectRect(inRect.left(), height() - inRect.top(),
+                                     inRect.right() + 1, height() - (inRect.bottom() + 1),
+                                     outIndices);
+    }
+    // -------------------------------------------------------------------------
+    // selectPoints
+    // -------------------------------------------------------------------------
+    // The indices of the points in the lasso polygon
+    size_t selectPoints(const QPolygon &inLasso, std::vector<size_t> *outIndices)
+    {
+      outIndices->clear();
+      if (updatePointPicker() == false)
+        return 0;
+      std::vector<GLfloat>  xy(inLasso.size() * 2);
+      for (int i = 0; i < inLasso.size(); i++)
+      {
+        xy[i * 2]     = inLasso[i].x() + 0.5f;
+        xy[i * 2 + 1] = height() - (inLasso[i].y() + 0.5f);
+      }
+      return mPointPicker.selectLasso(xy.data(), inLasso.size(), outIndices);
+    }
+    // -------------------------------------------------------------------------
+    // markAsPickTreeModified
+    // -------------------------------------------------------------------------
+    // Should be called when the points of mDataModel are modified in place
+    // (a new setDataPtr() is detected automatically)
+    void markAsPickTreeModified()
+    {
+      mIsPickTreeModified = true;
+    }
+    // -------------------------------------------------------------------------
+    // getPickTree
+    // -------------------------------------------------------------------------
+    // The k-d tree of mDataModel (e.g. for the nearest neighbor queries)
+    const ibc::gl::KdTree &getPickTree()
+    {
+      updatePickTree();
+      return mPickTree;
+    }
+
     // Member variables --------------------------------------------------------
     ibc::gl::shader::PointCloudRGBA8  mPointCloudShader;
     ibc::gl::model::PointsRGBA8  mDataModel;
@@ -92,6 +161,59 @@ namespace ibc
     ibc::gl::shader::Simple   mShader;
 
     ibc::gl::shader::Backdrop   mBackdropShader;
+
+    ibc::gl::KdTree mPickTree;
+    ibc::gl::PointPicker  mPointPicker;
+    const void  *mPickTreeDataPtr;
+    size_t  mPickTreeDataNum;
+    bool  mIsPickTreeModified;
+
+  signals:
+    void pointPicked(qulonglong inIndex, float inX, float inY, float inZ);
+
+  protected:
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // mouseDoubleClickEvent
+    // -------------------------------------------------------------------------
+    virtual void  mouseDoubleClickEvent(QMouseEvent *event)
+    {
+      ibc::gl::PointPicker::PickResult  result;
+      if (event->button() == Qt::LeftButton &&
+          pickPoint(event->pos().x(), event->pos().y(), &result))
+        emit pointPicked(result.index, result.xyz[0], result.xyz[1], result.xyz[2]);
+    }
+    // -------------------------------------------------------------------------
+    // updatePickTree
+    // -------------------------------------------------------------------------
+    void updatePickTree()
+    {
+      if (mIsPickTreeModified == false &&
+          mPickTreeDataPtr == mDataModel.getDataPtr() &&
+          mPickTreeDataNum == mDataModel.getDataNum())
+        return;
+      mPickTreeDataPtr = mDataModel.getDataPtr();
+      mPickTreeDataNum = mDataModel.getDataNum();
+      mIsPickTreeModified = false;
+      if (mPickTreeDataPtr == NULL)
+        mPickTree.clear();
+      else
+        mPickTree.build(mPickTreeDataPtr, mDataModel.getDataStride(), mPickTreeDataNum);
+    }
+    // -------------------------------------------------------------------------
+    // updatePointPicker
+    // -------------------------------------------------------------------------
+    // The matrices of the last paintGL() (the widget coordinates as the viewport)
+    bool updatePointPicker()
+    {
+      updatePickTree();
+      if (mPickTree.isBuilt() == false)
+        return false;
+      GLint viewport[4] = {0, 0, width(), height()};
+      mPointPicker.setMatrices(mGLModelView, mGLProjection, viewport,
+                               mDataModel.getModelFitParam());
+      return true;
+    }
   };
  };
 };
@@ -33,6 +33,7 @@
 #include "ibc/gl/model/surface_points.h"
 #include "ibc/gl/shader/simple.h"
 #include "ibc/gl/shader/point_sprite.h"
+#include "ibc/gl/shader/surface_mesh.h"
 
 // Namespace -------------------------------------------------------------------
 namespace ibc
@@ -59,9 +60,11 @@ namespace ibc
 
       mModel.setShader(&mShader);
       mDataModel.setShader(&mPointSpriteShader);
+      mDataModel.setMeshShader(&mSurfaceMeshShader);
 
       addShader(&mShader);
       addShader(&mPointSpriteShader);
+      addShader(&mSurfaceMeshShader);
       addModel(&mModel);
       addModel(&mDataModel);
     }
@@ -104,6 +107,14 @@ namespace ibc
                             type);
     }
     // -------------------------------------------------------------------------
+    // setDrawMode
+    // -------------------------------------------------------------------------
+    void  setDrawMode(ibc::gl::model::SurfacePoints::DrawMode inMode)
+    {
+      mDataModel.setDrawMode(inMode);
+      update();
+    }
+    // -------------------------------------------------------------------------
     // isImageSizeChanged
     // -------------------------------------------------------------------------
     bool  isImageSizeChanged() const
@@ -115,6 +126,7 @@ namespace ibc
     // Member variables --------------------------------------------------------
     ibc::gl::shader::Simple  mShader;
     ibc::gl::shader::PointSprite  mPointSpriteShader;
+    ibc::gl::shader::SurfaceMesh  mSurfaceMeshShader;
     ibc::gl::model::ColorCube  mModel;
     ibc::gl::model::SurfacePoints  mDataModel;
 
@@ -36,6 +36,10 @@
 #include "ibc/gl/matrix.h"
 #include "ibc/gl/model_interface.h"
 #include "ibc/gl/shader_interface.h"
+#include "ibc/gl/program_cache.h"
+#include "ibc/gl/frame_uniforms.h"
+#include "ibc/gl/frame_capture.h"
+#include "ibc/gl/state_tracker.h"
 
 // Namespace -------------------------------------------------------------------
 namespace ibc
@@ -106,6 +110,29 @@ namespace ibc
         return;
       mShaderList.erase(it);
     }
+    // -------------------------------------------------------------------------
+    // startCapture
+    // -------------------------------------------------------------------------
+    // Records the following frames (see ibc::gl::FrameCapture::start)
+    // e.g. startCapture("fly.y4m"), startCapture("shot_%d.png", FORMAT_PNG, 30, 1)
+    bool  startCapture(const char *inPath = NULL,
+                       ibc::image::utils::FrameWriter::Format inFormat = ibc::image::utils::FrameWriter::FORMAT_Y4M,
+                       int inFPS = 30, size_t inMaxFrameNum = 0)
+    {
+      if (mFrameCapture.start(inPath, inFormat, inFPS, inMaxFrameNum) == false)
+        return false;
+      update();
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // stopCapture
+    // -------------------------------------------------------------------------
+    // Waits for the frames in flight and the writer thread
+    void  stopCapture()
+    {
+      makeCurrent();
+      mFrameCapture.stop();
+    }
 
   protected:
     // Member variables --------------------------------------------------------
@@ -116,6 +143,8 @@ namespace ibc
     std::vector<ibc::gl::ModelInterface *>    mModelList;
 
     GLfloat mGLModelView[16], mGLProjection[16];
+    ibc::gl::FrameUniforms  mFrameUniforms; // the matrices and the light for the shaders
+    ibc::gl::FrameCapture   mFrameCapture;  // the screenshot / video recording
 
 
     // OpenGL related functions ------------------------------------------------
@@ -157,6 +186,12 @@ namespace ibc
       glDepthFunc(GL_LESS);
       glEnable(GL_DEPTH_TEST);
 
+      mFrameUniforms.init();
+
+      // The views in the same share group use the same shader programs
+      ibc::gl::StateTracker::getInstance()->invalidate();
+      ibc::gl::ProgramRegistry::setCurrentShareGroup(
+        QOpenGLContext::currentContext()->shareGroup());
       for (auto it = mShaderList.begin(); it != mShaderList.end(); it++)
         (*it)->initShader();
 
@@ -169,6 +204,9 @@ namespace ibc
     virtual void  disopseGL()
     {
       makeCurrent();
+      ibc::gl::StateTracker::getInstance()->invalidate();
+      mFrameCapture.dispose();
+      mFrameUniforms.dispose();
 
       for (auto it = mModelList.begin(); it != mModelList.end(); it++)
         (*it)->disposeModel();
@@ -193,11 +231,16 @@ namespace ibc
     virtual void  paintGL()
     {
       makeCurrent();
+      ibc::gl::StateTracker::getInstance()->invalidate();
+      mFrameUniforms.update(mGLModelView, mGLProjection);
 
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
       for (auto it = mModelList.begin(); it != mModelList.end(); it++)
         if ((*it)->isEnabled())
           (*it)->drawModel(mGLModelView, mGLProjection);
+      mFrameCapture.captureFrame();
+      if (mFrameCapture.hasPendingReads())
+        update();  // to retrieve the requested frames (even if the view is static)
     }
   };
  };
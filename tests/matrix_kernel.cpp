@@ -0,0 +1,246 @@
+// =============================================================================
+//  matrix_kernel.cpp
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     tests/matrix_kernel.cpp
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Compares the MatrixKernel (SIMD) results of MatrixBase with the
+            scalar reference (multi, aliased operands, inverseAffine,
+            transformPoints and the quaternion multiply)
+*/
+
+// Includes --------------------------------------------------------------------
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "ibc/gl/data.h"
+#include "ibc/gl/matrix.h"
+#include "ibc/gl/quaternion.h"
+
+using namespace ibc::gl;
+
+// Globals ---------------------------------------------------------------------
+static const int  TRIAL_NUM = 1000;
+static const size_t POINT_NUM = 1001;
+static int  sFailNum = 0;
+
+#define CHECK(c)  \
+  { if (!(c)) { ::printf("FAILED : %s:%d %s\n", __FILE__, __LINE__, #c); sFailNum++; } }
+
+// -----------------------------------------------------------------------------
+// refMulti
+// -----------------------------------------------------------------------------
+template <typename T> static void refMulti(T outDst[], const T inSrc0[], const T inSrc1[])
+{
+  for (int i = 0; i < 4; i++)
+    for (int j = 0; j < 4; j++)
+    {
+      double v = 0;
+      for (int k = 0; k < 4; k++)
+        v += (double )inSrc0[i * 4 + k] * (double )inSrc1[k * 4 + j];
+      outDst[i * 4 + j] = (T )v;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// calcMaxDiff
+// -----------------------------------------------------------------------------
+template <typename T0, typename T1>
+static double calcMaxDiff(const T0 inA[], const T1 inB[], int inNum)
+{
+  double  diff = 0;
+  for (int i = 0; i < inNum; i++)
+    diff = std::max(diff, std::fabs((double )inA[i] - (double )inB[i]));
+  return diff;
+}
+
+// -----------------------------------------------------------------------------
+// testMulti
+// -----------------------------------------------------------------------------
+template <typename T> static void testMulti(double inTolerance)
+{
+  int failNum = sFailNum;
+  std::mt19937  rng(1);
+  std::uniform_real_distribution<double> dist(-2.0, 2.0);
+  for (int t = 0; t < TRIAL_NUM; t++)
+  {
+    MatrixBase<T> a, b;
+    T *aPtr = (T *)a.mMat, *bPtr = (T *)b.mMat;
+    for (int i = 0; i < 16; i++)
+    {
+      aPtr[i] = (T )dist(rng);
+      bPtr[i] = (T )dist(rng);
+    }
+    T ref[16];
+    refMulti(ref, aPtr, bPtr);
+    MatrixBase<T> c = a * b;
+    CHECK(calcMaxDiff(ref, (T *)c.mMat, 16) < inTolerance);
+
+    // Aliased operands (outDst == inSrc0 and outDst == inSrc1 are allowed
+    // only by the kernels, the member functions copy the operands)
+    MatrixBase<T> d = a;
+    if constexpr (MatrixKernel<T>::IS_ACCELERATED)
+    {
+      MatrixBase<T>::multi((T *)d.mMat, (T *)d.mMat, bPtr);
+      CHECK(calcMaxDiff(ref, (T *)d.mMat, 16) < inTolerance);
+      d = b;
+      MatrixBase<T>::multi((T *)d.mMat, aPtr, (T *)d.mMat);
+      CHECK(calcMaxDiff(ref, (T *)d.mMat, 16) < inTolerance);
+    }
+    d = a;
+    d *= b;
+    CHECK(calcMaxDiff(ref, (T *)d.mMat, 16) < inTolerance);
+    refMulti(ref, aPtr, aPtr);
+    d = a;
+    d *= d;
+    CHECK(calcMaxDiff(ref, (T *)d.mMat, 16) < inTolerance);
+  }
+  ::printf("multi (%zu bytes, accelerated %d) : %s\n", sizeof(T),
+           (int )MatrixKernel<T>::IS_ACCELERATED, (failNum == sFailNum) ? "OK" : "FAILED");
+}
+
+// -----------------------------------------------------------------------------
+// testInverseAffine
+// -----------------------------------------------------------------------------
+template <typename T> static void testInverseAffine(double inTolerance)
+{
+  int failNum = sFailNum;
+  std::mt19937  rng(2);
+  std::uniform_real_distribution<double> dist(-2.0, 2.0);
+  for (int t = 0; t < TRIAL_NUM; t++)
+  {
+    MatrixBase<T> m;
+    m.setIdentity();
+    T *mPtr = (T *)m.mMat;
+    for (int i = 0; i < 12; i++)
+      mPtr[i] = (T )dist(rng);
+    MatrixBase<T> inv = m, full = m;
+    if (full.inverse() == false)
+      continue;
+    CHECK(inv.inverseAffine());
+    // The round trip is the identity, and the same as the full inverse
+    MatrixBase<T> id = m * inv, ref;
+    ref.setIdentity();
+    CHECK(calcMaxDiff((T *)ref.mMat, (T *)id.mMat, 16) < inTolerance);
+    CHECK(calcMaxDiff((T *)full.mMat, (T *)inv.mMat, 16) <
+          inTolerance * (1.0 + calcMaxDiff((T *)full.mMat, (T *)ref.mMat, 16)));
+  }
+  // Singular
+  MatrixBase<T> m;
+  m.setZero();
+  CHECK(m.inverseAffine() == false);
+  ::printf("inverseAffine (%zu bytes) : %s\n", sizeof(T), (failNum == sFailNum) ? "OK" : "FAILED");
+}
+
+// -----------------------------------------------------------------------------
+// testTransformPoints
+// -----------------------------------------------------------------------------
+static void testTransformPoints()
+{
+  int failNum = sFailNum;
+  std::mt19937  rng(3);
+  std::uniform_real_distribution<GLfloat> dist(-2.0f, 2.0f);
+  glMatrix4f  m;
+  m.setIdentity();
+  GLfloat *mPtr = (GLfloat *)m.mMat;
+  for (int i = 0; i < 12; i++)
+    mPtr[i] = dist(rng);
+
+  // Stride 12 (glXYZf) : the last point ends at the end of the array
+  std::vector<glXYZf> points(POINT_NUM), out(POINT_NUM);
+  for (size_t i = 0; i < POINT_NUM; i++)
+  {
+    points[i].x = dist(rng);
+    points[i].y = dist(rng);
+    points[i].z = dist(rng);
+  }
+  m.transformPoints(points.data(), POINT_NUM, out.data());
+  for (size_t i = 0; i < POINT_NUM; i++)
+  {
+    GLfloat ref[3];
+    glMatrix4f::multiMatrixByVector(ref, mPtr, &(points[i].x));
+    CHECK(calcMaxDiff(ref, &(out[i].x), 3) < 1e-5);
+  }
+  GLfloat last[3];
+  glMatrix4f::multiMatrixByVector(last, mPtr, &(points[POINT_NUM - 1].x));
+  CHECK(calcMaxDiff(last, &(out[POINT_NUM - 1].x), 3) < 1e-5);
+
+  // In place with the stride 16 : the attributes are not touched
+  std::vector<glXYZf_RGBAub> colored(POINT_NUM);
+  for (size_t i = 0; i < POINT_NUM; i++)
+  {
+    colored[i].x = points[i].x;
+    colored[i].y = points[i].y;
+    colored[i].z = points[i].z;
+    colored[i].r = (GLubyte )i;
+    colored[i].g = 1;
+    colored[i].b = 2;
+    colored[i].a = 3;
+  }
+  glMatrix4f::transformPoints(mPtr, colored.data(), sizeof(glXYZf_RGBAub), POINT_NUM,
+                              colored.data(), sizeof(glXYZf_RGBAub));
+  for (size_t i = 0; i < POINT_NUM; i++)
+  {
+    CHECK(calcMaxDiff(&(out[i].x), &(colored[i].x), 3) == 0);
+    CHECK(colored[i].r == (GLubyte )i && colored[i].g == 1 &&
+          colored[i].b == 2 && colored[i].a == 3);
+  }
+  ::printf("transformPoints : %s\n", (failNum == sFailNum) ? "OK" : "FAILED");
+}
+
+// -----------------------------------------------------------------------------
+// testQuaternion
+// -----------------------------------------------------------------------------
+static void testQuaternion()
+{
+  int failNum = sFailNum;
+  std::mt19937  rng(4);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  for (int t = 0; t < TRIAL_NUM; t++)
+  {
+    double  a[4], b[4], ref[4];
+    float   af[4], bf[4], out[4];
+    for (int i = 0; i < 4; i++)
+    {
+      af[i] = (float )dist(rng);
+      bf[i] = (float )dist(rng);
+      a[i] = af[i];
+      b[i] = bf[i];
+    }
+    QuaternionBase<double>::multi(ref, a, b);
+    QuaternionBase<float>::multi(out, af, bf);
+    CHECK(calcMaxDiff(ref, out, 4) < 1e-5);
+    QuaternionBase<float>::multi(af, af, bf);   // aliased
+    CHECK(calcMaxDiff(ref, af, 4) < 1e-5);
+  }
+  ::printf("quaternion : %s\n", (failNum == sFailNum) ? "OK" : "FAILED");
+}
+
+// -----------------------------------------------------------------------------
+// main
+// -----------------------------------------------------------------------------
+int main()
+{
+  testMulti<float>(1e-5);
+  testMulti<double>(1e-12);
+  testMulti<int>(0.5);
+  testInverseAffine<float>(1e-3);
+  testInverseAffine<double>(1e-9);
+  testTransformPoints();
+  testQuaternion();
+  return (sFailNum == 0) ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+// =============================================================================
+//  ply_round_trip.cpp
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     tests/ply_round_trip.cpp
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Writes each vertex struct of data.h with PLYFile::write() in all
+            the formats and reads it back with the PLYFile::get_*() functions
+*/
+
+// Includes --------------------------------------------------------------------
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "ibc/gl/file/ply.h"
+
+using namespace ibc::gl;
+using namespace ibc::gl::file;
+
+// Globals ---------------------------------------------------------------------
+static const char *FILE_NAME = "ply_round_trip.ply";
+static const size_t DATA_NUM = 1000;
+static int  sFailNum = 0;
+
+#define CHECK(c)  \
+  { if (!(c)) { ::printf("FAILED : %s:%d %s\n", __FILE__, __LINE__, #c); sFailNum++; } }
+
+// -----------------------------------------------------------------------------
+// fill
+// -----------------------------------------------------------------------------
+// The float colors are k / 255 (stored as uchar in the file)
+template <typename DataType>
+static void fill(DataType *outData, size_t inIndex)
+{
+  std::memset(outData, 0, sizeof(DataType));
+  outData->x = inIndex * 0.1f + 1e-7f;
+  outData->y = -(GLfloat )inIndex / 3.0f;
+  outData->z = 1e20f / (GLfloat )(inIndex + 1);
+  if constexpr (requires { outData->nx; })
+  {
+    outData->nx = 1.0f / (GLfloat )(inIndex + 1);
+    outData->ny = -0.5f;
+    outData->nz = (GLfloat )inIndex * 1e-3f;
+  }
+  if constexpr (requires { outData->a; })
+  {
+    outData->r = (GLubyte )(inIndex & 255);
+    outData->g = (GLubyte )((inIndex * 7) & 255);
+    outData->b = (GLubyte )((inIndex * 13) & 255);
+    outData->a = (GLubyte )((inIndex * 31) & 255);
+  }
+  else if constexpr (requires { outData->r; })
+  {
+    outData->r = (GLfloat )((inIndex & 255) / 255.0);
+    outData->g = (GLfloat )(((inIndex * 7) & 255) / 255.0);
+    outData->b = (GLfloat )(((inIndex * 13) & 255) / 255.0);
+  }
+  if constexpr (requires { outData->i; })
+    outData->i = (decltype(outData->i))((inIndex * 17) & 255);
+}
+
+// -----------------------------------------------------------------------------
+// isEqual
+// -----------------------------------------------------------------------------
+// Member by member (the padding of the read data is not initialized)
+template <typename DataType>
+static bool isEqual(const DataType &inA, const DataType &inB)
+{
+  bool  result = (inA.x == inB.x && inA.y == inB.y && inA.z == inB.z);
+  if constexpr (requires { inA.nx; })
+    result = result && (inA.nx == inB.nx && inA.ny == inB.ny && inA.nz == inB.nz);
+  if constexpr (requires { inA.r; })
+    result = result && (inA.r == inB.r && inA.g == inB.g && inA.b == inB.b);
+  if constexpr (requires { inA.a; })
+    result = result && (inA.a == inB.a);
+  if constexpr (requires { inA.i; })
+    result = result && (inA.i == inB.i);
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+// testRoundTrip
+// -----------------------------------------------------------------------------
+template <typename DataType, typename GetFunc>
+static void testRoundTrip(const char *inName, GetFunc inGetFunc)
+{
+  static const PLYHeader::DataFormat  formats[] = {
+    PLYHeader::DATA_FORMAT_ASCII,
+    PLYHeader::DATA_FORMAT_BINARY_LITTLE_ENDIAN,
+    PLYHeader::DATA_FORMAT_BINARY_BIG_ENDIAN };
+  static const char *formatNames[] = { "ascii", "binary_little_endian", "binary_big_endian" };
+  std::vector<DataType> data(DATA_NUM);
+  for (size_t i = 0; i < DATA_NUM; i++)
+    fill(&(data[i]), i);
+  glFacesCSR  faces;
+  faces.offsets = { 0, 3, 7, 12 };
+  faces.indices = { 0, 1, 2,  3, 4, 5, 6,  7, 8, 9, 10, 11 };
+
+  for (int f = 0; f < 3; f++)
+  {
+    PLYHeader::DataFormat format = formats[f];
+    int failNum = sFailNum;
+    CHECK(PLYFile::write(FILE_NAME, data.data(), DATA_NUM, format, &faces));
+    PLYHeader *header = NULL;
+    unsigned char *buf = NULL;
+    size_t  bufSize = 0;
+    CHECK(PLYFile::readHeader(FILE_NAME, &header, &buf, &bufSize));
+    if (header == NULL)
+      continue;
+    DataType  *readData = NULL;
+    size_t  readNum = 0;
+    CHECK(inGetFunc(*header, buf, bufSize, &readData, &readNum, (GLfloat *)NULL));
+    CHECK(readNum == DATA_NUM);
+    if (readData != NULL && readNum == DATA_NUM)
+    {
+      size_t  i;
+      for (i = 0; i < DATA_NUM; i++)
+        if (isEqual(data[i], readData[i]) == false)
+          break;
+      CHECK(i == DATA_NUM);
+    }
+    glFacesCSR  readFaces;
+    CHECK(PLYFile::get_faces(*header, buf, bufSize, &readFaces));
+    CHECK(readFaces.offsets == faces.offsets && readFaces.indices == faces.indices);
+    ::printf("%-20s %-22s : %s\n", inName, formatNames[f],
+             (failNum == sFailNum) ? "OK" : "FAILED");
+    delete[] (unsigned char *)readData;
+    delete[] buf;
+    delete header;
+  }
+  std::remove(FILE_NAME);
+}
+
+// -----------------------------------------------------------------------------
+// main
+// -----------------------------------------------------------------------------
+int main()
+{
+  testRoundTrip<glXYZf>("glXYZf", PLYFile::get_glXYZf);
+  testRoundTrip<glXYZ_RGBf>("glXYZ_RGBf", PLYFile::get_glXYZ_RGBf);
+  testRoundTrip<glXYZ_If>("glXYZ_If", PLYFile::get_glXYZ_If);
+  testRoundTrip<glXYZ_NORM_RGBf>("glXYZ_NORM_RGBf", PLYFile::get_glXYZ_NORM_RGBf);
+  testRoundTrip<glXYZ_NORM_If>("glXYZ_NORM_If", PLYFile::get_glXYZ_NORM_If);
+  testRoundTrip<glXYZf_RGBAub>("glXYZf_RGBAub", PLYFile::get_glXYZf_RGBAub);
+  testRoundTrip<glXYZ_NORMf_RGBAub>("glXYZ_NORMf_RGBAub", PLYFile::get_glXYZ_NORMf_RGBAub);
+  testRoundTrip<glXYZf_Iub>("glXYZf_Iub", PLYFile::get_glXYZf_Iub);
+  testRoundTrip<glXYZ_NORMf_Iub>("glXYZ_NORMf_Iub", PLYFile::get_glXYZ_NORMf_Iub);
+  return (sFailNum == 0) ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+// =============================================================================
+//  point_registration.cpp
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     tests/point_registration.cpp
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Checks that PointRegistration (ICP) recovers a known rigid
+            transform, that Horn's closed form solve is exact, and that
+            PointTransform rotates the normals without the translation
+*/
+
+// Includes --------------------------------------------------------------------
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "ibc/gl/data.h"
+#include "ibc/gl/matrix.h"
+#include "ibc/gl/point_registration.h"
+#include "ibc/gl/point_transform.h"
+
+using namespace ibc::gl;
+
+// Globals ---------------------------------------------------------------------
+static const size_t DATA_NUM = 20000;
+static int  sFailNum = 0;
+
+#define CHECK(c)  \
+  { if (!(c)) { ::printf("FAILED : %s:%d %s\n", __FILE__, __LINE__, #c); sFailNum++; } }
+
+// -----------------------------------------------------------------------------
+// RegistrationTest class
+// -----------------------------------------------------------------------------
+// Exposes the closed form solve
+class RegistrationTest : public PointRegistration
+{
+public:
+  using PointRegistration::Moments;
+  using PointRegistration::solve;
+};
+
+// -----------------------------------------------------------------------------
+// makeRigidTransform
+// -----------------------------------------------------------------------------
+// Rotation about z (inAngleZ), then about x (inAngleX), then the translation
+static MatrixBase<double> makeRigidTransform(double inAngleZ, double inAngleX,
+                                             double inX, double inY, double inZ)
+{
+  MatrixBase<double>  rotZ, rotX;
+  rotZ.setIdentity();
+  rotZ.mMat[0][0] = std::cos(inAngleZ);
+  rotZ.mMat[0][1] = -std::sin(inAngleZ);
+  rotZ.mMat[1][0] = std::sin(inAngleZ);
+  rotZ.mMat[1][1] = std::cos(inAngleZ);
+  rotX.setIdentity();
+  rotX.mMat[1][1] = std::cos(inAngleX);
+  rotX.mMat[1][2] = -std::sin(inAngleX);
+  rotX.mMat[2][1] = std::sin(inAngleX);
+  rotX.mMat[2][2] = std::cos(inAngleX);
+  MatrixBase<double>  mat = rotZ * rotX;
+  mat.setTranslation(inX, inY, inZ);
+  return mat;
+}
+
+// -----------------------------------------------------------------------------
+// calcMaxDiff
+// -----------------------------------------------------------------------------
+// The upper 3x4 (the bottom row is (0, 0, 0, 1))
+static double calcMaxDiff(const MatrixBase<double> &inA, const MatrixBase<double> &inB)
+{
+  double  diff = 0;
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 4; j++)
+      diff = std::max(diff, std::fabs(inA.mMat[i][j] - inB.mMat[i][j]));
+  return diff;
+}
+
+// -----------------------------------------------------------------------------
+// testSolve
+// -----------------------------------------------------------------------------
+static void testSolve()
+{
+  int failNum = sFailNum;
+  std::mt19937  rng(1);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  MatrixBase<double>  ref = makeRigidTransform(0.7, -0.4, 0.5, -1.0, 2.0);
+  RegistrationTest::Moments moments;
+  moments.clear();
+  for (int i = 0; i < 100; i++)
+  {
+    double  p[3] = { dist(rng), dist(rng), dist(rng) }, q[3];
+    MatrixBase<double>::multiMatrixByVector(q, (const double *)ref.mMat, p);
+    moments.num++;
+    for (int j = 0; j < 3; j++)
+    {
+      moments.p[j] += p[j];
+      moments.q[j] += q[j];
+      for (int k = 0; k < 3; k++)
+        moments.pq[j][k] += p[j] * q[k];
+    }
+  }
+  MatrixBase<double>  mat;
+  double  angle, translation;
+  CHECK(RegistrationTest::solve(moments, &mat, &angle, &translation));
+  CHECK(calcMaxDiff(mat, ref) < 1e-9);
+  ::printf("solve : %s\n", (failNum == sFailNum) ? "OK" : "FAILED");
+}
+
+// -----------------------------------------------------------------------------
+// testAlign
+// -----------------------------------------------------------------------------
+static void testAlign(unsigned int inTaskNum)
+{
+  int failNum = sFailNum;
+  std::mt19937  rng(2);
+  std::uniform_real_distribution<GLfloat> dist(-1.0f, 1.0f);
+  // The target : z = 0.3 sin(3x) cos(2y)
+  std::vector<glXYZf> target(DATA_NUM);
+  for (size_t i = 0; i < DATA_NUM; i++)
+  {
+    GLfloat x = dist(rng), y = dist(rng);
+    target[i].x = x;
+    target[i].y = y;
+    target[i].z = 0.3f * std::sin(3.0f * x) * std::cos(2.0f * y);
+  }
+  // The source : the target moved by the inverse of the transform
+  MatrixBase<double>  ref = makeRigidTransform(0.05, 0.03, 0.03, -0.02, 0.01);
+  MatrixBase<double>  inv = ref;
+  CHECK(inv.inverseAffine());
+  std::vector<glXYZf> source(DATA_NUM);
+  PointTransform::transform(inv, target.data(), DATA_NUM, source.data(), inTaskNum);
+
+  PointRegistration reg;
+  reg.setTaskNum(inTaskNum);
+  reg.setMaxIterationNum(100);
+  CHECK(reg.setTarget(target.data(), DATA_NUM));
+  MatrixBase<double>  mat;
+  mat.setIdentity();
+  PointRegistration::Result result;
+  CHECK(reg.align(source.data(), DATA_NUM, &mat, &result));
+  CHECK(result.isConverged);
+  CHECK(result.correspondenceNum == DATA_NUM);
+  CHECK(result.rmse < 1e-4);
+  CHECK(calcMaxDiff(mat, ref) < 1e-4);
+  ::printf("align (tasks %u, %u iterations) : %s\n", inTaskNum, result.iterationNum,
+           (failNum == sFailNum) ? "OK" : "FAILED");
+}
+
+// -----------------------------------------------------------------------------
+// testNormals
+// -----------------------------------------------------------------------------
+static void testNormals()
+{
+  int failNum = sFailNum;
+  MatrixBase<double>  mat = makeRigidTransform(0.3, 0.2, 0.1, -0.2, 0.3);
+  std::vector<glXYZ_NORMf_RGBAub> data(1001), out(data.size());
+  for (size_t i = 0; i < data.size(); i++)
+  {
+    data[i].x = (GLfloat )i * 0.001f;
+    data[i].y = 1.0f;
+    data[i].z = -0.5f;
+    data[i].nx = 0;
+    data[i].ny = 0;
+    data[i].nz = 1;
+    data[i].r = 1;
+    data[i].g = 2;
+    data[i].b = 3;
+    data[i].a = 4;
+  }
+  PointTransform::transform(mat, data.data(), data.size(), out.data(), 3);
+  for (size_t i = 0; i < data.size(); i++)
+  {
+    double  p[3] = { data[i].x, data[i].y, data[i].z }, q[3];
+    MatrixBase<double>::multiMatrixByVector(q, (const double *)mat.mMat, p);
+    CHECK(std::fabs(out[i].x - q[0]) < 1e-5 && std::fabs(out[i].y - q[1]) < 1e-5 &&
+          std::fabs(out[i].z - q[2]) < 1e-5);
+    // The normal is the 3rd column of the rotation (not translated)
+    CHECK(std::fabs(out[i].nx - mat.mMat[0][2]) < 1e-6 &&
+          std::fabs(out[i].ny - mat.mMat[1][2]) < 1e-6 &&
+          std::fabs(out[i].nz - mat.mMat[2][2]) < 1e-6);
+    CHECK(out[i].r == 1 && out[i].g == 2 && out[i].b == 3 && out[i].a == 4);
+  }
+  ::printf("normals : %s\n", (failNum == sFailNum) ? "OK" : "FAILED");
+}
+
+// -----------------------------------------------------------------------------
+// main
+// -----------------------------------------------------------------------------
+int main()
+{
+  testSolve();
+  testAlign(1);
+  testAlign(4);
+  testNormals();
+  return (sFailNum == 0) ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+// =============================================================================
+//  spatial_query.cpp
+//
+//  Written in 2019 by Dairoku Sekiguchi (sekiguchi at acm dot org)
+//
+//  To the extent possible under law, the author(s) have dedicated all copyright
+//  and related and neighboring rights to this software to the public domain worldwide.
+//  This software is distributed without any warranty.
+//
+//  You should have received a copy of the CC0 Public Domain Dedication along with
+//  this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+// =============================================================================
+/*!
+  \file     tests/spatial_query.cpp
+  \author   Dairoku Sekiguchi
+  \version  1.0.0
+  \date     2019/06/01
+  \brief    Compares the KdTree and VoxelGrid queries (nearest, k nearest,
+            radius and box) with the brute force search
+*/
+
+// Includes --------------------------------------------------------------------
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+#include "ibc/gl/data.h"
+#include "ibc/gl/kd_tree.h"
+#include "ibc/gl/voxel_grid.h"
+
+using namespace ibc::gl;
+
+// Globals ---------------------------------------------------------------------
+static const size_t DATA_NUM = 20000;
+static const size_t QUERY_NUM = 50;
+static const size_t K = 8;
+static const GLfloat RADIUS = 0.05f;
+static const GLfloat VOXEL_SIZE = 0.04f;
+static int  sFailNum = 0;
+
+#define CHECK(c)  \
+  { if (!(c)) { ::printf("FAILED : %s:%d %s\n", __FILE__, __LINE__, #c); sFailNum++; } }
+
+// -----------------------------------------------------------------------------
+// calcDist2
+// -----------------------------------------------------------------------------
+static GLfloat calcDist2(const glXYZf_RGBAub &inPoint, const GLfloat inQuery[3])
+{
+  GLfloat dx = inPoint.x - inQuery[0];
+  GLfloat dy = inPoint.y - inQuery[1];
+  GLfloat dz = inPoint.z - inQuery[2];
+  return dx * dx + dy * dy + dz * dz;
+}
+
+// -----------------------------------------------------------------------------
+// isValid
+// -----------------------------------------------------------------------------
+static bool isValid(const glXYZf_RGBAub &inPoint)
+{
+  return std::isfinite(inPoint.x) && std::isfinite(inPoint.y) && std::isfinite(inPoint.z);
+}
+
+// -----------------------------------------------------------------------------
+// sorted
+// -----------------------------------------------------------------------------
+static std::vector<size_t> sorted(std::vector<size_t> inIndices)
+{
+  std::sort(inIndices.begin(), inIndices.end());
+  return inIndices;
+}
+
+// -----------------------------------------------------------------------------
+// testQueries
+// -----------------------------------------------------------------------------
+static void testQueries(const std::vector<glXYZf_RGBAub> &inData, unsigned int inTaskNum)
+{
+  int failNum = sFailNum;
+  KdTree  tree;
+  VoxelGrid grid;
+  CHECK(tree.build(inData.data(), sizeof(glXYZf_RGBAub), inData.size(), 16, inTaskNum));
+  CHECK(grid.build(inData.data(), sizeof(glXYZf_RGBAub), inData.size(), VOXEL_SIZE, inTaskNum));
+
+  std::mt19937  rng(2);
+  std::uniform_real_distribution<GLfloat> dist(-1.0f, 1.0f);
+  std::vector<glXYZf> queries(QUERY_NUM);
+  for (size_t q = 0; q < QUERY_NUM; q++)
+  {
+    queries[q].x = dist(rng);
+    queries[q].y = dist(rng);
+    queries[q].z = dist(rng) * 0.5f;
+  }
+
+  for (size_t q = 0; q < QUERY_NUM; q++)
+  {
+    const GLfloat *query = &(queries[q].x);
+    std::vector<std::pair<GLfloat, size_t>> all;
+    std::vector<size_t> radiusRef, boxRef;
+    GLfloat box[6] = { query[0] - 0.1f, query[0] + 0.05f, query[1] - 0.03f,
+                       query[1] + 0.08f, query[2] - 0.2f, query[2] + 0.02f };
+    for (size_t i = 0; i < inData.size(); i++)
+    {
+      if (isValid(inData[i]) == false)
+        continue;
+      GLfloat d2 = calcDist2(inData[i], query);
+      all.push_back(std::make_pair(d2, i));
+      if (d2 <= RADIUS * RADIUS)
+        radiusRef.push_back(i);
+      if (inData[i].x >= box[0] && inData[i].x <= box[1] &&
+          inData[i].y >= box[2] && inData[i].y <= box[3] &&
+          inData[i].z >= box[4] && inData[i].z <= box[5])
+        boxRef.push_back(i);
+    }
+    std::partial_sort(all.begin(), all.begin() + K, all.end());
+
+    // Nearest and k nearest (compared by the distance, in case of the ties)
+    GLfloat d2;
+    size_t  nearest = tree.findNearest(query, &d2);
+    CHECK(nearest != KdTree::INVALID_INDEX && d2 == all[0].first);
+    size_t  indices[K];
+    GLfloat dists[K];
+    CHECK(tree.findKNearest(query, K, indices, dists) == K);
+    for (size_t k = 0; k < K; k++)
+      CHECK(dists[k] == all[k].first);
+    nearest = grid.findNearest(query, 1.0f, &d2);
+    CHECK(nearest != VoxelGrid::INVALID_INDEX && d2 == all[0].first);
+
+    // Radius and box
+    std::vector<size_t> found;
+    tree.findRadius(query, RADIUS, &found);
+    CHECK(sorted(found) == radiusRef);
+    grid.findRadius(query, RADIUS, &found);
+    CHECK(sorted(found) == radiusRef);
+    tree.findBox(box, &found);
+    CHECK(sorted(found) == boxRef);
+    grid.findBox(box, &found);
+    CHECK(sorted(found) == boxRef);
+  }
+
+  // The batches are the same as the single queries
+  std::vector<size_t> nearests(QUERY_NUM), knearests(QUERY_NUM * K);
+  tree.findNearestBatch(queries.data(), sizeof(glXYZf), QUERY_NUM, nearests.data(),
+                        NULL, std::numeric_limits<GLfloat>::infinity(), inTaskNum);
+  tree.findKNearestBatch(queries.data(), sizeof(glXYZf), QUERY_NUM, K, knearests.data(),
+                         NULL, NULL, std::numeric_limits<GLfloat>::infinity(), inTaskNum);
+  std::vector<size_t> offsets, batchIndices, gridOffsets, gridIndices;
+  tree.findRadiusBatch(queries.data(), sizeof(glXYZf), QUERY_NUM, RADIUS,
+                       &offsets, &batchIndices, inTaskNum);
+  grid.findRadiusBatch(queries.data(), sizeof(glXYZf), QUERY_NUM, RADIUS,
+                       &gridOffsets, &gridIndices, inTaskNum);
+  for (size_t q = 0; q < QUERY_NUM; q++)
+  {
+    const GLfloat *query = &(queries[q].x);
+    CHECK(nearests[q] == tree.findNearest(query));
+    size_t  indices[K];
+    tree.findKNearest(query, K, indices);
+    CHECK(std::equal(indices, indices + K, knearests.begin() + q * K));
+    std::vector<size_t> found;
+    tree.findRadius(query, RADIUS, &found);
+    CHECK(std::vector<size_t>(batchIndices.begin() + offsets[q],
+                              batchIndices.begin() + offsets[q + 1]) == found);
+    CHECK(sorted(std::vector<size_t>(gridIndices.begin() + gridOffsets[q],
+                                     gridIndices.begin() + gridOffsets[q + 1])) == sorted(found));
+  }
+  ::printf("tasks %u : %s\n", inTaskNum, (failNum == sFailNum) ? "OK" : "FAILED");
+}
+
+// -----------------------------------------------------------------------------
+// main
+// -----------------------------------------------------------------------------
+int main()
+{
+  std::mt19937  rng(1);
+  std::uniform_real_distribution<GLfloat> dist(-1.0f, 1.0f);
+  std::vector<glXYZf_RGBAub> data(DATA_NUM);
+  for (size_t i = 0; i < DATA_NUM; i++)
+  {
+    data[i].x = dist(rng);
+    data[i].y = dist(rng);
+    data[i].z = dist(rng) * dist(rng) * 0.5f;
+    if (i % 997 == 3)
+      data[i].y = NAN;    // skipped by the both
+  }
+  // 1 : serial, 3 and 8 : the parallel builds (even on a single core)
+  testQueries(data, 1);
+  testQueries(data, 3);
+  testQueries(data, 8);
+  return (sFailNum == 0) ? 0 : 1;
+}